@@ -159,6 +159,7 @@ var gniExportDescs = []exporter.GNIExportDesc{
 			}},
 		{Var: "skia_encode_libpng_srcs",
 			Rules: []string{
+				"//src/encode:deflate_chunk_hdrs",
 				"//src/encode:png_encode_srcs",
 				"//src/encode:png_encode_hdrs",
 			}},
@@ -171,6 +172,7 @@ var gniExportDescs = []exporter.GNIExportDesc{
 			Rules: []string{
 				"//src/encode:png_encode_base_srcs",
 				"//src/encode:png_encode_base_hdrs",
+				"//src/encode:deflate_chunk_hdrs",
 				"//src/encode:png_encode_srcs",
 				"//src/encode:png_encode_hdrs",
 			}},
@@ -347,6 +349,7 @@ var gniExportDescs = []exporter.GNIExportDesc{
 			Rules: []string{"//include/docs:pdf_hdrs"}},
 		{Var: "skia_pdf_sources",
 			Rules: []string{
+				"//src/encode:deflate_chunk_hdrs",
 				"//src/pdf:_pdf_hdrs",
 				"//src/pdf:_pdf_srcs",
 			}},
@@ -13,12 +13,13 @@
 #include "src/core/SkOSFile.h"
 
 BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData* encoded,
-        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset)
+        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset, bool tiled)
     : fBRD(nullptr)
     , fData(SkRef(encoded))
     , fColorType(colorType)
     , fSampleSize(sampleSize)
     , fSubset(subset)
+    , fTiled(tiled)
 {
     // Choose a useful name for the color type
     const char* colorName = color_type_to_str(colorType);
@@ -45,8 +46,19 @@ void BitmapRegionDecoderBench::onDraw(int n, SkCanvas* canvas) {
     auto ct = fBRD->computeOutputColorType(fColorType);
     auto cs = fBRD->computeOutputColorSpace(ct, nullptr);
     for (int i = 0; i < n; i++) {
-        SkBitmap bm;
-        SkAssertResult(fBRD->decodeRegion(&bm, nullptr, fSubset, fSampleSize, ct, false, cs));
+        if (!fTiled) {
+            SkBitmap bm;
+            SkAssertResult(fBRD->decodeRegion(&bm, nullptr, fSubset, fSampleSize, ct, false, cs));
+            continue;
+        }
+        for (int y = 0; y < fBRD->height(); y += fSubset.height()) {
+            for (int x = 0; x < fBRD->width(); x += fSubset.width()) {
+                SkIRect tile = fSubset.makeOffset(x, y);
+                SkAssertResult(tile.intersect(SkIRect::MakeWH(fBRD->width(), fBRD->height())));
+                SkBitmap bm;
+                SkAssertResult(fBRD->decodeRegion(&bm, nullptr, tile, fSampleSize, ct, false, cs));
+            }
+        }
     }
 }
 #endif // SK_ENABLE_ANDROID_UTILS
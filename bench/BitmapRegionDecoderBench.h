@@ -26,12 +26,15 @@ class BitmapRegionDecoder;
  *
  *  nanobench.cpp handles creating benchmarks for interesting scaled subsets.  We strive to test
  *  on real use cases.
+ *
+ *  If tiled is true, each iteration decodes every subset-sized tile of the image with the same
+ *  decoder, as a tile server panning across a large image would.
  */
 class BitmapRegionDecoderBench : public Benchmark {
 public:
     // Calls encoded->ref()
     BitmapRegionDecoderBench(const char* basename, SkData* encoded, SkColorType colorType,
-            uint32_t sampleSize, const SkIRect& subset);
+            uint32_t sampleSize, const SkIRect& subset, bool tiled = false);
 
 protected:
     const char* onGetName() override;
@@ -46,6 +49,7 @@ private:
     const SkColorType                                   fColorType;
     const uint32_t                                      fSampleSize;
     const SkIRect                                       fSubset;
+    const bool                                          fTiled;
     using INHERITED = Benchmark;
 };
 #endif // SK_ENABLE_ANDROID_UTILS
@@ -8,16 +8,22 @@
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/effects/SkImageFilters.h"
 #include "src/base/SkRandom.h"
 
+#include <memory>
+
 #define FILTER_WIDTH_SMALL  32
 #define FILTER_HEIGHT_SMALL 32
 #define FILTER_WIDTH_LARGE  256
 #define FILTER_HEIGHT_LARGE 256
+#define FILTER_WIDTH_HUGE   2048
+#define FILTER_HEIGHT_HUGE  2048
 #define BLUR_SIGMA_MINI     0.5f
 #define BLUR_SIGMA_SMALL    1.0f
 #define BLUR_SIGMA_LARGE    10.0f
@@ -34,6 +40,10 @@
 // of the source (not inset). This is intended to exercise blurring a smaller source bitmap to a
 // larger destination.
 
+// When 'huge' is set we blur a much larger source. When 'parallel' is also set, raster blurs are
+// split into bands run on a work-stealing thread pool (see
+// SkGraphics::SetRasterBlurParallelThreshold); compare against 'huge' alone to see how they scale.
+
 static sk_sp<SkImage> make_checkerboard(int width, int height) {
     SkBitmap bm;
     bm.allocN32Pixels(width, height);
@@ -61,19 +71,24 @@ static sk_sp<SkImage> make_checkerboard(int width, int height) {
 class BlurImageFilterBench : public Benchmark {
 public:
     BlurImageFilterBench(SkScalar sigmaX, SkScalar sigmaY,  bool small, bool cropped,
-                         bool expanded)
+                         bool expanded, bool huge = false, bool parallel = false)
       : fIsSmall(small)
       , fIsCropped(cropped)
       , fIsExpanded(expanded)
+      , fIsHuge(huge)
+      , fIsParallel(parallel)
       , fInitialized(false)
       , fSigmaX(sigmaX)
       , fSigmaY(sigmaY) {
-        fName.printf("blur_image_filter_%s%s%s_%.2f_%.2f",
-                     fIsSmall ? "small" : "large",
+        fName.printf("blur_image_filter_%s%s%s%s_%.2f_%.2f",
+                     fIsSmall ? "small" : fIsHuge ? "huge" : "large",
                      fIsCropped ? "_cropped" : "",
                      fIsExpanded ? "_expanded" : "",
+                     fIsParallel ? "_parallel" : "",
                      sigmaX, sigmaY);
         SkASSERT(!fIsExpanded || fIsCropped); // never want expansion w/o cropping
+        SkASSERT(!fIsParallel || fIsHuge);
+        SkASSERT(!fIsHuge || !fIsSmall);
     }
 
 protected:
@@ -83,12 +98,34 @@ protected:
 
     void onDelayedSetup() override {
         if (!fInitialized) {
-            fCheckerboard = make_checkerboard(fIsSmall ? FILTER_WIDTH_SMALL : FILTER_WIDTH_LARGE,
-                                              fIsSmall ? FILTER_HEIGHT_SMALL : FILTER_HEIGHT_LARGE);
+            if (fIsHuge) {
+                fCheckerboard = make_checkerboard(FILTER_WIDTH_HUGE, FILTER_HEIGHT_HUGE);
+            } else {
+                fCheckerboard = make_checkerboard(
+                        fIsSmall ? FILTER_WIDTH_SMALL : FILTER_WIDTH_LARGE,
+                        fIsSmall ? FILTER_HEIGHT_SMALL : FILTER_HEIGHT_LARGE);
+            }
+            if (fIsParallel) {
+                fExecutor = SkExecutor::MakeWorkStealingThreadPool();
+            }
             fInitialized = true;
         }
     }
 
+    void onPerCanvasPreDraw(SkCanvas*) override {
+        if (fIsParallel) {
+            SkExecutor::SetDefault(fExecutor.get());
+            fOldThreshold = SkGraphics::SetRasterBlurParallelThreshold(kParallelThreshold);
+        }
+    }
+
+    void onPerCanvasPostDraw(SkCanvas*) override {
+        if (fIsParallel) {
+            SkGraphics::SetRasterBlurParallelThreshold(fOldThreshold);
+            SkExecutor::SetDefault(nullptr);
+        }
+    }
+
     void onDraw(int loops, SkCanvas* canvas) override {
         static const int kX = 0;
         static const int kY = 0;
@@ -112,12 +149,18 @@ protected:
     }
 
 private:
+    // One 256x256 pass is about where splitting starts to beat the cost of waking the pool.
+    static constexpr size_t kParallelThreshold = 256 * 256;
 
     SkString fName;
     bool fIsSmall;
     bool fIsCropped;
     bool fIsExpanded;
+    bool fIsHuge;
+    bool fIsParallel;
     bool fInitialized;
+    std::unique_ptr<SkExecutor> fExecutor;
+    size_t fOldThreshold = 0;
     sk_sp<SkImage> fCheckerboard;
     SkScalar fSigmaX, fSigmaY;
     using INHERITED = Benchmark;
@@ -161,3 +204,12 @@ DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE, tr
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE, false, true, true);)
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, true, true, true);)
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, false, true, true);)
+
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE,
+                                          false, false, false, true, false);)
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE,
+                                          false, false, false, true, true);)
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE,
+                                          false, false, false, true, false);)
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE,
+                                          false, false, false, true, true);)
@@ -15,13 +15,20 @@
 #include "include/core/SkString.h"
 #include "src/base/SkAutoMalloc.h"
 
+#include <memory>
+
+class SkExecutor;
+
 /**
- *  Time SkCodec.
+ *  Time SkCodec.  If threaded, the codec may decode parts of the image concurrently on a thread
+ *  pool.
  */
 class CodecBench : public Benchmark {
 public:
     // Calls encoded->ref()
-    CodecBench(SkString basename, SkData* encoded, SkColorType colorType, SkAlphaType alphaType);
+    CodecBench(SkString basename, SkData* encoded, SkColorType colorType, SkAlphaType alphaType,
+               bool threaded = false);
+    ~CodecBench() override;
 
 protected:
     const char* onGetName() override;
@@ -33,7 +40,9 @@ private:
     SkString                fName;
     const SkColorType       fColorType;
     const SkAlphaType       fAlphaType;
+    const bool              fThreaded;
     sk_sp<SkData>           fData;
+    std::unique_ptr<SkExecutor> fExecutor;  // Set in onDelayedSetup if fThreaded.
     SkImageInfo             fInfo;          // Set in onDelayedSetup.
     SkAutoMalloc            fPixelStorage;
     using INHERITED = Benchmark;
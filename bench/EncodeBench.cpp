@@ -7,12 +7,16 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/encode/SkPngEncoder.h"
 #include "include/encode/SkWebpEncoder.h"
 #include "tools/DecodeUtils.h"
 
+#include <memory>
+
 // Like other Benchmark subclasses, Encoder benchmarks are run by:
 // nanobench --match ^Encode_
 //
@@ -123,3 +127,51 @@ DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 3), "PNG_3n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 1), "PNG_1n"));
 
 #undef PNG
+
+// Encodes a 4096x4096 screenshot-sized image (the 512x512 mandrill, scaled up) as PNG across a
+// pool of `threads` threads, or serially if `threads` is zero.  Divide the pixel count by the
+// time per loop for throughput at each core count.
+class PngParallelEncodeBench : public Benchmark {
+public:
+    explicit PngParallelEncodeBench(int threads)
+        : fThreads(threads)
+        , fName(threads ? SkStringPrintf("Encode_png_parallel_%dthreads", threads)
+                        : SkString("Encode_png_parallel_serial")) {}
+
+    bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        SkBitmap source;
+        SkAssertResult(ToolUtils::GetResourceAsBitmap(srcs[0], &source));
+        fBitmap.allocN32Pixels(4096, 4096);
+        SkCanvas canvas(fBitmap);
+        canvas.scale(8, 8);
+        canvas.drawImage(source.asImage(), 0, 0, SkSamplingOptions(SkFilterMode::kLinear));
+        if (fThreads) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkPngEncoder::Options opts;
+        opts.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            SkNullWStream dst;
+            SkAssertResult(SkPngEncoder::Encode(&dst, fBitmap.pixmap(), opts));
+        }
+    }
+
+private:
+    const int                   fThreads;
+    SkString                    fName;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+DEF_BENCH(return new PngParallelEncodeBench(0));
+DEF_BENCH(return new PngParallelEncodeBench(1));
+DEF_BENCH(return new PngParallelEncodeBench(2));
+DEF_BENCH(return new PngParallelEncodeBench(4));
+DEF_BENCH(return new PngParallelEncodeBench(8));
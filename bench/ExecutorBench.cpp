@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkString.h"
+#include "src/core/SkTaskGroup.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Compares the thread pools SkExecutor offers on many small tasks:
+//   - flat:    one SkTaskGroup fans out kTasks tasks, as SkPDF does for its objects.
+//   - nested:  each task fans out its own SkTaskGroup and waits on it.
+//   - latency: a single task is added to an idle pool and we spin until it has run.  nanobench's
+//              per-sample spread (max, stddev) is the interesting number here.
+enum class PoolType { kFIFO, kLIFO, kWorkStealing };
+enum class Load { kFlat, kNested, kLatency };
+
+class ExecutorBench : public Benchmark {
+public:
+    ExecutorBench(PoolType type, Load load) : fType(type), fLoad(load) {
+        static const char* kTypeNames[] = {"fifo", "lifo", "stealing"};
+        static const char* kLoadNames[] = {"flat", "nested", "latency"};
+        fName.printf("executor_%s_%s", kTypeNames[(int)type], kLoadNames[(int)load]);
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == Backend::kNonRendering;
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        switch (fType) {
+            case PoolType::kFIFO:
+                fExecutor = SkExecutor::MakeFIFOThreadPool();
+                break;
+            case PoolType::kLIFO:
+                fExecutor = SkExecutor::MakeLIFOThreadPool();
+                break;
+            case PoolType::kWorkStealing:
+                fExecutor = SkExecutor::MakeWorkStealingThreadPool();
+                break;
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            switch (fLoad) {
+                case Load::kFlat: {
+                    SkTaskGroup tg(*fExecutor);
+                    tg.batch(kTasks, [](int j) { spin(j); });
+                    tg.wait();
+                } break;
+
+                case Load::kNested: {
+                    SkExecutor* executor = fExecutor.get();
+                    SkTaskGroup tg(*executor);
+                    tg.batch(kNestedTasks, [executor](int) {
+                        SkTaskGroup inner(*executor);
+                        inner.batch(kNestedTasks, [](int j) { spin(j); });
+                        inner.wait();
+                    });
+                    tg.wait();
+                } break;
+
+                case Load::kLatency: {
+                    // Don't borrow: that would run the task on this thread.
+                    std::atomic<bool> ran{false};
+                    fExecutor->add([&ran] { ran.store(true, std::memory_order_release); });
+                    while (!ran.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                } break;
+            }
+        }
+    }
+
+private:
+    static constexpr int kTasks = 1024;
+    static constexpr int kNestedTasks = 32;
+
+    // A few hundred nanoseconds of work the compiler can't skip.
+    static void spin(int seed) {
+        uint32_t x = seed;
+        for (int k = 0; k < 64; k++) {
+            x = x * 1664525u + 1013904223u;
+        }
+        gSink.store(x, std::memory_order_relaxed);
+    }
+    static std::atomic<uint32_t> gSink;
+
+    const PoolType              fType;
+    const Load                  fLoad;
+    SkString                    fName;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+std::atomic<uint32_t> ExecutorBench::gSink{0};
+
+DEF_BENCH( return new ExecutorBench(PoolType::kFIFO,         Load::kFlat); )
+DEF_BENCH( return new ExecutorBench(PoolType::kLIFO,         Load::kFlat); )
+DEF_BENCH( return new ExecutorBench(PoolType::kWorkStealing, Load::kFlat); )
+
+DEF_BENCH( return new ExecutorBench(PoolType::kFIFO,         Load::kNested); )
+DEF_BENCH( return new ExecutorBench(PoolType::kLIFO,         Load::kNested); )
+DEF_BENCH( return new ExecutorBench(PoolType::kWorkStealing, Load::kNested); )
+
+DEF_BENCH( return new ExecutorBench(PoolType::kFIFO,         Load::kLatency); )
+DEF_BENCH( return new ExecutorBench(PoolType::kLIFO,         Load::kLatency); )
+DEF_BENCH( return new ExecutorBench(PoolType::kWorkStealing, Load::kLatency); )
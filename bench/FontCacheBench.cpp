@@ -7,14 +7,29 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
+#include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkString.h"
+#include "include/core/SkSurfaceProps.h"
+#include "include/core/SkTypeface.h"
 #include "include/private/base/SkTemplates.h"
+#include "include/private/base/SkTo.h"
 #include "src/core/SkChecksum.h"
+#include "src/core/SkGlyph.h"
+#include "src/core/SkScalerContext.h"
+#include "src/core/SkStrike.h"
+#include "src/core/SkStrikeCache.h"
+#include "src/core/SkStrikeSpec.h"
 #include "tools/fonts/FontToolUtils.h"
 
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include "bench/gUniqueGlyphIDs.h"
 
 #define gUniqueGlyphIDs_Sentinel    0xFFFF
@@ -54,6 +69,54 @@ private:
     using INHERITED = Benchmark;
 };
 
+// Makes the images of many glyphs in a new strike each loop, as the first draw of a page of CJK
+// text does, either one at a time or in parallel on an executor. Run with --nativeFonts to measure
+// the platform's scaler, e.g. FreeType, which gives each task a face of its own.
+class FontCacheColdBench : public Benchmark {
+public:
+    explicit FontCacheColdBench(bool parallel) : fParallel(parallel) {
+        fName.printf("fontcache_cold%s", parallel ? "_parallel" : "");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
+
+    void onDelayedSetup() override {
+        if (fParallel) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool();
+        }
+        SkFont font = ToolUtils::DefaultFont();
+        font.setSize(48);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        fStrikeSpec.emplace(SkStrikeSpec::MakeMask(font, SkPaint(), SkSurfaceProps(),
+                                                   SkScalerContextFlags::kNone, SkMatrix::I()));
+        const int glyphCount = std::min(font.getTypeface()->countGlyphs(), 1024);
+        for (int i = 0; i < glyphCount; ++i) {
+            fPackedIDs.push_back(SkPackedGlyphID{SkTo<SkGlyphID>(i)});
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        std::vector<const SkGlyph*> glyphs(fPackedIDs.size());
+        for (int i = 0; i < loops; ++i) {
+            SkStrikeCache cache;
+            sk_sp<SkStrike> strike = fStrikeSpec->findOrCreateStrike(&cache);
+            strike->prepareImages(fPackedIDs, glyphs.data(), fExecutor.get());
+        }
+    }
+
+private:
+    const bool fParallel;
+    SkString fName;
+    std::unique_ptr<SkExecutor> fExecutor;
+    std::optional<SkStrikeSpec> fStrikeSpec;
+    std::vector<SkPackedGlyphID> fPackedIDs;
+};
+DEF_BENCH( return new FontCacheColdBench(false); )
+DEF_BENCH( return new FontCacheColdBench(true); )
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static uint32_t rotr(uint32_t value, unsigned bits) {
@@ -7,6 +7,7 @@
 
 #include "bench/Benchmark.h"
 #include "src/core/SkResourceCache.h"
+#include "src/core/SkTaskGroup.h"
 
 namespace {
 static void* gGlobalAddress;
@@ -14,8 +15,8 @@ class TestKey : public SkResourceCache::Key {
 public:
     intptr_t fValue;
 
-    TestKey(intptr_t value) : fValue(value) {
-        this->init(&gGlobalAddress, 0, sizeof(fValue));
+    TestKey(intptr_t value, uint64_t sharedID = 0) : fValue(value) {
+        this->init(&gGlobalAddress, sharedID, sizeof(fValue));
     }
 };
 struct TestRec : public SkResourceCache::Rec {
@@ -74,4 +75,55 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Many threads finding (and now and then adding) recs in the global cache at once.
+class ContendedImageCacheBench : public Benchmark {
+    static constexpr uint64_t kSharedID = 0x1ACE;
+    static constexpr int      kKeyCount = 4096;
+
+    const int fThreads;
+    SkString  fName;
+
+public:
+    ContendedImageCacheBench(int threads) : fThreads(threads) {
+        fName.printf("imagecache_contended_%d", threads);
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onPerCanvasPreDraw(SkCanvas*) override {
+        for (int i = 0; i < kKeyCount; ++i) {
+            SkResourceCache::Add(new TestRec(TestKey(i, kSharedID), i));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkTaskGroup().batch(fThreads, [&](int threadIndex) {
+            // Each thread walks the keys in its own order; about 1 in 8 is not in the cache.
+            intptr_t value = threadIndex * 977;
+            for (int i = 0; i < loops; ++i) {
+                value = (value + 7919) % (kKeyCount + kKeyCount / 8);
+                TestKey key(value, kSharedID);
+                if (!SkResourceCache::Find(key, TestRec::Visitor, nullptr) && value < kKeyCount) {
+                    SkResourceCache::Add(new TestRec(key, value));
+                }
+            }
+        });
+    }
+
+    void onPerCanvasPostDraw(SkCanvas*) override {
+        SkResourceCache::PostPurgeSharedID(kSharedID);
+        SkResourceCache::CheckMessages();
+    }
+
+private:
+    using INHERITED = Benchmark;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 DEF_BENCH( return new ImageCacheBench(); )
+DEF_BENCH( return new ContendedImageCacheBench(1); )
+DEF_BENCH( return new ContendedImageCacheBench(32); )
@@ -10,6 +10,7 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
 #include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkPixmap.h"
@@ -19,6 +20,7 @@
 #include "include/private/base/SkTo.h"
 #include "src/base/SkRandom.h"
 #include "src/core/SkAutoPixmapStorage.h"
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFUnion.h"
 #include "src/utils/SkFloatToDecimal.h"
 #include "tools/DecodeUtils.h"
@@ -189,6 +191,47 @@ private:
     std::unique_ptr<SkStreamAsset> fAsset;
 };
 
+/** Deflates a 1.2MB PDF command stream (16 copies of the one above), either serially or in
+    blocks spread across a thread pool. */
+class PDFDeflateBench : public Benchmark {
+public:
+    PDFDeflateBench(bool chunked) : fChunked(chunked) {}
+
+protected:
+    const char* onGetName() override {
+        return fChunked ? "PDFDeflate_chunked" : "PDFDeflate_serial";
+    }
+    bool isSuitableFor(Backend backend) override {
+        return backend == Backend::kNonRendering;
+    }
+    void onDelayedSetup() override {
+        sk_sp<SkData> commands = GetResourceAsData("pdf_command_stream.txt");
+        SkDynamicMemoryWStream input;
+        for (int i = 0; commands && i < 16; ++i) {
+            input.write(commands->data(), commands->size());
+        }
+        fInput = input.detachAsData();
+        if (fChunked) {
+            fExecutor = SkExecutor::MakeWorkStealingThreadPool();
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        SkDeflateWStream::Options options;
+        options.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            SkNullWStream wStream;
+            SkDeflateWStream deflateWStream(&wStream, options);
+            deflateWStream.write(fInput->data(), fInput->size());
+            deflateWStream.finalize();
+        }
+    }
+
+private:
+    const bool fChunked;
+    sk_sp<SkData> fInput;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
 struct PDFColorComponentBench : public Benchmark {
     bool isSuitableFor(Backend b) override {
         return b == Backend::kNonRendering;
@@ -307,14 +350,68 @@ struct PDFClipPathBenchmark : public Benchmark {
     }
 };
 
+// Writes a long document with a different image on every page, with pages and images queued on
+// a thread pool. Without streaming, every page dict is kept until close() and images pile up
+// waiting for the pool; with streaming and a memory budget, neither should grow with the page
+// count. nanobench's own memory reporting is process-wide, so run each variant alone
+// (--match PDFStreaming_off$ or PDFStreaming_on$) to compare them.
+class PDFStreamingBench : public Benchmark {
+public:
+    PDFStreamingBench(bool streaming) : fStreaming(streaming) {}
+
+protected:
+    const char* onGetName() override {
+        return fStreaming ? "PDFStreaming_on" : "PDFStreaming_off";
+    }
+    bool isSuitableFor(Backend backend) override {
+        return backend == Backend::kNonRendering;
+    }
+    void onDelayedSetup() override {
+        fExecutor = SkExecutor::MakeFIFOThreadPool();
+        fBitmap.allocN32Pixels(256, 256);
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        SkFont font = ToolUtils::DefaultFont();
+        while (loops-- > 0) {
+            SkNullWStream nullStream;
+            SkPDF::Metadata metadata;
+            metadata.fExecutor = fExecutor.get();
+            metadata.fStreaming = fStreaming;
+            metadata.fMemoryBudget = fStreaming ? 16 << 20 : 0;
+            metadata.jpegDecoder = SkPDF::JPEG::Decode;
+            metadata.jpegEncoder = SkPDF::JPEG::Encode;
+            auto doc = SkPDF::MakeDocument(&nullStream, metadata);
+            for (int i = 0; i < kPageCount; ++i) {
+                fBitmap.eraseColor(SkColorSetRGB(i, i >> 8, 0x80));
+                SkCanvas* canvas = doc->beginPage(612, 792);
+                canvas->drawImage(fBitmap.asImage(), 36, 36);
+                canvas->drawString(SkStringPrintf("Page %d", i), 36, 320, font, SkPaint());
+                doc->endPage();
+            }
+            doc->close();
+        }
+    }
+
+private:
+    static constexpr int kPageCount = 2000;
+
+    const bool fStreaming;
+    std::unique_ptr<SkExecutor> fExecutor;
+    SkBitmap fBitmap;
+};
+
 }  // namespace
 DEF_BENCH(return new PDFImageBench;)
 DEF_BENCH(return new PDFJpegImageBench;)
 DEF_BENCH(return new PDFCompressionBench;)
+DEF_BENCH(return new PDFDeflateBench(false);)
+DEF_BENCH(return new PDFDeflateBench(true);)
 DEF_BENCH(return new PDFColorComponentBench;)
 DEF_BENCH(return new PDFShaderBench;)
 DEF_BENCH(return new WritePDFTextBenchmark;)
 DEF_BENCH(return new PDFClipPathBenchmark;)
+DEF_BENCH(return new PDFStreamingBench(false);)
+DEF_BENCH(return new PDFStreamingBench(true);)
 
 #ifdef SK_PDF_ENABLE_SLOW_TESTS
 #include "include/core/SkExecutor.h"
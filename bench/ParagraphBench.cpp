@@ -14,6 +14,8 @@
 #include "tools/Resources.h"
 #include "tools/fonts/FontToolUtils.h"
 
+#include <cstring>
+
 #if defined(SK_ENABLE_PARAGRAPH)
 
 #include "modules/skparagraph/include/FontCollection.h"
@@ -21,14 +23,27 @@
 #include "modules/skparagraph/include/ParagraphStyle.h"
 
 class ParagraphBench final : public Benchmark {
+public:
+    enum class Mode {
+        kFull,       // Lay out the whole paragraph again after markDirty()
+        kWidthOnly,  // Only break and format the text again for a new width
+        kEdit,       // Insert or delete a letter in a text of many styles
+    };
+
+private:
+    Mode fMode;
     SkString fName;
     sk_sp<skia::textlayout::FontCollection> fFontCollection;
     skia::textlayout::TextStyle fTStyle;
     std::unique_ptr<skia::textlayout::Paragraph> fParagraph;
+    size_t fEditAt = 0;
+    bool fInserted = false;
 
 public:
-    ParagraphBench() {
-        fName.printf("skparagraph");
+    explicit ParagraphBench(Mode mode) : fMode(mode) {
+        fName.printf("skparagraph%s", mode == Mode::kWidthOnly ? "_width"
+                                    : mode == Mode::kEdit      ? "_edit"
+                                                               : "");
     }
 
 protected:
@@ -73,9 +88,28 @@ protected:
             return;
         }
 
-        builder->pushStyle(fTStyle);
-        builder->addText(text);
-        builder->pop();
+        if (fMode == Mode::kEdit) {
+            // Every sentence in its own style, as in a document with a lot of emphasis.
+            // Edits are shaped again, so the paragraph cache must not remember them.
+            fFontCollection->getParagraphCache()->turnOn(false);
+            skia::textlayout::TextStyle bold(fTStyle);
+            bold.setFontStyle(SkFontStyle::Bold());
+            bool isBold = false;
+            for (const char* sentence = text; *sentence;) {
+                const char* end = strchr(sentence, '.');
+                size_t length = end ? end - sentence + 1 : strlen(sentence);
+                builder->pushStyle(isBold ? bold : fTStyle);
+                builder->addText(sentence, length);
+                builder->pop();
+                sentence += length;
+                isBold = !isBold;
+            }
+            fEditAt = strlen(text) / 2;
+        } else {
+            builder->pushStyle(fTStyle);
+            builder->addText(text);
+            builder->pop();
+        }
         fParagraph = builder->Build();
 
         // Call onDraw once to warm up the glyph cache otherwise nanobench will mis-calculate the
@@ -86,8 +120,24 @@ protected:
 
     void onDraw(int loops, SkCanvas* canvas) override {
         for (int i = 0; i < loops; ++i) {
-            fParagraph->markDirty();
-            fParagraph->layout(300);
+            switch (fMode) {
+                case Mode::kFull:
+                    fParagraph->markDirty();
+                    fParagraph->layout(300);
+                    break;
+                case Mode::kWidthOnly:
+                    fParagraph->layout(i % 2 ? 300 : 301);
+                    break;
+                case Mode::kEdit:
+                    if (fInserted) {
+                        fParagraph->updateText(fEditAt, fEditAt + 1, SkString());
+                    } else {
+                        fParagraph->updateText(fEditAt, fEditAt, SkString("x"));
+                    }
+                    fInserted = !fInserted;
+                    fParagraph->layout(300);
+                    break;
+            }
         }
     }
 
@@ -95,6 +145,8 @@ private:
     using INHERITED = Benchmark;
 };
 
-DEF_BENCH( return new ParagraphBench; )
+DEF_BENCH( return new ParagraphBench(ParagraphBench::Mode::kFull); )
+DEF_BENCH( return new ParagraphBench(ParagraphBench::Mode::kWidthOnly); )
+DEF_BENCH( return new ParagraphBench(ParagraphBench::Mode::kEdit); )
 
 #endif // SK_ENABLE_PARAGRAPH
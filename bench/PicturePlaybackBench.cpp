@@ -10,7 +10,9 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkData.h"
 #include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkPoint.h"
@@ -98,3 +100,105 @@ DEF_BENCH( return new TiledPlaybackBench(kNone,     kRandom); )
 DEF_BENCH( return new TiledPlaybackBench(kNone,     kTiled ); )
 DEF_BENCH( return new TiledPlaybackBench(kRTree,    kRandom); )
 DEF_BENCH( return new TiledPlaybackBench(kRTree,    kTiled ); )
+
+// Measures how long it takes to load a serialized picture, copying it into an SkRecord or
+// referring to the serialized data in place.
+class PictureLoadBench : public Benchmark {
+public:
+    PictureLoadBench(bool withoutCopy)
+        : fWithoutCopy(withoutCopy)
+        , fName(withoutCopy ? "picture_load_without_copy" : "picture_load_copy") {}
+
+    bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(1024, 1024);
+            SkRandom rand;
+            for (int i = 0; i < 10000; i++) {
+                SkScalar x = rand.nextRangeScalar(0, 1024),
+                         y = rand.nextRangeScalar(0, 1024),
+                         w = rand.nextRangeScalar(0, 128),
+                         h = rand.nextRangeScalar(0, 128);
+                SkPaint paint;
+                paint.setColor(rand.nextU());
+                if (i % 4 == 0) {
+                    canvas->drawPath(SkPath::Oval(SkRect::MakeXYWH(x,y,w,h)), paint);
+                } else {
+                    canvas->drawRect(SkRect::MakeXYWH(x,y,w,h), paint);
+                }
+            }
+        fData = recorder.finishRecordingAsPicture()->serialize();
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            sk_sp<SkPicture> pic = fWithoutCopy ? SkPicture::MakeFromDataWithoutCopy(fData)
+                                                : SkPicture::MakeFromData(fData.get());
+            SkASSERT(pic);
+        }
+    }
+
+private:
+    bool          fWithoutCopy;
+    SkString      fName;
+    sk_sp<SkData> fData;
+};
+
+DEF_BENCH( return new PictureLoadBench(false); )
+DEF_BENCH( return new PictureLoadBench(true);  )
+
+// Draws small viewports of a large picture loaded with MakeFromDataWithoutCopy(). With a BBH,
+// the serialized op bounds let playback skip the ops outside each viewport.
+class ViewportPlaybackBench : public Benchmark {
+public:
+    ViewportPlaybackBench(BBH bbh)
+        : fBBH(bbh)
+        , fName(bbh == kRTree ? "picture_viewport_playback_rtree"
+                              : "picture_viewport_playback_none") {}
+
+    const char* onGetName() override { return fName.c_str(); }
+    SkISize onGetSize() override { return SkISize::Make(256, 256); }
+
+    void onDelayedSetup() override {
+        SkRTreeFactory factory;
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(kSize, kSize, fBBH == kRTree ? &factory
+                                                                                 : nullptr);
+            SkRandom rand;
+            for (int i = 0; i < 50000; i++) {
+                SkScalar x = rand.nextRangeScalar(0, kSize),
+                         y = rand.nextRangeScalar(0, kSize),
+                         w = rand.nextRangeScalar(0, 64),
+                         h = rand.nextRangeScalar(0, 64);
+                SkPaint paint;
+                paint.setColor(rand.nextU());
+                paint.setAlpha(0xFF);
+                canvas->drawRect(SkRect::MakeXYWH(x,y,w,h), paint);
+            }
+        fPic = SkPicture::MakeFromDataWithoutCopy(
+                recorder.finishRecordingAsPicture()->serialize());
+        SkASSERT(fPic);
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkRandom rand;
+        for (int i = 0; i < loops; i++) {
+            SkAutoCanvasRestore acr(canvas, true);
+            canvas->translate(-rand.nextRangeScalar(0, kSize - 256),
+                              -rand.nextRangeScalar(0, kSize - 256));
+            fPic->playback(canvas);
+        }
+    }
+
+private:
+    inline static constexpr SkScalar kSize = 8192;
+
+    BBH              fBBH;
+    SkString         fName;
+    sk_sp<SkPicture> fPic;
+};
+
+DEF_BENCH( return new ViewportPlaybackBench(kNone);  )
+DEF_BENCH( return new ViewportPlaybackBench(kRTree); )
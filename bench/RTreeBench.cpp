@@ -6,10 +6,12 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/core/SkBBHFactory.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkString.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkRandom.h"
+#include "src/core/SkPackedRTree.h"
 #include "src/core/SkRTree.h"
 
 using namespace skia_private;
@@ -22,11 +24,19 @@ static const int GRID_WIDTH = 100;
 
 typedef SkRect (*MakeRectProc)(SkRandom&, int, int);
 
+static sk_sp<SkBBoxHierarchy> make_tree(bool packed) {
+    if (packed) {
+        return sk_make_sp<SkPackedRTree>();
+    }
+    return sk_make_sp<SkRTree>();
+}
+
 // Time how long it takes to build an R-Tree.
 class RTreeBuildBench : public Benchmark {
 public:
-    RTreeBuildBench(const char* name, MakeRectProc proc) : fProc(proc) {
-        fName.printf("rtree_%s_build", name);
+    RTreeBuildBench(const char* name, MakeRectProc proc, bool packed = false)
+            : fProc(proc), fPacked(packed) {
+        fName.printf("%srtree_%s_build", packed ? "packed_" : "", name);
     }
 
     bool isSuitableFor(Backend backend) override {
@@ -45,12 +55,12 @@ protected:
         }
 
         for (int i = 0; i < loops; ++i) {
-            SkRTree tree;
-            tree.insert(rects.data(), NUM_BUILD_RECTS);
+            make_tree(fPacked)->insert(rects.data(), NUM_BUILD_RECTS);
         }
     }
 private:
     MakeRectProc fProc;
+    bool fPacked;
     SkString fName;
     using INHERITED = Benchmark;
 };
@@ -58,8 +68,9 @@ private:
 // Time how long it takes to perform queries on an R-Tree.
 class RTreeQueryBench : public Benchmark {
 public:
-    RTreeQueryBench(const char* name, MakeRectProc proc) : fProc(proc) {
-        fName.printf("rtree_%s_query", name);
+    RTreeQueryBench(const char* name, MakeRectProc proc, bool packed = false)
+            : fTree(make_tree(packed)), fProc(proc) {
+        fName.printf("%srtree_%s_query", packed ? "packed_" : "", name);
     }
 
     bool isSuitableFor(Backend backend) override {
@@ -75,7 +86,7 @@ protected:
         for (int i = 0; i < NUM_QUERY_RECTS; ++i) {
             rects[i] = fProc(rand, i, NUM_QUERY_RECTS);
         }
-        fTree.insert(rects.data(), NUM_QUERY_RECTS);
+        fTree->insert(rects.data(), NUM_QUERY_RECTS);
     }
 
     void onDraw(int loops, SkCanvas* canvas) override {
@@ -87,16 +98,72 @@ protected:
             query.fTop    = rand.nextRangeF(0, GENERATE_EXTENTS);
             query.fRight  = query.fLeft + 1 + rand.nextRangeF(0, GENERATE_EXTENTS/2);
             query.fBottom = query.fTop  + 1 + rand.nextRangeF(0, GENERATE_EXTENTS/2);
-            fTree.search(query, &hits);
+            fTree->search(query, &hits);
         }
     }
 private:
-    SkRTree fTree;
+    sk_sp<SkBBoxHierarchy> fTree;
     MakeRectProc fProc;
     SkString fName;
     using INHERITED = Benchmark;
 };
 
+// Time how long it takes to find what intersects each tile of a grid covering an R-Tree.
+class RTreeTileQueryBench : public Benchmark {
+public:
+    RTreeTileQueryBench(const char* name, MakeRectProc proc, bool packed, bool batched)
+            : fTree(make_tree(packed)), fProc(proc), fBatched(batched) {
+        fName.printf("%srtree_%s_tile_query%s", packed ? "packed_" : "", name,
+                     batched ? "_batched" : "");
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == Backend::kNonRendering;
+    }
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+    void onDelayedSetup() override {
+        SkRandom rand;
+        AutoTArray<SkRect> rects(NUM_QUERY_RECTS);
+        for (int i = 0; i < NUM_QUERY_RECTS; ++i) {
+            rects[i] = fProc(rand, i, NUM_QUERY_RECTS);
+        }
+        fTree->insert(rects.data(), NUM_QUERY_RECTS);
+
+        const SkScalar tile = GENERATE_EXTENTS / TILES_PER_SIDE;
+        for (int y = 0; y < TILES_PER_SIDE; ++y) {
+            for (int x = 0; x < TILES_PER_SIDE; ++x) {
+                fTiles[y * TILES_PER_SIDE + x] = SkRect::MakeXYWH(x * tile, y * tile, tile, tile);
+            }
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; ++i) {
+            std::vector<int> hits[NUM_TILES];
+            if (fBatched) {
+                fTree->search(fTiles, NUM_TILES, hits);
+            } else {
+                for (int t = 0; t < NUM_TILES; ++t) {
+                    fTree->search(fTiles[t], &hits[t]);
+                }
+            }
+        }
+    }
+private:
+    static constexpr int TILES_PER_SIDE = 8;
+    static constexpr int NUM_TILES = TILES_PER_SIDE * TILES_PER_SIDE;
+
+    sk_sp<SkBBoxHierarchy> fTree;
+    SkRect fTiles[NUM_TILES];
+    MakeRectProc fProc;
+    bool fBatched;
+    SkString fName;
+    using INHERITED = Benchmark;
+};
+
 static inline SkRect make_XYordered_rects(SkRandom& rand, int index, int numRects) {
     SkRect out;
     out.fLeft   = SkIntToScalar(index % GRID_WIDTH);
@@ -138,3 +205,17 @@ DEF_BENCH(return new RTreeQueryBench("XY", &make_XYordered_rects));
 DEF_BENCH(return new RTreeQueryBench("YX", &make_YXordered_rects));
 DEF_BENCH(return new RTreeQueryBench("random", &make_random_rects));
 DEF_BENCH(return new RTreeQueryBench("concentric", &make_concentric_rects));
+
+DEF_BENCH(return new RTreeBuildBench("XY", &make_XYordered_rects, true));
+DEF_BENCH(return new RTreeBuildBench("YX", &make_YXordered_rects, true));
+DEF_BENCH(return new RTreeBuildBench("random", &make_random_rects, true));
+DEF_BENCH(return new RTreeBuildBench("concentric", &make_concentric_rects, true));
+
+DEF_BENCH(return new RTreeQueryBench("XY", &make_XYordered_rects, true));
+DEF_BENCH(return new RTreeQueryBench("YX", &make_YXordered_rects, true));
+DEF_BENCH(return new RTreeQueryBench("random", &make_random_rects, true));
+DEF_BENCH(return new RTreeQueryBench("concentric", &make_concentric_rects, true));
+
+DEF_BENCH(return new RTreeTileQueryBench("random", &make_random_rects, false, false));
+DEF_BENCH(return new RTreeTileQueryBench("random", &make_random_rects, true, false));
+DEF_BENCH(return new RTreeTileQueryBench("random", &make_random_rects, true, true));
@@ -9,21 +9,40 @@
 #include "tools/Resources.h"
 #include "tools/fonts/FontToolUtils.h"
 
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+#include "modules/skshaper/include/SkShaper_harfbuzz.h"
+#endif
+
 #include <cfloat>
+#include <string>
+#include <vector>
 
 namespace {
 struct ShaperBench : public Benchmark {
-    ShaperBench(const char* r, const char* n) : fResource(r), fName(n) {}
+    ShaperBench(const char* r, const char* n, bool cached = true)
+        : fResource(r), fName(n), fCached(cached) {}
     std::unique_ptr<SkShaper> fShaper;
     sk_sp<SkData> fData;
     const char* fResource;
     const char* fName;
+    const bool fCached;
+    size_t fLimit = 0;
     const char* onGetName() override { return fName; }
     bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
     void onDelayedSetup() override {
         fShaper = SkShaper::Make();
         fData = GetResourceAsData(fResource);
     }
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+    // Without the HarfBuzz run cache every loop shapes all of the text again.
+    void onPreDraw(SkCanvas*) override {
+        fLimit = SkShapers::HB::GetRunCacheLimit();
+        if (!fCached) {
+            SkShapers::HB::SetRunCacheLimit(0);
+        }
+    }
+    void onPostDraw(SkCanvas*) override { SkShapers::HB::SetRunCacheLimit(fLimit); }
+#endif
     void onDraw(int loops, SkCanvas*) override {
         if (!fData || !fShaper) { return; }
         SkFont font = ToolUtils::DefaultFont();
@@ -36,8 +55,68 @@ struct ShaperBench : public Benchmark {
         }
     }
 };
+
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+// Shapes each word of the text on its own, as a UI does its labels, with the HarfBuzz run cache at
+// its default limit or off. Most words come up many times, so with the cache most of them are not
+// shaped again.
+struct ShaperWordsBench : public Benchmark {
+    ShaperWordsBench(const char* r, bool cached)
+        : fResource(r)
+        , fCached(cached)
+        , fName(cached ? "shaper_words_cached" : "shaper_words_uncached") {}
+    std::unique_ptr<SkShaper> fShaper;
+    std::vector<std::string> fWords;
+    const char* fResource;
+    const bool fCached;
+    const char* fName;
+    size_t fLimit = 0;
+    const char* onGetName() override { return fName; }
+    bool isSuitableFor(Backend backend) override { return backend == Backend::kNonRendering; }
+    void onDelayedSetup() override {
+        fShaper = SkShaper::Make();
+        if (sk_sp<SkData> data = GetResourceAsData(fResource)) {
+            std::string word;
+            for (const char c : SkSpan((const char*)data->data(), data->size())) {
+                if (c == ' ' || c == '\n') {
+                    if (!word.empty()) {
+                        fWords.push_back(std::move(word));
+                        word.clear();
+                    }
+                } else {
+                    word.push_back(c);
+                }
+            }
+        }
+    }
+    void onPreDraw(SkCanvas*) override {
+        fLimit = SkShapers::HB::GetRunCacheLimit();
+        if (!fCached) {
+            SkShapers::HB::SetRunCacheLimit(0);
+        }
+    }
+    void onPostDraw(SkCanvas*) override { SkShapers::HB::SetRunCacheLimit(fLimit); }
+    void onDraw(int loops, SkCanvas*) override {
+        if (fWords.empty() || !fShaper) { return; }
+        SkFont font = ToolUtils::DefaultFont();
+        while (loops-- > 0) {
+            for (const std::string& word : fWords) {
+                SkTextBlobBuilderRunHandler rh(word.c_str(), {0, 0});
+                fShaper->shape(word.c_str(), word.size(), font, true, FLT_MAX, &rh);
+                (void)rh.makeBlob();
+            }
+        }
+    }
+};
+#endif  // defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
 }  // namespace
 
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+DEF_BENCH(return new ShaperWordsBench("text/english.txt", true);)
+DEF_BENCH(return new ShaperWordsBench("text/english.txt", false);)
+DEF_BENCH(return new ShaperBench("text/english.txt", "shaper_english_uncached", false);)
+#endif
+
 #define SHAPER_BENCH(X) DEF_BENCH(return new ShaperBench("text/" #X ".txt", "shaper_" #X);)
 SHAPER_BENCH(arabic)
 SHAPER_BENCH(armenian)
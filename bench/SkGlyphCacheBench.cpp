@@ -117,10 +117,61 @@ private:
     SkString fName;
 };
 
+// Many threads drawing the same text at once, so that every lookup hits the same strike, and
+// after the first loop, finds every glyph already in it.
+class SkGlyphCacheContendedHits : public Benchmark {
+public:
+    explicit SkGlyphCacheContendedHits(int threadCount) : fThreadCount(threadCount) { }
+
+protected:
+    const char* onGetName() override {
+        fName.printf("SkGlyphCacheContendedHits_%dthreads", fThreadCount);
+        return fName.c_str();
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == Backend::kNonRendering;
+    }
+
+    void onDelayedSetup() override {
+        fFont = ToolUtils::DefaultFont();
+        fFont.setEdging(SkFont::Edging::kAntiAlias);
+        fFont.setSubpixel(true);
+        fFont.setTypeface(ToolUtils::CreatePortableTypeface("serif", SkFontStyle::Italic()));
+        fFont.setSize(24);
+        for (int c = ' '; c < 'z'; c++) {
+            fGlyphs.push_back(SkPackedGlyphID{fFont.unicharToGlyph(c)});
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkPaint defaultPaint;
+        auto strikeSpec = SkStrikeSpec::MakeMask(
+                fFont, defaultPaint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+        SkTaskGroup().batch(fThreadCount, [&](int) {
+            SkBulkGlyphMetricsAndImages images{strikeSpec};
+            for (int i = 0; i < loops; i++) {
+                for (int lookups = 0; lookups < 100; lookups++) {
+                    (void)images.glyphs(fGlyphs);
+                }
+            }
+        });
+    }
+
+private:
+    const int fThreadCount;
+    SkString fName;
+    SkFont fFont;
+    std::vector<SkPackedGlyphID> fGlyphs;
+};
+
 DEF_BENCH( return new SkGlyphCacheBasic(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheBasic(32 * 1024 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(32 * 1024 * 1024); )
+DEF_BENCH( return new SkGlyphCacheContendedHits(1); )
+DEF_BENCH( return new SkGlyphCacheContendedHits(16); )
 
 namespace {
 class DiscardableManager : public SkStrikeServer::DiscardableHandleManager,
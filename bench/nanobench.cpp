@@ -28,6 +28,7 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkString.h"
@@ -41,6 +42,7 @@
 #include "src/core/SkOSFile.h"
 #include "src/core/SkTaskGroup.h"
 #include "src/core/SkTraceEvent.h"
+#include "src/image/SkSurface_Base.h"
 #include "src/utils/SkJSONWriter.h"
 #include "src/utils/SkOSPath.h"
 #include "src/utils/SkShaderUtils.h"
@@ -88,6 +90,7 @@
 
 extern bool gSkForceRasterPipelineBlitter;
 extern bool gForceHighPrecisionRasterPipeline;
+extern bool gDisableRasterPipelineFusion;
 
 #ifndef SK_BUILD_FOR_WIN
 #include <unistd.h>
@@ -149,6 +152,7 @@ static DEFINE_string(zoom, "1.0,0",
                      "Comma-separated zoomMax,zoomPeriodMs factors for a periodic SKP zoom "
                      "function that ping-pongs between 1.0 and zoomMax.");
 static DEFINE_bool(bbh, true, "Build a BBH for SKPs?");
+static DEFINE_bool(packedBBH, false, "Use SkPackedRTreeFactory for the BBH of SKPs?");
 static DEFINE_bool(loopSKP, true, "Loop SKPs like we do for micro benches?");
 static DEFINE_int(flushEvery, 10, "Flush --outResultsFile every Nth run.");
 static DEFINE_bool(gpuStats, false, "Print GPU stats after each gpu benchmark?");
@@ -164,6 +168,7 @@ static DEFINE_string(benchType,  "",
 
 static DEFINE_bool(forceRasterPipeline, false, "sets gSkForceRasterPipelineBlitter");
 static DEFINE_bool(forceRasterPipelineHP, false, "sets gSkForceRasterPipelineBlitter and gForceHighPrecisionRasterPipeline");
+static DEFINE_bool(disableRasterPipelineFusion, false, "sets gDisableRasterPipelineFusion");
 
 static DEFINE_bool2(pre_log, p, false,
                     "Log before running each test. May be incomprehensible when threading");
@@ -247,6 +252,37 @@ bool Target::capturePixels(SkBitmap* bmp) {
     return true;
 }
 
+struct TiledRasterTarget : public Target {
+    explicit TiledRasterTarget(const Config& c) : Target(c) {}
+    std::unique_ptr<SkExecutor> executor;
+
+    ~TiledRasterTarget() override {
+        // The surface borrows our executor.
+        surface.reset();
+    }
+
+    void submitFrame() override {
+        asSB(this->surface.get())->onResolveDeferredDraws();
+    }
+    void submitWorkAndSyncCPU() override {
+        asSB(this->surface.get())->onResolveDeferredDraws();
+    }
+
+    bool init(SkImageInfo info, Benchmark* bench) override {
+        // No borrowing, so exactly tiledRasterThreads threads rasterize.
+        this->executor = SkExecutor::MakeFIFOThreadPool(this->config.tiledRasterThreads,
+                                                        /*allowBorrowing=*/false);
+        this->surface = SkSurfaces::RasterTiled(info, this->executor.get());
+        return this->surface != nullptr;
+    }
+
+    bool capturePixels(SkBitmap* bmp) override {
+        // Our canvas only records, so read back through the surface.
+        bmp->allocPixels(this->surface->imageInfo());
+        return this->surface->readPixels(*bmp, 0, 0);
+    }
+};
+
 struct GPUTarget : public Target {
     explicit GPUTarget(const Config& c) : Target(c) {}
     ContextInfo contextInfo;
@@ -687,6 +723,31 @@ static std::optional<Config> create_config(const SkCommandLineConfig* config) {
 
 #undef CPU_CONFIG
 
+#define TILED_CONFIG(name, threads)                                                     \
+    if (config->getBackend().equals(name)) {                                            \
+        if (!FLAGS_cpu) {                                                               \
+            SkDebugf("Skipping config '%s' as requested.\n", config->getTag().c_str()); \
+            return std::nullopt;                                                        \
+        }                                                                               \
+        return Config{SkString(name),                                                   \
+                      Benchmark::Backend::kRaster,                                      \
+                      kN32_SkColorType,                                                 \
+                      kPremul_SkAlphaType,                                              \
+                      config->refColorSpace(),                                          \
+                      0,                                                                \
+                      kBogusContextType,                                                \
+                      kBogusContextOverrides,                                           \
+                      0,                                                                \
+                      threads};                                                         \
+    }
+
+    TILED_CONFIG("8888_tiled1", 1)
+    TILED_CONFIG("8888_tiled2", 2)
+    TILED_CONFIG("8888_tiled4", 4)
+    TILED_CONFIG("8888_tiled8", 8)
+
+#undef TILED_CONFIG
+
     SkDebugf("Unknown config '%s'.\n", config->getTag().c_str());
     return std::nullopt;
 }
@@ -737,7 +798,8 @@ static Target* is_enabled(Benchmark* bench, const Config& config) {
         break;
 #endif
     default:
-        target = new Target(config);
+        target = config.tiledRasterThreads > 0 ? new TiledRasterTarget(config)
+                                               : new Target(config);
         break;
     }
 
@@ -997,11 +1059,14 @@ public:
 
                 if (FLAGS_bbh) {
                     // The SKP we read off disk doesn't have a BBH.  Re-record so it grows one.
-                    SkRTreeFactory factory;
+                    SkRTreeFactory rtreeFactory;
+                    SkPackedRTreeFactory packedFactory;
+                    SkBBHFactory* factory = FLAGS_packedBBH ? (SkBBHFactory*)&packedFactory
+                                                            : &rtreeFactory;
                     SkPictureRecorder recorder;
                     pic->playback(recorder.beginRecording(pic->cullRect().width(),
                                                           pic->cullRect().height(),
-                                                          &factory));
+                                                          factory));
                     pic = recorder.finishRecordingAsPicture();
                 }
                 SkString name = SkOSPath::Basename(path.c_str());
@@ -1134,6 +1199,25 @@ public:
             fCurrentColorType = 0;
         }
 
+        // Run threaded CodecBenches on the formats that can decode parts of an image
+        // concurrently.
+        for (; fCurrentThreadedCodec < fImages.size(); fCurrentThreadedCodec++) {
+            fSourceType = "image";
+            fBenchType = "skcodec";
+            const SkString& path = fImages[fCurrentThreadedCodec];
+            if (CommandLineFlags::ShouldSkip(FLAGS_match, path.c_str())) {
+                continue;
+            }
+            sk_sp<SkData> encoded(SkData::MakeFromFileName(path.c_str()));
+            std::unique_ptr<SkCodec> codec(SkCodec::MakeFromData(encoded));
+            if (!codec || codec->getEncodedFormat() != SkEncodedImageFormat::kJPEG) {
+                continue;
+            }
+            fCurrentThreadedCodec++;
+            return new CodecBench(SkOSPath::Basename(path.c_str()), encoded.get(),
+                                  kN32_SkColorType, kOpaque_SkAlphaType, /*threaded=*/true);
+        }
+
         // Run AndroidCodecBenches
         const int sampleSizes[] = { 2, 4, 8 };
         for (; fCurrentAndroidCodec < fImages.size(); fCurrentAndroidCodec++) {
@@ -1193,7 +1277,7 @@ public:
 
             while (fCurrentColorType < fColorTypes.size()) {
                 while (fCurrentSampleSize < (int) std::size(brdSampleSizes)) {
-                    while (fCurrentSubsetType <= kLastSingle_SubsetType) {
+                    while (fCurrentSubsetType <= kTiles_SubsetType) {
 
                         sk_sp<SkData> encoded(SkData::MakeFromFileName(path.c_str()));
                         const SkColorType colorType = fColorTypes[fCurrentColorType];
@@ -1209,6 +1293,7 @@ public:
 
                         SkString basename = SkOSPath::Basename(path.c_str());
                         SkIRect subset;
+                        bool tiled = false;
                         const uint32_t subsetSize = sampleSize * minOutputSize;
                         switch (currentSubsetType) {
                             case kTopLeft_SubsetType:
@@ -1235,12 +1320,19 @@ public:
                                 subset = SkIRect::MakeXYWH(width - subsetSize,
                                         height - subsetSize, subsetSize, subsetSize);
                                 break;
+                            case kTiles_SubsetType:
+                                // Every tile in turn, so that codecs which index the image on
+                                // the first decode can seek straight to the later ones.
+                                basename.append("_Tiles");
+                                subset = SkIRect::MakeWH(subsetSize, subsetSize);
+                                tiled = true;
+                                break;
                             default:
                                 SkASSERT(false);
                         }
 
                         return new BitmapRegionDecoderBench(basename.c_str(), encoded.get(),
-                                colorType, sampleSize, subset);
+                                colorType, sampleSize, subset, tiled);
                     }
                     fCurrentSubsetType = 0;
                     fCurrentSampleSize++;
@@ -1282,8 +1374,9 @@ private:
         kMiddle_SubsetType      = 2,
         kBottomLeft_SubsetType  = 3,
         kBottomRight_SubsetType = 4,
-        kTranslate_SubsetType   = 5,
-        kZoom_SubsetType        = 6,
+        kTiles_SubsetType       = 5,
+        kTranslate_SubsetType   = 6,
+        kZoom_SubsetType        = 7,
         kLast_SubsetType        = kZoom_SubsetType,
         kLastSingle_SubsetType  = kBottomRight_SubsetType,
     };
@@ -1314,6 +1407,7 @@ private:
     int fCurrentSVG = 0;
     int fCurrentTextBlobTrace = 0;
     int fCurrentCodec = 0;
+    int fCurrentThreadedCodec = 0;
     int fCurrentAndroidCodec = 0;
 #ifdef SK_ENABLE_ANDROID_UTILS
     int fCurrentBRDImage = 0;
@@ -1457,6 +1551,7 @@ int main(int argc, char** argv) {
 
     gSkForceRasterPipelineBlitter     = FLAGS_forceRasterPipelineHP || FLAGS_forceRasterPipeline;
     gForceHighPrecisionRasterPipeline = FLAGS_forceRasterPipelineHP;
+    gDisableRasterPipelineFusion      = FLAGS_disableRasterPipelineFusion;
 
     // The SkSL memory benchmark must run before any GPU painting occurs. SkSL allocates memory for
     // its modules the first time they are accessed, and this test is trying to measure the size of
@@ -31,6 +31,7 @@ struct Config {
     sk_gpu_test::GrContextFactory::ContextType ctxType;
     sk_gpu_test::GrContextFactory::ContextOverrides ctxOverrides;
     uint32_t surfaceFlags;
+    int tiledRasterThreads = 0;  // If non-zero, draw through SkSurfaces::RasterTiled().
 };
 
 struct Target {
@@ -8,15 +8,20 @@
 #ifndef SkAnimatedImage_DEFINED
 #define SkAnimatedImage_DEFINED
 
+#include "include/codec/SkCodec.h"
 #include "include/codec/SkCodecAnimation.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkDrawable.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkRect.h"
 
+#include <memory>
+
 class SkAndroidCodec;
+class SkExecutor;
 class SkImage;
 class SkPicture;
+class SkTaskGroup;
 
 /**
  *  Thread unsafe drawable for drawing animated images (e.g. GIF).
@@ -123,6 +128,23 @@ public:
      */
     SkFilterMode getFilterMode() const { return fFilterMode; }
 
+    /**
+     *  Decode the frame after the current one on |executor| while the current
+     *  one is displayed, so that decodeNextFrame() can usually return it
+     *  without decoding. The executor is also passed to the codec, and while
+     *  it is set a WebP image lets libwebp filter lossy frames on a thread of
+     *  its own (SkCodec::Options::fUseWebpFilterThread).
+     *
+     *  A frame is only decoded ahead if the pixels that it may allocate (the
+     *  frame itself, plus a copy of the current frame if the next one will be
+     *  restored afterwards) fit in |memoryBudget| bytes. Otherwise the frame is
+     *  decoded by decodeNextFrame(), as without an executor.
+     *
+     *  Pass nullptr to stop prefetching. The executor must outlive this object
+     *  or the next call to this method.
+     */
+    void setPrefetchExecutor(SkExecutor* executor, size_t memoryBudget);
+
 protected:
     SkRect onGetBounds() override;
     void onDraw(SkCanvas*) override;
@@ -167,12 +189,31 @@ private:
     int                             fRepetitionsCompleted;
     SkFilterMode                    fFilterMode = SkFilterMode::kLinear;
 
+    // While a prefetch is in flight it owns fCodec, fDecodingFrame and fRestoreFrame, and reads
+    // fDisplayFrame. Anything else that touches them waits for it first.
+    SkExecutor*                     fPrefetchExecutor = nullptr;
+    size_t                          fPrefetchBudget = 0;
+    std::unique_ptr<SkTaskGroup>    fPrefetchTasks;
+
     SkAnimatedImage(std::unique_ptr<SkAndroidCodec>, const SkImageInfo& requestedInfo,
             SkIRect cropRect, sk_sp<SkPicture> postProcess);
 
     int computeNextFrame(int current, bool* animationEnded);
     double finish();
 
+    /**
+     *  Decode frameToDecode into fDecodingFrame, reusing or saving other frames as its
+     *  dependencies allow. Returns false on failure, leaving fDecodingFrame without an index.
+     */
+    bool decodeFrame(int frameToDecode, const SkCodec::FrameInfo& frameInfo);
+
+    /**
+     *  Start decoding the frame after fDisplayFrame on fPrefetchExecutor, if there is one and
+     *  the frame fits in fPrefetchBudget.
+     */
+    void startPrefetch();
+    void waitForPrefetch();
+
     /**
      *  True if there is no crop, orientation, or post decoding scaling.
      */
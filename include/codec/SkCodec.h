@@ -30,6 +30,7 @@
 #include <vector>
 
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkImage;
 class SkPngChunkReader;
@@ -334,6 +335,8 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
+            , fUseWebpFilterThread(false)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -377,6 +380,24 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, a codec that can split the image into parts which decode
+         *  independently may decode those parts concurrently on this executor.
+         *  getPixels() still returns only once the whole image is decoded.
+         *
+         *  Currently only the JPEG codec does this, for large baseline images
+         *  whose restart markers fall at the start of MCU rows.  It is ignored by
+         *  scanline and incremental decodes.
+         */
+        SkExecutor*                fExecutor;
+
+        /**
+         *  If true, the WebP codec lets libwebp run the loop filter of lossy
+         *  frames on a worker thread that libwebp creates itself, overlapping
+         *  it with decoding the next rows.  Other codecs ignore it.
+         */
+        bool                       fUseWebpFilterThread;
     };
 
     /**
@@ -1044,6 +1065,13 @@ private:
     Result handleFrameIndex(const SkImageInfo&, void* pixels, size_t rowBytes, const Options&,
                             GetPixelsCallback = nullptr);
 
+    /**
+     *  If the frame holder shares decoded frames through SkCodecFrameCache,
+     *  returns the ID to look up a complete decode with these options.
+     *  Otherwise returns 0.
+     */
+    uint64_t frameCacheID(const Options&);
+
     // Methods for scanline decoding.
     virtual Result onStartScanlineDecode(const SkImageInfo& /*dstInfo*/,
             const Options& /*options*/) {
@@ -34,6 +34,13 @@ public:
      */
     virtual void search(const SkRect& query, std::vector<int>* results) const = 0;
 
+    /**
+     * Populate results[i] with the indices of bounding boxes intersecting queries[i], for each of
+     * the N queries, e.g. all the tiles of a picture. Some hierarchies can do this faster than N
+     * calls to search().
+     */
+    virtual void search(const SkRect queries[], int N, std::vector<int> results[]) const;
+
     /**
      * Return approximate size in memory of *this.
      */
@@ -64,4 +71,14 @@ public:
     sk_sp<SkBBoxHierarchy> operator()() const override;
 };
 
+/**
+ *  Like SkRTreeFactory, but the R-Tree is packed into flat arrays that are searched with SIMD.
+ *  It takes a little longer to build, and is usually faster to search, especially for pictures
+ *  with many draws.
+ */
+class SK_API SkPackedRTreeFactory : public SkBBHFactory {
+public:
+    sk_sp<SkBBoxHierarchy> operator()() const override;
+};
+
 #endif
@@ -22,6 +22,13 @@ public:
     static std::unique_ptr<SkExecutor> MakeLIFOThreadPool(int threads = 0,
                                                           bool allowBorrowing = true);
 
+    // Like the pools above, but each thread keeps its own queue of work, so threads contend on
+    // a shared lock only for work added from outside the pool. Work added from a pool thread
+    // (e.g. by a nested SkTaskGroup) goes on that thread's queue and is run LIFO by that thread,
+    // or stolen FIFO by idle threads. Prefer this for many small, fine-grained tasks.
+    static std::unique_ptr<SkExecutor> MakeWorkStealingThreadPool(int threads = 0,
+                                                                  bool allowBorrowing = true);
+
     // There is always a default SkExecutor available by calling SkExecutor::GetDefault().
     static SkExecutor& GetDefault();
     static void SetDefault(SkExecutor*);  // Does not take ownership.  Not thread safe.
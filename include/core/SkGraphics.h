@@ -96,6 +96,25 @@ public:
      */
     static void PurgePinnedFontCache();
 
+    /**
+     *  Use the file at path to keep the glyphs of the font cache from one run
+     *  of the program to the next. Font cache entries that are not in memory
+     *  are first looked for in the file, which is memory-mapped, before their
+     *  glyphs are made by the font. Only sfnt fonts, i.e. that have a 'head'
+     *  table, are kept in the file. The file is ignored if it was written by
+     *  another version of Skia, and a strike's glyphs are if they were made by
+     *  another version of the font's scaler (e.g. of FreeType). Pass nullptr
+     *  to stop using a file.
+     */
+    static void SetFontCacheFile(const char path[]);
+
+    /**
+     *  Write the glyphs of every entry in the font cache to the file set by
+     *  SetFontCacheFile(), keeping those it already holds for other entries.
+     *  Returns false if no file is set or it could not be written.
+     */
+    static bool SaveFontCacheFile();
+
     /**
      *  This function returns the memory used for temporary images and other resources.
      */
@@ -126,6 +145,26 @@ public:
     static size_t GetResourceCacheSingleAllocationByteLimit();
     static size_t SetResourceCacheSingleAllocationByteLimit(size_t newLimit);
 
+    /**
+     *  Raster drawing with solid-color paints reuses the compiled pipelines of earlier draws with
+     *  the same blend mode into the same kind of destination, so a repeated draw only has to
+     *  update the color. These return how many pipelines have been reused from that cache, and
+     *  how many had to be compiled.
+     */
+    static size_t GetRasterPipelineCacheHits();
+    static size_t GetRasterPipelineCacheMisses();
+
+    /**
+     *  Raster gaussian blurs, from image filters and mask filters, split each of their passes into
+     *  bands of rows or columns run concurrently on SkExecutor::GetDefault() when the pass writes
+     *  at least this many pixels. Zero, the default, keeps every blur on the calling thread.
+     *
+     *  This function returns the previous setting, as if GetRasterBlurParallelThreshold() had
+     *  been called before the new threshold was set.
+     */
+    static size_t GetRasterBlurParallelThreshold();
+    static size_t SetRasterBlurParallelThreshold(size_t pixels);
+
     /**
      *  Dumps memory usage of caches using the SkTraceMemoryDump interface. See SkTraceMemoryDump
      *  for usage of this method.
@@ -87,6 +87,24 @@ public:
     static sk_sp<SkPicture> MakeFromData(const void* data, size_t size,
                                          const SkDeserialProcs* procs = nullptr);
 
+    /** Recreates SkPicture that was serialized into data, like MakeFromData(), but refers to
+        data in place where it can rather than copying from it. The drawing commands, and the
+        encoded data of images, are shared with data, which the returned SkPicture keeps alive.
+        Drawing commands are parsed each time the SkPicture is drawn, rather than once here.
+        If the picture was recorded with an SkBBHFactory, drawing it skips the commands that
+        fall outside the clip without parsing them.
+
+        Use with SkData::MakeFromFileName() to load a large picture from a memory-mapped file
+        for little more than the cost of the pages that are drawn. Pictures serialized by older
+        versions of Skia are read correctly, but may be copied.
+
+        @param data   container for serial data
+        @param procs  custom serial data decoders; may be nullptr
+        @return       SkPicture constructed from data
+    */
+    static sk_sp<SkPicture> MakeFromDataWithoutCopy(sk_sp<SkData> data,
+                                                    const SkDeserialProcs* procs = nullptr);
+
     /** \class SkPicture::AbortCallback
         AbortCallback is an abstract class. An implementation of AbortCallback may
         passed as a parameter to SkPicture::playback, to stop it before all drawing
@@ -253,12 +271,14 @@ private:
     friend class SkBigPicture;
     friend class SkEmptyPicture;
     friend class SkPicturePriv;
+    friend class SkPlaybackPicture;
 
     void serialize(SkWStream*, const SkSerialProcs*, class SkRefCntSet* typefaces,
         bool textBlobsOnly=false) const;
     static sk_sp<SkPicture> MakeFromStreamPriv(SkStream*, const SkDeserialProcs*,
                                                class SkTypefacePlayback*,
-                                               int recursionLimit);
+                                               int recursionLimit,
+                                               bool shareStreamData = false);
     friend class SkPictureData;
 
     /** Return true if the SkStream/Buffer represents a serialized picture, and
@@ -275,6 +295,8 @@ private:
 
     // Returns NULL if this is not an SkBigPicture.
     virtual const class SkBigPicture* asSkBigPicture() const { return nullptr; }
+    // Returns NULL if this is not an SkPlaybackPicture.
+    virtual const class SkPlaybackPicture* asSkPlaybackPicture() const { return nullptr; }
 
     static bool IsValidPictInfo(const struct SkPictInfo& info);
     static sk_sp<SkPicture> Forwardport(const struct SkPictInfo&,
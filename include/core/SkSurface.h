@@ -30,6 +30,7 @@ class SkBitmap;
 class SkCanvas;
 class SkCapabilities;
 class SkColorSpace;
+class SkExecutor;
 class SkPaint;
 class SkSurface;
 struct SkIRect;
@@ -82,6 +83,33 @@ inline sk_sp<SkSurface> Raster(const SkImageInfo& imageInfo,
     return Raster(imageInfo, 0, props);
 }
 
+/** Allocates raster SkSurface whose SkCanvas records draws instead of executing them immediately.
+    Recorded draws are played back into the surface's pixels whenever those are needed: when a
+    snapshot is made, when pixels are peeked, read or written, or when the surface is drawn.
+    Playback splits the surface into square tiles, each drawn with its own clip on executor, so
+    that large surfaces are rasterized in parallel.
+    As with Raster(), draws into a layer do not reach the pixels until the layer is restored:
+    playback stops at a saveLayer that is still open, and the layer is drawn as a whole once it
+    is restored.
+
+    Pixel memory is allocated and zeroed as by Raster(). Pixels can not be read or peeked through
+    the returned surface's SkCanvas; use the SkSurface methods instead. Paths are scan converted
+    per tile, so their edges may differ slightly from those drawn by a Raster() surface.
+
+    @param imageInfo     width, height, SkColorType, SkAlphaType, SkColorSpace,
+                         of raster surface; width and height must be greater than zero
+    @param executor      runs the tile draws; SkExecutor::GetDefault() if nullptr.
+                         Must outlive the surface.
+    @param tileSize      width and height of each tile in pixels; zero selects a default
+    @param surfaceProps  LCD striping orientation and setting for device independent fonts;
+                         may be nullptr
+    @return              SkSurface if parameters are valid and memory was allocated, else nullptr.
+*/
+SK_API sk_sp<SkSurface> RasterTiled(const SkImageInfo& imageInfo,
+                                    SkExecutor* executor,
+                                    int tileSize = 0,
+                                    const SkSurfaceProps* surfaceProps = nullptr);
+
 /** Allocates raster SkSurface. SkCanvas returned by SkSurface draws directly into the
     provided pixels.
 
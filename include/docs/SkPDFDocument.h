@@ -11,6 +11,7 @@
 #include "include/private/base/SkAPI.h"
 #include "include/private/base/SkNoncopyable.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -85,6 +86,8 @@ struct DateTime {
 
 using DecodeJpegCallback = std::unique_ptr<SkCodec> (*)(sk_sp<SkData>);
 using EncodeJpegCallback = bool (*)(SkWStream* dst, const SkPixmap& src, int quality);
+using DeflateCallback = bool (*)(SkWStream* dst, const void* src, size_t size,
+                                 int compressionLevel);
 
 /** Optional metadata to be passed into the PDF factory function.
 */
@@ -177,6 +180,28 @@ struct Metadata {
     */
     SkExecutor* fExecutor = nullptr;
 
+    /** If true, each page (and the page tree nodes above it, once they are
+        complete) is written out when the page ends, rather than being kept
+        until the document is closed. Memory use then no longer grows with
+        the number of pages, at the cost of a page tree that may be one level
+        deeper. The output renders the same, but its objects are numbered and
+        ordered differently.
+
+        Experimental.
+    */
+    bool fStreaming = false;
+
+    /** An upper bound, in bytes, on the page contents and images that may be
+        queued on fExecutor waiting to be compressed and written. Work that
+        would go over the budget is done immediately on the calling thread
+        instead, which keeps documents that draw faster than they can be
+        written from piling up their pending work in memory. Zero, the
+        default, means no limit.
+
+        Experimental.
+    */
+    size_t fMemoryBudget = 0;
+
     /** PDF streams may be compressed to save space.
         Use this to specify the desired compression vs time tradeoff.
     */
@@ -188,6 +213,15 @@ struct Metadata {
         HighButSlow = 9,
     } fCompressionLevel = CompressionLevel::Default;
 
+    /** If true, objects that aren't streams are packed together into object
+        streams, which are compressed like any other stream, and the
+        cross-reference table is written as a cross-reference stream. This
+        makes documents smaller, but they require a PDF 1.5 reader.
+
+        Experimental.
+    */
+    bool fObjectStreams = false;
+
     /** Preferred Subsetter. */
     enum Subsetter {
         kHarfbuzz_Subsetter,
@@ -209,6 +243,17 @@ struct Metadata {
     */
     SkPDF::EncodeJpegCallback jpegEncoder = nullptr;
 
+    /** Clients can provide a faster implementation of the Deflate algorithm (for
+        example, one that compresses a whole buffer at a time, like libdeflate). It
+        is given all of a stream's data and should write it to dst as a complete
+        zlib stream (RFC 1950) at about the given compression level, returning false
+        if it can't, in which case Skia compresses the stream with zlib. If not
+        supplied, Skia uses zlib, spreading large streams across fExecutor if set.
+
+        Experimental.
+    */
+    SkPDF::DeflateCallback deflater = nullptr;
+
     // Skia's PDF support depends on having both a jpeg encoder and decoder for writing
     // compact PDFs. It will technically work, but produce larger than optimal PDFs
     // if either the decoder or encoder are left as nullptr. If clients will be creating
@@ -19,6 +19,7 @@
 
 class GrDirectContext;
 class SkData;
+class SkExecutor;
 class SkImage;
 class SkPixmap;
 class SkWStream;
@@ -94,6 +95,15 @@ struct Options {
      */
     const SkPixmap* fGainmap = nullptr;
     const SkGainmapInfo* fGainmapInfo = nullptr;
+
+    /**
+     *  If set, Encode() splits large images into stripes of rows that are filtered and
+     *  compressed concurrently on this executor, then joined into a single zlib stream.
+     *  The result is an ordinary PNG, typically a fraction of a percent larger than one
+     *  encoded serially.  Small images, and encoders returned by Make(), which encode
+     *  rows incrementally, are still encoded serially.
+     */
+    SkExecutor* fExecutor = nullptr;
 };
 
 /**
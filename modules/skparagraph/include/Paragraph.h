@@ -80,6 +80,11 @@ public:
     virtual void updateForegroundPaint(size_t from, size_t to, SkPaint paint) = 0;
     virtual void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) = 0;
 
+    // Experimental API that replaces the text in [from:to) (UTF-8 code units) with text.
+    // The new text takes the style of the text before it. The next layout only reshapes
+    // the runs the edit touches; the edit must not overlap a placeholder.
+    virtual void updateText(size_t from, size_t to, const SkString& text) = 0;
+
     enum VisitorFlags {
         kWhiteSpace_VisitorFlag = 1 << 0,
     };
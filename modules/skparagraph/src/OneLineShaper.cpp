@@ -187,7 +187,15 @@ void OneLineShaper::finish(const Block& block, SkScalar height, SkScalar& advanc
         }
         lastTextEnd = text.end;
 
-        if (resolvedBlock.isFullyResolved()) {
+        // A run kept from the last layout was positioned where its block started then;
+        // if that has changed, it is copied below like a piece of a run
+        if (resolvedBlock.isFullyResolved() &&
+            (!resolvedBlock.fReused || run->posX(0) == advanceX)) {
+            if (run->fPiece) {
+                // It was a piece of a run when it was shaped, and still counts as one
+                fAdvance.fX += run->fAdvance.fX;
+                fAdvance.fY = std::max(fAdvance.fY, run->fAdvance.fY);
+            }
             // Just move the entire run
             resolvedBlock.fRun->fIndex = this->fParagraph->fRuns.size();
             this->fParagraph->fRuns.emplace_back(*resolvedBlock.fRun);
@@ -216,6 +224,7 @@ void OneLineShaper::finish(const Block& block, SkScalar height, SkScalar& advanc
                     advanceX
                 );
         auto piece = &this->fParagraph->fRuns.back();
+        piece->fPiece = !resolvedBlock.isFullyResolved() || run->fPiece;
 
         // TODO: Optimize copying
         SkPoint zero = {run->fPositions[glyphs.start].fX, 0};
@@ -237,6 +246,11 @@ void OneLineShaper::finish(const Block& block, SkScalar height, SkScalar& advanc
             piece->addX(index, advanceX);
         }
 
+        if (!piece->fPiece) {
+            // An entire run only moves to where the block starts
+            continue;
+        }
+
         // Carve out the line text out of the entire run text
         fAdvance.fX += runAdvance.fX;
         fAdvance.fY = std::max(fAdvance.fY, runAdvance.fY);
@@ -614,6 +628,30 @@ bool OneLineShaper::iterateThroughShapingRegions(const ShapeVisitor& shape) {
     return true;
 }
 
+void OneLineShaper::reuseRuns(TextRange blockText, uint8_t bidiLevel) {
+    // Take the runs kept from the last layout that fit in the block as they are
+    // and leave only the text between them to shape
+    auto& runs = fParagraph->fReusableRuns;
+    auto run = std::lower_bound(runs.begin(), runs.end(), blockText.start,
+                                [](const Run& reusable, TextIndex start) {
+                                    return reusable.fTextRange.start < start;
+                                });
+    TextIndex unresolvedStart = blockText.start;
+    for (; run != runs.end() && run->fTextRange.end <= blockText.end; ++run) {
+        if (run->fBidiLevel != bidiLevel) {
+            continue;
+        }
+        if (unresolvedStart < run->fTextRange.start) {
+            fUnresolvedBlocks.emplace_back(TextRange(unresolvedStart, run->fTextRange.start));
+        }
+        fResolvedBlocks.emplace_back(std::make_shared<Run>(*run)).fReused = true;
+        unresolvedStart = run->fTextRange.end;
+    }
+    if (unresolvedStart < blockText.end) {
+        fUnresolvedBlocks.emplace_back(TextRange(unresolvedStart, blockText.end));
+    }
+}
+
 bool OneLineShaper::shape() {
 
     // The text can be broken into many shaping sequences
@@ -643,7 +681,12 @@ bool OneLineShaper::shape() {
             fBaselineShift = block.fStyle.getBaselineShift();
             fAdvance = SkVector::Make(advanceX, 0);
             fCurrentText = block.fRange;
-            fUnresolvedBlocks.emplace_back(RunBlock(block.fRange));
+            this->reuseRuns(block.fRange, defaultBidiLevel);
+            if (fUnresolvedBlocks.empty()) {
+                // Nothing has changed in the block since the last time it was shaped
+                this->finish(block, fHeight, advanceX);
+                return;
+            }
 
             this->matchResolvedFonts(block.fStyle, [&](sk_sp<SkTypeface> typeface) {
 
@@ -58,6 +58,7 @@ private:
         std::shared_ptr<Run> fRun;
         TextRange fText;
         GlyphRange fGlyphs;
+        bool fReused = false;  // The run was kept from the last layout instead of shaped
         bool isFullyResolved() { return fRun != nullptr && fGlyphs.width() == fRun->size(); }
     };
 
@@ -82,6 +83,7 @@ private:
     void printState();
 #endif
     void finish(const Block& block, SkScalar height, SkScalar& advanceX);
+    void reuseRuns(TextRange blockText, uint8_t bidiLevel);
 
     void beginLine() override {}
     void runInfo(const RunInfo&) override {}
@@ -197,6 +197,7 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
                 fFontCollection->getParagraphCache()->updateParagraph(this);
             }
         }
+        this->fReusableRuns.clear();
         fState = kShaped;
     }
 
@@ -1086,6 +1087,7 @@ void ParagraphImpl::updateFontSize(size_t from, size_t to, SkScalar fontSize) {
   }
 
   fState = std::min(fState, kIndexed);
+  fReusableRuns.clear();
   fOldWidth = 0;
   fOldHeight = 0;
 }
@@ -1120,6 +1122,122 @@ void ParagraphImpl::updateBackgroundPaint(size_t from, size_t to, SkPaint paint)
     }
 }
 
+void ParagraphImpl::updateText(size_t from, size_t to, const SkString& text) {
+    SkASSERT(from <= to && to <= fText.size());
+    if (from == to && text.isEmpty()) {
+        return;
+    }
+    for (auto& placeholder : fPlaceholders) {
+        SkASSERT(!(from < placeholder.fRange.end && to > placeholder.fRange.start));
+    }
+
+    // Where an index of the old text ends up in the new one
+    // (inEdit says where to put the indexes of the edited text)
+    const size_t newEnd = from + text.size();
+    auto moved = [from, to, newEnd](TextIndex index, TextIndex inEdit) {
+        return index < from ? index : index > to ? index - to + newEnd : inEdit;
+    };
+
+    // Keep the runs that the edit does not touch so the next layout only reshapes the rest.
+    // The runs next to the edit are reshaped, too: the new text could join their graphemes.
+    // Spacing changes the runs after shaping, and unresolved text has no runs to keep.
+    fReusableRuns.clear();
+    bool hasSpacing = false;
+    for (auto& block : fTextStyles) {
+        hasSpacing |= !SkScalarNearlyZero(block.fStyle.getLetterSpacing()) ||
+                      !SkScalarNearlyZero(block.fStyle.getWordSpacing());
+    }
+    if (fState >= kShaped && fUnresolvedGlyphs == 0 && !hasSpacing) {
+        for (auto& run : fRuns) {
+            if (run.isPlaceholder() ||
+                (run.fTextRange.end >= from && run.fTextRange.start <= to) ||
+                (run.fTextRange.start > to && run.fClusterStart + newEnd < to)) {
+                continue;
+            }
+            auto& reusable = fReusableRuns.emplace_back(run);
+            if (run.fTextRange.start > to) {
+                reusable.fTextRange = TextRange(moved(run.fTextRange.start, newEnd),
+                                                moved(run.fTextRange.end, newEnd));
+                reusable.fClusterStart = run.fClusterStart + newEnd - to;
+            }
+        }
+    }
+
+    // The new text takes the style of the text before it
+    // (or after it, at the start of the paragraph or next to a placeholder)
+    auto findTextBlock = [this](TextIndex index) {
+        for (int i = 0; i < fTextStyles.size(); ++i) {
+            auto& block = fTextStyles[i];
+            if (!block.fStyle.isPlaceholder() &&
+                block.fRange.start <= index && index < block.fRange.end) {
+                return i;
+            }
+        }
+        return -1;
+    };
+    int anchor = from > 0 ? findTextBlock(from - 1) : -1;
+    if (anchor < 0 && to < fText.size()) {
+        anchor = findTextBlock(to);
+    }
+    if (anchor < 0) {
+        // There is no text around, only placeholders (or nothing at all)
+        TArray<Block, true> blocks;
+        for (auto& block : fTextStyles) {
+            if (anchor < 0 && block.fRange.start >= to) {
+                anchor = blocks.size();
+                blocks.emplace_back(from, from, fParagraphStyle.getTextStyle());
+            }
+            blocks.emplace_back(block);
+        }
+        if (anchor < 0) {
+            anchor = blocks.size();
+            blocks.emplace_back(from, from, fParagraphStyle.getTextStyle());
+        }
+        fTextStyles = std::move(blocks);
+    }
+    for (int i = 0; i < fTextStyles.size(); ++i) {
+        auto& range = fTextStyles[i].fRange;
+        range = TextRange(moved(range.start, i <= anchor ? from : newEnd),
+                          moved(range.end, i < anchor ? from : newEnd));
+    }
+
+    SkString newText(fText.c_str(), from);
+    newText.append(text);
+    newText.append(fText.c_str() + to, fText.size() - to);
+    fText = std::move(newText);
+
+    // The last placeholder only marks the end of the text
+    TextIndex textBefore = 0;
+    for (auto& placeholder : fPlaceholders) {
+        if (&placeholder == &fPlaceholders.back()) {
+            placeholder.fRange = TextRange(fText.size(), fText.size());
+        } else {
+            placeholder.fRange = TextRange(moved(placeholder.fRange.start, newEnd),
+                                           moved(placeholder.fRange.end, from));
+        }
+        placeholder.fTextBefore = TextRange(textBefore, placeholder.fRange.start);
+        textBefore = placeholder.fRange.end;
+    }
+
+    // The UTF-16 mapping is only filled once; if it has been, fill it again for the new text
+    if (!fUTF16IndexForUTF8Index.empty()) {
+        fUTF8IndexForUTF16Index.clear();
+        fUTF16IndexForUTF8Index.clear();
+        SkUnicode::extractUtfConversionMapping(
+                this->text(),
+                [&](size_t index) { fUTF8IndexForUTF16Index.emplace_back(index); },
+                [&](size_t index) { fUTF16IndexForUTF8Index.emplace_back(index); });
+    }
+    fBidiRegions.clear();
+    fWords.clear();
+    fHasLineBreaks = false;
+    fHasWhitespacesInside = false;
+
+    fState = kUnknown;
+    fOldWidth = 0;
+    fOldHeight = 0;
+}
+
 TArray<TextIndex> ParagraphImpl::countSurroundingGraphemes(TextRange textRange) const {
     textRange = textRange.intersection({0, fText.size()});
     TArray<TextIndex> graphemes;
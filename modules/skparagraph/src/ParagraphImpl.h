@@ -207,6 +207,7 @@ public:
     void updateFontSize(size_t from, size_t to, SkScalar fontSize) override;
     void updateForegroundPaint(size_t from, size_t to, SkPaint paint) override;
     void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) override;
+    void updateText(size_t from, size_t to, const SkString& text) override;
 
     void visit(const Visitor&) override;
     void extendedVisit(const ExtendedVisitor&) override;
@@ -271,6 +272,7 @@ private:
     // Internal structures
     InternalState fState;
     skia_private::TArray<Run, false> fRuns;         // kShaped
+    skia_private::TArray<Run, false> fReusableRuns; // Runs the last updateText left alone
     skia_private::TArray<Cluster, true> fClusters;  // kClusterized (cached: text, word spacing, letter spacing, resolved fonts)
     skia_private::TArray<SkUnicode::CodeUnitFlags, true> fCodeUnitProperties;
     skia_private::TArray<size_t, true> fClustersIndexFromCodeUnit;
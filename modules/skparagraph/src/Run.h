@@ -211,6 +211,7 @@ private:
     SkScalar fCorrectLeading;
 
     bool fEllipsis;
+    bool fPiece;  // Cut out of a longer run, so (unlike an entire run) it moves the next block
     uint8_t fBidiLevel;
 };
 
@@ -7570,6 +7570,127 @@ UNIX_ONLY_TEST(SkParagraph_lineMetricsAfterUpdate, reporter) {
     REPORTER_ASSERT(reporter, lm.size() == 2, "size: %zu", lm.size());
 }
 
+UNIX_ONLY_TEST(SkParagraph_UpdateText, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    SKIP_IF_FONTS_NOT_FOUND(reporter, fontCollection)
+    // The expected paragraphs must be shaped, not found in the cache as the edited ones
+    fontCollection->getParagraphCache()->turnOn(false);
+
+    TextStyle small;
+    small.setFontFamilies({SkString("Roboto"), SkString("Noto Naskh Arabic")});
+    small.setFontSize(20);
+    small.setColor(SK_ColorBLACK);
+    TextStyle large(small);
+    large.setFontSize(30);
+    PlaceholderStyle placeholder(40, 20, PlaceholderAlignment::kBaseline,
+                                 TextBaseline::kAlphabetic, 0);
+
+    // The pieces of text are small and large in turn; a null piece is a placeholder
+    auto build = [&](std::vector<const char*> pieces, TextDirection direction) {
+        ParagraphStyle paragraph_style;
+        paragraph_style.turnHintingOff();
+        paragraph_style.setTextDirection(direction);
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection, get_unicode());
+        bool isLarge = false;
+        for (const char* piece : pieces) {
+            if (piece == nullptr) {
+                builder.addPlaceholder(placeholder);
+                continue;
+            }
+            builder.pushStyle(isLarge ? large : small);
+            builder.addText(piece);
+            builder.pop();
+            isLarge = !isLarge;
+        }
+        auto paragraph = builder.Build();
+        paragraph->layout(150);
+        return paragraph;
+    };
+    // The runs can only be compared when the edit leaves the text split into the same runs
+    auto check = [&](Paragraph* edited, std::vector<const char*> pieces, TextDirection direction,
+                     bool sameRuns = true) {
+        edited->layout(150);
+        auto expected = build(pieces, direction);
+        REPORTER_ASSERT(reporter, edited->lineNumber() == expected->lineNumber());
+        REPORTER_ASSERT(reporter, edited->getHeight() == expected->getHeight());
+        REPORTER_ASSERT(reporter, edited->getMaxIntrinsicWidth() == expected->getMaxIntrinsicWidth());
+        REPORTER_ASSERT(reporter, edited->getMinIntrinsicWidth() == expected->getMinIntrinsicWidth());
+        auto compare = [&](const std::vector<TextBox>& editedBoxes,
+                           const std::vector<TextBox>& expectedBoxes) {
+            REPORTER_ASSERT(reporter, editedBoxes.size() == expectedBoxes.size());
+            for (size_t i = 0; i < std::min(editedBoxes.size(), expectedBoxes.size()); ++i) {
+                REPORTER_ASSERT(reporter, editedBoxes[i].rect == expectedBoxes[i].rect);
+                REPORTER_ASSERT(reporter, editedBoxes[i].direction == expectedBoxes[i].direction);
+            }
+        };
+        compare(edited->getRectsForRange(0, 1000, RectHeightStyle::kTight, RectWidthStyle::kTight),
+                expected->getRectsForRange(0, 1000, RectHeightStyle::kTight, RectWidthStyle::kTight));
+        compare(edited->getRectsForPlaceholders(), expected->getRectsForPlaceholders());
+        if (!sameRuns) {
+            return;
+        }
+        // The runs kept from the last layout are placed where a new shaping would put them
+        auto editedRuns = static_cast<ParagraphImpl*>(edited)->runs();
+        auto expectedRuns = static_cast<ParagraphImpl*>(expected.get())->runs();
+        REPORTER_ASSERT(reporter, editedRuns.size() == expectedRuns.size());
+        for (size_t i = 0; i < std::min(editedRuns.size(), expectedRuns.size()); ++i) {
+            REPORTER_ASSERT(reporter, editedRuns[i].textRange() == expectedRuns[i].textRange());
+            REPORTER_ASSERT(reporter, SkScalarNearlyEqual(editedRuns[i].posX(0),
+                                                          expectedRuns[i].posX(0)));
+            REPORTER_ASSERT(reporter, SkScalarNearlyEqual(editedRuns[i].advance().fX,
+                                                          expectedRuns[i].advance().fX));
+        }
+    };
+    auto firstGlyphs = [](Paragraph* paragraph) {
+        return static_cast<ParagraphImpl*>(paragraph)->runs()[0].glyphs().data();
+    };
+
+    {
+        auto paragraph = build({"Hello ", "brave new", " world"}, TextDirection::kLtr);
+        auto glyphs = firstGlyphs(paragraph.get());
+
+        // Only the middle run is shaped again
+        paragraph->updateText(11, 12, SkString(" and bold "));
+        check(paragraph.get(), {"Hello ", "brave and bold new", " world"}, TextDirection::kLtr);
+        REPORTER_ASSERT(reporter, firstGlyphs(paragraph.get()) == glyphs);
+
+        // The new text at the start takes the style of the text after it
+        paragraph->updateText(0, 0, SkString("Oh, "));
+        check(paragraph.get(), {"Oh, Hello ", "brave and bold new", " world"}, TextDirection::kLtr);
+
+        // Deleting a whole style (which leaves two runs of the same style)
+        paragraph->updateText(10, 28, SkString());
+        check(paragraph.get(), {"Oh, Hello ", "", " world"}, TextDirection::kLtr, false);
+    }
+    {
+        // Right to left
+        auto paragraph = build({"مرحبا ", "بالعالم الجميل", " اليوم"}, TextDirection::kRtl);
+        auto glyphs = firstGlyphs(paragraph.get());
+        const size_t at = strlen("مرحبا بالعالم");
+        paragraph->updateText(at, at, SkString(" جدا"));
+        check(paragraph.get(), {"مرحبا ", "بالعالم جدا الجميل", " اليوم"}, TextDirection::kRtl);
+        REPORTER_ASSERT(reporter, firstGlyphs(paragraph.get()) == glyphs);
+    }
+    {
+        // Both directions
+        auto paragraph = build({"Hello مرحبا ", "brave", " world"}, TextDirection::kLtr);
+        auto glyphs = firstGlyphs(paragraph.get());
+        const size_t at = strlen("Hello مرحبا brave");
+        paragraph->updateText(at, at, SkString(" new"));
+        check(paragraph.get(), {"Hello مرحبا ", "brave new", " world"}, TextDirection::kLtr);
+        REPORTER_ASSERT(reporter, firstGlyphs(paragraph.get()) == glyphs);
+    }
+    {
+        // After a placeholder, which takes up the three bytes of U+FFFC in the text
+        auto paragraph = build({"Hello ", nullptr, "brave", " world"}, TextDirection::kLtr);
+        auto glyphs = firstGlyphs(paragraph.get());
+        const size_t at = strlen("Hello ") + 3 + strlen("brave");
+        paragraph->updateText(at, at, SkString(" new"));
+        check(paragraph.get(), {"Hello ", nullptr, "brave new", " world"}, TextDirection::kLtr);
+        REPORTER_ASSERT(reporter, firstGlyphs(paragraph.get()) == glyphs);
+    }
+}
+
 // Google logo is shown in one style (the first one)
 UNIX_ONLY_TEST(SkParagraph_MultiStyle_Logo, reporter) {
     sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>(true);
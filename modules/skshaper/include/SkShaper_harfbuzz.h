@@ -14,6 +14,7 @@
 #include "modules/skshaper/include/SkShaper.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 class SkFontMgr;
@@ -34,6 +35,23 @@ SKSHAPER_API std::unique_ptr<SkShaper::ScriptRunIterator> ScriptRunIterator(cons
                                                                             SkFourByteTag script);
 
 SKSHAPER_API void PurgeCaches();
+
+// The words shaped by any of the shapers above are kept in a cache shared by all threads, so a
+// word seen before (in another paragraph, or in a label drawn again) reuses the glyphs HarfBuzz
+// found for it and only the other words of a run are shaped. Fonts where a space takes part in
+// substitutions or kerning are not cached, since their words cannot be shaped apart. The cache
+// holds at most the given number of bytes, 2MB by default, dropping the words used least
+// recently; a limit of zero turns it off. PurgeCaches() empties it.
+SKSHAPER_API void SetRunCacheLimit(size_t bytes);
+SKSHAPER_API size_t GetRunCacheLimit();
+
+struct RunCacheStats {
+    size_t   fBytes = 0;   // The memory the cached words take up.
+    int      fCount = 0;   // How many words are cached.
+    uint64_t fHits = 0;    // Words found in the cache since the process started.
+    uint64_t fMisses = 0;  // Words looked for but not found.
+};
+SKSHAPER_API RunCacheStats GetRunCacheStats();
 }  // namespace SkShapers::HB
 
 #endif
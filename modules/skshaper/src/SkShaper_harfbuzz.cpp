@@ -28,13 +28,17 @@
 #include "include/private/base/SkMutex.h"
 #include "include/private/base/SkTArray.h"
 #include "include/private/base/SkTemplates.h"
+#include "include/private/base/SkThreadAnnotations.h"
 #include "include/private/base/SkTo.h"
 #include "include/private/base/SkTypeTraits.h"
 #include "modules/skshaper/include/SkShaper.h"
 #include "modules/skunicode/include/SkUnicode.h"
 #include "src/base/SkTDPQueue.h"
+#include "src/base/SkTInternalLList.h"
 #include "src/base/SkUTF.h"
+#include "src/core/SkChecksum.h"
 #include "src/core/SkLRUCache.h"
+#include "src/core/SkTHash.h"
 
 #if !defined(SK_DISABLE_LEGACY_SKSHAPER_FUNCTIONS)
 #include "modules/skshaper/include/SkShaper_skunicode.h"
@@ -43,9 +47,13 @@
 #include <hb-ot.h>
 #include <hb.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <optional>
+#include <string>
 #include <type_traits>
 #include <utility>
 
@@ -1241,9 +1249,93 @@ void ShapeDontWrapOrReorder::wrap(char const * const utf8, size_t utf8Bytes,
     handler->commitLine();
 }
 
+// Whether a kern table has a pair with the glyph in it. Only the format 0 subtables of a version 0
+// table are read; anything else is taken to have one.
+bool kern_table_pairs_glyph(hb_blob_t* kern, hb_codepoint_t glyph) {
+    unsigned length = 0;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(hb_blob_get_data(kern, &length));
+    auto readU16 = [&](unsigned offset) -> std::optional<uint16_t> {
+        if (offset + 2 > length) {
+            return std::nullopt;
+        }
+        return SkToU16((data[offset] << 8) | data[offset + 1]);
+    };
+    std::optional<uint16_t> version = readU16(0);
+    std::optional<uint16_t> subtableCount = readU16(2);
+    if (!version || *version != 0 || !subtableCount) {
+        return true;
+    }
+    unsigned subtable = 4;
+    for (int i = 0; i < *subtableCount; ++i) {
+        std::optional<uint16_t> subtableLength = readU16(subtable + 2);
+        std::optional<uint16_t> coverage = readU16(subtable + 4);
+        std::optional<uint16_t> pairCount = readU16(subtable + 6);
+        if (!subtableLength || !coverage || !pairCount || (*coverage >> 8) != 0) {
+            return true;
+        }
+        for (unsigned pair = subtable + 14; pair < subtable + 14 + *pairCount * 6u; pair += 6) {
+            std::optional<uint16_t> left = readU16(pair);
+            std::optional<uint16_t> right = readU16(pair + 2);
+            if (!left || !right || *left == glyph || *right == glyph) {
+                return true;
+            }
+        }
+        subtable += *subtableLength;
+    }
+    return false;
+}
+
+// Whether a space may be looked at by the substitutions or positioning of the font, in which case
+// the words on either side of it cannot be shaped apart. This is what Chrome and Firefox check
+// before shaping text a word at a time.
+bool space_takes_part_in_shaping(hb_font_t* font) {
+    hb_codepoint_t space;
+    if (!hb_font_get_nominal_glyph(font, ' ', &space)) {
+        return false;
+    }
+    hb_face_t* face = hb_font_get_face(font);
+    HBBlob kern(hb_face_reference_table(face, HB_TAG('k','e','r','n')));
+    if (hb_blob_get_length(kern.get()) > 0 && kern_table_pairs_glyph(kern.get(), space)) {
+        return true;
+    }
+    // AAT tables are not looked into.
+    for (hb_tag_t tag : {HB_TAG('k','e','r','x'), HB_TAG('m','o','r','x')}) {
+        HBBlob table(hb_face_reference_table(face, tag));
+        if (hb_blob_get_length(table.get()) > 0) {
+            return true;
+        }
+    }
+    std::unique_ptr<hb_set_t, SkFunctionObject<hb_set_destroy>> glyphs(hb_set_create());
+    for (hb_tag_t tag : {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS}) {
+        unsigned lookupCount = hb_ot_layout_table_get_lookup_count(face, tag);
+        for (unsigned i = 0; i < lookupCount; ++i) {
+            hb_set_clear(glyphs.get());
+            hb_ot_layout_lookup_collect_glyphs(face, tag, i, glyphs.get(), glyphs.get(),
+                                               glyphs.get(), glyphs.get());
+            if (hb_set_has(glyphs.get(), space)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The HarfBuzz font made for a typeface, with what the run cache needs to know about it.
+struct HBTypefaceFont {
+    HBFont fFont;
+    std::optional<bool> fSpaceTakesPart;  // Looked for the first time the run cache asks.
+
+    bool spaceTakesPart() {
+        if (!fSpaceTakesPart) {
+            fSpaceTakesPart = space_takes_part_in_shaping(fFont.get());
+        }
+        return *fSpaceTakesPart;
+    }
+};
+
 class HBLockedFaceCache {
 public:
-    HBLockedFaceCache(SkLRUCache<SkTypefaceID, HBFont>& lruCache, SkMutex& mutex)
+    HBLockedFaceCache(SkLRUCache<SkTypefaceID, HBTypefaceFont>& lruCache, SkMutex& mutex)
         : fLRUCache(lruCache), fMutex(mutex)
     {
         fMutex.acquire();
@@ -1256,40 +1348,290 @@ public:
         fMutex.release();
     }
 
-    HBFont* find(SkTypefaceID fontId) {
+    HBTypefaceFont* find(SkTypefaceID fontId) {
         return fLRUCache.find(fontId);
     }
-    HBFont* insert(SkTypefaceID fontId, HBFont hbFont) {
-        return fLRUCache.insert(fontId, std::move(hbFont));
+    HBTypefaceFont* insert(SkTypefaceID fontId, HBFont hbFont) {
+        return fLRUCache.insert(fontId, {std::move(hbFont), std::nullopt});
     }
     void reset() {
         fLRUCache.reset();
     }
 private:
-    SkLRUCache<SkTypefaceID, HBFont>& fLRUCache;
+    SkLRUCache<SkTypefaceID, HBTypefaceFont>& fLRUCache;
     SkMutex& fMutex;
 };
 static HBLockedFaceCache get_hbFace_cache() {
     static SkMutex gHBFaceCacheMutex;
-    static SkLRUCache<SkTypefaceID, HBFont> gHBFaceCache(100);
+    static SkLRUCache<SkTypefaceID, HBTypefaceFont> gHBFaceCache(100);
     return HBLockedFaceCache(gHBFaceCache, gHBFaceCacheMutex);
 }
 
-ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
-                                  size_t const utf8Bytes,
-                                  char const * const utf8Start,
-                                  char const * const utf8End,
-                                  const BiDiRunIterator& bidi,
-                                  const LanguageRunIterator& language,
-                                  const ScriptRunIterator& script,
-                                  const FontRunIterator& font,
-                                  Feature const * const features, size_t const featuresSize) const
-{
-    size_t utf8runLength = utf8End - utf8Start;
-    ShapedRun run(RunHandler::Range(utf8Start - utf8, utf8runLength),
-                  font.currentFont(), bidi.currentLevel(), nullptr, 0);
+// Words shaped before, shared by every HarfBuzz shaper so that text which comes up again (the same
+// words in other paragraphs, labels drawn every frame) is only shaped once. Runs are split into
+// words, each with the spaces after it, and only the words not found are given to HarfBuzz. When
+// nothing in the font looks at a space, this puts together the glyphs HarfBuzz finds for the whole
+// run; fonts where something does are not cached.
+//
+// A word is only found again when everything HarfBuzz looks at is the same: the font, the
+// direction, script and language, the features that apply to the word, and its text with the
+// context around it. Clusters are kept from the start of the word, so the same word is found
+// wherever it is.
+//
+// The cache is split into shards by hash, each with its own lock, list and share of the byte
+// limit, so that threads shaping different text rarely wait on each other.
+class HBRunCache {
+public:
+    // HarfBuzz looks at up to five code points of context on each side of a run.
+    static constexpr int kContextLength = 5;
+    // Longer words are mostly text written without spaces, which is seldom seen again.
+    static constexpr size_t kMaxWordBytes = 64;
+    // The words of all of the shaper_* bench texts together take up about 800KB.
+    static constexpr size_t kDefaultLimit = 2 * 1024 * 1024;
+
+    using Key = std::string;
+
+    ~HBRunCache() { this->purge(); }
+
+    // Append the glyphs cached for key to glyphs, making their clusters start at clusterStart.
+    bool find(const Key& key, size_t clusterStart, TArray<ShapedGlyph>* glyphs) {
+        Shard& shard = this->shard(key);
+        SkAutoMutexExclusive lock(shard.fMutex);
+        Entry** found = shard.fTable.find(key);
+        if (!found) {
+            fMisses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        fHits.fetch_add(1, std::memory_order_relaxed);
+        Entry* entry = *found;
+        shard.fLRU.remove(entry);
+        shard.fLRU.addToHead(entry);
+
+        for (const ShapedGlyph& glyph : SkSpan(entry->fGlyphs.get(), entry->fNumGlyphs)) {
+            glyphs->push_back(glyph).fCluster += clusterStart;
+        }
+        return true;
+    }
+
+    void insert(Key key, size_t clusterStart, SkSpan<const ShapedGlyph> glyphs) {
+        auto entry = std::make_unique<Entry>();
+        entry->fKey = std::move(key);
+        entry->fGlyphs.reset(new ShapedGlyph[glyphs.size()]);
+        for (size_t i = 0; i < glyphs.size(); ++i) {
+            entry->fGlyphs[i] = glyphs[i];
+            entry->fGlyphs[i].fCluster -= clusterStart;
+        }
+        entry->fNumGlyphs = glyphs.size();
 
-    hb_buffer_t* buffer = fBuffer.get();
+        Shard& shard = this->shard(entry->fKey);
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (shard.fTable.find(entry->fKey)) {
+            // Another thread shaped the same word first.
+            return;
+        }
+        shard.fBytes += entry->bytes();
+        shard.fLRU.addToHead(entry.get());
+        shard.fTable.set(entry.release());
+        this->evict(&shard, fLimit.load(std::memory_order_relaxed) / kShardCount);
+    }
+
+    void setLimit(size_t bytes) {
+        fLimit.store(bytes, std::memory_order_relaxed);
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            this->evict(&shard, bytes / kShardCount);
+        }
+    }
+
+    size_t limit() const { return fLimit.load(std::memory_order_relaxed); }
+
+    void purge() {
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            this->evict(&shard, 0);
+        }
+    }
+
+    SkShapers::HB::RunCacheStats stats() {
+        SkShapers::HB::RunCacheStats stats;
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            stats.fBytes += shard.fBytes;
+            stats.fCount += shard.fTable.count();
+        }
+        stats.fHits = fHits.load(std::memory_order_relaxed);
+        stats.fMisses = fMisses.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static constexpr int kShardBits = 4;
+    static constexpr int kShardCount = 1 << kShardBits;
+
+    struct Entry {
+        Key fKey;
+        std::unique_ptr<ShapedGlyph[]> fGlyphs;  // Clusters are from the start of the word.
+        size_t fNumGlyphs;
+
+        size_t bytes() const {
+            return sizeof(Entry) + fKey.size() + fNumGlyphs * sizeof(ShapedGlyph);
+        }
+
+        static const Key& GetKey(const Entry* entry) { return entry->fKey; }
+        static uint32_t Hash(const Key& key) {
+            return SkChecksum::Hash32(key.data(), key.size());
+        }
+
+        SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+    };
+
+    struct Shard {
+        SkMutex fMutex;
+        THashTable<Entry*, Key, Entry> fTable SK_GUARDED_BY(fMutex);
+        SkTInternalLList<Entry> fLRU SK_GUARDED_BY(fMutex);
+        size_t fBytes SK_GUARDED_BY(fMutex) = 0;
+    };
+
+    Shard& shard(const Key& key) {
+        return fShards[Entry::Hash(key) >> (32 - kShardBits)];
+    }
+
+    void evict(Shard* shard, size_t limit) SK_REQUIRES(shard->fMutex) {
+        while (shard->fBytes > limit) {
+            Entry* oldest = shard->fLRU.tail();
+            shard->fLRU.remove(oldest);
+            shard->fTable.remove(oldest->fKey);
+            shard->fBytes -= oldest->bytes();
+            delete oldest;
+        }
+    }
+
+    Shard fShards[kShardCount];
+    std::atomic<size_t> fLimit{kDefaultLimit};
+    std::atomic<uint64_t> fHits{0};
+    std::atomic<uint64_t> fMisses{0};
+};
+static HBRunCache& get_run_cache() {
+    static HBRunCache gHBRunCache;
+    return gHBRunCache;
+}
+
+// Splits [utf8Start, utf8End) into words, each with the spaces after it, appending the start of
+// each word and then the end of the last. A mark after a space is kept with the space, since
+// HarfBuzz may place it on the space.
+static void split_words(const char* utf8Start, const char* utf8End, TArray<const char*>* words) {
+    words->push_back(utf8Start);
+    bool afterSpace = false;
+    const char* utf8Current = utf8Start;
+    while (utf8Current < utf8End) {
+        const char* wordStart = utf8Current;
+        hb_codepoint_t u = utf8_next(&utf8Current, utf8End);
+        if (u == ' ') {
+            afterSpace = true;
+            continue;
+        }
+        if (afterSpace) {
+            switch (hb_unicode_general_category(hb_unicode_funcs_get_default(), u)) {
+                case HB_UNICODE_GENERAL_CATEGORY_SPACING_MARK:
+                case HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK:
+                case HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK:
+                    break;
+                default:
+                    words->push_back(wordStart);
+                    break;
+            }
+        }
+        afterSpace = false;
+    }
+    words->push_back(utf8End);
+}
+
+// Everything HarfBuzz looks at when it shapes [wordStart, wordEnd) as part of a run.
+static HBRunCache::Key make_word_key(const char* utf8, size_t utf8Bytes,
+                                     const char* wordStart, const char* wordEnd,
+                                     const SkFont& font, SkBidiIterator::Level level,
+                                     hb_script_t script, hb_language_t language,
+                                     SkSpan<const hb_feature_t> features) {
+    SkASSERT(wordStart < wordEnd);
+    HBRunCache::Key key;
+    auto append = [&key](const auto& value) {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    append(font.getTypeface()->uniqueID());
+    append(font.getSize());
+    append(font.getScaleX());
+    append(font.getSkewX());
+    append(SkToU8(font.getEdging()));
+    append(SkToU8(font.getHinting()));
+    append(SkToU8((font.isForceAutoHinting() << 0) | (font.isEmbeddedBitmaps() << 1) |
+                  (font.isSubpixel()         << 2) | (font.isLinearMetrics()  << 3) |
+                  (font.isEmbolden()         << 4) | (font.isBaselineSnap()   << 5)));
+    append(SkToU8(is_LTR(level)));
+    append(script);
+    append(language);  // Languages are interned by HarfBuzz.
+
+    // Feature ranges are made relative to the word, like its clusters. A feature over other words
+    // of the run does nothing to this one.
+    const unsigned start = SkTo<unsigned>(wordStart - utf8);
+    const unsigned end = SkTo<unsigned>(wordEnd - utf8);
+    const size_t featureCountOffset = key.size();
+    uint32_t featureCount = 0;
+    append(featureCount);
+    for (const hb_feature_t& feature : features) {
+        if (feature.start == HB_FEATURE_GLOBAL_START && feature.end == HB_FEATURE_GLOBAL_END) {
+            append(feature.tag);
+            append(feature.value);
+            append(HB_FEATURE_GLOBAL_START);
+            append(HB_FEATURE_GLOBAL_END);
+        } else if (feature.start < end && start < feature.end) {
+            append(feature.tag);
+            append(feature.value);
+            append(std::max(feature.start, start) - start);
+            append(std::min(feature.end, end) - start);
+        } else {
+            continue;
+        }
+        ++featureCount;
+    }
+    memcpy(key.data() + featureCountOffset, &featureCount, sizeof(featureCount));
+
+    // The context is found the way HarfBuzz finds it, but only up to a space: HarfBuzz uses it to
+    // join letters, as in Arabic, and nothing joins across a space. Invalid UTF-8 may make it take
+    // in more bytes than HarfBuzz does; that only makes the key more particular.
+    const char* contextStart = wordStart;
+    if (*wordStart != ' ') {
+        for (int i = 0; i < HBRunCache::kContextLength && contextStart > utf8 &&
+                        contextStart[-1] != ' '; ++i) {
+            do {
+                --contextStart;
+            } while (contextStart > utf8 && (*contextStart & 0xC0) == 0x80);
+        }
+    }
+    const char* utf8BufferEnd = utf8 + utf8Bytes;
+    const char* contextEnd = wordEnd;
+    if (wordEnd[-1] != ' ') {
+        for (int i = 0; i < HBRunCache::kContextLength && contextEnd < utf8BufferEnd &&
+                        *contextEnd != ' '; ++i) {
+            do {
+                ++contextEnd;
+            } while (contextEnd < utf8BufferEnd && (*contextEnd & 0xC0) == 0x80);
+        }
+    }
+    append(SkTo<uint32_t>(wordStart - contextStart));
+    append(SkTo<uint32_t>(wordEnd - wordStart));
+    key.append(contextStart, contextEnd - contextStart);
+    return key;
+}
+
+// Shapes [utf8Start, utf8End) of utf8, the text around it being its context, and appends the
+// glyphs to glyphs in logical order with the clusters HarfBuzz gives them.
+static void shape_with_harfbuzz(hb_buffer_t* buffer, hb_font_t* hbFont, const SkFont& font,
+                                const char* utf8, size_t utf8Bytes,
+                                const char* utf8Start, const char* utf8End,
+                                hb_direction_t direction, hb_script_t script,
+                                hb_language_t language, SkSpan<const hb_feature_t> features,
+                                TArray<ShapedGlyph>* glyphs) {
     SkAutoTCallVProc<hb_buffer_t, hb_buffer_clear_contents> autoClearBuffer(buffer);
     hb_buffer_set_content_type(buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
     hb_buffer_set_cluster_level(buffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS);
@@ -1313,61 +1655,15 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     // Add postcontext.
     hb_buffer_add_utf8(buffer, utf8Current, utf8 + utf8Bytes - utf8Current, 0, 0);
 
-    hb_direction_t direction = is_LTR(bidi.currentLevel()) ? HB_DIRECTION_LTR:HB_DIRECTION_RTL;
     hb_buffer_set_direction(buffer, direction);
-    hb_buffer_set_script(buffer, hb_script_from_iso15924_tag((hb_tag_t)script.currentScript()));
-    // Buffers with HB_LANGUAGE_INVALID race since hb_language_get_default is not thread safe.
-    // The user must provide a language, but may provide data hb_language_from_string cannot use.
-    // Use "und" for the undefined language in this case (RFC5646 4.1 5).
-    hb_language_t hbLanguage = hb_language_from_string(language.currentLanguage(), -1);
-    if (hbLanguage == HB_LANGUAGE_INVALID) {
-        hbLanguage = fUndefinedLanguage;
-    }
-    hb_buffer_set_language(buffer, hbLanguage);
+    hb_buffer_set_script(buffer, script);
+    hb_buffer_set_language(buffer, language);
     hb_buffer_guess_segment_properties(buffer);
 
-    // TODO: better cache HBFace (data) / hbfont (typeface)
-    // An HBFace is expensive (it sanitizes the bits).
-    // An HBFont is fairly inexpensive.
-    // An HBFace is actually tied to the data, not the typeface.
-    // The size of 100 here is completely arbitrary and used to match libtxt.
-    HBFont hbFont;
-    {
-        HBLockedFaceCache cache = get_hbFace_cache();
-        SkTypefaceID dataId = font.currentFont().getTypeface()->uniqueID();
-        HBFont* typefaceFontCached = cache.find(dataId);
-        if (!typefaceFontCached) {
-            HBFont typefaceFont(create_typeface_hb_font(*font.currentFont().getTypeface()));
-            typefaceFontCached = cache.insert(dataId, std::move(typefaceFont));
-        }
-        hbFont = create_sub_hb_font(font.currentFont(), *typefaceFontCached);
-    }
-    if (!hbFont) {
-        return run;
-    }
-
-    STArray<32, hb_feature_t> hbFeatures;
-    for (const auto& feature : SkSpan(features, featuresSize)) {
-        if (feature.end < SkTo<size_t>(utf8Start - utf8) ||
-                          SkTo<size_t>(utf8End   - utf8)  <= feature.start)
-        {
-            continue;
-        }
-        if (feature.start <= SkTo<size_t>(utf8Start - utf8) &&
-                             SkTo<size_t>(utf8End   - utf8) <= feature.end)
-        {
-            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
-                                   HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END});
-        } else {
-            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
-                                   SkTo<unsigned>(feature.start), SkTo<unsigned>(feature.end)});
-        }
-    }
-
-    hb_shape(hbFont.get(), buffer, hbFeatures.data(), hbFeatures.size());
+    hb_shape(hbFont, buffer, features.data(), features.size());
     unsigned len = hb_buffer_get_length(buffer);
     if (len == 0) {
-        return run;
+        return;
     }
 
     if (direction == HB_DIRECTION_RTL) {
@@ -1378,10 +1674,6 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     hb_glyph_info_t* info = hb_buffer_get_glyph_infos(buffer, nullptr);
     hb_glyph_position_t* pos = hb_buffer_get_glyph_positions(buffer, nullptr);
 
-    run = ShapedRun(RunHandler::Range(utf8Start - utf8, utf8runLength),
-                    font.currentFont(), bidi.currentLevel(),
-                    std::unique_ptr<ShapedGlyph[]>(new ShapedGlyph[len]), len);
-
     // Undo skhb_position with (1.0/(1<<16)) and scale as needed.
     AutoSTArray<32, SkGlyphID> glyphIDs(len);
     for (unsigned i = 0; i < len; i++) {
@@ -1389,13 +1681,12 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     }
     AutoSTArray<32, SkRect> glyphBounds(len);
     SkPaint p;
-    run.fFont.getBounds(glyphIDs.get(), len, glyphBounds.get(), &p);
+    font.getBounds(glyphIDs.get(), len, glyphBounds.get(), &p);
 
-    double SkScalarFromHBPosX = +(1.52587890625e-5) * run.fFont.getScaleX();
+    double SkScalarFromHBPosX = +(1.52587890625e-5) * font.getScaleX();
     double SkScalarFromHBPosY = -(1.52587890625e-5);  // HarfBuzz y-up, Skia y-down
-    SkVector runAdvance = { 0, 0 };
     for (unsigned i = 0; i < len; i++) {
-        ShapedGlyph& glyph = run.fGlyphs[i];
+        ShapedGlyph& glyph = glyphs->push_back();
         glyph.fID = info[i].codepoint;
         glyph.fCluster = info[i].cluster;
         glyph.fOffset.fX = pos[i].x_offset * SkScalarFromHBPosX;
@@ -1410,11 +1701,160 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
         glyph.fUnsafeToBreak = false;
 #endif
         glyph.fMustLineBreakBefore = false;
+    }
+}
+
+ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
+                                  size_t const utf8Bytes,
+                                  char const * const utf8Start,
+                                  char const * const utf8End,
+                                  const BiDiRunIterator& bidi,
+                                  const LanguageRunIterator& language,
+                                  const ScriptRunIterator& script,
+                                  const FontRunIterator& font,
+                                  Feature const * const features, size_t const featuresSize) const
+{
+    size_t utf8runLength = utf8End - utf8Start;
+    ShapedRun run(RunHandler::Range(utf8Start - utf8, utf8runLength),
+                  font.currentFont(), bidi.currentLevel(), nullptr, 0);
 
-        runAdvance += glyph.fAdvance;
+    hb_script_t hbScript = hb_script_from_iso15924_tag((hb_tag_t)script.currentScript());
+    // Buffers with HB_LANGUAGE_INVALID race since hb_language_get_default is not thread safe.
+    // The user must provide a language, but may provide data hb_language_from_string cannot use.
+    // Use "und" for the undefined language in this case (RFC5646 4.1 5).
+    hb_language_t hbLanguage = hb_language_from_string(language.currentLanguage(), -1);
+    if (hbLanguage == HB_LANGUAGE_INVALID) {
+        hbLanguage = fUndefinedLanguage;
+    }
+
+    STArray<32, hb_feature_t> hbFeatures;
+    for (const auto& feature : SkSpan(features, featuresSize)) {
+        if (feature.end < SkTo<size_t>(utf8Start - utf8) ||
+                          SkTo<size_t>(utf8End   - utf8)  <= feature.start)
+        {
+            continue;
+        }
+        if (feature.start <= SkTo<size_t>(utf8Start - utf8) &&
+                             SkTo<size_t>(utf8End   - utf8) <= feature.end)
+        {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END});
+        } else {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   SkTo<unsigned>(feature.start), SkTo<unsigned>(feature.end)});
+        }
+    }
+
+    // TODO: better cache HBFace (data) / hbfont (typeface)
+    // An HBFace is expensive (it sanitizes the bits).
+    // An HBFont is fairly inexpensive.
+    // An HBFace is actually tied to the data, not the typeface.
+    // The size of 100 here is completely arbitrary and used to match libtxt.
+    HBFont hbFont;
+    bool cacheWords = false;
+    {
+        HBLockedFaceCache cache = get_hbFace_cache();
+        SkTypefaceID dataId = font.currentFont().getTypeface()->uniqueID();
+        HBTypefaceFont* typefaceFontCached = cache.find(dataId);
+        if (!typefaceFontCached) {
+            HBFont typefaceFont(create_typeface_hb_font(*font.currentFont().getTypeface()));
+            typefaceFontCached = cache.insert(dataId, std::move(typefaceFont));
+        }
+        hbFont = create_sub_hb_font(font.currentFont(), typefaceFontCached->fFont);
+        cacheWords = hbFont && utf8Start < utf8End && get_run_cache().limit() > 0 &&
+                     !typefaceFontCached->spaceTakesPart();
+    }
+    if (!hbFont) {
+        return run;
+    }
+
+    hb_direction_t direction = is_LTR(bidi.currentLevel()) ? HB_DIRECTION_LTR:HB_DIRECTION_RTL;
+    auto shapeText = [&](const char* textStart, const char* textEnd,
+                         TArray<ShapedGlyph>* glyphs) {
+        shape_with_harfbuzz(fBuffer.get(), hbFont.get(), font.currentFont(), utf8, utf8Bytes,
+                            textStart, textEnd, direction, hbScript, hbLanguage, hbFeatures,
+                            glyphs);
+    };
+
+    STArray<32, ShapedGlyph> glyphs;
+    if (!cacheWords) {
+        shapeText(utf8Start, utf8End, &glyphs);
+    } else {
+        HBRunCache& cache = get_run_cache();
+        STArray<16, const char*> words;
+        split_words(utf8Start, utf8End, &words);
+
+        // Words not found are shaped together, in stretches between the words that are found.
+        int missedStart = 0;
+        STArray<16, std::optional<HBRunCache::Key>> missedKeys;
+        auto shapeMissed = [&](int missedEnd) {
+            if (missedStart == missedEnd) {
+                return;
+            }
+            int glyphIndex = glyphs.size();
+            shapeText(words[missedStart], words[missedEnd], &glyphs);
+
+            // Cache each word unless HarfBuzz says it was shaped differently for having the
+            // words around it in the same buffer.
+            auto safeToBreakAt = [&](int word, int glyph) {
+                return word == missedStart || word == missedEnd || glyph == glyphs.size() ||
+                       (glyphs[glyph].fCluster == SkToU32(words[word] - utf8) &&
+                        !glyphs[glyph].fUnsafeToBreak);
+            };
+            for (int word = missedStart; word < missedEnd; ++word) {
+                int wordGlyphStart = glyphIndex;
+                while (glyphIndex < glyphs.size() &&
+                       glyphs[glyphIndex].fCluster < SkToU32(words[word + 1] - utf8)) {
+                    ++glyphIndex;
+                }
+                std::optional<HBRunCache::Key>& key = missedKeys[word - missedStart];
+                if (key && safeToBreakAt(word, wordGlyphStart) &&
+                    safeToBreakAt(word + 1, glyphIndex)) {
+                    cache.insert(std::move(*key), words[word] - utf8,
+                                 SkSpan(glyphs).subspan(wordGlyphStart,
+                                                        glyphIndex - wordGlyphStart));
+                }
+            }
+            missedKeys.clear();
+        };
+
+        STArray<16, ShapedGlyph> found;
+        for (int word = 0; word + 1 < words.size(); ++word) {
+            std::optional<HBRunCache::Key> key;
+            if (SkToSizeT(words[word + 1] - words[word]) <= HBRunCache::kMaxWordBytes) {
+                key = make_word_key(utf8, utf8Bytes, words[word], words[word + 1],
+                                    font.currentFont(), bidi.currentLevel(), hbScript, hbLanguage,
+                                    hbFeatures);
+                // Until a stretch of missed words is shaped, what is found waits in found.
+                TArray<ShapedGlyph>* foundGlyphs = &found;
+                if (missedStart == word) {
+                    foundGlyphs = &glyphs;
+                }
+                found.clear();
+                if (cache.find(*key, words[word] - utf8, foundGlyphs)) {
+                    shapeMissed(word);
+                    glyphs.push_back_n(found.size(), found.data());
+                    missedStart = word + 1;
+                    continue;
+                }
+            }
+            missedKeys.push_back(std::move(key));
+        }
+        shapeMissed(words.size() - 1);
+    }
+    if (glyphs.empty()) {
+        return run;
     }
-    run.fAdvance = runAdvance;
 
+    run = ShapedRun(RunHandler::Range(utf8Start - utf8, utf8runLength),
+                    font.currentFont(), bidi.currentLevel(),
+                    std::unique_ptr<ShapedGlyph[]>(new ShapedGlyph[glyphs.size()]), glyphs.size());
+    SkVector runAdvance = { 0, 0 };
+    for (int i = 0; i < glyphs.size(); i++) {
+        run.fGlyphs[i] = glyphs[i];
+        runAdvance += glyphs[i].fAdvance;
+    }
+    run.fAdvance = runAdvance;
     return run;
 }
 }  // namespace
@@ -1534,5 +1974,12 @@ std::unique_ptr<SkShaper::ScriptRunIterator> ScriptRunIterator(const char* utf8,
 void PurgeCaches() {
     HBLockedFaceCache cache = get_hbFace_cache();
     cache.reset();
+    get_run_cache().purge();
 }
+
+void SetRunCacheLimit(size_t bytes) { get_run_cache().setLimit(bytes); }
+
+size_t GetRunCacheLimit() { return get_run_cache().limit(); }
+
+RunCacheStats GetRunCacheStats() { return get_run_cache().stats(); }
 }  // namespace SkShapers::HB
@@ -16,12 +16,15 @@
 #include "modules/skshaper/include/SkShaper_harfbuzz.h"
 #include "modules/skshaper/include/SkShaper_skunicode.h"
 #include "modules/skunicode/include/SkUnicode.h"
+#include "src/base/SkScopeExit.h"
 #include "src/base/SkZip.h"
 #include "tools/Resources.h"
 #include "tools/fonts/FontToolUtils.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 #if defined(SK_UNICODE_ICU_IMPLEMENTATION)
@@ -271,4 +274,56 @@ SHAPER_TEST(taitham)
 SHAPER_TEST(tamil)
 #undef SHAPER_TEST
 
+DEF_TEST(Shaper_run_cache, r) {
+    const size_t limit = SkShapers::HB::GetRunCacheLimit();
+    SK_AT_SCOPE_EXIT(SkShapers::HB::SetRunCacheLimit(limit));
+    auto shaper = SkShapers::HB::ShapeDontWrapOrReorder(get_unicode(), SkFontMgr::RefEmpty());
+    if (!shaper) {
+        ERRORF(r, "Could not create shaper.");
+        return;
+    }
+    // Nothing in this font looks at a space, so its runs are cached a word at a time.
+    SkFont font(ToolUtils::CreateTypefaceFromResource("fonts/ahem.ttf"), 16);
+    if (!font.getTypeface()) {
+        ERRORF(r, "Could not load ahem.ttf.");
+        return;
+    }
+    auto shape = [&](const char* utf8, RunHandler* rh) {
+        const size_t utf8Bytes = strlen(utf8);
+        constexpr SkFourByteTag latn = SkSetFourByteTag('l','a','t','n');
+        auto fontIterator = SkShaper::TrivialFontRunIterator(font, utf8Bytes);
+        auto bidiIterator = SkShaper::TrivialBiDiRunIterator(0, utf8Bytes);
+        auto scriptIterator = SkShaper::TrivialScriptRunIterator(latn, utf8Bytes);
+        auto languageIterator = SkShaper::TrivialLanguageRunIterator("en-US", utf8Bytes);
+        shaper->shape(utf8, utf8Bytes, fontIterator, bidiIterator, scriptIterator,
+                      languageIterator, nullptr, 0, 400, rh);
+    };
+    const char utf8[] = "The same words, shaped twice.";
+    const size_t utf8Bytes = sizeof(utf8) - 1;
+
+    SkShapers::HB::SetRunCacheLimit(0);
+    RunHandler uncached("uncached", r, utf8, utf8Bytes);
+    shape(utf8, &uncached);
+
+    // Cache some of the words from other text, so that shaping the text again puts their glyphs
+    // together with those of the words shaped then.
+    SkShapers::HB::SetRunCacheLimit(1024 * 1024);
+    SkShapers::HB::PurgeCaches();
+    const char words[] = "words, The twice.";
+    RunHandler first("first", r, words, sizeof(words) - 1);
+    shape(words, &first);
+    const uint64_t hits = SkShapers::HB::GetRunCacheStats().fHits;
+    RunHandler cached("cached", r, utf8, utf8Bytes);
+    shape(utf8, &cached);
+
+    // Other tests may shape at the same time, so only expect the hits to have gone up.
+    REPORTER_ASSERT(r, SkShapers::HB::GetRunCacheStats().fHits > hits);
+    REPORTER_ASSERT(r, uncached.fGlyphCount == cached.fGlyphCount);
+    for (unsigned i = 0; i < std::min(uncached.fGlyphCount, cached.fGlyphCount); ++i) {
+        REPORTER_ASSERT(r, uncached.fGlyphs[i] == cached.fGlyphs[i]);
+        REPORTER_ASSERT(r, uncached.fPositions[i] == cached.fPositions[i]);
+        REPORTER_ASSERT(r, uncached.fClusters[i] == cached.fClusters[i]);
+    }
+}
+
 #endif  // #if defined(SK_SHAPER_HARFBUZZ_AVAILABLE) && defined(SK_SHAPER_UNICODE_AVAILABLE)
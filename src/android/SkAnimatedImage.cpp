@@ -16,6 +16,7 @@
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkPixmapUtilsPriv.h"
 #include "src/core/SkImagePriv.h"
+#include "src/core/SkTaskGroup.h"
 
 #include <limits.h>
 #include <utility>
@@ -103,7 +104,9 @@ SkAnimatedImage::SkAnimatedImage(std::unique_ptr<SkAndroidCodec> codec,
     this->decodeNextFrame();
 }
 
-SkAnimatedImage::~SkAnimatedImage() { }
+SkAnimatedImage::~SkAnimatedImage() {
+    this->waitForPrefetch();
+}
 
 SkRect SkAnimatedImage::onGetBounds() {
     return SkRect::MakeIWH(fCropRect.width(), fCropRect.height());
@@ -151,6 +154,7 @@ bool SkAnimatedImage::Frame::copyTo(Frame* dst) const {
 }
 
 void SkAnimatedImage::reset() {
+    this->waitForPrefetch();
     fFinished = false;
     fRepetitionsCompleted = 0;
     if (fDisplayFrame.fIndex != 0) {
@@ -188,6 +192,7 @@ double SkAnimatedImage::finish() {
 }
 
 int SkAnimatedImage::decodeNextFrame() {
+    this->waitForPrefetch();
     if (fFinished) {
         return kFinished;
     }
@@ -235,10 +240,38 @@ int SkAnimatedImage::decodeNextFrame() {
             if (animationEnded) {
                 return this->finish();
             }
+            this->startPrefetch();
             return fCurrentFrameDuration;
         }
     }
 
+    if (!this->decodeFrame(frameToDecode, frameInfo)) {
+        return this->finish();
+    }
+
+    using std::swap;
+    swap(fDecodingFrame, fDisplayFrame);
+    fDisplayFrame.fBitmap.notifyPixelsChanged();
+
+    if (animationEnded) {
+        return this->finish();
+    } else if (fCodec->getEncodedFormat() == SkEncodedImageFormat::kHEIF) {
+        // HEIF doesn't know the frame duration until after decoding. Update to
+        // the correct value. Note that earlier returns in this method either
+        // return kFinished, or fCurrentFrameDuration. If they return the
+        // latter, it is a frame that was previously decoded, so it has the
+        // updated value.
+        if (fCodec->codec()->getFrameInfo(frameToDecode, &frameInfo)) {
+            fCurrentFrameDuration = frameInfo.fDuration;
+        } else {
+            SkCodecPrintf("Failed to getFrameInfo on second attempt (HEIF)");
+        }
+    }
+    this->startPrefetch();
+    return fCurrentFrameDuration;
+}
+
+bool SkAnimatedImage::decodeFrame(int frameToDecode, const SkCodec::FrameInfo& frameInfo) {
     // The following code makes an effort to avoid overwriting a frame that will
     // be used again. If frame |i| is_restore_previous, frame |i+1| will not
     // depend on frame |i|, so do not overwrite frame |i-1|, which may be needed
@@ -248,6 +281,8 @@ int SkAnimatedImage::decodeNextFrame() {
     SkAndroidCodec::AndroidOptions options;
     options.fSampleSize = fSampleSize;
     options.fFrameIndex = frameToDecode;
+    options.fExecutor = fPrefetchExecutor;
+    options.fUseWebpFilterThread = fPrefetchExecutor != nullptr;
     if (frameInfo.fRequiredFrame == SkCodec::kNoFrame) {
         if (is_restore_previous(frameInfo.fDisposalMethod)) {
             // frameToDecode will be discarded immediately after drawing, so
@@ -278,7 +313,7 @@ int SkAnimatedImage::decodeNextFrame() {
         } else if (validPriorFrame(fDisplayFrame)) {
             if (!fDisplayFrame.copyTo(&fDecodingFrame)) {
                 SkCodecPrintf("Failed to allocate pixels for frame\n");
-                return this->finish();
+                return false;
             }
             options.fPriorFrame = fDecodingFrame.fIndex;
         } else if (validPriorFrame(fRestoreFrame)) {
@@ -287,7 +322,7 @@ int SkAnimatedImage::decodeNextFrame() {
                 swap(fDecodingFrame, fRestoreFrame);
             } else if (!fRestoreFrame.copyTo(&fDecodingFrame)) {
                 SkCodecPrintf("Failed to restore frame\n");
-                return this->finish();
+                return false;
             }
             options.fPriorFrame = fDecodingFrame.fIndex;
         }
@@ -298,39 +333,71 @@ int SkAnimatedImage::decodeNextFrame() {
     auto info = fDecodeInfo.makeAlphaType(alphaType);
     SkBitmap* dst = &fDecodingFrame.fBitmap;
     if (!fDecodingFrame.init(info, Frame::OnInit::kRestoreIfNecessary)) {
-        return this->finish();
+        return false;
     }
+    // The pixels no longer hold the frame they did, whether or not the decode succeeds.
+    fDecodingFrame.fIndex = SkCodec::kNoFrame;
 
     auto result = fCodec->getAndroidPixels(dst->info(), dst->getPixels(), dst->rowBytes(),
                                            &options);
     if (result != SkCodec::kSuccess) {
         SkCodecPrintf("%s, frame %i of %i\n", SkCodec::ResultToString(result),
                       frameToDecode, fFrameCount);
-        return this->finish();
+        return false;
     }
 
     fDecodingFrame.fIndex = frameToDecode;
     fDecodingFrame.fDisposalMethod = frameInfo.fDisposalMethod;
+    return true;
+}
 
-    using std::swap;
-    swap(fDecodingFrame, fDisplayFrame);
-    fDisplayFrame.fBitmap.notifyPixelsChanged();
+void SkAnimatedImage::setPrefetchExecutor(SkExecutor* executor, size_t memoryBudget) {
+    this->waitForPrefetch();
+    fPrefetchTasks.reset();
+    fPrefetchExecutor = executor;
+    fPrefetchBudget = memoryBudget;
+    this->startPrefetch();
+}
 
-    if (animationEnded) {
-        return this->finish();
-    } else if (fCodec->getEncodedFormat() == SkEncodedImageFormat::kHEIF) {
-        // HEIF doesn't know the frame duration until after decoding. Update to
-        // the correct value. Note that earlier returns in this method either
-        // return kFinished, or fCurrentFrameDuration. If they return the
-        // latter, it is a frame that was previously decoded, so it has the
-        // updated value.
-        if (fCodec->codec()->getFrameInfo(frameToDecode, &frameInfo)) {
-            fCurrentFrameDuration = frameInfo.fDuration;
-        } else {
-            SkCodecPrintf("Failed to getFrameInfo on second attempt (HEIF)");
-        }
+void SkAnimatedImage::waitForPrefetch() {
+    if (fPrefetchTasks) {
+        fPrefetchTasks->wait();
     }
-    return fCurrentFrameDuration;
+}
+
+void SkAnimatedImage::startPrefetch() {
+    if (!fPrefetchExecutor || fFinished || fFrameCount <= 1 ||
+            fDisplayFrame.fIndex == SkCodec::kNoFrame) {
+        return;
+    }
+
+    // Do not count repetitions here; decodeNextFrame() will, and it will find this frame ready.
+    const int next = fDisplayFrame.fIndex + 1 == fFrameCount ? 0 : fDisplayFrame.fIndex + 1;
+    if (next == fDecodingFrame.fIndex || next == fRestoreFrame.fIndex) {
+        return;
+    }
+
+    SkCodec::FrameInfo frameInfo;
+    if (!fCodec->codec()->getFrameInfo(next, &frameInfo) || !frameInfo.fFullyReceived) {
+        return;
+    }
+
+    const size_t frameBytes = fDecodeInfo.computeMinByteSize();
+    const size_t bytes = is_restore_previous(frameInfo.fDisposalMethod) ? 2 * frameBytes
+                                                                        : frameBytes;
+    if (SkImageInfo::ByteSizeOverflowed(frameBytes) || bytes < frameBytes ||
+            bytes > fPrefetchBudget) {
+        return;
+    }
+
+    if (!fPrefetchTasks) {
+        fPrefetchTasks = std::make_unique<SkTaskGroup>(*fPrefetchExecutor);
+    }
+    fPrefetchTasks->add([this, next, frameInfo] {
+        // A failure leaves fDecodingFrame without an index, so decodeNextFrame() will retry the
+        // frame itself and report the error.
+        this->decodeFrame(next, frameInfo);
+    });
 }
 
 void SkAnimatedImage::onDraw(SkCanvas* canvas) {
@@ -16,7 +16,9 @@
 #include "include/core/SkStream.h"
 #include "modules/skcms/skcms.h"
 #include "src/codec/SkAndroidCodecAdapter.h"
+#include "src/codec/SkCodecFrameCache.h"
 #include "src/codec/SkCodecPriv.h"
+#include "src/codec/SkFrameHolder.h"
 #include "src/codec/SkSampledCodec.h"
 
 #include <algorithm>
@@ -512,6 +514,16 @@ SkCodec::Result SkAndroidCodec::getAndroidPixels(const SkImageInfo& requestInfo,
         }
     }
 
+    // A shared frame saves decoding it, and any frames that it requires, at a scale the codec
+    // decodes directly. Frames sampled any other way are not cached.
+    if (const uint64_t frameCacheID = fCodec->frameCacheID(*options);
+            frameCacheID && SkCodecFrameCache::Find(frameCacheID,
+                                                    *fCodec->getFrameHolder()->frameCacheData(),
+                                                    options->fFrameIndex, requestInfo,
+                                                    requestPixels, requestRowBytes)) {
+        return SkCodec::kSuccess;
+    }
+
     // We may need to have handleFrameIndex recursively call this method
     // to resolve one frame depending on another. The recursion stops
     // when we find a frame which does not require an earlier frame
@@ -21,6 +21,7 @@
 #include "include/private/base/SkTemplates.h"
 #include "modules/skcms/skcms.h"
 #include "src/base/SkNoDestructor.h"
+#include "src/codec/SkCodecFrameCache.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkFrameHolder.h"
 #include "src/codec/SkPixmapUtilsPriv.h"
@@ -495,15 +496,26 @@ SkCodec::Result SkCodec::getPixels(const SkImageInfo& info, void* pixels, size_t
         }
     }
 
+    const uint64_t frameCacheID = this->frameCacheID(*options);
+    const SkData* frameCacheData =
+            frameCacheID ? this->getFrameHolder()->frameCacheData() : nullptr;
+    if (frameCacheID && SkCodecFrameCache::Find(frameCacheID, *frameCacheData,
+                                                options->fFrameIndex, info, pixels, rowBytes)) {
+        return kSuccess;
+    }
+
     const Result frameIndexResult = this->handleFrameIndex(info, pixels, rowBytes,
                                                            *options);
     if (frameIndexResult != kSuccess) {
         return frameIndexResult;
     }
 
-    // FIXME: Support subsets somehow? Note that this works for SkWebpCodec
+    // An unscaled subset is always supported once onGetValidSubset() has accepted it.
+    // FIXME: Support scaled subsets somehow? Note that this works for SkWebpCodec
     // because it supports arbitrary scaling/subset combinations.
-    if (!this->dimensionsSupported(info.dimensions())) {
+    const bool unscaledSubset = options->fSubset &&
+                                info.dimensions() == options->fSubset->size();
+    if (!unscaledSubset && !this->dimensionsSupported(info.dimensions())) {
         return kInvalidScale;
     }
 
@@ -531,9 +543,37 @@ SkCodec::Result SkCodec::getPixels(const SkImageInfo& info, void* pixels, size_t
                 rowsDecoded);
     }
 
+    if (frameCacheID && kSuccess == result) {
+        SkCodecFrameCache::Add(frameCacheID, *frameCacheData, options->fFrameIndex, info, pixels,
+                               rowBytes);
+    }
     return result;
 }
 
+uint64_t SkCodec::frameCacheID(const Options& options) {
+    // A subset is not a complete frame, so it cannot stand in for one.
+    const SkFrameHolder* frameHolder = this->getFrameHolder();
+    if (!frameHolder || !frameHolder->frameCacheID() || options.fSubset) {
+        return 0;
+    }
+
+    // Leave it to handleFrameIndex() to reject a bad index or prior frame, as it would without
+    // the cache.
+    const int index = options.fFrameIndex;
+    if (index < 0 || index >= this->onGetFrameCount()) {
+        return 0;
+    }
+    if (options.fPriorFrame != kNoFrame) {
+        const SkFrame* frame = frameHolder->getFrame(index);
+        if (options.fPriorFrame < frame->getRequiredFrame() || options.fPriorFrame >= index ||
+            frameHolder->getFrame(options.fPriorFrame)->getDisposalMethod() ==
+                    SkCodecAnimation::DisposalMethod::kRestorePrevious) {
+            return 0;
+        }
+    }
+    return frameHolder->frameCacheID();
+}
+
 std::tuple<sk_sp<SkImage>, SkCodec::Result> SkCodec::getImage(const SkImageInfo& info,
                                                               const Options* options) {
     SkBitmap bm;
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkCodecFrameCache.h"
+
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkRefCnt.h"
+#include "src/base/SkRectMemcpy.h"
+#include "src/core/SkCachedData.h"
+#include "src/core/SkChecksum.h"
+#include "src/core/SkResourceCache.h"
+
+class SkDiscardableMemory;
+
+#define CHECK_LOCAL(localCache, localName, globalName, ...) \
+    ((localCache) ? localCache->localName(__VA_ARGS__) : SkResourceCache::globalName(__VA_ARGS__))
+
+namespace {
+static unsigned gCodecFrameKeyNamespaceLabel;
+
+struct CodecFrameKey : public SkResourceCache::Key {
+    CodecFrameKey(uint64_t dataID, int frameIndex, const SkImageInfo& info)
+        : fFrameIndex(frameIndex)
+        , fWidth(info.width())
+        , fHeight(info.height())
+        , fColorType(info.colorType())
+        , fAlphaType(info.alphaType())
+        , fColorSpaceHash(info.colorSpace() ? info.colorSpace()->toXYZD50Hash() : 0)
+        , fTransferFnHash(info.colorSpace() ? info.colorSpace()->transferFnHash() : 0)
+    {
+        this->init(&gCodecFrameKeyNamespaceLabel, dataID,
+                   sizeof(fFrameIndex) + sizeof(fWidth) + sizeof(fHeight) + sizeof(fColorType) +
+                   sizeof(fAlphaType) + sizeof(fColorSpaceHash) + sizeof(fTransferFnHash));
+    }
+
+    int32_t  fFrameIndex;
+    int32_t  fWidth;
+    int32_t  fHeight;
+    int32_t  fColorType;
+    int32_t  fAlphaType;
+    uint32_t fColorSpaceHash;
+    uint32_t fTransferFnHash;
+};
+
+struct CodecFrameRec : public SkResourceCache::Rec {
+    CodecFrameRec(const CodecFrameKey& key, sk_sp<SkData> encoded, SkCachedData* data)
+        : fKey(key)
+        , fEncoded(std::move(encoded))
+        , fData(data)
+    {
+        fData->attachToCacheAndRef();
+    }
+    ~CodecFrameRec() override {
+        fData->detachFromCacheAndUnref();
+    }
+
+    CodecFrameKey fKey;
+    // The frame's encoded data, to tell it apart from other data with the same digest. It is
+    // shared with the codecs and the image's other frames, so it isn't counted in bytesUsed().
+    sk_sp<SkData> fEncoded;
+    SkCachedData* fData;
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override { return sizeof(*this) + fData->size(); }
+    const char* getCategory() const override { return "codec-frame"; }
+    SkDiscardableMemory* diagnostic_only_getDiscardable() const override {
+        return fData->diagnostic_only_getDiscardable();
+    }
+
+    struct Context {
+        const SkData* fEncoded;
+        SkCachedData* fResult;
+    };
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* contextData) {
+        const CodecFrameRec& rec = static_cast<const CodecFrameRec&>(baseRec);
+        Context* context = static_cast<Context*>(contextData);
+
+        // The digest only finds candidates; the bytes decide. On a mismatch the cache drops this
+        // entry, making room for the caller's own frame.
+        const SkData* encoded = context->fEncoded;
+        if (rec.fEncoded.get() != encoded && !rec.fEncoded->equals(encoded)) {
+            return false;
+        }
+
+        SkCachedData* tmpData = rec.fData;
+        tmpData->ref();
+        if (nullptr == tmpData->data()) {
+            tmpData->unref();
+            return false;
+        }
+        context->fResult = tmpData;
+        return true;
+    }
+};
+} // namespace
+
+uint64_t SkCodecFrameCache::DataID(const void* data, size_t size) {
+    const uint64_t id = SkChecksum::Hash64(data, size, size);
+    return id ? id : 1;
+}
+
+bool SkCodecFrameCache::Find(uint64_t dataID, const SkData& encoded, int frameIndex,
+                             const SkImageInfo& info, void* pixels, size_t rowBytes,
+                             SkResourceCache* localCache) {
+    CodecFrameRec::Context context = {&encoded, nullptr};
+    CodecFrameKey key(dataID, frameIndex, info);
+    if (!CHECK_LOCAL(localCache, find, Find, key, CodecFrameRec::Visitor, &context)) {
+        return false;
+    }
+    SkCachedData* data = context.fResult;
+
+    // Copy outside of the cache's lock; the ref keeps the pixels from being purged meanwhile.
+    SkRectMemcpy(pixels, rowBytes, data->data(), info.minRowBytes(), info.minRowBytes(),
+                 info.height());
+    data->unref();
+    return true;
+}
+
+void SkCodecFrameCache::Add(uint64_t dataID, const SkData& encoded, int frameIndex,
+                            const SkImageInfo& info, const void* pixels, size_t rowBytes,
+                            SkResourceCache* localCache) {
+    const size_t size = info.computeMinByteSize();
+    if (SkImageInfo::ByteSizeOverflowed(size) || 0 == size) {
+        return;
+    }
+    SkCachedData* data = CHECK_LOCAL(localCache, newCachedData, NewCachedData, size);
+    if (!data) {
+        return;
+    }
+    SkRectMemcpy(data->writable_data(), info.minRowBytes(), pixels, rowBytes, info.minRowBytes(),
+                 info.height());
+
+    CHECK_LOCAL(localCache, add, Add, new CodecFrameRec(CodecFrameKey(dataID, frameIndex, info),
+                                                        sk_ref_sp(&encoded), data));
+    data->unref();
+}
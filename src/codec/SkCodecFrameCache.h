@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkCodecFrameCache_DEFINED
+#define SkCodecFrameCache_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+
+class SkData;
+class SkResourceCache;
+struct SkImageInfo;
+
+/*
+ * Decoded frames of animated images, kept in SkResourceCache so that every codec made from the
+ * same encoded data can share them instead of decoding each frame again.
+ *
+ * Frames are keyed by a digest of the encoded data rather than by the SkData or SkStream holding
+ * it, so separate copies of one image share frames too. Each cached frame also keeps a ref on the
+ * encoded data it came from, and a lookup only succeeds if that matches the caller's data byte
+ * for byte, so images whose digests collide never see each other's pixels. The digest is also
+ * the cache's shared ID for the frames, so posting
+ * SkResourceCache::PostPurgeSharedID(DataID(...)) purges all of them.
+ */
+class SkCodecFrameCache {
+public:
+    /*
+     * Returns the ID to cache the frames of |data| under. It is never 0, which callers may use
+     * to mean that frames are not cached.
+     */
+    static uint64_t DataID(const void* data, size_t size);
+
+    /*
+     * Copies the cached frame |frameIndex| of |encoded|, whose DataID() is |dataID|, decoded to
+     * |info|, into |pixels|. Returns false if it is not in the cache.
+     */
+    static bool Find(uint64_t dataID, const SkData& encoded, int frameIndex,
+                     const SkImageInfo& info, void* pixels, size_t rowBytes,
+                     SkResourceCache* localCache = nullptr);
+
+    /*
+     * Adds a copy of frame |frameIndex| of |encoded|, whose DataID() is |dataID|, completely
+     * decoded to |info|.
+     */
+    static void Add(uint64_t dataID, const SkData& encoded, int frameIndex,
+                    const SkImageInfo& info, const void* pixels, size_t rowBytes,
+                    SkResourceCache* localCache = nullptr);
+};
+
+#endif  // SkCodecFrameCache_DEFINED
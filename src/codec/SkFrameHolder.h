@@ -10,7 +10,9 @@
 
 #include "include/codec/SkCodec.h"
 #include "include/codec/SkCodecAnimation.h"
+#include "include/core/SkData.h"
 #include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
 #include "include/core/SkTypes.h"
 #include "include/private/SkEncodedInfo.h"
 #include "include/private/base/SkNoncopyable.h"
@@ -171,6 +173,7 @@ public:
     SkFrameHolder()
         : fScreenWidth(0)
         , fScreenHeight(0)
+        , fFrameCacheID(0)
     {}
 
     virtual ~SkFrameHolder() {}
@@ -196,9 +199,23 @@ public:
         return this->onGetFrame(i);
     }
 
+    /**
+     *  The SkCodecFrameCache ID under which SkCodec shares decoded frames
+     *  with other codecs of the same encoded data, or 0 if it does not,
+     *  and that encoded data, which a cached frame must match exactly.
+     */
+    uint64_t frameCacheID() const { return fFrameCacheID; }
+    const SkData* frameCacheData() const { return fFrameCacheData.get(); }
+    void setFrameCacheData(uint64_t id, sk_sp<SkData> data) {
+        fFrameCacheID = id;
+        fFrameCacheData = std::move(data);
+    }
+
 protected:
     int fScreenWidth;
     int fScreenHeight;
+    uint64_t fFrameCacheID;
+    sk_sp<SkData> fFrameCacheData;
 
     virtual const SkFrame* onGetFrame(int i) const = 0;
 };
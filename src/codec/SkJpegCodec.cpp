@@ -12,6 +12,7 @@
 #include "include/core/SkAlphaType.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkRefCnt.h"
@@ -26,17 +27,22 @@
 #include "src/codec/SkJpegDecoderMgr.h"
 #include "src/codec/SkJpegMetadataDecoderImpl.h"
 #include "src/codec/SkJpegPriv.h"
+#include "src/codec/SkJpegRestartIndex.h"
 #include "src/codec/SkParseEncodedOrigin.h"
 #include "src/codec/SkSwizzler.h"
+#include "src/core/SkTaskGroup.h"
 
 #ifdef SK_CODEC_DECODES_JPEG_GAINMAPS
 #include "include/private/SkGainmapInfo.h"
 #endif  // SK_CODEC_DECODES_JPEG_GAINMAPS
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <csetjmp>
 #include <cstring>
 #include <utility>
+#include <vector>
 
 using namespace skia_private;
 
@@ -475,6 +481,178 @@ static inline bool needs_swizzler_to_convert_from_cmyk(J_COLOR_SPACE jpegColorTy
     return !hasCMYKColorSpace || !hasColorSpaceXform;
 }
 
+// Restart slices only pay for their setup when each has at least this many pixels.
+static constexpr int kMinRestartSlicePixels = 1 << 20;
+
+const SkJpegRestartIndex* SkJpegCodec::restartIndex() {
+    if (!fTriedRestartIndex) {
+        fTriedRestartIndex = true;
+        // Bands are built straight from the encoded bytes, so they must all be in memory.
+        SkStream* stream = this->stream();
+        const void* data = stream->getMemoryBase();
+        if (data && stream->hasLength() && !fDecoderMgr->dinfo()->progressive_mode) {
+            fRestartIndex = SkJpegRestartIndex::Make(static_cast<const uint8_t*>(data),
+                                                     stream->getLength());
+            if (fRestartIndex && fRestartIndex->height() != this->dimensions().height()) {
+                fRestartIndex = nullptr;
+            }
+        }
+    }
+    return fRestartIndex.get();
+}
+
+std::unique_ptr<SkCodec> SkJpegCodec::makeBandCodec(size_t first, size_t last) {
+    SkASSERT(fRestartIndex);
+    const uint8_t* data = static_cast<const uint8_t*>(this->stream()->getMemoryBase());
+
+    // The band carries the profile over, rather than the APP2 segments it came from.
+    const skcms_ICCProfile* profile = this->getEncodedInfo().profile();
+    Result result;
+    return SkJpegCodec::MakeFromStream(
+            SkMemoryStream::Make(fRestartIndex->makeBand(data, first, last)),
+            &result,
+            profile ? SkEncodedInfo::ICCProfile::Make(*profile) : nullptr);
+}
+
+bool SkJpegCodec::decodeRestartSlices(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                                      SkExecutor* executor) {
+    const jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    if (dinfo->restart_interval == 0 || dstInfo.dimensions() != this->dimensions() ||
+        dstInfo.width() * (int64_t)dstInfo.height() < 2 * kMinRestartSlicePixels) {
+        return false;
+    }
+    const SkJpegRestartIndex* index = this->restartIndex();
+    if (!index) {
+        return false;
+    }
+
+    // Greedily group the restart boundaries into slices of at least kMinRestartSlicePixels.
+    const int height = dstInfo.height();
+    const int minSliceRows = kMinRestartSlicePixels / dstInfo.width();
+    std::vector<size_t> sliceStarts = {0};
+    for (size_t i = 1; i < index->boundaryCount(); i++) {
+        const int top = index->boundaryTop(i);
+        if (top - index->boundaryTop(sliceStarts.back()) >= minSliceRows &&
+            height - top >= minSliceRows) {
+            sliceStarts.push_back(i);
+        }
+    }
+    if (sliceStarts.size() < 2) {
+        return false;
+    }
+    sliceStarts.push_back(index->boundaryCount());
+
+    std::atomic<bool> failed{false};
+    SkTaskGroup tg(*executor);
+    tg.batch(sliceStarts.size() - 1, [&](int i) {
+        // With context rows, decode an extra interval on either side so that upsampling at the
+        // edges of the slice sees the same neighbours as it would in the full image.
+        const size_t first = sliceStarts[i],
+                     last = sliceStarts[i + 1];
+        const bool context = index->needsContextRows();
+        const size_t decodeFirst = context && first > 0 ? first - 1 : first,
+                     decodeLast = context && last < index->boundaryCount() ? last + 1 : last;
+
+        std::unique_ptr<SkCodec> codec = this->makeBandCodec(decodeFirst, decodeLast);
+        if (!codec || kSuccess != codec->startScanlineDecode(
+                                          dstInfo.makeDimensions(codec->dimensions()))) {
+            failed = true;
+            return;
+        }
+
+        const int top = index->boundaryTop(first),
+                  bottom = index->boundaryTop(last),
+                  skip = top - index->boundaryTop(decodeFirst);
+        if (skip > 0) {
+            AutoTMalloc<uint8_t> discard(rowBytes);
+            if (codec->getScanlines(discard.get(), skip, 0) != skip) {
+                failed = true;
+                return;
+            }
+        }
+        if (codec->getScanlines(SkTAddOffset<void>(dst, top * rowBytes), bottom - top,
+                                rowBytes) != bottom - top) {
+            failed = true;
+        }
+    });
+    tg.wait();
+    return !failed;
+}
+
+bool SkJpegCodec::onGetValidSubset(SkIRect* desiredSubset) const {
+    // Any subset can be decoded from a restart index. SkCodec::getPixels() asks this before it
+    // rewinds, so callers that fall back to scanline decoding still have their rewind. Building
+    // the index only reads the encoded bytes in memory, not the stream.
+    return SkIRect::MakeSize(this->dimensions()).contains(*desiredSubset) &&
+           const_cast<SkJpegCodec*>(this)->restartIndex();
+}
+
+SkCodec::Result SkJpegCodec::decodeSubset(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                                          const SkIRect& subset, int* rowsDecoded) {
+    const SkJpegRestartIndex* index = this->restartIndex();
+    if (!index) {
+        return kUnimplemented;
+    }
+
+    // Decode the band from the last boundary above the subset to the first one below it, with
+    // a row to spare on either side if upsampling needs it.
+    const int context = index->needsContextRows() ? 1 : 0;
+    size_t first = 0;
+    while (first + 1 < index->boundaryCount() &&
+           index->boundaryTop(first + 1) <= subset.top() - context) {
+        first++;
+    }
+    size_t last = first + 1;
+    while (last < index->boundaryCount() &&
+           index->boundaryTop(last) < subset.bottom() + context) {
+        last++;
+    }
+
+    std::unique_ptr<SkCodec> codec = this->makeBandCodec(first, last);
+    if (!codec) {
+        return kErrorInInput;
+    }
+
+    // libjpeg replicates the edges of a crop when upsampling, so widen it by the context columns
+    // and only keep the subset's columns.
+    const int width = this->dimensions().width(),
+              left  = std::max(subset.left()  - index->contextColumns(), 0),
+              right = std::min(subset.right() + index->contextColumns(), width);
+    const SkIRect bandSubset = SkIRect::MakeLTRB(left, 0, right, codec->dimensions().height());
+    Options bandOptions;
+    bandOptions.fSubset = &bandSubset;
+    const Result result = codec->startScanlineDecode(
+            dstInfo.makeDimensions(codec->dimensions()), &bandOptions);
+    if (result != kSuccess) {
+        return result;
+    }
+
+    if (!codec->skipScanlines(subset.top() - index->boundaryTop(first))) {
+        *rowsDecoded = 0;
+        return kIncompleteInput;
+    }
+    if (bandSubset.width() == subset.width()) {
+        const int rows = codec->getScanlines(dst, subset.height(), rowBytes);
+        if (rows != subset.height()) {
+            *rowsDecoded = rows;
+            return kIncompleteInput;
+        }
+        return kSuccess;
+    }
+
+    const size_t bpp = dstInfo.bytesPerPixel();
+    AutoTMalloc<uint8_t> row(bandSubset.width() * bpp);
+    for (int y = 0; y < subset.height(); y++) {
+        if (codec->getScanlines(row.get(), 1, 0) != 1) {
+            *rowsDecoded = y;
+            return kIncompleteInput;
+        }
+        memcpy(SkTAddOffset<void>(dst, y * rowBytes), row.get() + (subset.left() - left) * bpp,
+               subset.width() * bpp);
+    }
+    return kSuccess;
+}
+
 /*
  * Performs the jpeg decode
  */
@@ -483,8 +661,12 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
                                          const Options& options,
                                          int* rowsDecoded) {
     if (options.fSubset) {
-        // Subsets are not supported.
-        return kUnimplemented;
+        return this->decodeSubset(dstInfo, dst, dstRowBytes, *options.fSubset, rowsDecoded);
+    }
+
+    if (options.fExecutor &&
+        this->decodeRestartSlices(dstInfo, dst, dstRowBytes, options.fExecutor)) {
+        return kSuccess;
     }
 
     // Get a pointer to the decompress info since we will use it quite frequently
@@ -23,6 +23,8 @@
 #include <memory>
 
 class JpegDecoderMgr;
+class SkExecutor;
+class SkJpegRestartIndex;
 class SkSampler;
 class SkStream;
 class SkSwizzler;
@@ -74,6 +76,8 @@ protected:
 
     bool conversionSupported(const SkImageInfo&, bool, bool) override;
 
+    bool onGetValidSubset(SkIRect* desiredSubset) const override;
+
     bool onGetGainmapCodec(SkGainmapInfo* info, std::unique_ptr<SkCodec>* gainmapCodec) override;
     bool onGetGainmapInfo(SkGainmapInfo* info,
                           std::unique_ptr<SkStream>* gainmapImageStream) override;
@@ -133,6 +137,32 @@ private:
     Result readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count,
                   const Options&, int* rowsDecoded);
 
+    /*
+     * Decodes the image as horizontal bands that start at restart markers, each with its own
+     * decoder, concurrently on the executor.  Returns false if the image cannot be split this
+     * way or if any band fails to decode, in which case the caller should decode it serially.
+     */
+    bool decodeRestartSlices(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                             SkExecutor* executor);
+
+    /*
+     * Builds the restart index on first use.  Returns nullptr if the image cannot be indexed,
+     * e.g. because it is progressive or its stream is not in memory.
+     */
+    const SkJpegRestartIndex* restartIndex();
+
+    /*
+     * Returns a codec for the rows from restart index boundary |first| up to |last|.
+     */
+    std::unique_ptr<SkCodec> makeBandCodec(size_t first, size_t last);
+
+    /*
+     * Decodes |subset| by seeking to the nearest restart boundary above it, rather than
+     * decoding every row above it.
+     */
+    Result decodeSubset(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                        const SkIRect& subset, int* rowsDecoded);
+
     /*
      * Scanline decoding.
      */
@@ -158,6 +188,9 @@ private:
     // to further subset the output from libjpeg-turbo.
     SkIRect fSwizzlerSubset = SkIRect::MakeEmpty();
 
+    std::unique_ptr<SkJpegRestartIndex> fRestartIndex;
+    bool                                fTriedRestartIndex = false;
+
     std::unique_ptr<SkSwizzler>        fSwizzler;
 
     friend class SkRawCodec;
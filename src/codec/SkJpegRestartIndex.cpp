@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkJpegRestartIndex.h"
+
+#include "include/core/SkData.h"
+#include "src/codec/SkJpegConstants.h"
+#include "src/codec/SkJpegSegmentScan.h"
+
+#include <algorithm>
+#include <cstring>
+
+static bool keep_in_band_header(uint8_t marker) {
+    // JFIF (APP0) and Adobe (APP14) segments affect how libjpeg interprets the components.
+    // The rest of the metadata is read from the full image.
+    if (marker >= kJpegMarkerAPP0 && marker <= kJpegMarkerAPP0 + 15) {
+        return marker == kJpegMarkerAPP0 || marker == kJpegMarkerAPP0 + 14;
+    }
+    return marker != 0xFE;  // COM
+}
+
+std::unique_ptr<SkJpegRestartIndex> SkJpegRestartIndex::Make(const uint8_t* data, size_t size) {
+    SkJpegSegmentScanner scanner(kJpegMarkerEndOfImage);
+    scanner.onBytes(data, size);
+    if (!scanner.isDone()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SkJpegRestartIndex> index(new SkJpegRestartIndex);
+    int width = 0, components = 0, maxH = 0, maxV = 0, minH = 16, minV = 16;
+    int restartInterval = 0;
+    size_t scanStart = 0;
+    for (const SkJpegSegment& segment : scanner.getSegments()) {
+        if (scanStart) {
+            if (segment.marker == 0xD0 + (index->fRestartMarkers.size() & 7)) {
+                index->fRestartMarkers.push_back(segment.offset);
+                continue;
+            }
+            if (segment.marker != kJpegMarkerEndOfImage) {
+                // A second scan, or a restart marker out of sequence.
+                return nullptr;
+            }
+            index->fEndOfScan = segment.offset;
+            break;
+        }
+
+        const uint8_t* params =
+                data + segment.offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize;
+        const size_t paramSize = segment.parameterLength > kJpegSegmentParameterLengthSize
+                ? segment.parameterLength - kJpegSegmentParameterLengthSize : 0;
+        switch (segment.marker) {
+            case 0xC0:  // SOF0, baseline
+            case 0xC1:  // SOF1, extended sequential Huffman
+                if (paramSize < 6) {
+                    return nullptr;
+                }
+                index->fHeight = (params[1] << 8) | params[2];
+                width = (params[3] << 8) | params[4];
+                components = params[5];
+                if (width == 0 || index->fHeight == 0 || components == 0 ||
+                    paramSize < 6 + 3 * (size_t)components) {
+                    return nullptr;
+                }
+                for (int i = 0; i < components; i++) {
+                    const int h = params[7 + 3 * i] >> 4,
+                              v = params[7 + 3 * i] & 0xF;
+                    maxH = std::max(maxH, h);
+                    maxV = std::max(maxV, v);
+                    minH = std::min(minH, h);
+                    minV = std::min(minV, v);
+                }
+                index->fHeightOffset = index->fHeader.size() + kJpegMarkerCodeSize +
+                                       kJpegSegmentParameterLengthSize + 1;
+                break;
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                // Progressive, lossless, hierarchical or arithmetic coded.
+                return nullptr;
+            case 0xDD:  // DRI
+                if (paramSize < 2) {
+                    return nullptr;
+                }
+                restartInterval = (params[0] << 8) | params[1];
+                break;
+            case kJpegMarkerStartOfScan:
+                // Every component must be interleaved in this one scan.
+                if (paramSize < 1 || params[0] != components) {
+                    return nullptr;
+                }
+                scanStart = segment.offset + kJpegMarkerCodeSize + segment.parameterLength;
+                break;
+        }
+        if (keep_in_band_header(segment.marker)) {
+            const uint8_t* bytes = data + segment.offset;
+            index->fHeader.insert(index->fHeader.end(), bytes,
+                                  bytes + kJpegMarkerCodeSize + segment.parameterLength);
+        }
+    }
+    if (!scanStart || !index->fEndOfScan || !components) {
+        return nullptr;
+    }
+
+    // A scan of a single component is coded in 8x8 blocks whatever its sampling factors.
+    const int mcuWidth  = components == 1 ? 8 : 8 * maxH;
+    index->fMcuHeight   = components == 1 ? 8 : 8 * maxV;
+    index->fNeedsContextRows = components > 1 && minV < maxV;
+    index->fContextColumns   = components > 1 && minH < maxH ? mcuWidth : 0;
+    const int mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+    const int mcuRows = (index->fHeight + index->fMcuHeight - 1) / index->fMcuHeight;
+    const int64_t mcuCount = (int64_t)mcusPerRow * mcuRows;
+    const int64_t expectedMarkers = restartInterval ? (mcuCount - 1) / restartInterval : 0;
+    if ((int64_t)index->fRestartMarkers.size() != expectedMarkers) {
+        return nullptr;
+    }
+
+    index->fBoundaries.push_back({0, scanStart, 0});
+    for (size_t i = 0; i < index->fRestartMarkers.size(); i++) {
+        const int64_t firstMcu = (int64_t)(i + 1) * restartInterval;
+        if (firstMcu % mcusPerRow == 0) {
+            index->fBoundaries.push_back({(int)(firstMcu / mcusPerRow),
+                                          index->fRestartMarkers[i] + kJpegMarkerCodeSize,
+                                          i + 1});
+        }
+    }
+    return index;
+}
+
+int SkJpegRestartIndex::boundaryTop(size_t i) const {
+    return i < fBoundaries.size() ? fBoundaries[i].fMcuRow * fMcuHeight : fHeight;
+}
+
+sk_sp<SkData> SkJpegRestartIndex::makeBand(const uint8_t* data, size_t first, size_t last) const {
+    const Boundary& start = fBoundaries[first];
+    const bool toEnd = last >= fBoundaries.size();
+    const size_t dataEnd = toEnd ? fEndOfScan
+                                 : fBoundaries[last].fDataOffset - kJpegMarkerCodeSize;
+    const size_t markerEnd = toEnd ? fRestartMarkers.size() : fBoundaries[last].fFirstMarker - 1;
+    const int height = this->boundaryTop(last) - this->boundaryTop(first);
+
+    const size_t headerSize = fHeader.size();
+    sk_sp<SkData> band = SkData::MakeUninitialized(headerSize + (dataEnd - start.fDataOffset) +
+                                                   kJpegMarkerCodeSize);
+    uint8_t* bytes = static_cast<uint8_t*>(band->writable_data());
+    memcpy(bytes, fHeader.data(), headerSize);
+    bytes[fHeightOffset + 0] = height >> 8;
+    bytes[fHeightOffset + 1] = height & 0xFF;
+    memcpy(bytes + headerSize, data + start.fDataOffset, dataEnd - start.fDataOffset);
+
+    // libjpeg insists that the restart markers count up from RST0.
+    for (size_t i = start.fFirstMarker; i < markerEnd; i++) {
+        bytes[headerSize + fRestartMarkers[i] - start.fDataOffset + 1] =
+                0xD0 + ((i - start.fFirstMarker) & 7);
+    }
+    bytes[band->size() - 2] = 0xFF;
+    bytes[band->size() - 1] = kJpegMarkerEndOfImage;
+    return band;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkJpegRestartIndex_codec_DEFINED
+#define SkJpegRestartIndex_codec_DEFINED
+
+#include "include/core/SkRefCnt.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class SkData;
+
+/*
+ * An index of the places where decoding a baseline JPEG can start part way down the image: the
+ * restart intervals that begin an MCU row.  From it we can build a standalone JPEG for any band
+ * of MCU rows, which libjpeg can decode without touching the rest of the entropy-coded data.
+ *
+ * The index only records offsets, so the encoded data must outlive it and be passed back in.
+ */
+class SkJpegRestartIndex {
+public:
+    /*
+     * Returns nullptr unless |data| is a baseline (or extended sequential Huffman) JPEG with a
+     * single scan that interleaves all of its components.  An image without restart markers
+     * still gets an index, with a single boundary at the top.
+     */
+    static std::unique_ptr<SkJpegRestartIndex> Make(const uint8_t* data, size_t size);
+
+    int height() const { return fHeight; }
+
+    /*
+     * Vertically subsampled chroma is upsampled from the MCU rows above and below, so a band
+     * needs an extra MCU row on either side to decode exactly as it would in the full image.
+     */
+    bool needsContextRows() const { return fNeedsContextRows; }
+
+    /*
+     * Likewise, horizontally subsampled chroma needs an extra MCU column on either side of a crop.
+     */
+    int contextColumns() const { return fContextColumns; }
+
+    /*
+     * The boundaries are in increasing order of row, and the first is always row 0.
+     */
+    size_t boundaryCount() const { return fBoundaries.size(); }
+
+    /*
+     * The first pixel row of boundary |i|, or height() if |i| is boundaryCount().
+     */
+    int boundaryTop(size_t i) const;
+
+    /*
+     * Returns a JPEG of the rows from boundary |first| up to boundary |last|, which may be
+     * boundaryCount() to go to the bottom of the image.  |data| must be the data this index was
+     * made from.
+     */
+    sk_sp<SkData> makeBand(const uint8_t* data, size_t first, size_t last) const;
+
+private:
+    SkJpegRestartIndex() = default;
+
+    struct Boundary {
+        int    fMcuRow;
+        // Offset of the restart interval's first byte of entropy-coded data.
+        size_t fDataOffset;
+        // Index in fRestartMarkers of the first marker after fDataOffset.
+        size_t fFirstMarker;
+    };
+
+    // SOI through SOS, minus the APPn and COM segments that a band does not need.
+    std::vector<uint8_t>  fHeader;
+    // Offset in fHeader of the SOF's 16-bit image height.
+    size_t                fHeightOffset = 0;
+    int                   fHeight = 0;
+    int                   fMcuHeight = 0;
+    bool                  fNeedsContextRows = false;
+    int                   fContextColumns = 0;
+    std::vector<Boundary> fBoundaries;
+    // Offsets of every RSTn marker in the scan, and of the EOI that ends it.
+    std::vector<size_t>   fRestartMarkers;
+    size_t                fEndOfScan = 0;
+};
+
+#endif
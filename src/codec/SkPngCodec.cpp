@@ -26,6 +26,7 @@
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkPngCompositeChunkReader.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/codec/SkPngRowIndex.h"
 #include "src/codec/SkSwizzler.h"
 
 #include <csetjmp>
@@ -1006,13 +1007,107 @@ SkCodec::Result SkPngCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
     }
 
     if (options.fSubset) {
-        return kUnimplemented;
+        return this->decodeSubset(dst, rowBytes, *options.fSubset, rowsDecoded);
     }
 
     this->initializeXformParams();
     return this->decodeAllRows(dst, rowBytes, rowsDecoded);
 }
 
+// Returns true if libpng hands over the rows of this image just as they were encoded, so that
+// SkPngRowIndex can stand in for it.  Sets |bytesPerPixel| if so.
+static bool rows_need_no_transforms(png_const_structp png_ptr, png_const_infop info_ptr,
+                                    int* bytesPerPixel) {
+    png_uint_32 width, height;
+    int bitDepth, encodedColorType, interlaceType;
+    png_get_IHDR(png_ptr, info_ptr, &width, &height, &bitDepth, &encodedColorType,
+                 &interlaceType, nullptr, nullptr);
+    if (interlaceType != PNG_INTERLACE_NONE) {
+        return false;
+    }
+
+    // These mirror the transforms set up in AutoCleanPng::infoCallback().
+    const bool hasTrns = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
+    int channels;
+    switch (encodedColorType) {
+        case PNG_COLOR_TYPE_PALETTE:
+            channels = 1;
+            if (bitDepth != 8) {
+                return false;
+            }
+            break;
+        case PNG_COLOR_TYPE_RGB:
+            channels = 3;
+            if (hasTrns) {
+                return false;
+            }
+            break;
+        case PNG_COLOR_TYPE_GRAY:
+            channels = 1;
+            if (bitDepth != 8 || hasTrns) {
+                return false;
+            }
+            break;
+        case PNG_COLOR_TYPE_GRAY_ALPHA:
+            channels = 2;
+            if (bitDepth != 8) {
+                return false;
+            }
+            break;
+        case PNG_COLOR_TYPE_RGBA:
+            channels = 4;
+            break;
+        default:
+            return false;
+    }
+    *bytesPerPixel = channels * bitDepth / 8;
+    return true;
+}
+
+bool SkPngCodec::onGetValidSubset(SkIRect* desiredSubset) const {
+    // As in SkJpegCodec, only accept subsets once the index exists, so that getPixels() rejects
+    // the rest before it rewinds. Building the index only reads the encoded bytes in memory.
+    return fPng_ptr && SkIRect::MakeSize(this->dimensions()).contains(*desiredSubset) &&
+           const_cast<SkPngCodec*>(this)->rowIndex();
+}
+
+const SkPngRowIndex* SkPngCodec::rowIndex() {
+    if (!fTriedRowIndex) {
+        fTriedRowIndex = true;
+        // The index inflates straight from the encoded bytes, so they must all be in memory.
+        SkStream* stream = this->stream();
+        const void* data = stream->getMemoryBase();
+        int bytesPerPixel;
+        if (data && stream->hasLength() &&
+            rows_need_no_transforms(fPng_ptr, fInfo_ptr, &bytesPerPixel)) {
+            fRowIndex = SkPngRowIndex::Make(static_cast<const uint8_t*>(data),
+                                            stream->getLength(),
+                                            this->dimensions().height(),
+                                            this->dimensions().width() * (size_t)bytesPerPixel,
+                                            bytesPerPixel);
+        }
+    }
+    return fRowIndex.get();
+}
+
+SkCodec::Result SkPngCodec::decodeSubset(void* dst, size_t rowBytes, const SkIRect& subset,
+                                         int* rowsDecoded) {
+    SkASSERT(fRowIndex);
+    const uint8_t* data = static_cast<const uint8_t*>(this->stream()->getMemoryBase());
+
+    this->initializeXformParams();
+    const int rows = fRowIndex->decodeRows(data, subset.top(), subset.bottom(),
+                                           [&](const uint8_t* row) {
+        this->applyXformRow(dst, row);
+        dst = SkTAddOffset<void>(dst, rowBytes);
+    });
+    if (rows != subset.height()) {
+        *rowsDecoded = rows;
+        return kIncompleteInput;
+    }
+    return kSuccess;
+}
+
 SkCodec::Result SkPngCodec::onStartIncrementalDecode(const SkImageInfo& dstInfo,
         void* dst, size_t rowBytes, const SkCodec::Options& options) {
     Result result = this->initializeXforms(dstInfo, options);
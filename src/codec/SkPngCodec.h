@@ -19,6 +19,7 @@
 
 class SkPngChunkReader;
 class SkPngCompositeChunkReader;
+class SkPngRowIndex;
 class SkStream;
 struct SkEncodedInfo;
 struct SkImageInfo;
@@ -66,6 +67,7 @@ protected:
     Result onGetPixels(const SkImageInfo&, void*, size_t, const Options&, int*)
             override;
     bool onRewind() override;
+    bool onGetValidSubset(SkIRect* desiredSubset) const override;
 
     voidp png_ptr() { return fPng_ptr; }
     voidp info_ptr() { return fInfo_ptr; }
@@ -97,6 +99,13 @@ private:
 
     void destroyReadStruct();
 
+    // Builds the row index on first use.  Returns nullptr if the image cannot be indexed, e.g.
+    // because it is interlaced or its stream is not in memory.
+    const SkPngRowIndex* rowIndex();
+
+    // Decodes |subset| by inflating from the nearest checkpoint in the row index above it.
+    Result decodeSubset(void* dst, size_t rowBytes, const SkIRect& subset, int* rowsDecoded);
+
     virtual Result decodeAllRows(void* dst, size_t rowBytes, int* rowsDecoded) = 0;
     virtual Result setRange(int firstRow, int lastRow, void* dst, size_t rowBytes) = 0;
     virtual Result decode(int* rowsDecoded) = 0;
@@ -105,5 +114,8 @@ private:
     bool                           fDecodedIdat;
     std::unique_ptr<SkStream> fGainmapStream;
     std::optional<SkGainmapInfo> fGainmapInfo;
+
+    std::unique_ptr<SkPngRowIndex> fRowIndex;
+    bool                           fTriedRowIndex = false;
 };
 #endif  // SkPngCodec_DEFINED
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkPngRowIndex.h"
+
+#include "include/private/base/SkAssert.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "zlib.h"  // NO_G3_REWRITE
+
+// Each checkpoint costs a 32K window, so only take one every so often.
+static constexpr size_t kCheckpointSpan = 1 << 20;
+static constexpr size_t kWindowSize = 32768;
+
+static uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    const int p = a + b - c,
+              pa = std::abs(p - a),
+              pb = std::abs(p - b),
+              pc = std::abs(p - c);
+    return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+// Undoes the PNG |filter| of |row| in place, given the unfiltered row above it.
+static bool unfilter(uint8_t filter, uint8_t* row, const uint8_t* prev, size_t n, int bpp) {
+    switch (filter) {
+        case 0:  // None
+            return true;
+        case 1:  // Sub
+            for (size_t i = bpp; i < n; i++) {
+                row[i] += row[i - bpp];
+            }
+            return true;
+        case 2:  // Up
+            for (size_t i = 0; i < n; i++) {
+                row[i] += prev[i];
+            }
+            return true;
+        case 3:  // Average
+            for (size_t i = 0; i < n; i++) {
+                const int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+                row[i] += (left + prev[i]) >> 1;
+            }
+            return true;
+        case 4:  // Paeth
+            for (size_t i = 0; i < n; i++) {
+                const bool hasLeft = i >= (size_t)bpp;
+                row[i] += paeth(hasLeft ? row[i - bpp] : 0, prev[i], hasLeft ? prev[i - bpp] : 0);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint8_t SkPngRowIndex::byteAt(const uint8_t* data, size_t pos) const {
+    for (const IdatRange& range : fIdat) {
+        if (pos < range.fStart + range.fSize) {
+            return data[range.fOffset + pos - range.fStart];
+        }
+    }
+    SkASSERT(false);
+    return 0;
+}
+
+/*
+ * Inflates the concatenated IDAT data from a checkpoint, unfiltering rows as they complete.
+ */
+class SkPngRowIndex::Inflater {
+public:
+    Inflater(const SkPngRowIndex& index, const uint8_t* data)
+            : fIndex(index)
+            , fData(data)
+            , fWindow(kWindowSize)
+            , fCurrentRow(index.fRowBytes + 1)
+            , fPrevRow(index.fRowBytes) {
+        memset(&fZ, 0, sizeof(fZ));
+    }
+
+    ~Inflater() {
+        if (fInitialized) {
+            inflateEnd(&fZ);
+        }
+    }
+
+    bool start(const Checkpoint& checkpoint) {
+        // The checkpoints are all in raw deflate data, after the zlib header.
+        if (inflateInit2(&fZ, -15) != Z_OK) {
+            return false;
+        }
+        fInitialized = true;
+        fIn = checkpoint.fIn;
+        if (checkpoint.fBits &&
+            inflatePrime(&fZ, checkpoint.fBits,
+                         fIndex.byteAt(fData, fIn - 1) >> (8 - checkpoint.fBits)) != Z_OK) {
+            return false;
+        }
+        if (!checkpoint.fWindow.empty() &&
+            inflateSetDictionary(&fZ, checkpoint.fWindow.data(),
+                                 (uInt)checkpoint.fWindow.size()) != Z_OK) {
+            return false;
+        }
+        fRow = checkpoint.fRow;
+        fCurrentFill = checkpoint.fPartialRow.size();
+        memcpy(fCurrentRow.data(), checkpoint.fPartialRow.data(), fCurrentFill);
+        memcpy(fPrevRow.data(), checkpoint.fPrevRow.data(), fPrevRow.size());
+        return true;
+    }
+
+    /*
+     * Inflates until row |bottom|, calling |rowProc| with each row as it completes.  If
+     * |building| is not null, adds checkpoints to it along the way.  Returns the row it reached.
+     */
+    template <typename RowProc>
+    int run(int bottom, RowProc&& rowProc, SkPngRowIndex* building) {
+        size_t lastCheckpoint = 0;
+        while (fRow < bottom) {
+            if (fZ.avail_in == 0 && !this->feed()) {
+                break;
+            }
+            if (fWindowPos == kWindowSize) {
+                fWindowPos = 0;
+            }
+            fZ.next_out = fWindow.data() + fWindowPos;
+            fZ.avail_out = (uInt)(kWindowSize - fWindowPos);
+            const int ret = inflate(&fZ, building ? Z_BLOCK : Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                break;
+            }
+
+            const size_t produced = kWindowSize - fWindowPos - fZ.avail_out;
+            if (!this->consume(fWindow.data() + fWindowPos, produced, bottom, rowProc)) {
+                break;
+            }
+            fWindowPos += produced;
+            fTotalOut += produced;
+
+            // Deflate blocks only depend on earlier ones through the window, so they are the
+            // places to resume from.
+            if (building && (fZ.data_type & 128) && !(fZ.data_type & 64) &&
+                fTotalOut - lastCheckpoint >= kCheckpointSpan && fRow < bottom) {
+                building->fCheckpoints.push_back(this->checkpoint());
+                lastCheckpoint = fTotalOut;
+            }
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+        }
+        return fRow;
+    }
+
+private:
+    // Points the inflater at the rest of the IDAT chunk containing fIn.
+    bool feed() {
+        for (const IdatRange& range : fIndex.fIdat) {
+            if (fIn < range.fStart + range.fSize) {
+                fZ.next_in = const_cast<uint8_t*>(fData + range.fOffset + fIn - range.fStart);
+                fZ.avail_in = (uInt)(range.fStart + range.fSize - fIn);
+                fIn += fZ.avail_in;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename RowProc>
+    bool consume(const uint8_t* bytes, size_t size, int bottom, RowProc&& rowProc) {
+        const size_t rowBytes = fIndex.fRowBytes;
+        while (size > 0 && fRow < bottom) {
+            const size_t n = std::min(size, rowBytes + 1 - fCurrentFill);
+            memcpy(fCurrentRow.data() + fCurrentFill, bytes, n);
+            fCurrentFill += n;
+            bytes += n;
+            size -= n;
+
+            if (fCurrentFill == rowBytes + 1) {
+                uint8_t* row = fCurrentRow.data() + 1;
+                if (!unfilter(fCurrentRow[0], row, fPrevRow.data(), rowBytes,
+                              fIndex.fBytesPerPixel)) {
+                    return false;
+                }
+                memcpy(fPrevRow.data(), row, rowBytes);
+                rowProc(fRow, row);
+                fRow++;
+                fCurrentFill = 0;
+            }
+        }
+        return true;
+    }
+
+    Checkpoint checkpoint() const {
+        Checkpoint checkpoint;
+        checkpoint.fIn = fIn - fZ.avail_in;
+        checkpoint.fBits = fZ.data_type & 7;
+        checkpoint.fRow = fRow;
+        checkpoint.fPartialRow.assign(fCurrentRow.begin(), fCurrentRow.begin() + fCurrentFill);
+        checkpoint.fPrevRow = fPrevRow;
+        if (fTotalOut >= kWindowSize) {
+            checkpoint.fWindow.assign(fWindow.begin() + fWindowPos, fWindow.end());
+        }
+        checkpoint.fWindow.insert(checkpoint.fWindow.end(), fWindow.begin(),
+                                  fWindow.begin() + fWindowPos);
+        return checkpoint;
+    }
+
+    const SkPngRowIndex& fIndex;
+    const uint8_t*       fData;
+    z_stream             fZ;
+    bool                 fInitialized = false;
+    // The next byte of the zlib stream to hand to the inflater.
+    size_t               fIn = 0;
+
+    // The inflater writes into a circular buffer, so that its last 32K is always at hand.
+    std::vector<uint8_t> fWindow;
+    size_t               fWindowPos = 0;
+    size_t               fTotalOut = 0;
+
+    int                  fRow = 0;
+    std::vector<uint8_t> fCurrentRow;
+    size_t               fCurrentFill = 0;
+    std::vector<uint8_t> fPrevRow;
+};
+
+std::unique_ptr<SkPngRowIndex> SkPngRowIndex::Make(const uint8_t* data, size_t size, int height,
+                                                   size_t rowBytes, int bytesPerPixel) {
+    if (height <= 0 || rowBytes == 0 || bytesPerPixel <= 0) {
+        return nullptr;
+    }
+    std::unique_ptr<SkPngRowIndex> index(new SkPngRowIndex(height, rowBytes, bytesPerPixel));
+
+    // Gather the IDAT chunks, skipping the signature.
+    constexpr size_t kChunkOverhead = 12;  // length, type and CRC
+    size_t streamSize = 0;
+    for (size_t offset = 8; offset + kChunkOverhead <= size;) {
+        const size_t length = read_be32(data + offset);
+        if (length > size - offset - kChunkOverhead) {
+            return nullptr;
+        }
+        const uint8_t* type = data + offset + 4;
+        if (!memcmp(type, "IDAT", 4)) {
+            index->fIdat.push_back({offset + 8, length, streamSize});
+            streamSize += length;
+        } else if (!memcmp(type, "IEND", 4)) {
+            break;
+        }
+        offset += kChunkOverhead + length;
+    }
+
+    // Check the zlib header, which does not allow a preset dictionary in PNG.
+    if (streamSize < 2) {
+        return nullptr;
+    }
+    const uint8_t cmf = index->byteAt(data, 0),
+                  flg = index->byteAt(data, 1);
+    if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+        return nullptr;
+    }
+
+    Checkpoint first;
+    first.fIn = 2;
+    first.fBits = 0;
+    first.fRow = 0;
+    first.fPrevRow.assign(rowBytes, 0);
+    index->fCheckpoints.push_back(first);
+
+    Inflater inflater(*index, data);
+    if (!inflater.start(first) ||
+        inflater.run(height, [](int, const uint8_t*) {}, index.get()) != height) {
+        return nullptr;
+    }
+    return index;
+}
+
+int SkPngRowIndex::decodeRows(const uint8_t* data, int top, int bottom,
+                              const std::function<void(const uint8_t* row)>& rowProc) const {
+    SkASSERT(0 <= top && top < bottom && bottom <= fHeight);
+    auto checkpoint = std::upper_bound(fCheckpoints.begin(), fCheckpoints.end(), top,
+                                       [](int row, const Checkpoint& c) { return row < c.fRow; });
+    SkASSERT(checkpoint != fCheckpoints.begin());
+    --checkpoint;
+
+    Inflater inflater(*this, data);
+    if (!inflater.start(*checkpoint)) {
+        return 0;
+    }
+    const int reached = inflater.run(bottom, [&](int y, const uint8_t* row) {
+        if (y >= top) {
+            rowProc(row);
+        }
+    }, nullptr);
+    return std::max(reached - top, 0);
+}
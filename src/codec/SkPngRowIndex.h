@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPngRowIndex_DEFINED
+#define SkPngRowIndex_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+ * An index of places where inflating a non-interlaced PNG's image data can resume part way down
+ * the image.  Each checkpoint holds the inflater's 32K window and the row it is in the middle of,
+ * so decoding a band of rows only has to inflate from the nearest checkpoint above it.
+ *
+ * The index only records offsets, so the encoded data must outlive it and be passed back in.
+ */
+class SkPngRowIndex {
+public:
+    /*
+     * Inflates and unfilters all of the image data in |data|, a complete PNG file, to find the
+     * checkpoints.  Returns nullptr if the data is not |height| rows of |rowBytes| each, where
+     * filters work on |bytesPerPixel| (rounded up to a byte).
+     */
+    static std::unique_ptr<SkPngRowIndex> Make(const uint8_t* data, size_t size, int height,
+                                               size_t rowBytes, int bytesPerPixel);
+
+    /*
+     * Calls |rowProc| with each unfiltered row from |top| up to |bottom|, in order.  |data| must be
+     * the data this index was made from.  Returns the number of rows it produced, which is only
+     * less than bottom - top if the data is corrupt.
+     */
+    int decodeRows(const uint8_t* data, int top, int bottom,
+                   const std::function<void(const uint8_t* row)>& rowProc) const;
+
+    size_t checkpointCount() const { return fCheckpoints.size(); }
+
+private:
+    SkPngRowIndex(int height, size_t rowBytes, int bytesPerPixel)
+            : fHeight(height), fRowBytes(rowBytes), fBytesPerPixel(bytesPerPixel) {}
+
+    struct Checkpoint {
+        // Position in the zlib stream (i.e. the IDAT data, concatenated) of the first byte that
+        // has not been fully consumed, and how many of the bits before it are still unused.
+        size_t               fIn;
+        int                  fBits;
+        // The first row that has not been completed, and the filtered bytes of it so far.
+        int                  fRow;
+        std::vector<uint8_t> fPartialRow;
+        // The unfiltered row before fRow, which the filters refer back to.
+        std::vector<uint8_t> fPrevRow;
+        // Up to 32K of the output before this point, oldest first.
+        std::vector<uint8_t> fWindow;
+    };
+
+    struct IdatRange {
+        size_t fOffset;  // In the PNG file.
+        size_t fSize;
+        size_t fStart;   // In the zlib stream.
+    };
+
+    class Inflater;
+
+    // Returns the byte at |pos| in the zlib stream.
+    uint8_t byteAt(const uint8_t* data, size_t pos) const;
+
+    const int               fHeight;
+    const size_t            fRowBytes;
+    const int               fBytesPerPixel;
+    std::vector<IdatRange>  fIdat;
+    std::vector<Checkpoint> fCheckpoints;
+};
+
+#endif  // SkPngRowIndex_DEFINED
@@ -96,6 +96,15 @@ SkCodec::Result SkSampledCodec::onGetAndroidPixels(const SkImageInfo& info, void
         return this->sampledDecode(info, pixels, rowBytes, options);
     }
 
+    // Codecs that can seek to a subset decode it directly. getPixels() turns down subsets the
+    // codec can't seek to before it rewinds, so the fallbacks below can still rewind.
+    if (scaledSize == this->codec()->dimensions()) {
+        const SkCodec::Result result = this->codec()->getPixels(info, pixels, rowBytes, &options);
+        if (result != SkCodec::kUnimplemented) {
+            return result;
+        }
+    }
+
     // Calculate the scaled subset bounds.
     int scaledSubsetX = subset->x() / sampleSize;
     int scaledSubsetY = subset->y() / sampleSize;
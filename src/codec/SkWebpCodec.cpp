@@ -24,6 +24,7 @@
 #include "include/private/base/SkTemplates.h"
 #include "include/private/base/SkTo.h"
 #include "modules/skcms/skcms.h"
+#include "src/codec/SkCodecFrameCache.h"
 #include "src/codec/SkParseEncodedOrigin.h"
 #include "src/codec/SkSampler.h"
 #include "src/core/SkRasterPipeline.h"
@@ -299,6 +300,11 @@ int SkWebpCodec::onGetFrameCount() {
         fFrameHolder.setAlphaAndRequiredFrame(frame);
     }
 
+    // Share the decoded frames of an animation with other codecs of the same data.
+    if (fFrameHolder.size() > 1 && !fFrameHolder.frameCacheID()) {
+        fFrameHolder.setFrameCacheData(SkCodecFrameCache::DataID(fData->data(), fData->size()),
+                                      fData);
+    }
     return fFrameHolder.size();
 
 }
@@ -480,6 +486,12 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
         config.options.scaled_height = scaledHeight;
     }
 
+    // libwebp runs the loop filter of a lossy frame on a worker thread of its own, overlapping it
+    // with parsing the next macroblock row.
+    if (options.fUseWebpFilterThread) {
+        config.options.use_threads = 1;
+    }
+
     const bool blendWithPrevFrame = !independent && frame.blend_method == WEBP_MUX_BLEND
         && frame.has_alpha;
 
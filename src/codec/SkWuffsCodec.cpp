@@ -28,6 +28,7 @@
 #include "include/private/base/SkMalloc.h"
 #include "include/private/base/SkTo.h"
 #include "modules/skcms/skcms.h"
+#include "src/codec/SkCodecFrameCache.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkFrameHolder.h"
 #include "src/codec/SkSampler.h"
@@ -851,6 +852,13 @@ void SkWuffsCodec::onGetFrameCountInternal() {
     }
 
     fFramesComplete = true;
+
+    // Share the decoded frames of an animation with other codecs of the same GIF. This needs
+    // the whole GIF in an SkData, to identify it.
+    if (sk_sp<SkData> data = fPrivStream->getData(); fFrames.size() > 1 && data) {
+        const uint64_t id = SkCodecFrameCache::DataID(data->data(), data->size());
+        fFrameHolder.setFrameCacheData(id, std::move(data));
+    }
 }
 
 bool SkWuffsCodec::onGetFrameInfo(int i, SkCodec::FrameInfo* frameInfo) const {
@@ -10,6 +10,8 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkCanvas.h"
 #include "include/private/base/SkAssert.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkPictureRecord.h"
 #include "src/core/SkRecord.h"
 #include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecords.h"
@@ -43,6 +45,26 @@ void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
                  callback);
 }
 
+void SkBigPicture::playbackWithOpBounds(SkPictureRecord* rec,
+                                        skia_private::TArray<SkRect>* opBounds,
+                                        skia_private::TArray<uint32_t>* opOffsets) const {
+    SkASSERT(rec && opBounds && opOffsets);
+    const int count = fRecord->count();
+    skia_private::AutoTMalloc<SkBBoxHierarchy::Metadata> meta(count);
+    opBounds->resize(count);
+    SkRecordFillBounds(fCullRect, *fRecord, opBounds->data(), meta);
+
+    // This matches SkRecordDraw() without a BBH, so rec records the same ops as playback().
+    SkAutoCanvasRestore saveRestore(rec, true /*save now, restore at exit*/);
+    SkRecords::Draw draw(rec, this->drawablePicts(), nullptr, this->drawableCount());
+    opOffsets->reserve_exact(count + 1);
+    for (int i = 0; i < count; i++) {
+        opOffsets->push_back(SkToU32(rec->writeStream().bytesWritten()));
+        fRecord->visit(i, draw);
+    }
+    opOffsets->push_back(SkToU32(rec->writeStream().bytesWritten()));
+}
+
 struct NestedApproxOpCounter {
     int fCount = 0;
 
@@ -13,13 +13,16 @@
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/private/base/SkNoncopyable.h"
+#include "include/private/base/SkTArray.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/core/SkRecord.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 class SkCanvas;
+class SkPictureRecord;
 
 // An implementation of SkPicture supporting an arbitrary number of drawing commands.
 // This is called "big" because there used to be a "mini" that only supported a subset of the
@@ -57,6 +60,13 @@ public:
     const SkBBoxHierarchy* bbh() const { return fBBH.get(); }
     const SkRecord*     record() const { return fRecord.get(); }
 
+// Used by SkPicture::backport() to serialize the BBH's bounds along with the ops they cover.
+// Plays back into rec just as playback() would, recording the bounds of each of our ops and the
+// offset in rec's op data where its ops begin, plus the offset where the last one ends.
+    void playbackWithOpBounds(SkPictureRecord* rec,
+                              skia_private::TArray<SkRect>* opBounds,
+                              skia_private::TArray<uint32_t>* opOffsets) const;
+
 private:
     int drawableCount() const;
     SkPicture const* const* drawablePicts() const;
@@ -14,6 +14,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkColorSpace.h" // IWYU pragma: keep
 #include "include/core/SkColorType.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkM44.h"
 #include "include/core/SkMatrix.h"
@@ -36,9 +37,11 @@
 #include "src/core/SkDevice.h"
 #include "src/core/SkKnownRuntimeEffects.h"
 #include "src/core/SkSpecialImage.h"
+#include "src/core/SkTaskGroup.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
@@ -57,6 +60,40 @@
 // RasterBlurEngine
 // ----------------------------------------------------------------------------
 
+static std::atomic<size_t> gRasterParallelThreshold{0};
+
+size_t SkBlurEngine::SetRasterParallelThreshold(size_t pixels) {
+    return gRasterParallelThreshold.exchange(pixels, std::memory_order_relaxed);
+}
+
+size_t SkBlurEngine::GetRasterParallelThreshold() {
+    return gRasterParallelThreshold.load(std::memory_order_relaxed);
+}
+
+void SkBlurEngine::ForEachRasterBand(int count, int length,
+                                     const std::function<void(int start, int end)>& band) {
+    // Each band sets up its own pass buffers and warms up its sliding windows, so keep them big
+    // enough to amortize that.
+    static constexpr size_t kMinBandPixels = 64 * 1024;
+
+    const size_t pixels = (size_t)std::max(count, 0) * (size_t)std::max(length, 0);
+    const size_t threshold = GetRasterParallelThreshold();
+    const int bands = threshold == 0 || pixels < threshold
+                            ? 1
+                            : (int)std::min<size_t>(count, pixels / kMinBandPixels);
+    if (bands <= 1) {
+        band(0, count);
+        return;
+    }
+
+    SkTaskGroup tg(SkExecutor::GetDefault());
+    tg.batch(bands, [&](int i) {
+        band((int)((int64_t)count *  i      / bands),
+             (int)((int64_t)count * (i + 1) / bands));
+    });
+    tg.wait();
+}
+
 namespace {
 
 class Pass {
@@ -148,6 +185,23 @@ private:
     const int fWindow;
 };
 
+// A Pass and its buffers for one band of a blur pass. Bands may run concurrently, so each needs
+// its own.
+class BandPass {
+public:
+    explicit BandPass(const PassMaker* maker) {
+        void* buffer = fAlloc.makeBytesAlignedTo(maker->bufferSizeBytes(),
+                                                 alignof(skvx::Vec<4, uint32_t>));
+        fPass = maker->makePass(buffer, &fAlloc);
+    }
+
+    Pass* operator->() const { return fPass; }
+
+private:
+    SkSTArenaAlloc<1024> fAlloc;
+    Pass* fPass;
+};
+
 // Implement a scanline processor that uses a three-box filter to approximate a Gaussian blur.
 // The GaussPass is limit to processing sigmas < 135.
 class GaussPass final : public Pass {
@@ -795,10 +849,6 @@ public:
         }
         dst.eraseColor(SK_ColorTRANSPARENT);
 
-        auto buffer = alloc.makeBytesAlignedTo(std::max(makerX->bufferSizeBytes(),
-                                                        makerY->bufferSizeBytes()),
-                                            alignof(skvx::Vec<4, uint32_t>));
-
         // Basic Plan: The three cases to handle
         // * Horizontal and Vertical - blur horizontally while copying values from the source to
         //     the destination. Then, do an in-place vertical blur.
@@ -816,20 +866,23 @@ public:
             loopStart = std::max(srcBounds.top(),    dstBounds.top());
             loopEnd   = std::min(srcBounds.bottom(), dstBounds.bottom());
 
-            auto srcAddr = src.getAddr32(0, loopStart - srcBounds.top());
-            auto dstAddr = dst.getAddr32(0, loopStart - dstBounds.top());
-
             // Iterate over each row to calculate 1D blur along X.
-            Pass* pass = makerX->makePass(buffer, &alloc);
-            for (int y = loopStart; y < loopEnd; ++y) {
-                pass->blur(srcBounds.left()  - dstBounds.left(),
-                           srcBounds.right() - dstBounds.left(),
-                           dstBounds.width(),
-                           srcAddr, 1,
-                           dstAddr, 1);
-                srcAddr += src.rowBytesAsPixels();
-                dstAddr += dst.rowBytesAsPixels();
-            }
+            SkBlurEngine::ForEachRasterBand(loopEnd - loopStart, dstBounds.width(),
+                                            [&](int start, int end) {
+                auto srcAddr = src.getAddr32(0, loopStart + start - srcBounds.top());
+                auto dstAddr = dst.getAddr32(0, loopStart + start - dstBounds.top());
+
+                BandPass band(makerX);
+                for (int y = start; y < end; ++y) {
+                    band->blur(srcBounds.left()  - dstBounds.left(),
+                               srcBounds.right() - dstBounds.left(),
+                               dstBounds.width(),
+                               srcAddr, 1,
+                               dstAddr, 1);
+                    srcAddr += src.rowBytesAsPixels();
+                    dstAddr += dst.rowBytesAsPixels();
+                }
+            });
 
             // Set up the Y pass to blur from the full dst into the non-outset portion of dst
             src = dst;
@@ -848,19 +901,22 @@ public:
         // into dst for a 1D blur; or it's blurring from dst into dst for the second pass of a 2D
         // blur.
         if (makerY->window() > 1) {
-            auto srcAddr = src.getAddr32(loopStart - srcBounds.left(), 0);
-            auto dstAddr = dst.getAddr32(loopStart - dstBounds.left(), dstYOffset);
-
-            Pass* pass = makerY->makePass(buffer, &alloc);
-            for (int x = loopStart; x < loopEnd; ++x) {
-                pass->blur(srcBounds.top()    - dstBounds.top(),
-                           srcBounds.bottom() - dstBounds.top(),
-                           dstBounds.height(),
-                           srcAddr, src.rowBytesAsPixels(),
-                           dstAddr, dst.rowBytesAsPixels());
-                srcAddr += 1;
-                dstAddr += 1;
-            }
+            SkBlurEngine::ForEachRasterBand(loopEnd - loopStart, dstBounds.height(),
+                                            [&](int start, int end) {
+                auto srcAddr = src.getAddr32(loopStart + start - srcBounds.left(), 0);
+                auto dstAddr = dst.getAddr32(loopStart + start - dstBounds.left(), dstYOffset);
+
+                BandPass band(makerY);
+                for (int x = start; x < end; ++x) {
+                    band->blur(srcBounds.top()    - dstBounds.top(),
+                               srcBounds.bottom() - dstBounds.top(),
+                               dstBounds.height(),
+                               srcAddr, src.rowBytesAsPixels(),
+                               dstAddr, dst.rowBytesAsPixels());
+                    srcAddr += 1;
+                    dstAddr += 1;
+                }
+            });
         }
 
 #if defined(SK_AVOID_SLOW_RASTER_PIPELINE_BLURS)
@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <functional>
 
 class SkDevice;
 class SkRuntimeEffect;
@@ -91,6 +93,18 @@ public:
         return std::max(1, possibleWindow);
     }
 
+    // Each pass of a raster blur that writes at least this many pixels is split into bands of
+    // rows or columns that are run concurrently on SkExecutor::GetDefault(). Zero, the default,
+    // keeps every pass on the calling thread. The setter returns the previous threshold.
+    static size_t SetRasterParallelThreshold(size_t pixels);
+    static size_t GetRasterParallelThreshold();
+
+    // Runs one pass of a raster blur over `count` rows or columns that are each `length` pixels
+    // long, by calling band(start, end) for bands that together cover [0, count). Each band must
+    // use its own blur state, since bands may run concurrently (see SetRasterParallelThreshold).
+    static void ForEachRasterBand(int count, int length,
+                                  const std::function<void(int start, int end)>& band);
+
     // TODO: Bring in anything needed for the single-channel box blur from SkMaskBlurFilter
 };
 
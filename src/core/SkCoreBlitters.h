@@ -18,6 +18,7 @@
 #include "src/core/SkBlitter.h"
 #include "src/shaders/SkShaderBase.h"
 
+#include <cstddef>
 #include <cstdint>
 
 class SkArenaAlloc;
@@ -126,4 +127,10 @@ SkBlitter* SkCreateRasterPipelineBlitter(const SkPixmap&, const SkPaint&,
                                          bool shader_is_opaque,
                                          SkArenaAlloc*, sk_sp<SkShader> clipShader);
 
+// Raster pipeline blitters for solid-color paints share their compiled programs through a cache.
+// These count the programs reused from it and built for it, and empty it.
+size_t SkRasterPipelineBlitterCacheHits();
+size_t SkRasterPipelineBlitterCacheMisses();
+void SkRasterPipelineBlitterPurgeCache();
+
 #endif
@@ -11,7 +11,10 @@
 #include "include/private/base/SkTArray.h"
 #include "src/base/SkNoDestructor.h"
 
+#include <atomic>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <thread>
 #include <utility>
 
@@ -143,6 +146,234 @@ private:
     bool                  fAllowBorrowing;
 };
 
+// A Chase-Lev work-stealing deque ("Correct and Efficient Work-Stealing for Weak Memory Models",
+// Lê et al.) of heap-allocated work.  Only the owning thread may push() or pop(), at the bottom;
+// any thread may steal() from the top.  Outgrown buffers are kept until the deque is destroyed,
+// as a thief may still be reading from one.
+class SkWorkStealingDeque {
+public:
+    using Work = std::function<void(void)>;
+
+    SkWorkStealingDeque() {
+        fBuffers.push_back(std::make_unique<Buffer>(kInitialCapacity));
+        fBuffer.store(fBuffers.back().get(), std::memory_order_relaxed);
+    }
+
+    ~SkWorkStealingDeque() {
+        // Anything left was never run; Loop() threads have all exited by now.
+        while (Work* work = this->pop()) {
+            delete work;
+        }
+    }
+
+    void push(Work* work) {
+        int64_t b = fBottom.load(std::memory_order_relaxed),
+                t = fTop   .load(std::memory_order_acquire);
+        Buffer* buffer = fBuffer.load(std::memory_order_relaxed);
+        if (b - t >= buffer->capacity()) {
+            buffer = this->grow(buffer, b, t);
+        }
+        buffer->put(b, work);
+        // Publishes work (and everything the caller wrote before adding it) to thieves.
+        fBottom.store(b + 1, std::memory_order_release);
+    }
+
+    Work* pop() {
+        int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = fBuffer.load(std::memory_order_relaxed);
+        fBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = fTop.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty.
+            fBottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Work* work = buffer->get(b);
+        if (t == b) {
+            // This is the last item, so we race any thieves for it.
+            if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed)) {
+                work = nullptr;
+            }
+            fBottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return work;
+    }
+
+    // Returns nullptr if the deque was empty or if we lost a race with another thread.
+    Work* steal() {
+        int64_t t = fTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = fBottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return nullptr;
+        }
+        Work* work = fBuffer.load(std::memory_order_acquire)->get(t);
+        if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return work;
+    }
+
+private:
+    static constexpr int64_t kInitialCapacity = 64;
+
+    class Buffer {
+    public:
+        explicit Buffer(int64_t capacity)
+                : fMask(capacity - 1), fSlots(new std::atomic<Work*>[capacity]) {}
+
+        int64_t capacity() const { return fMask + 1; }
+
+        Work* get(int64_t i) const { return fSlots[i & fMask].load(std::memory_order_relaxed); }
+        void put(int64_t i, Work* work) { fSlots[i & fMask].store(work, std::memory_order_relaxed); }
+
+    private:
+        const int64_t                         fMask;
+        std::unique_ptr<std::atomic<Work*>[]> fSlots;
+    };
+
+    Buffer* grow(Buffer* buffer, int64_t b, int64_t t) {
+        auto bigger = std::make_unique<Buffer>(2 * buffer->capacity());
+        for (int64_t i = t; i < b; i++) {
+            bigger->put(i, buffer->get(i));
+        }
+        fBuffers.push_back(std::move(bigger));
+        fBuffer.store(fBuffers.back().get(), std::memory_order_release);
+        return fBuffers.back().get();
+    }
+
+    std::atomic<int64_t> fTop{0};
+    std::atomic<int64_t> fBottom{0};
+    std::atomic<Buffer*> fBuffer;
+    TArray<std::unique_ptr<Buffer>> fBuffers;  // Only touched by the owner.
+};
+
+// An SkWorkStealingThreadPool gives each of its threads an SkWorkStealingDeque.  Work added from
+// one of its own threads goes on that thread's deque without taking any locks; work added from
+// any other thread goes through a shared, locked queue.  fWorkAvailable counts queued work across
+// all of them, so a thread that decrements it is guaranteed to find work somewhere eventually.
+class SkWorkStealingThreadPool final : public SkExecutor {
+public:
+    using Work = std::function<void(void)>;
+
+    explicit SkWorkStealingThreadPool(int threads, bool allowBorrowing)
+            : fThreadCount(threads)
+            , fDeques(new SkWorkStealingDeque[threads])
+            , fAllowBorrowing(allowBorrowing) {
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&Loop, this, i);
+        }
+    }
+
+    ~SkWorkStealingThreadPool() override {
+        // Signal each thread that it's time to shut down.
+        for (int i = 0; i < fThreads.size(); i++) {
+            this->add(nullptr);
+        }
+        // Wait for each thread to shut down.
+        for (int i = 0; i < fThreads.size(); i++) {
+            fThreads[i].join();
+        }
+        for (Work* work : fShared) {
+            delete work;
+        }
+    }
+
+    void add(Work work) override {
+        // A null work is Loop()'s signal to shut down, which must go to the shared queue.
+        int self = work ? this->currentThreadIndex() : -1;
+        auto heapWork = new Work(std::move(work));
+        if (self >= 0) {
+            fDeques[self].push(heapWork);
+        } else {
+            SkAutoMutexExclusive lock(fSharedLock);
+            fShared.push_back(heapWork);
+        }
+        fWorkAvailable.signal(1);
+    }
+
+    void borrow() override {
+        if (fAllowBorrowing && fWorkAvailable.try_wait()) {
+            SkAssertResult(this->do_work(this->currentThreadIndex()));
+        }
+    }
+
+private:
+    // Identifies which pool, and which of its threads, the calling thread belongs to.
+    struct ThreadIdentity {
+        const SkWorkStealingThreadPool* pool  = nullptr;
+        int                             index = -1;
+    };
+    static thread_local ThreadIdentity gThisThread;
+
+    int currentThreadIndex() const {
+        return gThisThread.pool == this ? gThisThread.index : -1;
+    }
+
+    Work* find_work(int self) {
+        if (self >= 0) {
+            if (Work* work = fDeques[self].pop()) {
+                return work;
+            }
+        }
+        {
+            SkAutoMutexExclusive lock(fSharedLock);
+            if (!fShared.empty()) {
+                Work* work = fShared.front();
+                fShared.pop_front();
+                return work;
+            }
+        }
+        const int n = fThreadCount;
+        for (int i = 1; i <= n; i++) {
+            if (Work* work = fDeques[(self + i + n) % n].steal()) {
+                return work;
+            }
+        }
+        return nullptr;
+    }
+
+    // This method should be called only when fWorkAvailable indicates there's work to do.
+    bool do_work(int self) {
+        Work* work;
+        // The work we were promised may still be racing in from a thief or a push; keep looking.
+        while (!(work = this->find_work(self))) {
+            std::this_thread::yield();
+        }
+
+        std::unique_ptr<Work> owned(work);
+        if (!*owned) {
+            return false;  // This is Loop()'s signal to shut down.
+        }
+
+        (*owned)();
+        return true;
+    }
+
+    static void Loop(SkWorkStealingThreadPool* pool, int index) {
+        gThisThread = {pool, index};
+        do {
+            pool->fWorkAvailable.wait();
+        } while (pool->do_work(index));
+        gThisThread = {};
+    }
+
+    const int                              fThreadCount;
+    std::unique_ptr<SkWorkStealingDeque[]> fDeques;  // One per thread, indexed like fThreads.
+    TArray<std::thread>                    fThreads;
+    std::deque<Work*>                      fShared;
+    SkMutex                                fSharedLock;
+    SkSemaphore                            fWorkAvailable;
+    bool                                   fAllowBorrowing;
+};
+
+thread_local SkWorkStealingThreadPool::ThreadIdentity SkWorkStealingThreadPool::gThisThread;
+
 std::unique_ptr<SkExecutor> SkExecutor::MakeFIFOThreadPool(int threads, bool allowBorrowing) {
     using WorkList = std::deque<std::function<void(void)>>;
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
@@ -153,3 +384,8 @@ std::unique_ptr<SkExecutor> SkExecutor::MakeLIFOThreadPool(int threads, bool all
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
                                                     allowBorrowing);
 }
+std::unique_ptr<SkExecutor> SkExecutor::MakeWorkStealingThreadPool(int threads,
+                                                                bool allowBorrowing) {
+    return std::make_unique<SkWorkStealingThreadPool>(threads > 0 ? threads : num_cores(),
+                                                      allowBorrowing);
+}
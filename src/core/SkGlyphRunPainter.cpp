@@ -33,6 +33,7 @@
 #include "src/text/GlyphRun.h"
 
 #include <algorithm>
+#include <optional>
 #include <tuple>
 
 using namespace skia_private;
@@ -52,6 +53,41 @@ SkScalerContextFlags compute_scaler_context_flags(const SkColorSpace* cs) {
     }
 }
 
+// Call fn(i, digest, glyph) for the glyph at each index i of source whose packed ID packedIDAt(i)
+// returns, skipping those it returns nothing for. Glyphs that already have an action for
+// actionType are looked up without locking the strike; the lock is only taken from the first glyph
+// that needs one onwards.
+template <typename PackedIDAt, typename Fn>
+void for_each_digest(SkStrike* strike, ActionType actionType, size_t count,
+                     PackedIDAt&& packedIDAt, Fn&& fn) {
+    size_t i = 0;
+    for (; i < count; ++i) {
+        const std::optional<SkPackedGlyphID> packedID = packedIDAt(i);
+        if (!packedID.has_value()) {
+            continue;
+        }
+        SkGlyphDigest digest;
+        SkGlyph* glyph = strike->findDigest(actionType, *packedID, &digest);
+        if (glyph == nullptr) {
+            break;
+        }
+        fn(i, digest, glyph);
+    }
+
+    if (i < count) {
+        strike->lock();
+        for (; i < count; ++i) {
+            const std::optional<SkPackedGlyphID> packedID = packedIDAt(i);
+            if (!packedID.has_value()) {
+                continue;
+            }
+            const SkGlyphDigest digest = strike->digestFor(actionType, *packedID);
+            fn(i, digest, strike->glyph(digest));
+        }
+        strike->unlock();
+    }
+}
+
 // TODO: collect this up into a single class when all the details are worked out.
 // This is duplicate code. The original is in SubRunContainer.cpp.
 std::tuple<SkZip<const SkGlyph*, SkPoint>, SkZip<SkGlyphID, SkPoint>>
@@ -61,25 +97,27 @@ prepare_for_path_drawing(SkStrike* strike,
                          SkZip<SkGlyphID, SkPoint> rejectedBuffer) {
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
-    for (auto [glyphID, pos] : source) {
-        if (!SkIsFinite(pos.x(), pos.y())) {
-            continue;
-        }
-        const SkPackedGlyphID packedID{glyphID};
-        switch (SkGlyphDigest digest = strike->digestFor(kPath, packedID);
-                digest.actionFor(kPath)) {
-            case GlyphAction::kAccept:
-                acceptedBuffer[acceptedSize++] = std::make_tuple(strike->glyph(digest), pos);
-                break;
-            case GlyphAction::kReject:
-                rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
-                break;
-            default:
-                break;
-        }
-    }
-    strike->unlock();
+    for_each_digest(strike, kPath, source.size(),
+        [&](size_t i) -> std::optional<SkPackedGlyphID> {
+            const auto [glyphID, pos] = source[i];
+            if (!SkIsFinite(pos.x(), pos.y())) {
+                return std::nullopt;
+            }
+            return SkPackedGlyphID{glyphID};
+        },
+        [&](size_t i, SkGlyphDigest digest, SkGlyph* glyph) {
+            const auto [glyphID, pos] = source[i];
+            switch (digest.actionFor(kPath)) {
+                case GlyphAction::kAccept:
+                    acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, pos);
+                    break;
+                case GlyphAction::kReject:
+                    rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
+                    break;
+                default:
+                    break;
+            }
+        });
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
 
@@ -92,25 +130,27 @@ prepare_for_drawable_drawing(SkStrike* strike,
                              SkZip<SkGlyphID, SkPoint> rejectedBuffer) {
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
-    for (auto [glyphID, pos] : source) {
-        if (!SkIsFinite(pos.x(), pos.y())) {
-            continue;
-        }
-        const SkPackedGlyphID packedID{glyphID};
-        switch (SkGlyphDigest digest = strike->digestFor(kDrawable, packedID);
-                digest.actionFor(kDrawable)) {
-            case GlyphAction::kAccept:
-                acceptedBuffer[acceptedSize++] = std::make_tuple(strike->glyph(digest), pos);
-                break;
-            case GlyphAction::kReject:
-                rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
-                break;
-            default:
-                break;
-        }
-    }
-    strike->unlock();
+    for_each_digest(strike, kDrawable, source.size(),
+        [&](size_t i) -> std::optional<SkPackedGlyphID> {
+            const auto [glyphID, pos] = source[i];
+            if (!SkIsFinite(pos.x(), pos.y())) {
+                return std::nullopt;
+            }
+            return SkPackedGlyphID{glyphID};
+        },
+        [&](size_t i, SkGlyphDigest digest, SkGlyph* glyph) {
+            const auto [glyphID, pos] = source[i];
+            switch (digest.actionFor(kDrawable)) {
+                case GlyphAction::kAccept:
+                    acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, pos);
+                    break;
+                case GlyphAction::kReject:
+                    rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
+                    break;
+                default:
+                    break;
+            }
+        });
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
 
@@ -130,31 +170,32 @@ prepare_for_direct_mask_drawing(SkStrike* strike,
 
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
-    for (auto [glyphID, pos] : source) {
-        if (!SkIsFinite(pos.x(), pos.y())) {
-            continue;
-        }
-
-        const SkPoint mappedPos = positionMatrixWithRounding.mapPoint(pos);
-        const SkPackedGlyphID packedGlyphID = SkPackedGlyphID{glyphID, mappedPos, mask};
-        switch (SkGlyphDigest digest = strike->digestFor(kDirectMaskCPU, packedGlyphID);
-                digest.actionFor(kDirectMaskCPU)) {
-            case GlyphAction::kAccept: {
-                const SkPoint roundedPos{SkScalarFloorToScalar(mappedPos.x()),
-                                         SkScalarFloorToScalar(mappedPos.y())};
-                acceptedBuffer[acceptedSize++] =
-                        std::make_tuple(strike->glyph(digest), roundedPos);
-                break;
+    SkPoint mappedPos;  // Of the glyph whose packed ID was returned last.
+    for_each_digest(strike, kDirectMaskCPU, source.size(),
+        [&](size_t i) -> std::optional<SkPackedGlyphID> {
+            const auto [glyphID, pos] = source[i];
+            if (!SkIsFinite(pos.x(), pos.y())) {
+                return std::nullopt;
             }
-            case GlyphAction::kReject:
-                rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
-                break;
-            default:
-                break;
-        }
-    }
-    strike->unlock();
+            mappedPos = positionMatrixWithRounding.mapPoint(pos);
+            return SkPackedGlyphID{glyphID, mappedPos, mask};
+        },
+        [&](size_t i, SkGlyphDigest digest, SkGlyph* glyph) {
+            const auto [glyphID, pos] = source[i];
+            switch (digest.actionFor(kDirectMaskCPU)) {
+                case GlyphAction::kAccept: {
+                    const SkPoint roundedPos{SkScalarFloorToScalar(mappedPos.x()),
+                                             SkScalarFloorToScalar(mappedPos.y())};
+                    acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, roundedPos);
+                    break;
+                }
+                case GlyphAction::kReject:
+                    rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
+                    break;
+                default:
+                    break;
+            }
+        });
 
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
@@ -176,29 +217,28 @@ prepare_for_direct_bitmap_drawing(SkStrike* strike,
 
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
-    for (auto [glyphID, pos] : source) {
-        if (!SkIsFinite(pos.x(), pos.y())) {
-            continue;
-        }
-
-        const SkPoint mappedPos = positionMatrixWithRounding.mapPoint(pos);
-        const SkPackedGlyphID packedGlyphID = SkPackedGlyphID{glyphID, mappedPos, mask};
-        switch (SkGlyphDigest digest = strike->digestFor(kDirectMaskCPU, packedGlyphID);
-                digest.actionFor(kDirectMaskCPU)) {
-            case GlyphAction::kAccept: {
-                acceptedBuffer[acceptedSize++] =
-                        std::make_tuple(strike->glyph(digest), pos);
-                break;
+    for_each_digest(strike, kDirectMaskCPU, source.size(),
+        [&](size_t i) -> std::optional<SkPackedGlyphID> {
+            const auto [glyphID, pos] = source[i];
+            if (!SkIsFinite(pos.x(), pos.y())) {
+                return std::nullopt;
             }
-            case GlyphAction::kReject:
-                rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
-                break;
-            default:
-                break;
-        }
-    }
-    strike->unlock();
+            const SkPoint mappedPos = positionMatrixWithRounding.mapPoint(pos);
+            return SkPackedGlyphID{glyphID, mappedPos, mask};
+        },
+        [&](size_t i, SkGlyphDigest digest, SkGlyph* glyph) {
+            const auto [glyphID, pos] = source[i];
+            switch (digest.actionFor(kDirectMaskCPU)) {
+                case GlyphAction::kAccept:
+                    acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, pos);
+                    break;
+                case GlyphAction::kReject:
+                    rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
+                    break;
+                default:
+                    break;
+            }
+        });
 
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
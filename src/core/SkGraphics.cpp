@@ -10,6 +10,8 @@
 #include "src/core/SkBitmapProcState.h"
 #include "src/core/SkBlitMask.h"
 #include "src/core/SkBlitRow.h"
+#include "src/core/SkBlurEngine.h"
+#include "src/core/SkCoreBlitters.h"
 #include "src/core/SkCpu.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkMemset.h"
@@ -18,6 +20,7 @@
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkSwizzlePriv.h"
 #include "src/core/SkTypefaceCache.h"
+#include "src/core/SkYUVToRGB.h"
 
 void SkGraphics::Init() {
     // SkGraphics::Init() must be thread-safe and idempotent.
@@ -28,6 +31,7 @@ void SkGraphics::Init() {
     SkOpts::Init_BlitRow();
     SkOpts::Init_Memset();
     SkOpts::Init_Swizzler();
+    SkOpts::Init_YUVToRGB();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,6 +45,23 @@ void SkGraphics::PurgeAllCaches() {
     SkGraphics::PurgeFontCache();
     SkGraphics::PurgeResourceCache();
     SkImageFilter_Base::PurgeCache();
+    SkRasterPipelineBlitterPurgeCache();
+}
+
+size_t SkGraphics::GetRasterPipelineCacheHits() {
+    return SkRasterPipelineBlitterCacheHits();
+}
+
+size_t SkGraphics::GetRasterPipelineCacheMisses() {
+    return SkRasterPipelineBlitterCacheMisses();
+}
+
+size_t SkGraphics::GetRasterBlurParallelThreshold() {
+    return SkBlurEngine::GetRasterParallelThreshold();
+}
+
+size_t SkGraphics::SetRasterBlurParallelThreshold(size_t pixels) {
+    return SkBlurEngine::SetRasterParallelThreshold(pixels);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -78,6 +99,14 @@ void SkGraphics::PurgePinnedFontCache() {
     SkStrikeCache::GlobalStrikeCache()->purgePinned();
 }
 
+void SkGraphics::SetFontCacheFile(const char path[]) {
+    SkStrikeCache::GlobalStrikeCache()->setPersistentCache(path);
+}
+
+bool SkGraphics::SaveFontCacheFile() {
+    return SkStrikeCache::GlobalStrikeCache()->savePersistentCache();
+}
+
 static int gTypefaceCacheCountLimit = 1024; // historical default value
 
 int SkGraphics::GetTypefaceCacheCountLimit() {
@@ -14,6 +14,7 @@
 #include "include/private/base/SkTo.h"
 #include "src/base/SkArenaAlloc.h"
 #include "src/base/SkVx.h"
+#include "src/core/SkBlurEngine.h"
 #include "src/core/SkColorPriv.h"
 #include "src/core/SkGaussFilter.h"
 
@@ -996,6 +997,17 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMaskBuilder* dst) const {
     auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize());
     auto buffer = alloc.makeArrayDefault<uint32_t>(bufferSize);
 
+    // A pass that runs as a single band uses the shared buffer; concurrent bands each need their
+    // own.
+    auto bandBuffer = [&](int bandStart, int bandEnd, int count,
+                          skia_private::AutoTMalloc<uint32_t>* storage) {
+        if (bandStart == 0 && bandEnd == count) {
+            return buffer;
+        }
+        storage->reset(bufferSize);
+        return storage->get();
+    };
+
     // Blur both directions.
     int tmpW = srcH,
         tmpH = dstW;
@@ -1007,43 +1019,43 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMaskBuilder* dst) const {
     auto tmp = alloc.makeArrayDefault<uint8_t>(tmpW * tmpH);
 
     // Blur horizontally, and transpose.
-    const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer);
+    auto blurRows = [&](auto start, auto end) {
+        SkBlurEngine::ForEachRasterBand(srcH, srcW, [&](int bandStart, int bandEnd) {
+            skia_private::AutoTMalloc<uint32_t> storage;
+            const PlanGauss::Scan& scanW =
+                    planW.makeBlurScan(srcW, bandBuffer(bandStart, bandEnd, srcH, &storage));
+            const uint32_t bandOffset = SkTo<uint32_t>((size_t)bandStart * src.fRowBytes);
+            auto rowStart = start,
+                 rowEnd   = end;
+            rowStart >>= bandOffset;
+            rowEnd   >>= bandOffset;
+            for (int y = bandStart; y < bandEnd;
+                 ++y, rowStart >>= src.fRowBytes, rowEnd >>= src.fRowBytes) {
+                auto tmpStart = &tmp[y];
+                scanW.blur(rowStart, rowEnd, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+            }
+        });
+    };
     switch (src.fFormat) {
         case SkMask::kBW_Format: {
             const uint8_t* bwStart = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0);
-            auto end = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurRows(SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0),
+                     SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8));
         } break;
         case SkMask::kA8_Format: {
             const uint8_t* a8Start = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start);
-            auto end = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurRows(SkMask::AlphaIter<SkMask::kA8_Format>(a8Start),
+                     SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW));
         } break;
         case SkMask::kARGB32_Format: {
             const uint32_t* argbStart = reinterpret_cast<const uint32_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart);
-            auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurRows(SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart),
+                     SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW));
         } break;
         case SkMask::kLCD16_Format: {
             const uint16_t* lcdStart = reinterpret_cast<const uint16_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart);
-            auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurRows(SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart),
+                     SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW));
         } break;
         default:
             SK_ABORT("Unhandled format.");
@@ -1051,14 +1063,18 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMaskBuilder* dst) const {
 
     // Blur vertically (scan in memory order because of the transposition),
     // and transpose back to the original orientation.
-    const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer);
-    for (int y = 0; y < tmpH; y++) {
-        auto tmpStart = &tmp[y * tmpW];
-        auto dstStart = &dst->image()[y];
-
-        scanH.blur(tmpStart, tmpStart + tmpW,
-                   dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
-    }
+    SkBlurEngine::ForEachRasterBand(tmpH, tmpW, [&](int bandStart, int bandEnd) {
+        skia_private::AutoTMalloc<uint32_t> storage;
+        const PlanGauss::Scan& scanH =
+                planH.makeBlurScan(tmpW, bandBuffer(bandStart, bandEnd, tmpH, &storage));
+        for (int y = bandStart; y < bandEnd; y++) {
+            auto tmpStart = &tmp[y * tmpW];
+            auto dstStart = &dst->image()[y];
+
+            scanH.blur(tmpStart, tmpStart + tmpW,
+                       dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
+        }
+    });
 
     return {SkTo<int32_t>(borderW), SkTo<int32_t>(borderH)};
 }
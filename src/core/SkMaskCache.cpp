@@ -30,6 +30,13 @@ struct MaskValue {
     SkCachedData*   fData;
 };
 
+// Blurring a mask takes several passes over it, and over the wider mask it is blurred from, so
+// it is much more expensive to make than its size suggests. This is a fixed guess at that ratio,
+// not a measured recompute time: the box blurs do about the same work per pixel whatever the
+// sigma, so the cost of a blur mostly grows with its size. Timing each blur when it is made would
+// make the eviction order depend on how busy the machine happened to be.
+static constexpr double kBlurCostPerByte = 16;
+
 namespace {
 static unsigned gRRectBlurKeyNamespaceLabel;
 
@@ -64,6 +71,9 @@ struct RRectBlurRec : public SkResourceCache::Rec {
 
     const Key& getKey() const override { return fKey; }
     size_t bytesUsed() const override { return sizeof(*this) + fValue.fData->size(); }
+    double regenerationCost() const override {
+        return kBlurCostPerByte * fValue.fData->size();
+    }
     const char* getCategory() const override { return "rrect-blur"; }
     SkDiscardableMemory* diagnostic_only_getDiscardable() const override {
         return fValue.fData->diagnostic_only_getDiscardable();
@@ -152,6 +162,9 @@ struct RectsBlurRec : public SkResourceCache::Rec {
 
     const Key& getKey() const override { return fKey; }
     size_t bytesUsed() const override { return sizeof(*this) + fValue.fData->size(); }
+    double regenerationCost() const override {
+        return kBlurCostPerByte * fValue.fData->size();
+    }
     const char* getCategory() const override { return "rects-blur"; }
     SkDiscardableMemory* diagnostic_only_getDiscardable() const override {
         return fValue.fData->diagnostic_only_getDiscardable();
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkPackedRTree.h"
+
+#include "include/private/base/SkAssert.h"
+#include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTPin.h"
+#include "src/base/SkMathPriv.h"
+#include "src/base/SkVx.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using Lanes = skvx::Vec<SkPackedRTree::kNodeSize, float>;
+
+// Returns the distance of (x,y) along a Hilbert curve that visits every point of a 2^16 x 2^16
+// grid, so that points near each other in the plane tend to be near each other on the curve.
+static uint32_t hilbert_index(uint32_t x, uint32_t y) {
+    constexpr uint32_t kN = 1 << 16;
+    uint32_t d = 0;
+    for (uint32_t s = kN / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) ? 1 : 0,
+                       ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it runs in the canonical direction.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kN - 1 - x;
+                y = kN - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// A lane is set for each child of node that intersects query, with the same semantics as
+// SkRect::Intersects(). The query must not be empty.
+static skvx::Vec<SkPackedRTree::kNodeSize, int32_t> overlaps(const float left[],
+                                                              const float top[],
+                                                              const float right[],
+                                                              const float bottom[],
+                                                              const SkRect& query) {
+    return (Lanes::Load(left)  < query.fRight ) & (Lanes::Load(top)    < query.fBottom) &
+           (Lanes::Load(right) > query.fLeft  ) & (Lanes::Load(bottom) > query.fTop   );
+}
+
+namespace {
+struct Leaf {
+    uint32_t fKey;    // Where the center of its bounds lies along the Hilbert curve.
+    int      fIndex;
+};
+}  // namespace
+
+// Sums the half-perimeters of the leaf nodes that packing leaves in this order would make.
+// The smaller this is, the fewer nodes a typical search has to visit.
+static double leaf_node_margin(const SkRect bounds[], const std::vector<Leaf>& leaves) {
+    double margin = 0;
+    for (size_t i = 0; i < leaves.size(); i += SkPackedRTree::kNodeSize) {
+        SkRect node = SkRect::MakeEmpty();
+        for (size_t j = i; j < std::min(i + SkPackedRTree::kNodeSize, leaves.size()); j++) {
+            node.join(bounds[leaves[j].fIndex]);
+        }
+        margin += (double)node.width() + node.height();
+    }
+    return margin;
+}
+
+static bool is_searchable(const SkRect& query) {
+    // Written to be false for NaNs as well as for empty rects.
+    return query.fLeft < query.fRight && query.fTop < query.fBottom;
+}
+
+void SkPackedRTree::insert(const SkRect boundsArray[], int N) {
+    SkASSERT(0 == fCount);
+
+    std::vector<Leaf> leaves;
+    leaves.reserve(N);
+    SkRect total = SkRect::MakeEmpty();
+    for (int i = 0; i < N; i++) {
+        const SkRect& bounds = boundsArray[i];
+        if (bounds.isEmpty()) {
+            continue;
+        }
+        leaves.push_back({0, i});
+        total.join(bounds);
+    }
+
+    fCount = (int)leaves.size();
+    fIndexLimit = N;
+    if (0 == fCount) {
+        return;
+    }
+
+    // Find where the centers of the leaves' bounds lie along the Hilbert curve, scaling them to
+    // fit the curve's grid.
+    float sx = 65535 / total.width(),
+          sy = 65535 / total.height();
+    sx = SkIsFinite(sx) ? sx : 0;
+    sy = SkIsFinite(sy) ? sy : 0;
+    for (Leaf& leaf : leaves) {
+        const SkRect& bounds = boundsArray[leaf.fIndex];
+        const float x = SkTPin((bounds.centerX() - total.fLeft) * sx, 0.f, 65535.f),
+                    y = SkTPin((bounds.centerY() - total.fTop ) * sy, 0.f, 65535.f);
+        leaf.fKey = hilbert_index((uint32_t)x, (uint32_t)y);
+    }
+    std::vector<Leaf> hilbert = leaves;
+    std::sort(hilbert.begin(), hilbert.end(), [](const Leaf& a, const Leaf& b) {
+        return a.fKey != b.fKey ? a.fKey < b.fKey : a.fIndex < b.fIndex;
+    });
+
+    // Ordering the leaves along the curve keeps the leaves packed into each node close together,
+    // but then search() must sort what it finds. Most recordings draw in a coherent enough order
+    // already, so keep that order unless the curve makes for much tighter nodes.
+    constexpr double kCoherentEnough = 1.5;
+    fInsertionOrder = leaf_node_margin(boundsArray, leaves) <=
+                      kCoherentEnough * leaf_node_margin(boundsArray, hilbert);
+    if (!fInsertionOrder) {
+        leaves = std::move(hilbert);
+    }
+
+    int levelNodes = (fCount + kNodeSize - 1) / kNodeSize;
+    size_t totalNodes = levelNodes;
+    for (int n = levelNodes; n > 1; ) {
+        n = (n + kNodeSize - 1) / kNodeSize;
+        totalNodes += n;
+    }
+    fNodes.resize(totalNodes);
+
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    auto set_child = [](Node* node, int i, float l, float t, float r, float b) {
+        node->fLeft[i] = l;
+        node->fTop[i] = t;
+        node->fRight[i] = r;
+        node->fBottom[i] = b;
+    };
+
+    // Pack the leaves.
+    fLeafIndices.resize(fCount);
+    fLevelStart.push_back(0);
+    for (int n = 0; n < levelNodes; n++) {
+        Node* node = &fNodes[n];
+        for (int i = 0; i < kNodeSize; i++) {
+            const int leaf = n * kNodeSize + i;
+            if (leaf < fCount) {
+                const SkRect& b = boundsArray[leaves[leaf].fIndex];
+                set_child(node, i, b.fLeft, b.fTop, b.fRight, b.fBottom);
+                fLeafIndices[leaf] = leaves[leaf].fIndex;
+            } else {
+                set_child(node, i, kInf, kInf, -kInf, -kInf);
+            }
+        }
+    }
+
+    // Pack each level's nodes into the level above, until one node holds them all.
+    while (levelNodes > 1) {
+        const int below = fLevelStart.back(),
+                  start = below + levelNodes;
+        const int parents = (levelNodes + kNodeSize - 1) / kNodeSize;
+        for (int n = 0; n < parents; n++) {
+            Node* node = &fNodes[start + n];
+            for (int i = 0; i < kNodeSize; i++) {
+                const int child = n * kNodeSize + i;
+                if (child < levelNodes) {
+                    // The unused children of a node can't change these, being inside out.
+                    const Node& c = fNodes[below + child];
+                    set_child(node, i, skvx::min(Lanes::Load(c.fLeft)),
+                                       skvx::min(Lanes::Load(c.fTop)),
+                                       skvx::max(Lanes::Load(c.fRight)),
+                                       skvx::max(Lanes::Load(c.fBottom)));
+                } else {
+                    set_child(node, i, kInf, kInf, -kInf, -kInf);
+                }
+            }
+        }
+        fLevelStart.push_back(start);
+        levelNodes = parents;
+    }
+    SkASSERT(fLevelStart.back() + 1 == (int)fNodes.size());
+}
+
+void SkPackedRTree::search(const SkRect& query, std::vector<int>* results) const {
+    if (fCount > 0 && is_searchable(query)) {
+        const size_t first = results->size();
+        this->search(this->getDepth() - 1, 0, query, results);
+        if (!fInsertionOrder) {
+            std::sort(results->begin() + first, results->end());
+        }
+    }
+}
+
+void SkPackedRTree::search(int level, int n, const SkRect& query,
+                           std::vector<int>* results) const {
+    const Node& node = fNodes[fLevelStart[level] + n];
+    const auto hits = overlaps(node.fLeft, node.fTop, node.fRight, node.fBottom, query);
+    if (!skvx::any(hits)) {
+        return;
+    }
+    // Visiting just the set bits of a mask is quicker than testing each lane in turn.
+    uint32_t mask = 0;
+    for (int i = 0; i < kNodeSize; ++i) {
+        mask |= (hits[i] ? 1u : 0u) << i;
+    }
+    const int first = n * kNodeSize;
+    if (0 == level) {
+        for (; mask; mask &= mask - 1) {
+            results->push_back(fLeafIndices[first + SkCTZ(mask)]);
+        }
+    } else {
+        for (; mask; mask &= mask - 1) {
+            this->search(level - 1, first + SkCTZ(mask), query, results);
+        }
+    }
+}
+
+void SkPackedRTree::search(const SkRect queries[], int N, std::vector<int> results[]) const {
+    if (0 == fCount) {
+        return;
+    }
+
+    std::vector<size_t> firsts(N);
+    size_t hits = 0;
+    for (int q = 0; q < N; q++) {
+        firsts[q] = results[q].size();
+        if (is_searchable(queries[q])) {
+            this->search(this->getDepth() - 1, 0, queries[q], &results[q]);
+            hits += results[q].size() - firsts[q];
+        }
+    }
+    if (fInsertionOrder) {
+        return;
+    }
+
+    // With few hits, sorting each query's is quickest.
+    if (hits < (size_t)fIndexLimit / 4) {
+        for (int q = 0; q < N; q++) {
+            std::sort(results[q].begin() + firsts[q], results[q].end());
+        }
+        return;
+    }
+
+    // Otherwise sort all of them at once by counting how often each index was hit. A whole
+    // screen of tiles easily hits more than a quarter of the ops in a picture.
+    std::vector<int> bucketStart(fIndexLimit + 1, 0);
+    for (int q = 0; q < N; q++) {
+        for (size_t k = firsts[q]; k < results[q].size(); k++) {
+            bucketStart[results[q][k] + 1]++;
+        }
+    }
+    for (int i = 1; i <= fIndexLimit; i++) {
+        bucketStart[i] += bucketStart[i - 1];
+    }
+    // Gather the queries that hit each index. Afterwards each bucket starts where the last ended.
+    std::vector<int> queriesByIndex(hits);
+    for (int q = 0; q < N; q++) {
+        for (size_t k = firsts[q]; k < results[q].size(); k++) {
+            queriesByIndex[bucketStart[results[q][k]]++] = q;
+        }
+        results[q].resize(firsts[q]);
+    }
+    size_t k = 0;
+    for (int i = 0; i < fIndexLimit; i++) {
+        for (; k < (size_t)bucketStart[i]; k++) {
+            results[queriesByIndex[k]].push_back(i);
+        }
+    }
+}
+
+size_t SkPackedRTree::bytesUsed() const {
+    return sizeof(SkPackedRTree) +
+           fNodes.capacity() * sizeof(Node) +
+           fLevelStart.capacity() * sizeof(int) +
+           fLeafIndices.capacity() * sizeof(int);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPackedRTree_DEFINED
+#define SkPackedRTree_DEFINED
+
+#include "include/core/SkBBHFactory.h"
+#include "include/core/SkRect.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * An R-Tree packed into flat arrays, for searching a large, static set of bounds.
+ *
+ * insert() packs the bounds into nodes of kNodeSize children, packs the bounds of those nodes
+ * into the level above, and so on up to a single root node. The bounds are packed in the order
+ * they were inserted if that is already spatially coherent, as it is for most recordings, and
+ * otherwise in order along a Hilbert curve through their centers. Nodes of the same level are
+ * stored next to each other, so a child is found by its position rather than a pointer, and each
+ * node keeps the lefts, tops, rights and bottoms of its children in separate arrays so that
+ * search() can test all of them against the query at once with SIMD.
+ *
+ * Like SkRTree, search() reports the indices it finds in increasing order. When the leaves are
+ * in Hilbert order that takes a sort, which the batched search() shares across its queries.
+ */
+class SkPackedRTree : public SkBBoxHierarchy {
+public:
+    SkPackedRTree() = default;
+
+    void insert(const SkRect[], int N) override;
+    void search(const SkRect& query, std::vector<int>* results) const override;
+    void search(const SkRect queries[], int N, std::vector<int> results[]) const override;
+    size_t bytesUsed() const override;
+
+    // Methods and constants below here are only public for tests.
+
+    // Return the depth of the tree structure.
+    int getDepth() const { return (int)fLevelStart.size(); }
+    // Insertion count, not counting the empty bounds that were skipped.
+    int getCount() const { return fCount; }
+
+    // Eight floats fill an AVX register, or two SSE or NEON registers.
+    static constexpr int kNodeSize = 8;
+
+private:
+    struct alignas(32) Node {
+        // Unused children have bounds that never intersect anything.
+        float fLeft  [kNodeSize];
+        float fTop   [kNodeSize];
+        float fRight [kNodeSize];
+        float fBottom[kNodeSize];
+    };
+
+    void search(int level, int node, const SkRect& query, std::vector<int>* results) const;
+
+    // The nodes of each level follow those of the level below, leaves first and root last.
+    // Child i of the node n of a level is node kNodeSize*n + i of the level below it.
+    std::vector<Node> fNodes;
+    std::vector<int>  fLevelStart;
+    // The index passed to insert() for each child of the leaf nodes.
+    std::vector<int>  fLeafIndices;
+    int               fCount = 0;
+    int               fIndexLimit = 0;  // Every index in fLeafIndices is less than this.
+    bool              fInsertionOrder = true;
+};
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "include/core/SkPicture.h"
 
+#include "include/core/SkBBHFactory.h"
 #include "include/core/SkData.h"
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkSerialProcs.h"
@@ -14,11 +15,13 @@
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkTo.h"
 #include "src/base/SkMathPriv.h"
+#include "src/core/SkBigPicture.h"
 #include "src/core/SkCanvasPriv.h"
 #include "src/core/SkPictureData.h"
 #include "src/core/SkPicturePlayback.h"
 #include "src/core/SkPicturePriv.h"
 #include "src/core/SkPictureRecord.h"
+#include "src/core/SkPlaybackPicture.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkResourceCache.h"
 #include "src/core/SkStreamPriv.h"
@@ -27,6 +30,7 @@
 #include <atomic>
 #include <cstring>
 #include <memory>
+#include <utility>
 
 // When we read/write the SkPictInfo via a stream, we have a sentinel byte right after the info.
 // Note: in the read/write buffer versions, we have a slightly different convention:
@@ -138,7 +142,10 @@ sk_sp<SkPicture> SkPicture::Forwardport(const SkPictInfo& info,
     }
     SkPicturePlayback playback(data);
     SkPictureRecorder r;
-    playback.draw(r.beginRecording(info.fCullRect), nullptr/*no callback*/, buffer);
+    // A picture that was serialized with its op bounds gets a BBH again.
+    SkRTreeFactory factory;
+    playback.draw(r.beginRecording(info.fCullRect, data->hasOpBounds() ? &factory : nullptr),
+                  nullptr/*no callback*/, buffer);
     return r.finishRecordingAsPicture();
 }
 
@@ -165,8 +172,18 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialPro
     return MakeFromStreamPriv(&stream, procs, nullptr, kNestedSKPLimit);
 }
 
+sk_sp<SkPicture> SkPicture::MakeFromDataWithoutCopy(sk_sp<SkData> data,
+                                                    const SkDeserialProcs* procs) {
+    if (!data) {
+        return nullptr;
+    }
+    SkMemoryStream stream(std::move(data));
+    return MakeFromStreamPriv(&stream, procs, nullptr, kNestedSKPLimit, /*shareStreamData=*/true);
+}
+
 sk_sp<SkPicture> SkPicture::MakeFromStreamPriv(SkStream* stream, const SkDeserialProcs* procsPtr,
-                                               SkTypefacePlayback* typefaces, int recursionLimit) {
+                                               SkTypefacePlayback* typefaces, int recursionLimit,
+                                               bool shareStreamData) {
     if (recursionLimit <= 0) {
         return nullptr;
     }
@@ -186,7 +203,13 @@ sk_sp<SkPicture> SkPicture::MakeFromStreamPriv(SkStream* stream, const SkDeseria
         case kPictureData_TrailingStreamByteAfterPictInfo: {
             std::unique_ptr<SkPictureData> data(
                     SkPictureData::CreateFromStream(stream, info, procs, typefaces,
-                                                    recursionLimit));
+                                                    recursionLimit, shareStreamData));
+            if (shareStreamData) {
+                if (!data || !data->opData()) {
+                    return nullptr;
+                }
+                return sk_make_sp<SkPlaybackPicture>(info.fCullRect, std::move(data));
+            }
             return Forwardport(info, data.get(), nullptr);
         }
         case kCustom_TrailingStreamByteAfterPictInfo: {
@@ -236,6 +259,28 @@ sk_sp<SkPicture> SkPicturePriv::MakeFromBuffer(SkReadBuffer& buffer) {
 SkPictureData* SkPicture::backport() const {
     SkPictInfo info = this->createHeader();
     SkPictureRecord rec(info.fCullRect.roundOut(), 0/*flags*/);
+
+    // If we were recorded with a BBH, save the bounds it was built from alongside our ops.
+    // A picture that was read with its op bounds passes them on to the ops they now cover.
+    const SkBigPicture* bigPicture = this->asSkBigPicture();
+    if (bigPicture && bigPicture->bbh() && bigPicture->record()->count() > 0) {
+        skia_private::TArray<SkRect> opBounds;
+        skia_private::TArray<uint32_t> opOffsets;
+        rec.beginRecording();
+            bigPicture->playbackWithOpBounds(&rec, &opBounds, &opOffsets);
+        rec.endRecording();
+        return new SkPictureData(rec, info, std::move(opBounds), std::move(opOffsets));
+    }
+    const SkPlaybackPicture* playbackPicture = this->asSkPlaybackPicture();
+    if (playbackPicture && playbackPicture->hasOpBounds()) {
+        skia_private::TArray<SkRect> opBounds;
+        skia_private::TArray<uint32_t> opOffsets;
+        rec.beginRecording();
+            playbackPicture->playbackWithOpBounds(&rec, &opBounds, &opOffsets);
+        rec.endRecording();
+        return new SkPictureData(rec, info, std::move(opBounds), std::move(opOffsets));
+    }
+
     rec.beginRecording();
         this->playback(&rec);
     rec.endRecording();
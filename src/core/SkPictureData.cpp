@@ -13,6 +13,7 @@
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
+#include "include/private/base/SkAlign.h"
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkTemplates.h"
@@ -71,6 +72,24 @@ SkPictureData::SkPictureData(const SkPictureRecord& record,
     this->initForPlayback();
 }
 
+SkPictureData::SkPictureData(const SkPictureRecord& record,
+                             const SkPictInfo& info,
+                             TArray<SkRect> opBounds,
+                             TArray<uint32_t> opOffsets)
+    : SkPictureData(record, info) {
+    SkASSERT(opOffsets.size() == opBounds.size() + 1);
+    SkASSERT(opOffsets.back() <= fOpData->size());
+    fOpBounds = std::move(opBounds);
+    fOpOffsets = std::move(opOffsets);
+}
+
+void SkPictureData::searchOpBounds(const SkRect& query, std::vector<int>* runs) const {
+    SkASSERT(this->hasOpBounds());
+    fOpBBHOnce([this] { fOpBBH.insert(fOpBounds.data(), fOpBounds.size()); });
+    // SkRTree reports what it finds in the order it was inserted, i.e. the order of the ops.
+    fOpBBH.search(query, runs);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -101,6 +120,37 @@ static void write_tag_size(SkWStream* stream, uint32_t tag, size_t size) {
     stream->write32(SkToU32(size));
 }
 
+// Pads the stream so that what follows starts at a multiple of 4 bytes, where it can be read in
+// place from memory (e.g. a mapped file).
+static void write_alignment_padding(SkWStream* stream) {
+    const uint32_t padding = (0 - (stream->bytesWritten() + sizeof(uint32_t))) & 3;
+    stream->write32(padding);
+    stream->write("\0\0\0", padding);
+}
+
+static bool skip_alignment_padding(SkStream* stream) {
+    uint32_t padding;
+    return stream->readU32(&padding) && padding < 4 && stream->skip(padding) == padding;
+}
+
+// If the stream is reading from an SkData, returns the next size bytes of it without copying, and
+// skips past them. Returns nullptr if it can't, e.g. because they are not 4-byte aligned.
+static sk_sp<SkData> share_from_stream(SkStream* stream, size_t size) {
+    sk_sp<SkData> data = stream->getData();
+    if (!data || stream->getMemoryBase() != data->data()) {
+        return nullptr;
+    }
+    const size_t offset = stream->getPosition();
+    if (offset > data->size() || size > data->size() - offset ||
+        !SkIsAlign4(reinterpret_cast<uintptr_t>(data->bytes() + offset))) {
+        return nullptr;
+    }
+    if (stream->skip(size) != size) {
+        return nullptr;
+    }
+    return SkData::MakeSubset(data.get(), offset, size);
+}
+
 void SkPictureData::WriteFactories(SkWStream* stream, const SkFactorySet& rec) {
     int count = rec.count();
 
@@ -204,6 +254,13 @@ void SkPictureData::flattenToBuffer(SkWriteBuffer& buffer, bool textBlobsOnly) c
                 buffer.writeImage(img.get());
             }
         }
+
+        if (this->hasOpBounds()) {
+            write_tag_size(buffer, SK_PICT_OP_BOUNDS_BUFFER_TAG, fOpBounds.size());
+            buffer.writeScalarArray(&fOpBounds.data()->fLeft, 4 * fOpBounds.size());
+            buffer.writeIntArray(reinterpret_cast<const int32_t*>(fOpOffsets.data()),
+                                 fOpOffsets.size());
+        }
     }
 }
 
@@ -228,6 +285,7 @@ void SkPictureData::serialize(SkWStream* stream, const SkSerialProcs& procs,
                               SkRefCntSet* topLevelTypeFaceSet, bool textBlobsOnly) const {
     // This can happen at pretty much any time, so might as well do it first.
     write_tag_size(stream, SK_PICT_READER_TAG, fOpData->size());
+    write_alignment_padding(stream);
     stream->write(fOpData->bytes(), fOpData->size());
 
     // We serialize all typefaces into the typeface section of the top-level picture.
@@ -265,6 +323,7 @@ void SkPictureData::serialize(SkWStream* stream, const SkSerialProcs& procs,
 
     // Write the buffer.
     write_tag_size(stream, SK_PICT_BUFFER_SIZE_TAG, buffer.bytesWritten());
+    write_alignment_padding(stream);
     buffer.writeToStream(stream);
 
     // Write sub-pictures by calling serialize again.
@@ -312,7 +371,16 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
     switch (tag) {
         case SK_PICT_READER_TAG:
             SkASSERT(nullptr == fOpData);
-            fOpData = SkData::MakeFromStream(stream, size);
+            if (fInfo.getVersion() >= SkPicturePriv::kAlignedStreamData &&
+                !skip_alignment_padding(stream)) {
+                return false;
+            }
+            if (fShareStreamData) {
+                fOpData = share_from_stream(stream, size);
+            }
+            if (!fOpData) {
+                fOpData = SkData::MakeFromStream(stream, size);
+            }
             if (!fOpData) {
                 return false;
             }
@@ -370,7 +438,8 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
 
             for (uint32_t i = 0; i < size; i++) {
                 auto pic = SkPicture::MakeFromStreamPriv(stream, &procs,
-                                                         topLevelTFPlayback, recursionLimit - 1);
+                                                         topLevelTFPlayback, recursionLimit - 1,
+                                                         fShareStreamData);
                 if (!pic) {
                     return false;
                 }
@@ -378,15 +447,25 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             }
         } break;
         case SK_PICT_BUFFER_SIZE_TAG: {
-            if (StreamRemainingLengthIsBelow(stream, size)) {
+            if (fInfo.getVersion() >= SkPicturePriv::kAlignedStreamData &&
+                !skip_alignment_padding(stream)) {
                 return false;
             }
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
+            if (StreamRemainingLengthIsBelow(stream, size)) {
                 return false;
             }
+            // Images read from a shared buffer refer to their encoded data in place.
+            sk_sp<SkData> shared = fShareStreamData ? share_from_stream(stream, size) : nullptr;
+            SkAutoMalloc storage;
+            if (!shared) {
+                storage.reset(size);
+                if (stream->read(storage.get(), size) != size) {
+                    return false;
+                }
+            }
 
-            SkReadBuffer buffer(storage.get(), size);
+            SkReadBuffer buffer(shared ? shared->data() : storage.get(), size);
+            buffer.setBackingData(std::move(shared));
             buffer.setVersion(fInfo.getVersion());
 
             if (!fFactoryPlayback) {
@@ -509,6 +588,31 @@ void SkPictureData::parseBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t
         case SK_PICT_DRAWABLE_TAG:
             new_array_from_buffer(buffer, size, fDrawables, create_drawable_from_buffer);
             break;
+        case SK_PICT_OP_BOUNDS_BUFFER_TAG: {
+            // The op data is always written ahead of the buffer, so we can check the offsets.
+            if (!buffer.validate(size > 0 && fOpData && !this->hasOpBounds()) ||
+                !buffer.validateCanReadN<SkRect>(size)) {
+                return;
+            }
+            fOpBounds.resize(size);
+            fOpOffsets.resize(size + 1);
+            if (!buffer.readScalarArray(&fOpBounds.data()->fLeft, 4 * size) ||
+                !buffer.readIntArray(reinterpret_cast<int32_t*>(fOpOffsets.data()), size + 1)) {
+                return;
+            }
+            for (uint32_t i = 0; i <= size; ++i) {
+                if (!buffer.validate(SkIsAlign4(fOpOffsets[i]) &&
+                                     fOpOffsets[i] <= fOpData->size() &&
+                                     (i == 0 || fOpOffsets[i - 1] <= fOpOffsets[i]))) {
+                    return;
+                }
+            }
+            for (const SkRect& bounds : fOpBounds) {
+                if (!buffer.validate(bounds.isFinite())) {
+                    return;
+                }
+            }
+        } break;
         default:
             buffer.validate(false); // The tag was invalid.
             break;
@@ -519,8 +623,10 @@ SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
                                                const SkPictInfo& info,
                                                const SkDeserialProcs& procs,
                                                SkTypefacePlayback* topLevelTFPlayback,
-                                               int recursionLimit) {
+                                               int recursionLimit,
+                                               bool shareStreamData) {
     std::unique_ptr<SkPictureData> data(new SkPictureData(info));
+    data->fShareStreamData = shareStreamData;
     if (!topLevelTFPlayback) {
         topLevelTFPlayback = &data->fTFPlayback;
     }
@@ -528,6 +634,10 @@ SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
     if (!data->parseStream(stream, procs, topLevelTFPlayback, recursionLimit)) {
         return nullptr;
     }
+    if (shareStreamData) {
+        // This will be played back directly, perhaps on several threads at once.
+        data->initForPlayback();
+    }
     return data.release();
 }
 
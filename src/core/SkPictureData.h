@@ -21,13 +21,17 @@
 #include "include/core/SkTextBlob.h"
 #include "include/core/SkTypes.h"
 #include "include/core/SkVertices.h"
+#include "include/private/base/SkOnce.h"
 #include "include/private/base/SkTArray.h"
 #include "include/private/chromium/Slug.h"
 #include "src/core/SkPictureFlat.h"
+#include "src/core/SkRTree.h"
 #include "src/core/SkReadBuffer.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 class SkFactorySet;
 class SkPictureRecord;
@@ -74,6 +78,7 @@ public:
 #define SK_PICT_SLUG_BUFFER_TAG SkSetFourByteTag('s', 'l', 'u', 'g')
 #define SK_PICT_VERTICES_BUFFER_TAG SkSetFourByteTag('v', 'e', 'r', 't')
 #define SK_PICT_IMAGE_BUFFER_TAG    SkSetFourByteTag('i', 'm', 'a', 'g')
+#define SK_PICT_OP_BOUNDS_BUFFER_TAG SkSetFourByteTag('b', 'b', 'h', ' ')
 
 // Always write this last (with no length field afterwards)
 #define SK_PICT_EOF_TAG     SkSetFourByteTag('e', 'o', 'f', ' ')
@@ -88,12 +93,19 @@ T* read_index_base_1_or_null(SkReadBuffer* reader,
 class SkPictureData {
 public:
     SkPictureData(const SkPictureRecord& record, const SkPictInfo&);
-    // Does not affect ownership of SkStream.
+    // opBounds[i] bounds the ops recorded in [opOffsets[i], opOffsets[i+1]) of the op data, so
+    // opOffsets holds one more entry than opBounds. See searchOpBounds().
+    SkPictureData(const SkPictureRecord& record, const SkPictInfo&,
+                  skia_private::TArray<SkRect> opBounds,
+                  skia_private::TArray<uint32_t> opOffsets);
+    // Does not affect ownership of SkStream. If shareStreamData is true, the stream must be an
+    // SkMemoryStream over an SkData, which the op data and images may then refer to directly.
     static SkPictureData* CreateFromStream(SkStream*,
                                            const SkPictInfo&,
                                            const SkDeserialProcs&,
                                            SkTypefacePlayback*,
-                                           int recursionLimit);
+                                           int recursionLimit,
+                                           bool shareStreamData = false);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
 
     void serialize(SkWStream*, const SkSerialProcs&, SkRefCntSet*, bool textBlobsOnly=false) const;
@@ -103,6 +115,22 @@ public:
 
     const sk_sp<SkData>& opData() const { return fOpData; }
 
+    const skia_private::TArray<sk_sp<const SkPicture>>& pictures() const { return fPictures; }
+
+    // Pictures recorded with a BBH keep the bounds of runs of their ops, so playback can skip
+    // the runs outside the clip. Run i is the op data in [opOffsets()[i], opOffsets()[i+1]).
+    // The ops before the first run and after the last one are not covered, and always play.
+    bool hasOpBounds() const { return !fOpBounds.empty(); }
+    const skia_private::TArray<SkRect>& opBounds() const { return fOpBounds; }
+    const skia_private::TArray<uint32_t>& opOffsets() const { return fOpOffsets; }
+    size_t opBoundsBytesUsed() const {
+        return fOpBounds.size_bytes() + fOpOffsets.size_bytes();
+    }
+
+    // Appends the indices of the runs whose bounds intersect query, in increasing order.
+    // The SkRTree over the bounds is built by the first search.
+    void searchOpBounds(const SkRect& query, std::vector<int>* runs) const;
+
 protected:
     explicit SkPictureData(const SkPictInfo& info);
 
@@ -178,7 +206,13 @@ private:
     SkTypefacePlayback                 fTFPlayback;
     std::unique_ptr<SkFactoryPlayback> fFactoryPlayback;
 
+    skia_private::TArray<SkRect>   fOpBounds;
+    skia_private::TArray<uint32_t> fOpOffsets;
+    mutable SkOnce                 fOpBBHOnce;
+    mutable SkRTree                fOpBBH;
+
     const SkPictInfo fInfo;
+    bool             fShareStreamData = false;
 
     static void WriteFactories(SkWStream* stream, const SkFactorySet& rec);
     static void WriteTypefaces(SkWStream* stream, const SkRefCntSet& rec, const SkSerialProcs&);
@@ -61,6 +61,15 @@ static const SkRect* get_rect_ptr(SkReadBuffer* reader, SkRect* storage) {
 void SkPicturePlayback::draw(SkCanvas* canvas,
                              SkPicture::AbortCallback* callback,
                              SkReadBuffer* buffer) {
+    const OpRange all = {0, fPictureData->opData()->size()};
+    this->draw(canvas, callback, buffer, {&all, 1});
+}
+
+void SkPicturePlayback::draw(SkCanvas* canvas,
+                             SkPicture::AbortCallback* callback,
+                             SkReadBuffer* buffer,
+                             SkSpan<const OpRange> ranges,
+                             const std::function<void(size_t)>& beforeRange) {
     AutoResetOpID aroi(this);
     SkASSERT(0 == fCurOffset);
 
@@ -73,25 +82,36 @@ void SkPicturePlayback::draw(SkCanvas* canvas,
 
     SkAutoCanvasRestore acr(canvas, false);
 
-    while (!reader.eof() && reader.isValid()) {
-        if (callback && callback->abort()) {
-            return;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        const OpRange& range = ranges[i];
+        SkASSERT(range.fStart <= range.fEnd);
+        if (range.fStart > reader.offset()) {
+            reader.skip(range.fStart - reader.offset());
+        }
+        if (beforeRange) {
+            beforeRange(i);
         }
 
-        fCurOffset = reader.offset();
+        while (reader.offset() < range.fEnd && !reader.eof() && reader.isValid()) {
+            if (callback && callback->abort()) {
+                return;
+            }
+
+            fCurOffset = reader.offset();
 
-        uint32_t bits = reader.readInt();
-        uint32_t op   = bits >> 24,
-                 size = bits & 0xffffff;
-        if (size == 0xffffff) {
-            size = reader.readInt();
-        }
+            uint32_t bits = reader.readInt();
+            uint32_t op   = bits >> 24,
+                     size = bits & 0xffffff;
+            if (size == 0xffffff) {
+                size = reader.readInt();
+            }
 
-        if (!reader.validate(size > 0 && op > UNUSED && op <= LAST_DRAWTYPE_ENUM)) {
-            return;
-        }
+            if (!reader.validate(size > 0 && op > UNUSED && op <= LAST_DRAWTYPE_ENUM)) {
+                return;
+            }
 
-        this->handleOp(&reader, (DrawType)op, size, canvas, initialMatrix);
+            this->handleOp(&reader, (DrawType)op, size, canvas, initialMatrix);
+        }
     }
 
     // need to propagate invalid state to the parent reader
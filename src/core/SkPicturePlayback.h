@@ -10,11 +10,13 @@
 
 #include "include/core/SkM44.h"
 #include "include/core/SkPicture.h"
+#include "include/core/SkSpan.h"
 #include "include/private/base/SkNoncopyable.h"
 #include "src/core/SkPictureFlat.h"
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 
 class SkCanvas;
 class SkPictureData;
@@ -30,6 +32,20 @@ public:
 
     void draw(SkCanvas* canvas, SkPicture::AbortCallback*, SkReadBuffer* buffer);
 
+    // A range [fStart, fEnd) of byte offsets into the picture's op data.
+    struct OpRange {
+        size_t fStart;
+        size_t fEnd;
+    };
+
+    // Plays back only the ops that start within one of the ranges, which must be sorted and
+    // must not overlap. Every op that is skipped must be balanced, i.e. skip a save() only along
+    // with its restore(), as SkRecordFillBounds() arranges for ops that share bounds.
+    // If given, beforeRange(i) is called just before the ops of ranges[i] are played.
+    void draw(SkCanvas* canvas, SkPicture::AbortCallback*, SkReadBuffer* buffer,
+              SkSpan<const OpRange> ranges,
+              const std::function<void(size_t)>& beforeRange = nullptr);
+
     // TODO: remove the curOp calls after cleaning up GrGatherDevice
     // Return the ID of the operation currently being executed when playing
     // back. 0 indicates no call is active.
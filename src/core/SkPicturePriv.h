@@ -124,6 +124,8 @@ public:
     // v105: Unclamped matrix color filter
     // v106: SaveLayer supports custom backdrop tile modes
     // v107: Combine SkColorShader and SkColorShader4
+    // v109: Op data and the flattened buffer in streams are padded to a 4-byte offset
+    // v110: Pictures recorded with a BBH serialize the bounds of their ops
 
     enum Version {
         kPictureShaderFilterParam_Version   = 82,
@@ -153,6 +155,8 @@ public:
         kSaveLayerBackdropTileMode          = 106,
         kCombineColorShaders                = 107,
         kSerializeStableKeys                = 108,
+        kAlignedStreamData                  = 109,
+        kSerializeOpBounds                  = 110,
 
         // Only SKPs within the min/current picture version range (inclusive) can be read.
         //
@@ -177,7 +181,7 @@ public:
         //
         // Contact the Infra Gardener if the above steps do not work for you.
         kMin_Version     = kPictureShaderFilterParam_Version,
-        kCurrent_Version = kSerializeStableKeys
+        kCurrent_Version = kSerializeOpBounds
     };
 };
 
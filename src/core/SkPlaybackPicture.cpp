@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkPlaybackPicture.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkMatrix.h"
+#include "include/private/base/SkAssert.h"
+#include "include/private/base/SkTArray.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkPictureFlat.h"
+#include "src/core/SkPicturePlayback.h"
+#include "src/core/SkPictureRecord.h"
+#include "src/core/SkReadBuffer.h"
+
+#include <utility>
+#include <vector>
+
+SkPlaybackPicture::SkPlaybackPicture(const SkRect& cull,
+                                     std::unique_ptr<const SkPictureData> data)
+    : fCullRect(cull)
+    , fData(std::move(data)) {
+    SkASSERT(fData && fData->opData());
+}
+
+void SkPlaybackPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
+    SkASSERT(canvas);
+    SkPicturePlayback playback(fData.get());
+
+    // Like SkBigPicture, only consult the op bounds if the clip might exclude some of our ops.
+    // The bounds are in the same space as fCullRect, as is getLocalClipBounds().
+    const SkRect query = canvas->getLocalClipBounds();
+    if (!fData->hasOpBounds() || query.contains(fCullRect)) {
+        playback.draw(canvas, callback, nullptr);
+        return;
+    }
+
+    std::vector<int> runs;
+    fData->searchOpBounds(query, &runs);
+
+    // Play the ops ahead of the first run and after the last one, and the runs that were found,
+    // merging runs that follow one another into a single range.
+    const skia_private::TArray<uint32_t>& offsets = fData->opOffsets();
+    std::vector<SkPicturePlayback::OpRange> ranges;
+    ranges.reserve(runs.size() + 2);
+    ranges.push_back({0, offsets.front()});
+    for (int run : runs) {
+        SkASSERT(ranges.back().fEnd <= offsets[run]);
+        if (ranges.back().fEnd == offsets[run]) {
+            ranges.back().fEnd = offsets[run + 1];
+        } else {
+            ranges.push_back({offsets[run], offsets[run + 1]});
+        }
+    }
+    if (ranges.back().fEnd == offsets.back()) {
+        ranges.back().fEnd = fData->opData()->size();
+    } else {
+        ranges.push_back({offsets.back(), fData->opData()->size()});
+    }
+    playback.draw(canvas, callback, nullptr, ranges);
+}
+
+void SkPlaybackPicture::playbackWithOpBounds(SkPictureRecord* rec,
+                                             skia_private::TArray<SkRect>* opBounds,
+                                             skia_private::TArray<uint32_t>* opOffsets) const {
+    SkASSERT(rec && opBounds && opOffsets);
+    SkASSERT(fData->hasOpBounds());
+
+    // Play every op, as the ops ahead of the first run, then each run, then the ops after the
+    // last run, noting where rec's op data is at the start of each run and after the last one.
+    const skia_private::TArray<uint32_t>& offsets = fData->opOffsets();
+    std::vector<SkPicturePlayback::OpRange> ranges;
+    ranges.reserve(offsets.size() + 1);
+    ranges.push_back({0, offsets.front()});
+    for (int i = 0; i + 1 < offsets.size(); ++i) {
+        ranges.push_back({offsets[i], offsets[i + 1]});
+    }
+    ranges.push_back({offsets.back(), fData->opData()->size()});
+
+    opOffsets->reserve_exact(offsets.size());
+    SkPicturePlayback playback(fData.get());
+    playback.draw(rec, nullptr, nullptr, ranges, [&](size_t range) {
+        if (range > 0) {
+            opOffsets->push_back(SkToU32(rec->writeStream().bytesWritten()));
+        }
+    });
+    *opBounds = fData->opBounds();
+}
+
+void SkPlaybackPicture::countOps() const {
+    // Each op starts with its type and size, so we can step over them without parsing them.
+    const sk_sp<SkData>& ops = fData->opData();
+    SkReadBuffer reader(ops->data(), ops->size());
+    reader.setVersion(fData->info().getVersion());
+    while (!reader.eof() && reader.isValid()) {
+        const size_t start = reader.offset();
+        const uint32_t bits = reader.readUInt();
+        uint32_t size = bits & 0xffffff;
+        if (size == 0xffffff) {
+            size = reader.readUInt();
+        }
+
+        // Like SkBigPicture, count a nested picture's ops in place of the op that draws it.
+        const SkPicture* picture = nullptr;
+        if ((bits >> 24) == DRAW_PICTURE) {
+            picture = fData->getPicture(&reader);
+        } else if ((bits >> 24) == DRAW_PICTURE_MATRIX_PAINT) {
+            fData->optionalPaint(&reader);
+            SkMatrix matrix;
+            reader.readMatrix(&matrix);
+            picture = fData->getPicture(&reader);
+        }
+        fOpCount += 1;
+        fNestedOpCount += picture ? picture->approximateOpCount(true) : 1;
+
+        if (!reader.validate(start + size >= reader.offset())) {
+            break;
+        }
+        reader.skip(start + size - reader.offset());
+    }
+}
+
+int SkPlaybackPicture::approximateOpCount(bool nested) const {
+    fCountOnce([this] { this->countOps(); });
+    return nested ? fNestedOpCount : fOpCount;
+}
+
+size_t SkPlaybackPicture::approximateBytesUsed() const {
+    size_t bytes = sizeof(*this) + sizeof(SkPictureData) + fData->opData()->size() +
+                   fData->opBoundsBytesUsed();
+    for (const sk_sp<const SkPicture>& picture : fData->pictures()) {
+        bytes += picture->approximateBytesUsed();
+    }
+    return bytes;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPlaybackPicture_DEFINED
+#define SkPlaybackPicture_DEFINED
+
+#include "include/core/SkPicture.h"
+#include "include/core/SkRect.h"
+#include "include/private/base/SkOnce.h"
+#include "include/private/base/SkTArray.h"
+#include "src/core/SkPictureData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class SkCanvas;
+class SkPictureRecord;
+
+// An implementation of SkPicture that draws straight from deserialized SkPictureData, parsing
+// each op as it is drawn, rather than first converting it to an SkRecord like Forwardport() does.
+// The op data may be a subset of the data the picture was read from, e.g. a mapped file, so
+// loading a picture this way costs little more than reading its paints, paths and images.
+// If the picture was recorded with a BBH, playback skips the ops that fall outside the clip.
+class SkPlaybackPicture final : public SkPicture {
+public:
+    SkPlaybackPicture(const SkRect& cull, std::unique_ptr<const SkPictureData>);
+
+// SkPicture overrides
+    void playback(SkCanvas*, AbortCallback*) const override;
+    SkRect cullRect() const override { return fCullRect; }
+    int approximateOpCount(bool nested) const override;
+    size_t approximateBytesUsed() const override;
+    const SkPlaybackPicture* asSkPlaybackPicture() const override { return this; }
+
+    bool hasOpBounds() const { return fData->hasOpBounds(); }
+
+// Used by SkPicture::backport(), like SkBigPicture::playbackWithOpBounds(), to carry our op
+// bounds over to the op data that rec records. Plays back into rec just as playback() would with
+// no clip, recording our op bounds and the offsets in rec's op data where each run of ops begins,
+// plus the offset where the last one ends. Must only be called if hasOpBounds().
+    void playbackWithOpBounds(SkPictureRecord* rec,
+                              skia_private::TArray<SkRect>* opBounds,
+                              skia_private::TArray<uint32_t>* opOffsets) const;
+
+private:
+    void countOps() const;
+
+    const SkRect                         fCullRect;
+    std::unique_ptr<const SkPictureData> fData;
+
+    // Counting the ops means stepping through all of them, so it is only done when asked for.
+    mutable SkOnce                       fCountOnce;
+    mutable int                          fOpCount = 0;
+    mutable int                          fNestedOpCount = 0;
+};
+
+#endif//SkPlaybackPicture_DEFINED
@@ -20,13 +20,16 @@
 #include "src/core/SkRasterPipelineOpList.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <iterator>
 #include <vector>
 
 using namespace skia_private;
 using Op = SkRasterPipelineOp;
 
 bool gForceHighPrecisionRasterPipeline;
+bool gDisableRasterPipelineFusion;
 
 SkRasterPipeline::SkRasterPipeline(SkArenaAlloc* alloc) : fAlloc(alloc) {
     this->reset();
@@ -105,12 +108,19 @@ void SkRasterPipeline::uncheckedAppend(SkRasterPipelineOp op, void* ctx) {
             isStore = true;
             break;
         }
-        case Op::srcover_rgba_8888: {
+        case Op::srcover_rgba_8888:
+        case Op::fused_srcover_rgba_8888:
+        case Op::fused_srcover_bgra_8888: {
             ct = kRGBA_8888_SkColorType;
             isLoad = true;
             isStore = true;
             break;
         }
+        case Op::load_8888_premul: {
+            ct = kRGBA_8888_SkColorType;
+            isLoad = true;
+            break;
+        }
         case Op::scale_u8:
         case Op::lerp_u8: {
             ct = kAlpha_8_SkColorType;
@@ -224,6 +234,97 @@ const char* SkRasterPipeline::GetOpName(SkRasterPipelineOp op) {
     return name;
 }
 
+namespace {
+
+// A fusion replaces a run of ops with a single op doing the same work in one stage, saving the
+// cost of handing pixels from stage to stage. The fused op's stages compute exactly the pixels the
+// run would, in lowp and highp alike. Every op in the run that has a context must share it, and
+// the fused op takes that context.
+struct Fusion {
+    Op   ops[5];
+    int  count;
+    Op   fused;
+    // The fused stores leave different values in registers than the runs they replace (e.g.
+    // fused_srcover_bgra_8888 skips the final swap_rb), so they can only end a program.
+    bool endsProgram;
+};
+
+constexpr Fusion kFusions[] = {
+    {{Op::load_8888, Op::premul}, 2, Op::load_8888_premul, false},
+    {{Op::load_8888_dst, Op::srcover, Op::store_8888}, 3, Op::fused_srcover_rgba_8888, true},
+    {{Op::load_8888_dst, Op::swap_rb_dst, Op::srcover, Op::swap_rb, Op::store_8888}, 5,
+      Op::fused_srcover_bgra_8888, true},
+};
+static_assert(std::size(kFusions) <= 32, "Fusions are tracked in a uint32_t mask.");
+
+std::atomic<int> gFusionCounts[std::size(kFusions)];
+
+}  // namespace
+
+int SkRasterPipeline::GetFusionCount(SkRasterPipelineOp fusedOp) {
+    for (size_t i = 0; i < std::size(kFusions); ++i) {
+        if (kFusions[i].fused == fusedOp) {
+            return gFusionCounts[i].load(std::memory_order_relaxed);
+        }
+    }
+    return 0;
+}
+
+// Fusion changes the number of stages in the program, so it must be skipped for programs that
+// branch: their branch contexts hold stage offsets.
+static bool can_fuse(const SkRasterPipeline::StageList* st) {
+    if (gDisableRasterPipelineFusion) {
+        return false;
+    }
+    for (; st; st = st->prev) {
+        switch (st->stage) {
+            case Op::branch_if_all_lanes_active:
+            case Op::branch_if_any_lanes_active:
+            case Op::branch_if_no_lanes_active:
+            case Op::branch_if_no_active_lanes_eq:
+            case Op::jump:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// If the run of stages ending with `st` can be fused, sets `op` and `ctx` to the fused op and
+// returns the first stage of the run. Otherwise leaves `st`'s op and context and returns `st`.
+static const SkRasterPipeline::StageList* fuse(const SkRasterPipeline::StageList* st,
+                                               bool endsProgram,
+                                               Op* op,
+                                               void** ctx,
+                                               uint32_t* fusions) {
+    *op  = st->stage;
+    *ctx = st->ctx;
+    for (size_t f = 0; f < std::size(kFusions); ++f) {
+        const Fusion& fusion = kFusions[f];
+        if (fusion.endsProgram && !endsProgram) {
+            continue;
+        }
+        const SkRasterPipeline::StageList* first = st;
+        void* fusedCtx = nullptr;
+        int i = fusion.count;
+        for (const SkRasterPipeline::StageList* s = st; s && i > 0; s = s->prev, --i) {
+            if (s->stage != fusion.ops[i - 1] || (s->ctx && fusedCtx && s->ctx != fusedCtx)) {
+                break;
+            }
+            fusedCtx = s->ctx ? s->ctx : fusedCtx;
+            first = s;
+        }
+        if (i == 0) {
+            *op  = fusion.fused;
+            *ctx = fusedCtx;
+            *fusions |= 1u << f;
+            return first;
+        }
+    }
+    return st;
+}
+
 void SkRasterPipeline::dump() const {
     SkDebugf("SkRasterPipeline, %d stages\n", fNumStages);
     std::vector<const char*> stages;
@@ -264,24 +365,26 @@ void SkRasterPipeline::appendConstantColor(SkArenaAlloc* alloc, const float rgba
         this->append(Op::white_color);
     } else {
         auto ctx = alloc->make<SkRasterPipeline_UniformColorCtx>();
-        skvx::float4 color = skvx::float4::Load(rgba);
-        color.store(&ctx->r);
-
-        // uniform_color requires colors in range and can go lowp,
-        // while unbounded_uniform_color supports out-of-range colors too but not lowp.
-        if (0 <= rgba[0] && rgba[0] <= rgba[3] &&
-            0 <= rgba[1] && rgba[1] <= rgba[3] &&
-            0 <= rgba[2] && rgba[2] <= rgba[3]) {
-            // To make loads more direct, we store 8-bit values in 16-bit slots.
-            color = color * 255.0f + 0.5f;
-            ctx->rgba[0] = (uint16_t)color[0];
-            ctx->rgba[1] = (uint16_t)color[1];
-            ctx->rgba[2] = (uint16_t)color[2];
-            ctx->rgba[3] = (uint16_t)color[3];
-            this->uncheckedAppend(Op::uniform_color, ctx);
-        } else {
-            this->uncheckedAppend(Op::unbounded_uniform_color, ctx);
-        }
+        skvx::float4::Load(rgba).store(&ctx->r);
+        this->appendUniformColor(ctx);
+    }
+}
+
+void SkRasterPipeline::appendUniformColor(SkRasterPipeline_UniformColorCtx* ctx) {
+    // uniform_color requires colors in range and can go lowp,
+    // while unbounded_uniform_color supports out-of-range colors too but not lowp.
+    if (0 <= ctx->r && ctx->r <= ctx->a &&
+        0 <= ctx->g && ctx->g <= ctx->a &&
+        0 <= ctx->b && ctx->b <= ctx->a) {
+        // To make loads more direct, we store 8-bit values in 16-bit slots.
+        skvx::float4 color = skvx::float4::Load(&ctx->r) * 255.0f + 0.5f;
+        ctx->rgba[0] = (uint16_t)color[0];
+        ctx->rgba[1] = (uint16_t)color[1];
+        ctx->rgba[2] = (uint16_t)color[2];
+        ctx->rgba[3] = (uint16_t)color[3];
+        this->uncheckedAppend(Op::uniform_color, ctx);
+    } else {
+        this->uncheckedAppend(Op::unbounded_uniform_color, ctx);
     }
 }
 
@@ -559,30 +662,43 @@ static void prepend_to_pipeline(SkRasterPipelineStage*& ip, SkOpts::StageFn stag
     ip->ctx = ctx;
 }
 
-bool SkRasterPipeline::buildLowpPipeline(SkRasterPipelineStage* ip) const {
+SkRasterPipelineStage* SkRasterPipeline::buildLowpPipeline(SkRasterPipelineStage* ip,
+                                                           uint32_t* fusions) const {
     if (gForceHighPrecisionRasterPipeline || fRewindCtx) {
-        return false;
+        return nullptr;
     }
     // Stages are stored backwards in fStages; to compensate, we assemble the pipeline in reverse
     // here, back to front.
     prepend_to_pipeline(ip, SkOpts::just_return_lowp, /*ctx=*/nullptr);
+    const bool canFuse = can_fuse(fStages);
     for (const StageList* st = fStages; st; st = st->prev) {
-        int opIndex = (int)st->stage;
+        Op op = st->stage;
+        void* ctx = st->ctx;
+        if (canFuse) {
+            st = fuse(st, /*endsProgram=*/st == fStages, &op, &ctx, fusions);
+        }
+        int opIndex = (int)op;
         if (opIndex >= kNumRasterPipelineLowpOps || !SkOpts::ops_lowp[opIndex]) {
             // This program contains a stage that doesn't exist in lowp.
-            return false;
+            return nullptr;
         }
-        prepend_to_pipeline(ip, SkOpts::ops_lowp[opIndex], st->ctx);
+        prepend_to_pipeline(ip, SkOpts::ops_lowp[opIndex], ctx);
     }
-    return true;
+    return ip;
 }
 
-void SkRasterPipeline::buildHighpPipeline(SkRasterPipelineStage* ip) const {
+SkRasterPipelineStage* SkRasterPipeline::buildHighpPipeline(SkRasterPipelineStage* ip,
+                                                            uint32_t* fusions) const {
     // We assemble the pipeline in reverse, since the stage list is stored backwards.
     prepend_to_pipeline(ip, SkOpts::just_return_highp, /*ctx=*/nullptr);
+    const bool canFuse = can_fuse(fStages);
     for (const StageList* st = fStages; st; st = st->prev) {
-        int opIndex = (int)st->stage;
-        prepend_to_pipeline(ip, SkOpts::ops_highp[opIndex], st->ctx);
+        Op op = st->stage;
+        void* ctx = st->ctx;
+        if (canFuse) {
+            st = fuse(st, /*endsProgram=*/st == fStages, &op, &ctx, fusions);
+        }
+        prepend_to_pipeline(ip, SkOpts::ops_highp[(int)op], ctx);
     }
 
     // stack_checkpoint and stack_rewind are only implemented in highp. We only need these stages
@@ -593,16 +709,27 @@ void SkRasterPipeline::buildHighpPipeline(SkRasterPipelineStage* ip) const {
         const int rewindIndex = (int)Op::stack_checkpoint;
         prepend_to_pipeline(ip, SkOpts::ops_highp[rewindIndex], fRewindCtx);
     }
+    return ip;
 }
 
-SkRasterPipeline::StartPipelineFn SkRasterPipeline::buildPipeline(SkRasterPipelineStage* ip) const {
+SkRasterPipeline::StartPipelineFn SkRasterPipeline::buildPipeline(
+        SkRasterPipelineStage* end, SkRasterPipelineStage** program) const {
     // We try to build a lowp pipeline first; if that fails, we fall back to a highp float pipeline.
-    if (this->buildLowpPipeline(ip)) {
-        return SkOpts::start_pipeline_lowp;
+    StartPipelineFn start_pipeline = SkOpts::start_pipeline_lowp;
+    uint32_t fusions = 0;
+    *program = this->buildLowpPipeline(end, &fusions);
+    if (!*program) {
+        start_pipeline = SkOpts::start_pipeline_highp;
+        fusions = 0;
+        *program = this->buildHighpPipeline(end, &fusions);
     }
 
-    this->buildHighpPipeline(ip);
-    return SkOpts::start_pipeline_highp;
+    for (size_t f = 0; fusions; ++f, fusions >>= 1) {
+        if (fusions & 1) {
+            gFusionCounts[f].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return start_pipeline;
 }
 
 int SkRasterPipeline::stagesNeeded() const {
@@ -634,8 +761,9 @@ void SkRasterPipeline::run(size_t x, size_t y, size_t w, size_t h) const {
         memset(patches[i].scratch, 0, sizeof(patches[i].scratch));
     }
 
-    auto start_pipeline = this->buildPipeline(program.get() + stagesNeeded);
-    start_pipeline(x, y, x + w, y + h, program.get(),
+    SkRasterPipelineStage* first;
+    auto start_pipeline = this->buildPipeline(program.get() + stagesNeeded, &first);
+    start_pipeline(x, y, x + w, y + h, first,
                    SkSpan{patches.data(), numMemoryCtxs},
                    fTailPointer);
 }
@@ -659,14 +787,92 @@ std::function<void(size_t, size_t, size_t, size_t)> SkRasterPipeline::compile()
     }
     uint8_t* tailPointer = fTailPointer;
 
-    auto start_pipeline = this->buildPipeline(program + stagesNeeded);
+    SkRasterPipelineStage* first;
+    auto start_pipeline = this->buildPipeline(program + stagesNeeded, &first);
     return [=](size_t x, size_t y, size_t w, size_t h) {
-        start_pipeline(x, y, x + w, y + h, program,
+        start_pipeline(x, y, x + w, y + h, first,
                        SkSpan{patches, numMemoryCtxs},
                        tailPointer);
     };
 }
 
+bool SkRasterPipeline::compileRelocatable(const void* base, size_t size,
+                                          RelocatableProgram* relocatable) const {
+    if (this->empty() || fTailPointer || fRewindCtx) {
+        return false;
+    }
+
+    auto offset_of = [=](const void* ctx) -> ptrdiff_t {
+        if (!ctx) {
+            return RelocatableProgram::kNullCtx;
+        }
+        uintptr_t b = (uintptr_t)base,
+                  p = (uintptr_t)ctx;
+        return (p >= b && p - b < size) ? (ptrdiff_t)(p - b) : -2;
+    };
+
+    int stagesNeeded = this->stagesNeeded();
+    AutoSTMalloc<32, SkRasterPipelineStage> program(stagesNeeded);
+    SkRasterPipelineStage* end = program.get() + stagesNeeded;
+
+    SkRasterPipelineStage* first;
+    StartPipelineFn start_pipeline = this->buildPipeline(end, &first);
+
+    RelocatableProgram result;
+    result.fStart = start_pipeline;
+    result.fStages.reserve_exact(end - first);
+    for (SkRasterPipelineStage* st = first; st != end; ++st) {
+        ptrdiff_t offset = offset_of(st->ctx);
+        if (offset < RelocatableProgram::kNullCtx) {
+            return false;
+        }
+        result.fStages.push_back({st->fn, offset});
+    }
+    for (const SkRasterPipeline_MemoryCtxInfo& info : fMemoryCtxInfos) {
+        ptrdiff_t offset = offset_of(info.context);
+        if (offset < 0) {
+            return false;
+        }
+        result.fMemoryCtxs.push_back({offset, info.bytesPerPixel, info.load, info.store});
+    }
+
+    *relocatable = std::move(result);
+    return true;
+}
+
+std::function<void(size_t, size_t, size_t, size_t)> SkRasterPipeline::RelocatableProgram::bind(
+        void* base, SkArenaAlloc* alloc) const {
+    SkASSERT(!this->empty());
+    auto relocate = [base](ptrdiff_t offset) -> void* {
+        return offset == kNullCtx ? nullptr : SkTAddOffset<void>(base, offset);
+    };
+
+    int numStages = fStages.size();
+    SkRasterPipelineStage* program = alloc->makeArray<SkRasterPipelineStage>(numStages);
+    for (int i = 0; i < numStages; ++i) {
+        program[i].fn  = fStages[i].fn;
+        program[i].ctx = relocate(fStages[i].ctxOffset);
+    }
+
+    int numMemoryCtxs = fMemoryCtxs.size();
+    SkRasterPipeline_MemoryCtxPatch* patches =
+            alloc->makeArray<SkRasterPipeline_MemoryCtxPatch>(numMemoryCtxs);
+    for (int i = 0; i < numMemoryCtxs; ++i) {
+        const MemoryCtx& m = fMemoryCtxs[i];
+        patches[i].info = {static_cast<SkRasterPipeline_MemoryCtx*>(relocate(m.ctxOffset)),
+                           m.bytesPerPixel, m.load, m.store};
+        patches[i].backup = nullptr;
+        memset(patches[i].scratch, 0, sizeof(patches[i].scratch));
+    }
+
+    StartPipelineFn start_pipeline = fStart;
+    return [=](size_t x, size_t y, size_t w, size_t h) {
+        start_pipeline(x, y, x + w, y + h, program,
+                       SkSpan{patches, numMemoryCtxs},
+                       /*tailPointer=*/nullptr);
+    };
+}
+
 void SkRasterPipeline::addMemoryContext(SkRasterPipeline_MemoryCtx* ctx,
                                         int bytesPerPixel,
                                         bool load,
@@ -93,6 +93,14 @@ public:
     // Allocates a thunk which amortizes run() setup cost in alloc.
     std::function<void(size_t, size_t, size_t, size_t)> compile() const;
 
+    // A compiled program whose stage contexts are recorded relative to one object, so that it can
+    // be bound to any other object with the same layout without being built again.
+    class RelocatableProgram;
+
+    // Builds the program like compile(), for pipelines whose contexts all point into the `size`
+    // bytes at `base`. Returns false, leaving `program` untouched, if any context is elsewhere.
+    bool compileRelocatable(const void* base, size_t size, RelocatableProgram* program) const;
+
     // Callers can inspect the stage list for debugging purposes.
     struct StageList {
         StageList*          prev;
@@ -101,6 +109,13 @@ public:
     };
 
     static const char* GetOpName(SkRasterPipelineOp op);
+
+    // Programs are built with some common runs of ops fused into a single op that does the same
+    // work in one stage, e.g. load_8888_dst, srcover, store_8888 becomes
+    // fused_srcover_rgba_8888. Fusion never changes the pixels a program produces.
+    // Returns how many programs have been built with `fusedOp` standing in for its run.
+    static int GetFusionCount(SkRasterPipelineOp fusedOp);
+
     const StageList* getStageList() const { return fStages; }
     int getNumStages() const { return fNumStages; }
 
@@ -119,6 +134,10 @@ public:
         this->appendConstantColor(alloc, color.vec());
     }
 
+    // Appends a stage for the color in ctx->r,g,b,a, which the caller owns. This fills in
+    // ctx->rgba and, like appendConstantColor(), picks a lowp-capable stage if the color allows.
+    void appendUniformColor(SkRasterPipeline_UniformColorCtx* ctx);
+
     // Like appendConstantColor() but only affecting r,g,b, ignoring the alpha channel.
     void appendSetRGB(SkArenaAlloc*, const float rgb[3]);
 
@@ -139,14 +158,16 @@ public:
     bool empty() const { return fStages == nullptr; }
 
 private:
-    bool buildLowpPipeline(SkRasterPipelineStage* ip) const;
-    void buildHighpPipeline(SkRasterPipelineStage* ip) const;
+    // These assemble the program back to front, ending just before `end`, and return its first
+    // stage (or null if there is no lowp program). Each fusion applied sets a bit in `fusions`.
+    SkRasterPipelineStage* buildLowpPipeline(SkRasterPipelineStage* end, uint32_t* fusions) const;
+    SkRasterPipelineStage* buildHighpPipeline(SkRasterPipelineStage* end, uint32_t* fusions) const;
 
     using StartPipelineFn = void (*)(size_t, size_t, size_t, size_t,
                                      SkRasterPipelineStage* program,
                                      SkSpan<SkRasterPipeline_MemoryCtxPatch>,
                                      uint8_t*);
-    StartPipelineFn buildPipeline(SkRasterPipelineStage*) const;
+    StartPipelineFn buildPipeline(SkRasterPipelineStage* end, SkRasterPipelineStage** program) const;
 
     void uncheckedAppend(SkRasterPipelineOp, void*);
     int stagesNeeded() const;
@@ -165,6 +186,34 @@ private:
     skia_private::STArray<2, SkRasterPipeline_MemoryCtxInfo> fMemoryCtxInfos;
 };
 
+class SkRasterPipeline::RelocatableProgram {
+public:
+    bool empty() const { return fStart == nullptr; }
+
+    // Allocates a thunk in alloc that runs this program with its contexts pointing into `base`.
+    std::function<void(size_t, size_t, size_t, size_t)> bind(void* base, SkArenaAlloc*) const;
+
+private:
+    friend class SkRasterPipeline;
+
+    static constexpr ptrdiff_t kNullCtx = -1;
+
+    struct Stage {
+        void (*fn)();
+        ptrdiff_t ctxOffset;  // From `base`, or kNullCtx.
+    };
+    struct MemoryCtx {
+        ptrdiff_t ctxOffset;
+        int bytesPerPixel;
+        bool load;
+        bool store;
+    };
+
+    StartPipelineFn                           fStart = nullptr;
+    skia_private::TArray<Stage, true>         fStages;
+    skia_private::STArray<2, MemoryCtx, true> fMemoryCtxs;
+};
+
 template <size_t bytes>
 class SkRasterPipeline_ : public SkRasterPipeline {
 public:
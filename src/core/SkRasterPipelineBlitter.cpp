@@ -19,31 +19,97 @@
 #include "include/core/SkSurfaceProps.h"
 #include "include/private/base/SkAssert.h"
 #include "include/private/base/SkCPUTypes.h"
+#include "include/private/base/SkMutex.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkArenaAlloc.h"
+#include "src/base/SkNoDestructor.h"
 #include "src/core/SkBlendModePriv.h"
 #include "src/core/SkBlenderBase.h"
 #include "src/core/SkBlitter.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkColorSpaceXformSteps.h"
+#include "src/core/SkCoreBlitters.h"
 #include "src/core/SkEffectPriv.h"
+#include "src/core/SkImageInfoPriv.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkMask.h"
 #include "src/core/SkMemset.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkRasterPipeline.h"
 #include "src/core/SkRasterPipelineOpContexts.h"
 #include "src/core/SkRasterPipelineOpList.h"
 #include "src/effects/colorfilters/SkColorFilterBase.h"
 #include "src/shaders/SkShaderBase.h"
 
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <functional>
 #include <optional>
+#include <type_traits>
 #include <utility>
 
 class SkColorSpace;
 class SkShader;
 
+extern bool gForceHighPrecisionRasterPipeline;
+extern bool gDisableRasterPipelineFusion;
+
+namespace {
+
+// The blit programs an SkRasterPipelineBlitter builds lazily, one per kind of blit.
+enum class BlitProgram {
+    kRect, kAntiH, kMaskA8, kMaskLCD16, kMask3D, kMemsetColor,
+    kLast = kMemsetColor
+};
+constexpr int kBlitProgramCount = (int)BlitProgram::kLast + 1;
+
+// Everything the blit programs of a solid-color paint with a blend mode depend on, besides the
+// color itself (which they read from the blitter). That includes the global switches and stage
+// tables that SkRasterPipeline builds programs with.
+struct ProgramKey {
+    uint64_t    colorSpaceHash;  // Zero when there's no dst color space.
+    const void* stageTable;
+    uint32_t    colorType,
+                alphaType,
+                blendMode,
+                flags;
+
+    enum Flags : uint32_t {
+        kUnboundedColor = 1 << 0,
+        kHasColorSpace  = 1 << 1,
+        kForceHighp     = 1 << 2,
+        kNoFusion       = 1 << 3,
+    };
+
+    bool operator==(const ProgramKey& that) const {
+        return 0 == memcmp(this, &that, sizeof(ProgramKey));
+    }
+};
+static_assert(std::has_unique_object_representations<ProgramKey>::value);
+
+// The blit programs compiled so far for one ProgramKey, relocatable to any blitter.
+struct ProgramCacheEntry : public SkNVRefCnt<ProgramCacheEntry> {
+    SkRasterPipeline::RelocatableProgram fPrograms[kBlitProgramCount];  // Guarded by the cache.
+};
+
+struct ProgramCache {
+    // Enough for every blend mode into a few dst formats.
+    static constexpr int kMaxEntries = 128;
+
+    SkMutex                                          fMutex;
+    SkLRUCache<ProgramKey, sk_sp<ProgramCacheEntry>> fEntries{kMaxEntries};
+    std::atomic<size_t>                              fHits{0},
+                                                     fMisses{0};
+};
+
+ProgramCache& program_cache() {
+    static SkNoDestructor<ProgramCache> cache;
+    return *cache;
+}
+
+}  // namespace
+
 class SkRasterPipelineBlitter final : public SkBlitter {
 public:
     // This is our common entrypoint for creating the blitter once we've sorted out shaders.
@@ -56,6 +122,13 @@ public:
                              bool is_constant,
                              const SkShader* clipShader);
 
+    // Paints with no shader, color filter or clip shader, and with a blend mode, draw the same
+    // solid color everywhere. Their blit programs are shared through the program cache.
+    static SkBlitter* CreateSolid(const SkPixmap& dst,
+                                  const SkColor4f& dstPaintColor,
+                                  SkBlendMode blendMode,
+                                  SkArenaAlloc* alloc);
+
     SkRasterPipelineBlitter(SkPixmap dst,
                             SkArenaAlloc* alloc)
         : fDst(std::move(dst))
@@ -73,7 +146,19 @@ public:
     void blitV     (int x, int y, int height, SkAlpha alpha)        override;
 
 private:
+    using BlitFn = std::function<void(size_t, size_t, size_t, size_t)>;
+
     void blitRectWithTrace(int x, int y, int w, int h, bool trace);
+
+    // If this blitter shares its programs through the cache and `program` is there already, binds
+    // it to this blitter in *fn and returns true.
+    bool bindCachedProgram(BlitProgram program, BlitFn* fn);
+    // Compiles p, adding it to the cache as `program` if this blitter shares its programs.
+    BlitFn compile(BlitProgram program, const SkRasterPipeline& p);
+
+    using MemsetFn = void (*)(SkPixmap*, int x,int y, int w,int h, uint64_t color);
+    static MemsetFn MemsetProc(int shiftPerPixel);
+
     void appendLoadDst      (SkRasterPipeline*) const;
     void appendStore        (SkRasterPipeline*) const;
 
@@ -96,21 +181,26 @@ private:
     SkRasterPipeline_EmbossCtx fEmbossCtx;  // Used only for k3D_Format masks.
 
     // We may be able to specialize blitH() or blitRect() into a memset.
-    void   (*fMemset2D)(SkPixmap*, int x,int y, int w,int h, uint64_t color) = nullptr;
+    MemsetFn fMemset2D = nullptr;
     uint64_t fMemsetColor = 0;   // Big enough for largest memsettable dst format, F16.
 
     // Built lazily on first use.
-    std::function<void(size_t, size_t, size_t, size_t)> fBlitRect,
-                                                        fBlitAntiH,
-                                                        fBlitMaskA8,
-                                                        fBlitMaskLCD16,
-                                                        fBlitMask3D;
+    BlitFn fBlitRect,
+           fBlitAntiH,
+           fBlitMaskA8,
+           fBlitMaskLCD16,
+           fBlitMask3D;
 
     // These values are pointed to by the blit pipelines above,
     // which allows us to adjust them from call to call.
     float fCurrentCoverage = 0.0f;
     float fDitherRate      = 0.0f;
 
+    // Set by CreateSolid(). Its programs read the paint color from fUniformColor, so that like
+    // every other context they use it lives in this blitter, and they work for any other blitter.
+    sk_sp<ProgramCacheEntry>         fCacheEntry;
+    SkRasterPipeline_UniformColorCtx fUniformColor;
+
     using INHERITED = SkBlitter;
 };
 
@@ -136,6 +226,10 @@ SkBlitter* SkCreateRasterPipelineBlitter(const SkPixmap& dst,
     SkRasterPipeline_<256> shaderPipeline;
     if (!shader) {
         // Having no shader makes things nice and easy... just use the paint color
+        std::optional<SkBlendMode> blendMode = paint.asBlendMode();
+        if (!paint.getColorFilter() && !clipShader && blendMode.has_value()) {
+            return SkRasterPipelineBlitter::CreateSolid(dst, dstPaintColor, *blendMode, alloc);
+        }
         shaderPipeline.appendConstantColor(alloc, dstPaintColor.premul().vec());
         bool is_opaque    = dstPaintColor.fA == 1.0f,
              is_constant  = true;
@@ -316,29 +410,7 @@ SkBlitter* SkRasterPipelineBlitter::Create(const SkPixmap& dst,
         blitter->appendStore(&p);
         p.run(0,0,1,1);
 
-        switch (blitter->fDst.shiftPerPixel()) {
-            case 0: blitter->fMemset2D = [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
-                void* p = dst->writable_addr(x,y);
-                while (h --> 0) {
-                    memset(p, c, w);
-                    p = SkTAddOffset<void>(p, dst->rowBytes());
-                }
-            }; break;
-
-            case 1: blitter->fMemset2D = [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
-                SkOpts::rect_memset16(dst->writable_addr16(x,y), c, w, dst->rowBytes(), h);
-            }; break;
-
-            case 2: blitter->fMemset2D = [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
-                SkOpts::rect_memset32(dst->writable_addr32(x,y), c, w, dst->rowBytes(), h);
-            }; break;
-
-            case 3: blitter->fMemset2D = [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
-                SkOpts::rect_memset64(dst->writable_addr64(x,y), c, w, dst->rowBytes(), h);
-            }; break;
-
-            // TODO(F32)?
-        }
+        blitter->fMemset2D = MemsetProc(blitter->fDst.shiftPerPixel());
     }
 
     {
@@ -359,6 +431,150 @@ SkBlitter* SkRasterPipelineBlitter::Create(const SkPixmap& dst,
     return blitter;
 }
 
+SkBlitter* SkRasterPipelineBlitter::CreateSolid(const SkPixmap& dst,
+                                                const SkColor4f& dstPaintColor,
+                                                SkBlendMode blendMode,
+                                                SkArenaAlloc* alloc) {
+    auto blitter = alloc->make<SkRasterPipelineBlitter>(dst, alloc);
+
+    // This is the color Create() would collapse a constant color pipeline into.
+    SkPMColor4f color = dstPaintColor.premul();
+    if (SkColorTypeIsNormalized(dst.colorType())) {
+        color = {SkTPin(color.fR, 0.0f, 1.0f),
+                 SkTPin(color.fG, 0.0f, 1.0f),
+                 SkTPin(color.fB, 0.0f, 1.0f),
+                 SkTPin(color.fA, 0.0f, 1.0f)};
+    }
+    blitter->fUniformColor = {color.fR, color.fG, color.fB, color.fA, {}};
+    blitter->fColorPipeline.appendUniformColor(&blitter->fUniformColor);
+
+    // We can strength-reduce SrcOver into Src when opaque.
+    if (color.fA == 1.0f && blendMode == SkBlendMode::kSrcOver) {
+        blendMode = SkBlendMode::kSrc;
+    }
+    SkBlendMode_AppendStages(blendMode, &blitter->fBlendPipeline);
+    blitter->fBlendMode = blendMode;
+
+    // appendUniformColor() chose between uniform_color and unbounded_uniform_color.
+    uint32_t flags = 0;
+    if (blitter->fColorPipeline.getStageList()->stage ==
+                SkRasterPipelineOp::unbounded_uniform_color) {
+        flags |= ProgramKey::kUnboundedColor;
+    }
+    if (dst.colorSpace()) {
+        flags |= ProgramKey::kHasColorSpace;
+    }
+    if (gForceHighPrecisionRasterPipeline) {
+        flags |= ProgramKey::kForceHighp;
+    }
+    if (gDisableRasterPipelineFusion) {
+        flags |= ProgramKey::kNoFusion;
+    }
+    const ProgramKey key = {
+        dst.colorSpace() ? dst.colorSpace()->hash() : 0,
+        reinterpret_cast<const void*>(SkOpts::start_pipeline_lowp),
+        (uint32_t)dst.colorType(),
+        (uint32_t)dst.alphaType(),
+        (uint32_t)blendMode,
+        flags,
+    };
+    {
+        ProgramCache& cache = program_cache();
+        SkAutoMutexExclusive lock(cache.fMutex);
+        if (sk_sp<ProgramCacheEntry>* entry = cache.fEntries.find(key)) {
+            blitter->fCacheEntry = *entry;
+        } else {
+            blitter->fCacheEntry = sk_make_sp<ProgramCacheEntry>();
+            cache.fEntries.insert(key, blitter->fCacheEntry);
+        }
+    }
+
+    // When we're drawing in Src mode, we can sometimes just memset.
+    if (blendMode == SkBlendMode::kSrc &&
+        dst.info().bytesPerPixel() <= static_cast<int>(sizeof(blitter->fMemsetColor))) {
+        BlitFn storeColor;
+        if (!blitter->bindCachedProgram(BlitProgram::kMemsetColor, &storeColor)) {
+            SkRasterPipeline p(alloc);
+            p.extend(blitter->fColorPipeline);
+            blitter->appendStore(&p);
+            storeColor = blitter->compile(BlitProgram::kMemsetColor, p);
+        }
+        blitter->fDstPtr = SkRasterPipeline_MemoryCtx{&blitter->fMemsetColor, 0};
+        storeColor(0,0,1,1);
+        blitter->fMemset2D = MemsetProc(blitter->fDst.shiftPerPixel());
+    }
+
+    blitter->fDstPtr = SkRasterPipeline_MemoryCtx{
+        blitter->fDst.writable_addr(),
+        blitter->fDst.rowBytesAsPixels(),
+    };
+
+    return blitter;
+}
+
+bool SkRasterPipelineBlitter::bindCachedProgram(BlitProgram program, BlitFn* fn) {
+    if (!fCacheEntry) {
+        return false;
+    }
+    ProgramCache& cache = program_cache();
+    SkAutoMutexExclusive lock(cache.fMutex);
+    const SkRasterPipeline::RelocatableProgram& cached = fCacheEntry->fPrograms[(int)program];
+    if (cached.empty()) {
+        return false;
+    }
+    *fn = cached.bind(this, fAlloc);
+    cache.fHits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+SkRasterPipelineBlitter::BlitFn SkRasterPipelineBlitter::compile(BlitProgram program,
+                                                                 const SkRasterPipeline& p) {
+    if (!fCacheEntry) {
+        return p.compile();
+    }
+    ProgramCache& cache = program_cache();
+    cache.fMisses.fetch_add(1, std::memory_order_relaxed);
+
+    SkRasterPipeline::RelocatableProgram relocatable;
+    if (!p.compileRelocatable(this, sizeof(*this), &relocatable)) {
+        return p.compile();
+    }
+    BlitFn fn = relocatable.bind(this, fAlloc);
+
+    SkAutoMutexExclusive lock(cache.fMutex);
+    if (fCacheEntry->fPrograms[(int)program].empty()) {
+        fCacheEntry->fPrograms[(int)program] = std::move(relocatable);
+    }
+    return fn;
+}
+
+SkRasterPipelineBlitter::MemsetFn SkRasterPipelineBlitter::MemsetProc(int shiftPerPixel) {
+    switch (shiftPerPixel) {
+        case 0: return [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
+            void* p = dst->writable_addr(x,y);
+            while (h --> 0) {
+                memset(p, c, w);
+                p = SkTAddOffset<void>(p, dst->rowBytes());
+            }
+        };
+
+        case 1: return [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
+            SkOpts::rect_memset16(dst->writable_addr16(x,y), c, w, dst->rowBytes(), h);
+        };
+
+        case 2: return [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
+            SkOpts::rect_memset32(dst->writable_addr32(x,y), c, w, dst->rowBytes(), h);
+        };
+
+        case 3: return [](SkPixmap* dst, int x,int y, int w,int h, uint64_t c) {
+            SkOpts::rect_memset64(dst->writable_addr64(x,y), c, w, dst->rowBytes(), h);
+        };
+
+        // TODO(F32)?
+    }
+    return nullptr;
+}
+
 void SkRasterPipelineBlitter::appendLoadDst(SkRasterPipeline* p) const {
     p->appendLoadDst(fDst.info().colorType(), &fDstPtr);
     if (fDst.info().alphaType() == kUnpremul_SkAlphaType) {
@@ -399,7 +615,7 @@ void SkRasterPipelineBlitter::blitRectWithTrace(int x, int y, int w, int h, bool
         return;
     }
 
-    if (!fBlitRect) {
+    if (!fBlitRect && !this->bindCachedProgram(BlitProgram::kRect, &fBlitRect)) {
         SkRasterPipeline p(fAlloc);
         p.extend(fColorPipeline);
         p.appendClampIfNormalized(fDst.info());
@@ -425,14 +641,14 @@ void SkRasterPipelineBlitter::blitRectWithTrace(int x, int y, int w, int h, bool
             }
             this->appendStore(&p);
         }
-        fBlitRect = p.compile();
+        fBlitRect = this->compile(BlitProgram::kRect, p);
     }
 
     fBlitRect(x,y,w,h);
 }
 
 void SkRasterPipelineBlitter::blitAntiH(int x, int y, const SkAlpha aa[], const int16_t runs[]) {
-    if (!fBlitAntiH) {
+    if (!fBlitAntiH && !this->bindCachedProgram(BlitProgram::kAntiH, &fBlitAntiH)) {
         SkRasterPipeline p(fAlloc);
         p.extend(fColorPipeline);
         p.appendClampIfNormalized(fDst.info());
@@ -450,7 +666,7 @@ void SkRasterPipelineBlitter::blitAntiH(int x, int y, const SkAlpha aa[], const
         }
 
         this->appendStore(&p);
-        fBlitAntiH = p.compile();
+        fBlitAntiH = this->compile(BlitProgram::kAntiH, p);
     }
 
     for (int16_t run = *runs; run > 0; run = *runs) {
@@ -524,7 +740,8 @@ void SkRasterPipelineBlitter::blitMask(const SkMask& mask, const SkIRect& clip)
     }
 
     // Lazily build whichever pipeline we need, specialized for each mask format.
-    if (mask.fFormat == SkMask::kA8_Format && !fBlitMaskA8) {
+    if (mask.fFormat == SkMask::kA8_Format && !fBlitMaskA8 &&
+        !this->bindCachedProgram(BlitProgram::kMaskA8, &fBlitMaskA8)) {
         SkRasterPipeline p(fAlloc);
         p.extend(fColorPipeline);
         p.appendClampIfNormalized(fDst.info());
@@ -541,9 +758,10 @@ void SkRasterPipelineBlitter::blitMask(const SkMask& mask, const SkIRect& clip)
             this->appendClipLerp(&p);
         }
         this->appendStore(&p);
-        fBlitMaskA8 = p.compile();
+        fBlitMaskA8 = this->compile(BlitProgram::kMaskA8, p);
     }
-    if (mask.fFormat == SkMask::kLCD16_Format && !fBlitMaskLCD16) {
+    if (mask.fFormat == SkMask::kLCD16_Format && !fBlitMaskLCD16 &&
+        !this->bindCachedProgram(BlitProgram::kMaskLCD16, &fBlitMaskLCD16)) {
         SkRasterPipeline p(fAlloc);
         p.extend(fColorPipeline);
         p.appendClampIfNormalized(fDst.info());
@@ -561,9 +779,10 @@ void SkRasterPipelineBlitter::blitMask(const SkMask& mask, const SkIRect& clip)
             this->appendClipLerp(&p);
         }
         this->appendStore(&p);
-        fBlitMaskLCD16 = p.compile();
+        fBlitMaskLCD16 = this->compile(BlitProgram::kMaskLCD16, p);
     }
-    if (mask.fFormat == SkMask::k3D_Format && !fBlitMask3D) {
+    if (mask.fFormat == SkMask::k3D_Format && !fBlitMask3D &&
+        !this->bindCachedProgram(BlitProgram::kMask3D, &fBlitMask3D)) {
         SkRasterPipeline p(fAlloc);
         p.extend(fColorPipeline);
         // This bit is where we differ from kA8_Format:
@@ -583,10 +802,10 @@ void SkRasterPipelineBlitter::blitMask(const SkMask& mask, const SkIRect& clip)
             this->appendClipLerp(&p);
         }
         this->appendStore(&p);
-        fBlitMask3D = p.compile();
+        fBlitMask3D = this->compile(BlitProgram::kMask3D, p);
     }
 
-    std::function<void(size_t,size_t,size_t,size_t)>* blitter = nullptr;
+    BlitFn* blitter = nullptr;
     switch (mask.fFormat) {
         case SkMask::kA8_Format:    blitter = &fBlitMaskA8;    break;
         case SkMask::kLCD16_Format: blitter = &fBlitMaskLCD16; break;
@@ -599,3 +818,17 @@ void SkRasterPipelineBlitter::blitMask(const SkMask& mask, const SkIRect& clip)
     SkASSERT(blitter);
     (*blitter)(clip.left(),clip.top(), clip.width(),clip.height());
 }
+
+size_t SkRasterPipelineBlitterCacheHits() {
+    return program_cache().fHits.load(std::memory_order_relaxed);
+}
+
+size_t SkRasterPipelineBlitterCacheMisses() {
+    return program_cache().fMisses.load(std::memory_order_relaxed);
+}
+
+void SkRasterPipelineBlitterPurgeCache() {
+    ProgramCache& cache = program_cache();
+    SkAutoMutexExclusive lock(cache.fMutex);
+    cache.fEntries.reset();
+}
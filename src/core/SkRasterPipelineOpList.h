@@ -37,6 +37,8 @@
     M(darken) M(difference)                                        \
     M(exclusion) M(hardlight) M(lighten) M(overlay)                \
     M(srcover_rgba_8888)                                           \
+    M(fused_srcover_rgba_8888) M(fused_srcover_bgra_8888)          \
+    M(load_8888_premul)                                            \
     M(matrix_translate) M(matrix_scale_translate)                  \
     M(matrix_2x3)                                                  \
     M(matrix_perspective)                                          \
@@ -314,12 +314,27 @@ const void* SkReadBuffer::skipByteArray(size_t* size) {
     return buf;
 }
 
+void SkReadBuffer::setBackingData(sk_sp<SkData> data) {
+    SkASSERT(!data || (data->bytes() <= (const uint8_t*)fBase &&
+                       (const uint8_t*)fStop <= data->bytes() + data->size()));
+    fBackingData = std::move(data);
+}
+
 sk_sp<SkData> SkReadBuffer::readByteArrayAsData() {
     size_t numBytes = this->getArrayCount();
     if (!this->validate(this->isAvailable(numBytes))) {
         return nullptr;
     }
 
+    if (fBackingData) {
+        const void* bytes = this->skipByteArray(&numBytes);
+        if (!bytes) {
+            return nullptr;
+        }
+        return SkData::MakeSubset(fBackingData.get(),
+                                  (const uint8_t*)bytes - fBackingData->bytes(), numBytes);
+    }
+
     SkAutoMalloc buffer(numBytes);
     if (!this->readByteArray(buffer.get(), numBytes)) {
         return nullptr;
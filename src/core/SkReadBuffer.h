@@ -10,6 +10,7 @@
 
 #include "include/core/SkColor.h"
 #include "include/core/SkColorFilter.h"
+#include "include/core/SkData.h"
 #include "include/core/SkFlattenable.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkPaint.h"
@@ -37,7 +38,6 @@
 #include <cstdint>
 
 class SkBlender;
-class SkData;
 class SkImage;
 class SkM44;
 class SkMaskFilter;
@@ -58,6 +58,12 @@ public:
 
     void setMemory(const void*, size_t);
 
+    /**
+     *  If the buffer's memory lies within data, byte arrays read with readByteArrayAsData() (e.g.
+     *  the encoded data of images) are shared subsets of data rather than copies.
+     */
+    void setBackingData(sk_sp<SkData> data);
+
     /**
      *  Returns true IFF the version is older than the specified version.
      */
@@ -250,6 +256,8 @@ private:
 
     SkDeserialProcs fProcs;
 
+    sk_sp<SkData> fBackingData;
+
     static bool IsPtrAlign4(const void* ptr) {
         return SkIsAlign4((uintptr_t)ptr);
     }
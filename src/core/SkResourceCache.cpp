@@ -18,6 +18,7 @@
 #include "include/private/base/SkMutex.h"
 #include "include/private/base/SkTArray.h"
 #include "include/private/base/SkTo.h"
+#include "src/base/SkTDPQueue.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkChecksum.h"
 #include "src/core/SkImageFilter_Base.h"
@@ -29,6 +30,8 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 
 using namespace skia_private;
 
@@ -86,6 +89,27 @@ namespace {
 class SkResourceCache::Hash :
     public THashTable<SkResourceCache::Rec*, SkResourceCache::Key, HashTraits> {};
 
+class SkResourceCache::PriorityQueue {
+public:
+    static bool Less(Rec* const& a, Rec* const& b) {
+        // Break ties by age, so that recs whose cost is proportional to their size go in LRU order.
+        return a->fPriority < b->fPriority ||
+               (a->fPriority == b->fPriority && a->fLastUse - b->fLastUse > UINT32_MAX / 2);
+    }
+    static int* Index(Rec* const& rec) { return &rec->fQueueIndex; }
+
+    SkTDPQueue<Rec*, Less, Index> fQueue;
+};
+
+SkResourceCache::Stats& SkResourceCache::Stats::operator+=(const Stats& that) {
+    fHits         += that.fHits;
+    fMisses       += that.fMisses;
+    fEvictions    += that.fEvictions;
+    fEvictedBytes += that.fEvictedBytes;
+    fEvictedCost  += that.fEvictedCost;
+    return *this;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -93,6 +117,10 @@ void SkResourceCache::init() {
     fHead = nullptr;
     fTail = nullptr;
     fHash = new Hash;
+    fQueue = new PriorityQueue;
+    fEvictionPolicy = EvictionPolicy::kLRU;
+    fInflation = 0;
+    fUseCounter = 0;
     fTotalBytesUsed = 0;
     fCount = 0;
     fSingleAllocationByteLimit = 0;
@@ -121,6 +149,7 @@ SkResourceCache::~SkResourceCache() {
         delete rec;
         rec = next;
     }
+    delete fQueue;
     delete fHash;
 }
 
@@ -133,12 +162,19 @@ bool SkResourceCache::find(const Key& key, FindVisitor visitor, void* context) {
         Rec* rec = *found;
         if (visitor(*rec, context)) {
             this->moveToHead(rec);  // for our LRU
+            if (fEvictionPolicy == EvictionPolicy::kGreedyDualSize) {
+                this->prioritize(rec);
+                fQueue->fQueue.priorityDidChange(rec);
+            }
+            fStats.fHits += 1;
             return true;
         } else {
             this->remove(rec);  // stale
+            fStats.fMisses += 1;
             return false;
         }
     }
+    fStats.fMisses += 1;
     return false;
 }
 
@@ -174,6 +210,10 @@ void SkResourceCache::add(Rec* rec, void* payload) {
 
     this->addToHead(rec);
     fHash->set(rec);
+    if (fEvictionPolicy == EvictionPolicy::kGreedyDualSize) {
+        this->prioritize(rec);
+        fQueue->fQueue.insert(rec);
+    }
     rec->postAddInstall(payload);
 
     if (gDumpCacheTransactions) {
@@ -195,6 +235,9 @@ void SkResourceCache::remove(Rec* rec) {
 
     this->release(rec);
     fHash->remove(rec->getKey());
+    if (fEvictionPolicy == EvictionPolicy::kGreedyDualSize) {
+        fQueue->fQueue.remove(rec);
+    }
 
     fTotalBytesUsed -= used;
     fCount -= 1;
@@ -212,30 +255,105 @@ void SkResourceCache::remove(Rec* rec) {
     delete rec;
 }
 
+void SkResourceCache::evict(Rec* rec) {
+    fStats.fEvictions    += 1;
+    fStats.fEvictedBytes += rec->bytesUsed();
+    fStats.fEvictedCost  += rec->regenerationCost();
+    this->remove(rec);
+}
+
+void SkResourceCache::prioritize(Rec* rec) {
+    rec->fPriority = fInflation + rec->regenerationCost() / std::max<size_t>(rec->bytesUsed(), 1);
+    rec->fLastUse = fUseCounter++;
+}
+
 void SkResourceCache::purgeAsNeeded(bool forcePurge) {
-    size_t byteLimit;
-    int    countLimit;
+    if (forcePurge) {
+        Rec* rec = fTail;
+        while (rec) {
+            Rec* prev = rec->fPrev;
+            if (rec->canBePurged()) {
+                this->remove(rec);
+            }
+            rec = prev;
+        }
+        return;
+    }
 
+    size_t bytesToFree = 0;
+    int    countToFree = 0;
     if (fDiscardableFactory) {
-        countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
-        byteLimit = UINT32_MAX;  // no limit based on bytes
+        const int countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
+        countToFree = fCount >= countLimit ? fCount - countLimit + 1 : 0;
     } else {
-        countLimit = SK_MaxS32; // no limit based on count
-        byteLimit = fTotalByteLimit;
+        bytesToFree = fTotalBytesUsed >= fTotalByteLimit ? fTotalBytesUsed - fTotalByteLimit + 1
+                                                         : 0;
     }
+    if (fCount > 0 && (bytesToFree > 0 || countToFree > 0)) {
+        this->purgeSome(bytesToFree, countToFree);
+    }
+}
 
-    Rec* rec = fTail;
-    while (rec) {
-        if (!forcePurge && fTotalBytesUsed < byteLimit && fCount < countLimit) {
-            break;
+int SkResourceCache::purgeSome(size_t bytesToFree, int countToFree) {
+    size_t freedBytes = 0;
+    int    freedCount = 0;
+    auto done = [&] { return freedBytes >= bytesToFree && freedCount >= countToFree; };
+
+    if (fEvictionPolicy == EvictionPolicy::kLRU) {
+        Rec* rec = fTail;
+        while (rec && !done()) {
+            Rec* prev = rec->fPrev;
+            if (rec->canBePurged()) {
+                freedBytes += rec->bytesUsed();
+                freedCount += 1;
+                this->evict(rec);
+            }
+            rec = prev;
         }
+        return freedCount;
+    }
 
-        Rec* prev = rec->fPrev;
+    // Set aside the recs that can't be purged yet, and put them back when we're done.
+    SkTDPQueue<Rec*, PriorityQueue::Less, PriorityQueue::Index>& queue = fQueue->fQueue;
+    TArray<Rec*> pinned;
+    while (queue.count() > 0 && !done()) {
+        Rec* rec = queue.peek();
         if (rec->canBePurged()) {
-            this->remove(rec);
+            fInflation = std::max(fInflation, rec->fPriority);
+            freedBytes += rec->bytesUsed();
+            freedCount += 1;
+            this->evict(rec);
+        } else {
+            queue.pop();
+            pinned.push_back(rec);
         }
-        rec = prev;
     }
+    for (Rec* rec : pinned) {
+        queue.insert(rec);
+    }
+    return freedCount;
+}
+
+SkResourceCache::EvictionPolicy SkResourceCache::setEvictionPolicy(EvictionPolicy policy) {
+    const EvictionPolicy prevPolicy = fEvictionPolicy;
+    if (policy == prevPolicy) {
+        return prevPolicy;
+    }
+
+    fEvictionPolicy = policy;
+    if (policy == EvictionPolicy::kGreedyDualSize) {
+        // Start from the least recently used, so that ties keep the LRU order.
+        fInflation = 0;
+        for (Rec* rec = fTail; rec; rec = rec->fPrev) {
+            this->prioritize(rec);
+            fQueue->fQueue.insert(rec);
+        }
+    } else {
+        delete fQueue;
+        fQueue = new PriorityQueue;
+    }
+    this->purgeAsNeeded();
+    return prevPolicy;
 }
 
 //#define SK_TRACK_PURGE_SHAREDID_HITRATE
@@ -423,8 +541,11 @@ void SkResourceCache::validate() const {
 void SkResourceCache::dump() const {
     this->validate();
 
-    SkDebugf("SkResourceCache: count=%d bytes=%zu %s\n",
-             fCount, fTotalBytesUsed, fDiscardableFactory ? "discardable" : "malloc");
+    SkDebugf("SkResourceCache: count=%d bytes=%zu %s %s hits=%llu misses=%llu evictions=%llu\n",
+             fCount, fTotalBytesUsed, fDiscardableFactory ? "discardable" : "malloc",
+             fEvictionPolicy == EvictionPolicy::kLRU ? "lru" : "greedy-dual-size",
+             (unsigned long long)fStats.fHits, (unsigned long long)fStats.fMisses,
+             (unsigned long long)fStats.fEvictions);
 }
 
 size_t SkResourceCache::setSingleAllocationByteLimit(size_t newLimit) {
@@ -463,94 +584,273 @@ void SkResourceCache::checkMessages() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static SkMutex& resource_cache_mutex() {
-    static SkMutex& mutex = *(new SkMutex);
-    return mutex;
-}
+#ifndef SK_RESOURCE_CACHE_SHARD_COUNT
+    #define SK_RESOURCE_CACHE_SHARD_COUNT   16
+#endif
 
-/** Must hold resource_cache_mutex() when calling. */
-static SkResourceCache* get_cache() {
-    // resource_cache_mutex() is always held when this is called, so we don't need to be fancy in here.
-    resource_cache_mutex().assertHeld();
-    static SkResourceCache* gResourceCache = nullptr;
-    if (nullptr == gResourceCache) {
+namespace {
+
+/*
+ *  The global cache. Each shard is an SkResourceCache with its own lock and LRU list. The budget
+ *  is for all of them together: after an add pushes the total over it, shards are asked in turn
+ *  to purge their least recently used recs. Other threads can add and purge at the same time, so
+ *  the budget is only enforced approximately.
+ */
+class ShardedCache {
+public:
+    static constexpr int kShardCount = SK_RESOURCE_CACHE_SHARD_COUNT;
+    static_assert(kShardCount > 0, "need at least one shard");
+
+    ShardedCache() {
+        for (Shard& shard : fShards) {
 #if defined(SK_USE_DISCARDABLE_SCALEDIMAGECACHE)
-        gResourceCache = new SkResourceCache(SkDiscardableMemory::Create);
+            shard.fCache = new SkResourceCache(SkDiscardableMemory::Create);
 #else
-        gResourceCache = new SkResourceCache(SK_DEFAULT_IMAGE_CACHE_LIMIT);
+            // The shards never purge for bytes on their own; purgeAsNeeded() does it for them.
+            shard.fCache = new SkResourceCache(SIZE_MAX);
 #endif
+        }
+    }
+
+    bool find(const SkResourceCache::Key& key,
+              SkResourceCache::FindVisitor visitor,
+              void* context) {
+        Shard& shard = this->shardFor(key);
+        SkAutoMutexExclusive am(shard.fMutex);
+        bool found = shard.fCache->find(key, visitor, context);
+        shard.publish();
+        return found;
+    }
+
+    void add(SkResourceCache::Rec* rec, void* payload) {
+        {
+            Shard& shard = this->shardFor(rec->getKey());
+            SkAutoMutexExclusive am(shard.fMutex);
+            shard.fCache->add(rec, payload);
+            shard.publish();
+        }
+        this->purgeAsNeeded();
+    }
+
+    // Calls fn with each shard's cache, holding its lock.
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive am(shard.fMutex);
+            fn(shard.fCache);
+            shard.publish();
+        }
+    }
+
+    SkResourceCache::DiscardableFactory discardableFactory() const {
+        // Every shard was made with the same one.
+        return fShards[0].fCache->discardableFactory();
+    }
+
+    size_t getTotalBytesUsed() const {
+        size_t total = 0;
+        for (const Shard& shard : fShards) {
+            total += shard.fBytesUsed.load(std::memory_order_relaxed);
+        }
+        return total;
     }
+
+    size_t getTotalByteLimit() const {
+        return this->discardableFactory() ? 0 : fTotalByteLimit.load(std::memory_order_relaxed);
+    }
+
+    size_t setTotalByteLimit(size_t newLimit) {
+        if (this->discardableFactory()) {
+            return 0;
+        }
+        size_t prevLimit = fTotalByteLimit.exchange(newLimit, std::memory_order_relaxed);
+        if (newLimit < prevLimit) {
+            this->purgeAsNeeded();
+        }
+        return prevLimit;
+    }
+
+    SkResourceCache::EvictionPolicy setEvictionPolicy(SkResourceCache::EvictionPolicy policy) {
+        SkResourceCache::EvictionPolicy prevPolicy =
+                fEvictionPolicy.exchange(policy, std::memory_order_relaxed);
+        this->forEach([=](SkResourceCache* cache) { cache->setEvictionPolicy(policy); });
+        return prevPolicy;
+    }
+
+    SkResourceCache::EvictionPolicy getEvictionPolicy() const {
+        return fEvictionPolicy.load(std::memory_order_relaxed);
+    }
+
+    SkResourceCache::Stats getStats() {
+        SkResourceCache::Stats stats;
+        this->forEach([&](SkResourceCache* cache) { stats += cache->stats(); });
+        return stats;
+    }
+
+    size_t setSingleAllocationByteLimit(size_t newLimit) {
+        return fSingleAllocationByteLimit.exchange(newLimit, std::memory_order_relaxed);
+    }
+
+    size_t getSingleAllocationByteLimit() const {
+        return fSingleAllocationByteLimit.load(std::memory_order_relaxed);
+    }
+
+    size_t getEffectiveSingleAllocationByteLimit() const {
+        // Same as SkResourceCache::getEffectiveSingleAllocationByteLimit(), for the whole budget.
+        size_t limit = this->getSingleAllocationByteLimit();
+        if (nullptr == this->discardableFactory()) {
+            size_t totalLimit = this->getTotalByteLimit();
+            limit = 0 == limit ? totalLimit : std::min(limit, totalLimit);
+        }
+        return limit;
+    }
+
+private:
+    struct alignas(64) Shard {
+        SkMutex          fMutex;
+        SkResourceCache* fCache = nullptr;
+        // Copies of fCache's totals, so the budget can be checked without taking every lock.
+        std::atomic<size_t> fBytesUsed{0};
+        std::atomic<int>    fCount{0};
+
+        // Must hold fMutex.
+        void publish() {
+            fBytesUsed.store(fCache->getTotalBytesUsed(), std::memory_order_relaxed);
+            fCount.store(fCache->getCount(), std::memory_order_relaxed);
+        }
+    };
+
+    Shard& shardFor(const SkResourceCache::Key& key) {
+        // Use the high bits, since each shard's hash table indexes by the low ones.
+        return fShards[((uint64_t)key.hash() * kShardCount) >> 32];
+    }
+
+    void purgeAsNeeded() {
+        const bool discardable = this->discardableFactory() != nullptr;
+        int shardsWithNothingToPurge = 0;
+        while (shardsWithNothingToPurge < kShardCount) {
+            size_t bytesUsed = 0;
+            int    count = 0;
+            for (const Shard& shard : fShards) {
+                bytesUsed += shard.fBytesUsed.load(std::memory_order_relaxed);
+                count     += shard.fCount.load(std::memory_order_relaxed);
+            }
+
+            // Like SkResourceCache::purgeAsNeeded(), purge until we're under the limit.
+            size_t bytesToFree = 0;
+            int    countToFree = 0;
+            if (discardable) {
+                const int countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
+                countToFree = count >= countLimit ? count - countLimit + 1 : 0;
+            } else {
+                const size_t byteLimit = fTotalByteLimit.load(std::memory_order_relaxed);
+                bytesToFree = bytesUsed >= byteLimit ? bytesUsed - byteLimit + 1 : 0;
+            }
+            if (bytesUsed == 0 || (bytesToFree == 0 && countToFree == 0)) {
+                return;
+            }
+
+            // Take turns, each shard freeing only its share of the overage, so that one shard
+            // doesn't lose everything while the others keep older recs.
+            bytesToFree = (bytesToFree + kShardCount - 1) / kShardCount;
+            countToFree = (countToFree + kShardCount - 1) / kShardCount;
+            Shard& victim = fShards[fNextVictim.fetch_add(1, std::memory_order_relaxed) %
+                                    kShardCount];
+            SkAutoMutexExclusive am(victim.fMutex);
+            if (victim.fCache->purgeSome(bytesToFree, countToFree) > 0) {
+                shardsWithNothingToPurge = 0;
+            } else {
+                shardsWithNothingToPurge += 1;
+            }
+            victim.publish();
+        }
+    }
+
+    Shard                 fShards[kShardCount];
+    std::atomic<size_t>   fTotalByteLimit{SK_DEFAULT_IMAGE_CACHE_LIMIT};
+    std::atomic<size_t>   fSingleAllocationByteLimit{0};
+    std::atomic<SkResourceCache::EvictionPolicy> fEvictionPolicy{
+            SkResourceCache::EvictionPolicy::kLRU};
+    std::atomic<unsigned> fNextVictim{0};
+};
+
+}  // namespace
+
+static ShardedCache& get_cache() {
+    static ShardedCache& gResourceCache = *(new ShardedCache);
     return gResourceCache;
 }
 
 size_t SkResourceCache::GetTotalBytesUsed() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalBytesUsed();
+    return get_cache().getTotalBytesUsed();
 }
 
 size_t SkResourceCache::GetTotalByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalByteLimit();
+    return get_cache().getTotalByteLimit();
 }
 
 size_t SkResourceCache::SetTotalByteLimit(size_t newLimit) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setTotalByteLimit(newLimit);
+    return get_cache().setTotalByteLimit(newLimit);
 }
 
 SkResourceCache::DiscardableFactory SkResourceCache::GetDiscardableFactory() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->discardableFactory();
+    return get_cache().discardableFactory();
 }
 
 SkCachedData* SkResourceCache::NewCachedData(size_t bytes) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->newCachedData(bytes);
+    if (DiscardableFactory factory = get_cache().discardableFactory()) {
+        SkDiscardableMemory* dm = factory(bytes);
+        return dm ? new SkCachedData(bytes, dm) : nullptr;
+    }
+    return new SkCachedData(sk_malloc_throw(bytes), bytes);
 }
 
 void SkResourceCache::Dump() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->dump();
+    get_cache().forEach([](SkResourceCache* cache) { cache->dump(); });
 }
 
 size_t SkResourceCache::SetSingleAllocationByteLimit(size_t size) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setSingleAllocationByteLimit(size);
+    return get_cache().setSingleAllocationByteLimit(size);
 }
 
 size_t SkResourceCache::GetSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getSingleAllocationByteLimit();
+    return get_cache().getSingleAllocationByteLimit();
 }
 
 size_t SkResourceCache::GetEffectiveSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getEffectiveSingleAllocationByteLimit();
+    return get_cache().getEffectiveSingleAllocationByteLimit();
 }
 
 void SkResourceCache::PurgeAll() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->purgeAll();
+    get_cache().forEach([](SkResourceCache* cache) { cache->purgeAll(); });
 }
 
 void SkResourceCache::CheckMessages() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->checkMessages();
+    get_cache().forEach([](SkResourceCache* cache) { cache->checkMessages(); });
 }
 
 bool SkResourceCache::Find(const Key& key, FindVisitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->find(key, visitor, context);
+    return get_cache().find(key, visitor, context);
 }
 
 void SkResourceCache::Add(Rec* rec, void* payload) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->add(rec, payload);
+    get_cache().add(rec, payload);
+}
+
+SkResourceCache::EvictionPolicy SkResourceCache::SetEvictionPolicy(EvictionPolicy policy) {
+    return get_cache().setEvictionPolicy(policy);
+}
+
+SkResourceCache::EvictionPolicy SkResourceCache::GetEvictionPolicy() {
+    return get_cache().getEvictionPolicy();
+}
+
+SkResourceCache::Stats SkResourceCache::GetStats() {
+    return get_cache().getStats();
 }
 
 void SkResourceCache::VisitAll(Visitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->visitAll(visitor, context);
+    get_cache().forEach([=](SkResourceCache* cache) { cache->visitAll(visitor, context); });
 }
 
 void SkResourceCache::PostPurgeSharedID(uint64_t sharedID) {
@@ -617,4 +917,15 @@ void SkResourceCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
     // Since resource could be backed by malloc or discardable, the cache always dumps detailed
     // stats to be accurate.
     VisitAll(sk_trace_dump_visitor, dump);
+
+    const char* dumpName = "skia/sk_resource_cache";
+    const Stats stats = GetStats();
+    dump->dumpStringValue(dumpName, "eviction_policy",
+                          GetEvictionPolicy() == EvictionPolicy::kLRU ? "lru" : "greedy_dual_size");
+    dump->dumpNumericValue(dumpName, "hits", "objects", stats.fHits);
+    dump->dumpNumericValue(dumpName, "misses", "objects", stats.fMisses);
+    dump->dumpNumericValue(dumpName, "evictions", "objects", stats.fEvictions);
+    dump->dumpNumericValue(dumpName, "evicted_size", "bytes", stats.fEvictedBytes);
+    // Regeneration cost is measured in bytes written.
+    dump->dumpNumericValue(dumpName, "evicted_cost", "bytes", (uint64_t)stats.fEvictedCost);
 }
@@ -27,6 +27,9 @@ class SkTraceMemoryDump;
  *
  *  As a convenience, a global instance is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  It is split into shards by key, each with its own lock and LRU list, so
+ *  that threads working with different keys rarely wait on each other. The
+ *  total byte limit is shared by the shards and enforced approximately.
  */
 class SkResourceCache {
 public:
@@ -100,6 +103,12 @@ public:
         // happen during the add.
         virtual void postAddInstall(void*) {}
 
+        // An estimate of how long it would take to make this rec again if it were purged, in
+        // units of the time it takes to write one byte. Only the kGreedyDualSize eviction policy
+        // looks at it. Recs that are expensive to make for their size (e.g. blurred masks) should
+        // return more than the default.
+        virtual double regenerationCost() const { return (double)this->bytesUsed(); }
+
         // for memory usage diagnostics
         virtual const char* getCategory() const = 0;
         virtual SkDiscardableMemory* diagnostic_only_getDiscardable() const { return nullptr; }
@@ -108,6 +117,11 @@ public:
         Rec*    fNext;
         Rec*    fPrev;
 
+        // Only used by kGreedyDualSize.
+        double   fPriority = 0;
+        uint32_t fLastUse = 0;
+        int      fQueueIndex = -1;
+
         friend class SkResourceCache;
     };
 
@@ -119,6 +133,26 @@ public:
 
     typedef const Rec* ID;
 
+    enum class EvictionPolicy {
+        // Purge the least recently used recs first.
+        kLRU,
+        // GreedyDual-Size: purge the recs with the least regenerationCost() per byte first,
+        // ageing the rest each time one is purged so that recs that are no longer used go too.
+        kGreedyDualSize,
+    };
+
+    // Counters for tuning the budget and eviction policy.
+    struct Stats {
+        uint64_t fHits = 0;
+        uint64_t fMisses = 0;
+        // Recs purged to stay within the budget (not those purged as stale, or by purgeAll()).
+        uint64_t fEvictions = 0;
+        uint64_t fEvictedBytes = 0;
+        double   fEvictedCost = 0;
+
+        Stats& operator+=(const Stats&);
+    };
+
     /**
      *  Callback function for find(). If called, the cache will have found a match for the
      *  specified Key, and will pass in the corresponding Rec, along with a caller-specified
@@ -169,9 +203,14 @@ public:
     static void PurgeAll();
     static void CheckMessages();
 
+    static EvictionPolicy SetEvictionPolicy(EvictionPolicy);
+    static EvictionPolicy GetEvictionPolicy();
+    // The sum of the stats of every shard of the global cache.
+    static Stats GetStats();
+
     static void TestDumpMemoryStatistics();
 
-    /** Dump memory usage statistics of every Rec in the cache using the
+    /** Dump memory usage statistics of every Rec in the cache, and the cache's Stats, using the
         SkTraceMemoryDump interface.
      */
     static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
@@ -225,6 +264,7 @@ public:
 
     size_t getTotalBytesUsed() const { return fTotalBytesUsed; }
     size_t getTotalByteLimit() const { return fTotalByteLimit; }
+    int getCount() const { return fCount; }
 
     /**
      *  This is respected by SkBitmapProcState::possiblyScaleImage.
@@ -250,6 +290,21 @@ public:
         this->purgeAsNeeded(true);
     }
 
+    /**
+     *  Purge recs that can be purged, in the order given by the eviction policy, until at least
+     *  bytesToFree bytes and countToFree recs have been freed, or there are no more. These count
+     *  as evictions. Returns the number purged.
+     */
+    int purgeSome(size_t bytesToFree, int countToFree);
+
+    /**
+     *  Returns the previous policy. The default is kLRU.
+     */
+    EvictionPolicy setEvictionPolicy(EvictionPolicy);
+    EvictionPolicy evictionPolicy() const { return fEvictionPolicy; }
+
+    const Stats& stats() const { return fStats; }
+
     DiscardableFactory discardableFactory() const { return fDiscardableFactory; }
 
     SkCachedData* newCachedData(size_t bytes);
@@ -266,6 +321,16 @@ private:
     class Hash;
     Hash*   fHash;
 
+    // Every rec, ordered by fPriority, when the policy is kGreedyDualSize.
+    class PriorityQueue;
+    PriorityQueue*  fQueue;
+    EvictionPolicy  fEvictionPolicy;
+    // The GreedyDual-Size "L": the priority of the last rec evicted.
+    double          fInflation;
+    uint32_t        fUseCounter;
+
+    Stats   fStats;
+
     DiscardableFactory  fDiscardableFactory;
 
     size_t  fTotalBytesUsed;
@@ -283,6 +348,10 @@ private:
     void addToHead(Rec*);
     void release(Rec*);
     void remove(Rec*);
+    void evict(Rec*);
+
+    // Sets rec's priority for kGreedyDualSize from its cost and the current inflation.
+    void prioritize(Rec*);
 
     void init();    // called by constructors
 
@@ -37,6 +37,7 @@
 #include "src/core/SkMaskFilterBase.h"
 #include "src/core/SkPaintPriv.h"
 #include "src/core/SkRasterClip.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/core/SkTextFormatParams.h"
 #include "src/core/SkWriteBuffer.h"
 #include "src/utils/SkMatrix22.h"
@@ -588,6 +589,43 @@ void SkScalerContext::GenerateImageFromPath(
     }
 }
 
+std::unique_ptr<SkScalerContext> SkScalerContext::makeConcurrentContext(
+        const SkDescriptor& desc) const {
+    return fTypeface.createScalerContext(this->getEffects(), &desc);
+}
+
+void SkScalerContext::GetImages(SkSpan<SkGlyph> glyphs,
+                                SkArenaAlloc* alloc,
+                                SkExecutor* executor,
+                                const SkScalerContext& prototype,
+                                const SkDescriptor& desc) {
+    for (SkGlyph& glyph : glyphs) {
+        SkASSERT(!glyph.setImageHasBeenCalled());
+        glyph.allocImage(alloc);
+    }
+
+    // Bound the number of scaler contexts, which can be expensive to make.
+    static constexpr size_t kMaxTasks = 16;
+    const int tasks = executor == nullptr
+                              ? 1
+                              : (int)std::clamp<size_t>(glyphs.size() / kMinGlyphsPerImageTask,
+                                                        1, kMaxTasks);
+    auto task = [&](int i) {
+        std::unique_ptr<SkScalerContext> context = prototype.makeConcurrentContext(desc);
+        const size_t end = glyphs.size() * (i + 1) / tasks;
+        for (size_t g = glyphs.size() * i / tasks; g < end; ++g) {
+            context->getImage(glyphs[g]);
+        }
+    };
+    if (tasks == 1) {
+        task(0);
+        return;
+    }
+    SkTaskGroup tg(*executor);
+    tg.batch(tasks, task);
+    tg.wait();
+}
+
 void SkScalerContext::getImage(const SkGlyph& origGlyph) {
     SkASSERT(origGlyph.fAdvancesBoundsFormatAndInitialPathDone);
 
@@ -15,6 +15,7 @@
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkString.h"
 #include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypeface.h"
@@ -35,6 +36,7 @@ class SkArenaAlloc;
 class SkAutoDescriptor;
 class SkDescriptor;
 class SkDrawable;
+class SkExecutor;
 class SkFont;
 class SkMaskFilter;
 class SkPath;
@@ -292,6 +294,11 @@ public:
 
     SkTypeface* getTypeface() const { return &fTypeface; }
 
+    // The version of what makes the glyphs, e.g. the font library behind this context, so that
+    // glyphs made by another version are not mistaken for ours. 0 if it is not known, in which
+    // case the glyphs are not kept in the font cache file.
+    virtual uint32_t getScalerVersion() const { return 0; }
+
     SkMask::Format getMaskFormat() const {
         return fRec.fMaskFormat;
     }
@@ -313,6 +320,26 @@ public:
     sk_sp<SkDrawable> getDrawable(SkGlyph&);
     void        getFontMetrics(SkFontMetrics*);
 
+    // Make a scaler context for desc, which must be the descriptor this one was made with, that
+    // another thread can use while this one is in use. May be called from any thread. By default
+    // the typeface makes it as it makes any other; the FreeType port gives it an FT_Face of its
+    // own, so that it does not wait on the contexts sharing the typeface's face.
+    virtual std::unique_ptr<SkScalerContext> makeConcurrentContext(const SkDescriptor& desc) const;
+
+    // Make the images of glyphs, which must have their metrics but no image yet, in storage from
+    // alloc. A scaler context must only be used by one thread at a time, so the glyphs are split
+    // among tasks on executor that each get a context of their own from
+    // prototype.makeConcurrentContext(desc).
+    static void GetImages(SkSpan<SkGlyph> glyphs,
+                          SkArenaAlloc* alloc,
+                          SkExecutor* executor,
+                          const SkScalerContext& prototype,
+                          const SkDescriptor& desc);
+    // Each task of GetImages() makes a scaler context, whose first glyph costs about as much as
+    // several more (e.g. FreeType runs a font's hinting programs for each new size), so it is
+    // given at least this many glyphs.
+    static constexpr size_t kMinGlyphsPerImageTask = 64;
+
     /** Return the size in bytes of the associated gamma lookup table
      */
     static size_t GetGammaLUTSize(SkScalar contrast, SkScalar deviceGamma,
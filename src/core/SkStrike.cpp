@@ -15,6 +15,7 @@
 #include "include/core/SkTraceMemoryDump.h"
 #include "include/core/SkTypeface.h"
 #include "include/private/base/SkDebug.h"
+#include "include/private/base/SkMath.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "src/core/SkGlyph.h"
 #include "src/core/SkMask.h"
@@ -24,10 +25,14 @@
 #include "src/core/SkWriteBuffer.h"
 #include "src/text/StrikeForGPU.h"
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <new>
 #include <optional>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 using namespace skglyph;
 
@@ -50,6 +55,7 @@ SkStrike::SkStrike(SkStrikeCache* strikeCache,
         : fFontMetrics{use_or_generate_metrics(metrics, scaler.get())}
         , fRoundingSpec{scaler->isSubpixel(),
                         scaler->computeAxisAlignmentForHText()}
+        , fScalerVersion{scaler->getScalerVersion()}
         , fStrikeSpec{strikeSpec}
         , fStrikeCache{strikeCache}
         , fScalerContext{std::move(scaler)}
@@ -161,6 +167,26 @@ bool SkStrike::mergeFromBuffer(SkReadBuffer& buffer) {
     return true;
 }
 
+void SkStrike::flattenGlyphs(SkWriteBuffer& buffer) const {
+    std::vector<SkGlyph> images, paths, drawables;
+    {
+        SkAutoMutexExclusive lock{fStrikeLock};
+        for (const SkGlyph* glyph : fGlyphForIndex) {
+            if (glyph->setImageHasBeenCalled()) {
+                images.push_back(*glyph);
+            }
+            if (glyph->setPathHasBeenCalled()) {
+                paths.push_back(*glyph);
+            }
+            if (glyph->setDrawableHasBeenCalled()) {
+                drawables.push_back(*glyph);
+            }
+        }
+    }
+    // Once set, a glyph's image, path and drawable live as long as the strike does.
+    FlattenGlyphsByType(buffer, images, paths, drawables);
+}
+
 SkGlyph* SkStrike::mergeGlyphAndImage(SkPackedGlyphID toID, const SkGlyph& fromGlyph) {
     Monitor m{this};
     // TODO(herb): remove finding the glyph when setting the metrics and image are separated
@@ -217,38 +243,104 @@ void SkStrike::findIntercepts(const SkScalar bounds[2], SkScalar scale, SkScalar
 
 SkSpan<const SkGlyph*> SkStrike::metrics(
         SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) {
-    Monitor m{this};
-    return this->internalPrepare(glyphIDs, kMetricsOnly, results);
+    return this->prepareGlyphs(glyphIDs, 0, results);
 }
 
 SkSpan<const SkGlyph*> SkStrike::preparePaths(
         SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) {
-    Monitor m{this};
-    return this->internalPrepare(glyphIDs, kMetricsAndPath, results);
+    return this->prepareGlyphs(glyphIDs, kPreparedPath, results);
 }
 
 SkSpan<const SkGlyph*> SkStrike::prepareImages(
         SkSpan<const SkPackedGlyphID> glyphIDs, const SkGlyph* results[]) {
-    const SkGlyph** cursor = results;
-    Monitor m{this};
-    for (auto glyphID : glyphIDs) {
-        SkGlyph* glyph = this->glyph(glyphID);
-        this->prepareForImage(glyph);
-        *cursor++ = glyph;
+    return this->prepareGlyphs(glyphIDs, kPreparedImage, results);
+}
+
+SkSpan<const SkGlyph*> SkStrike::prepareImages(SkSpan<const SkPackedGlyphID> glyphIDs,
+                                               const SkGlyph* results[],
+                                               SkExecutor* executor) {
+    if (executor == nullptr) {
+        return this->prepareImages(glyphIDs, results);
     }
 
+    // Make the metrics of the glyphs, and copy out the ones that still need images.
+    std::vector<SkGlyph> unprepared;
+    const SkScalerContext* prototype;
+    {
+        Monitor m{this};
+        prototype = fScalerContext.get();
+        for (size_t i = 0; i < glyphIDs.size(); ++i) {
+            SkGlyph* glyph = this->glyph(glyphIDs[i]);
+            if (!glyph->setImageHasBeenCalled()) {
+                unprepared.push_back(*glyph);
+            }
+            results[i] = glyph;
+        }
+    }
+    std::sort(unprepared.begin(), unprepared.end(), [](const SkGlyph& a, const SkGlyph& b) {
+        return a.getPackedID().value() < b.getPackedID().value();
+    });
+    unprepared.erase(std::unique(unprepared.begin(), unprepared.end(),
+                                 [](const SkGlyph& a, const SkGlyph& b) {
+                                     return a.getPackedID() == b.getPackedID();
+                                 }),
+                     unprepared.end());
+
+    // With few images to make, it's quicker to make them with fScalerContext below.
+    SkArenaAlloc alloc{kMinAllocAmount};
+    if (unprepared.size() >= 2 * SkScalerContext::kMinGlyphsPerImageTask) {
+        SkScalerContext::GetImages(
+                unprepared, &alloc, executor, *prototype, fStrikeSpec.descriptor());
+    } else {
+        unprepared.clear();
+    }
+
+    Monitor m{this};
+    for (const SkGlyph& made : unprepared) {
+        SkGlyph* glyph = this->glyph(made.getPackedID());
+        // Another thread may have made the image meanwhile.
+        if (glyph->setImage(&fAlloc, made.image())) {
+            fMemoryIncrease += glyph->imageSize();
+        }
+    }
+    for (const SkPackedGlyphID& packedID : glyphIDs) {
+        this->prepareForImage(this->glyph(packedID));
+    }
     return {results, glyphIDs.size()};
 }
 
 SkSpan<const SkGlyph*> SkStrike::prepareDrawables(
         SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) {
-    const SkGlyph** cursor = results;
-    {
+    return this->prepareGlyphs(glyphIDs, kPreparedDrawable, results);
+}
+
+template <typename GlyphID>
+SkSpan<const SkGlyph*> SkStrike::prepareGlyphs(
+        SkSpan<const GlyphID> glyphIDs, uint32_t prepared, const SkGlyph* results[]) {
+    size_t i = 0;
+    for (; i < glyphIDs.size(); ++i) {
+        uint32_t found;
+        SkGlyph* glyph = fLockFreeLookup.find(SkPackedGlyphID{glyphIDs[i]}, nullptr, &found);
+        if (glyph == nullptr || (found & prepared) != prepared) {
+            break;
+        }
+        results[i] = glyph;
+    }
+
+    if (i < glyphIDs.size()) {
         Monitor m{this};
-        for (auto glyphID : glyphIDs) {
-            SkGlyph* glyph = this->glyph(SkPackedGlyphID{glyphID});
-            this->prepareForDrawable(glyph);
-            *cursor++ = glyph;
+        for (; i < glyphIDs.size(); ++i) {
+            SkGlyph* glyph = this->glyph(SkPackedGlyphID{glyphIDs[i]});
+            if (prepared & kPreparedImage) {
+                this->prepareForImage(glyph);
+            }
+            if (prepared & kPreparedPath) {
+                this->prepareForPath(glyph);
+            }
+            if (prepared & kPreparedDrawable) {
+                this->prepareForDrawable(glyph);
+            }
+            results[i] = glyph;
         }
     }
 
@@ -344,15 +436,29 @@ SkGlyphDigest SkStrike::digestFor(ActionType actionType, SkPackedGlyphID packedG
     }
 
     digestPtr->setActionFor(actionType, glyph, this);
+    fMemoryIncrease += fLockFreeLookup.set(glyph, *digestPtr);
 
     return *digestPtr;
 }
 
+SkGlyph* SkStrike::findDigest(ActionType actionType,
+                              SkPackedGlyphID packedGlyphID,
+                              SkGlyphDigest* digest) const {
+    SkGlyphDigest found;
+    SkGlyph* glyph = fLockFreeLookup.find(packedGlyphID, &found, nullptr);
+    if (glyph == nullptr || found.actionFor(actionType) == GlyphAction::kUnset) {
+        return nullptr;
+    }
+    *digest = found;
+    return glyph;
+}
+
 SkGlyphDigest* SkStrike::addGlyphAndDigest(SkGlyph* glyph) {
     size_t index = fGlyphForIndex.size();
     SkGlyphDigest digest = SkGlyphDigest{index, *glyph};
     SkGlyphDigest* newDigest = fDigestForPackedGlyphID.set(digest);
     fGlyphForIndex.push_back(glyph);
+    fMemoryIncrease += fLockFreeLookup.set(glyph, digest);
     return newDigest;
 }
 
@@ -360,6 +466,7 @@ bool SkStrike::prepareForImage(SkGlyph* glyph) {
     if (glyph->setImage(&fAlloc, fScalerContext.get())) {
         fMemoryIncrease += glyph->imageSize();
     }
+    fLockFreeLookup.markPrepared(glyph->getPackedID(), kPreparedImage);
     return glyph->image() != nullptr;
 }
 
@@ -367,6 +474,7 @@ bool SkStrike::prepareForPath(SkGlyph* glyph) {
     if (glyph->setPath(&fAlloc, fScalerContext.get())) {
         fMemoryIncrease += glyph->path()->approximateBytesUsed();
     }
+    fLockFreeLookup.markPrepared(glyph->getPackedID(), kPreparedPath);
     return glyph->path() !=nullptr;
 }
 
@@ -376,6 +484,7 @@ bool SkStrike::prepareForDrawable(SkGlyph* glyph) {
         SkASSERT(increase > 0);
         fMemoryIncrease += increase;
     }
+    fLockFreeLookup.markPrepared(glyph->getPackedID(), kPreparedDrawable);
     return glyph->drawable() != nullptr;
 }
 
@@ -429,20 +538,6 @@ bool SkStrike::mergeGlyphAndDrawableFromBuffer(SkReadBuffer& buffer) {
     return buffer.isValid();
 }
 
-SkSpan<const SkGlyph*> SkStrike::internalPrepare(
-        SkSpan<const SkGlyphID> glyphIDs, PathDetail pathDetail, const SkGlyph** results) {
-    const SkGlyph** cursor = results;
-    for (auto glyphID : glyphIDs) {
-        SkGlyph* glyph = this->glyph(SkPackedGlyphID{glyphID});
-        if (pathDetail == kMetricsAndPath) {
-            this->prepareForPath(glyph);
-        }
-        *cursor++ = glyph;
-    }
-
-    return {results, glyphIDs.size()};
-}
-
 void SkStrike::updateMemoryUsage(size_t increase) {
     if (increase > 0) {
         // fRemoved and the cache's total memory are managed under the cache's lock. This allows
@@ -454,3 +549,140 @@ void SkStrike::updateMemoryUsage(size_t increase) {
         }
     }
 }
+
+// -- SkStrike::LockFreeLookup ---------------------------------------------------------------------
+static_assert(sizeof(SkGlyphDigest) == 2 * sizeof(uint64_t));
+static_assert(std::is_trivially_copyable_v<SkGlyphDigest>);
+
+struct SkStrike::LockFreeLookup::Slot {
+    // Written last, when the slot is first used, so a reader that finds its packed ID here also
+    // sees everything else.
+    std::atomic<uint32_t> fPackedID{SkPackedGlyphID::kImpossibleID};
+    std::atomic<uint32_t> fPrepared{0};
+    // The two halves of the digest. Only the first, which holds the actions, ever changes.
+    std::atomic<uint64_t> fDigest[2]{};
+    std::atomic<SkGlyph*> fGlyph{nullptr};
+};
+
+SkStrike::LockFreeLookup::Table::Table(int capacity)
+        : fCapacity{capacity}
+        , fSlots{new Slot[capacity]} {
+    SkASSERT(SkIsPow2(capacity));
+}
+
+SkStrike::LockFreeLookup::Table::~Table() = default;
+
+SkStrike::LockFreeLookup::~LockFreeLookup() = default;
+
+SkStrike::LockFreeLookup::Slot*
+SkStrike::LockFreeLookup::Table::find(SkPackedGlyphID packedGlyphID) const {
+    const uint32_t mask = fCapacity - 1;
+    // The table is never more than half full, so this always reaches an unused slot.
+    for (uint32_t i = packedGlyphID.hash() & mask;; i = (i + 1) & mask) {
+        const uint32_t found = fSlots[i].fPackedID.load(std::memory_order_acquire);
+        if (found == packedGlyphID.value()) {
+            return &fSlots[i];
+        }
+        if (found == SkPackedGlyphID::kImpossibleID) {
+            return nullptr;
+        }
+    }
+}
+
+SkStrike::LockFreeLookup::Slot*
+SkStrike::LockFreeLookup::Table::insert(SkPackedGlyphID packedGlyphID) {
+    const uint32_t mask = fCapacity - 1;
+    for (uint32_t i = packedGlyphID.hash() & mask;; i = (i + 1) & mask) {
+        const uint32_t found = fSlots[i].fPackedID.load(std::memory_order_relaxed);
+        SkASSERT(found != packedGlyphID.value());
+        if (found == SkPackedGlyphID::kImpossibleID) {
+            fCount += 1;
+            return &fSlots[i];
+        }
+    }
+}
+
+SkGlyph* SkStrike::LockFreeLookup::find(SkPackedGlyphID packedGlyphID,
+                                        SkGlyphDigest* digest,
+                                        uint32_t* prepared) const {
+    const Table* table = fCurrent.load(std::memory_order_acquire);
+    if (table == nullptr) {
+        return nullptr;
+    }
+    const Slot* slot = table->find(packedGlyphID);
+    if (slot == nullptr) {
+        return nullptr;
+    }
+    if (digest != nullptr) {
+        const uint64_t halves[2] = {slot->fDigest[0].load(std::memory_order_acquire),
+                                    slot->fDigest[1].load(std::memory_order_relaxed)};
+        memcpy(digest, halves, sizeof(halves));
+    }
+    if (prepared != nullptr) {
+        *prepared = slot->fPrepared.load(std::memory_order_acquire);
+    }
+    return slot->fGlyph.load(std::memory_order_relaxed);
+}
+
+size_t SkStrike::LockFreeLookup::set(SkGlyph* glyph, const SkGlyphDigest& digest) {
+    uint64_t halves[2];
+    memcpy(halves, &digest, sizeof(halves));
+    const SkPackedGlyphID packedGlyphID = glyph->getPackedID();
+
+    Table* table = fCurrent.load(std::memory_order_relaxed);
+    if (table != nullptr) {
+        if (Slot* slot = table->find(packedGlyphID)) {
+            SkASSERT(slot->fGlyph.load(std::memory_order_relaxed) == glyph);
+            SkASSERT(slot->fDigest[1].load(std::memory_order_relaxed) == halves[1]);
+            slot->fDigest[0].store(halves[0], std::memory_order_release);
+            return 0;
+        }
+    }
+
+    size_t increase = 0;
+    if (table == nullptr || 2 * (table->fCount + 1) > table->fCapacity) {
+        // Copy everything into a bigger table before anyone can see it, and then publish it.
+        static constexpr int kMinCapacity = 16;
+        const int capacity = table != nullptr ? 2 * table->fCapacity : kMinCapacity;
+        auto grown = std::make_unique<Table>(capacity);
+        for (int i = 0; table != nullptr && i < table->fCapacity; ++i) {
+            const Slot& from = table->fSlots[i];
+            const uint32_t id = from.fPackedID.load(std::memory_order_relaxed);
+            if (id != SkPackedGlyphID::kImpossibleID) {
+                Slot* to = grown->insert(SkPackedGlyphID{id});
+                to->fPrepared.store(from.fPrepared.load(std::memory_order_relaxed),
+                                    std::memory_order_relaxed);
+                for (int half : {0, 1}) {
+                    to->fDigest[half].store(from.fDigest[half].load(std::memory_order_relaxed),
+                                            std::memory_order_relaxed);
+                }
+                to->fGlyph.store(from.fGlyph.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                to->fPackedID.store(id, std::memory_order_relaxed);
+            }
+        }
+        table = grown.get();
+        fCurrent.store(table, std::memory_order_release);
+        fTables.push_back(std::move(grown));
+        increase = sizeof(Table) + capacity * sizeof(Slot);
+    }
+
+    Slot* slot = table->insert(packedGlyphID);
+    slot->fDigest[0].store(halves[0], std::memory_order_relaxed);
+    slot->fDigest[1].store(halves[1], std::memory_order_relaxed);
+    slot->fGlyph.store(glyph, std::memory_order_relaxed);
+    slot->fPackedID.store(packedGlyphID.value(), std::memory_order_release);
+    return increase;
+}
+
+void SkStrike::LockFreeLookup::markPrepared(SkPackedGlyphID packedGlyphID, uint32_t prepared) {
+    Table* table = fCurrent.load(std::memory_order_relaxed);
+    Slot* slot = table != nullptr ? table->find(packedGlyphID) : nullptr;
+    SkASSERT(slot != nullptr);
+    if (slot != nullptr) {
+        const uint32_t old = slot->fPrepared.load(std::memory_order_relaxed);
+        if ((old & prepared) != prepared) {
+            slot->fPrepared.store(old | prepared, std::memory_order_release);
+        }
+    }
+}
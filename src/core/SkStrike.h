@@ -21,12 +21,15 @@
 #include "src/core/SkTHash.h"
 #include "src/text/StrikeForGPU.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 class SkDescriptor;
 class SkDrawable;
+class SkExecutor;
 class SkPath;
 class SkReadBuffer;
 class SkStrikeCache;
@@ -61,6 +64,9 @@ public:
                                     SkSpan<SkGlyph> images,
                                     SkSpan<SkGlyph> paths,
                                     SkSpan<SkGlyph> drawables);
+    // Write every glyph that has an image, path or drawable the way FlattenGlyphsByType() does,
+    // so that mergeFromBuffer() can read them into another strike with the same descriptor.
+    void flattenGlyphs(SkWriteBuffer& buffer) const SK_EXCLUDES(fStrikeLock);
 
     // Lookup (or create if needed) the returned glyph using toID. If that glyph is not initialized
     // with an image, then use the information in fromGlyph to initialize the width, height top,
@@ -96,6 +102,13 @@ public:
     SkSpan<const SkGlyph*> prepareImages(SkSpan<const SkPackedGlyphID> glyphIDs,
                                          const SkGlyph* results[]) SK_EXCLUDES(fStrikeLock);
 
+    // Like prepareImages() above, but the images that have not been made yet are made by tasks
+    // on executor, each with a scaler context of its own, and then added to the strike in one
+    // step. This is for first drawing text with many glyphs, such as CJK text.
+    SkSpan<const SkGlyph*> prepareImages(SkSpan<const SkPackedGlyphID> glyphIDs,
+                                         const SkGlyph* results[],
+                                         SkExecutor* executor) SK_EXCLUDES(fStrikeLock);
+
     SkSpan<const SkGlyph*> prepareDrawables(
             SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) SK_EXCLUDES(fStrikeLock);
 
@@ -122,6 +135,11 @@ public:
         return fStrikeSpec;
     }
 
+    // SkScalerContext::getScalerVersion() of the context that makes our glyphs.
+    uint32_t scalerVersion() const {
+        return fScalerVersion;
+    }
+
     void verifyPinnedStrike() const {
         if (fPinner != nullptr) {
             fPinner->assertValid();
@@ -133,11 +151,63 @@ public:
 
     SkGlyph* glyph(SkGlyphDigest) SK_REQUIRES(fStrikeLock);
 
+    // Find the digest for packedGlyphID without taking the lock. If digestFor() has already
+    // decided an action of actionType for the glyph, return the glyph and set *digest. Otherwise,
+    // return nullptr; the caller must then lock the strike and use digestFor().
+    SkGlyph* findDigest(skglyph::ActionType actionType,
+                        SkPackedGlyphID packedGlyphID,
+                        SkGlyphDigest* digest) const;
+
 private:
     friend class SkStrikeCache;
     friend class SkStrikeTestingPeer;
     class Monitor;
 
+    // What has been prepared for a glyph, as far as readers of the LockFreeLookup are concerned.
+    enum Prepared : uint32_t {
+        kPreparedImage    = 1 << 0,
+        kPreparedPath     = 1 << 1,
+        kPreparedDrawable = 1 << 2,
+    };
+
+    // A copy of fDigestForPackedGlyphID and fGlyphForIndex that can be searched without the lock.
+    // Only the thread holding the lock changes it, and a glyph is only published once everything
+    // a reader could use has been written. Growing the table publishes a new copy; the old
+    // copies may still be read by other threads so they are kept until the strike is deleted.
+    class LockFreeLookup {
+    public:
+        LockFreeLookup() = default;
+        ~LockFreeLookup();
+
+        // Return the glyph for packedGlyphID, and its digest and Prepared bits, or nullptr if
+        // it has not been published. Safe to call from any thread.
+        SkGlyph* find(SkPackedGlyphID packedGlyphID,
+                      SkGlyphDigest* digest,
+                      uint32_t* prepared) const;
+
+        // Add or update the glyph's digest. Returns how much memory the table grew by.
+        size_t set(SkGlyph* glyph, const SkGlyphDigest& digest);
+        // Add to the Prepared bits of a glyph that has already been set.
+        void markPrepared(SkPackedGlyphID packedGlyphID, uint32_t prepared);
+
+    private:
+        struct Slot;
+        struct Table {
+            explicit Table(int capacity);
+            ~Table();
+            Slot* find(SkPackedGlyphID packedGlyphID) const;
+            Slot* insert(SkPackedGlyphID packedGlyphID);
+
+            const int               fCapacity;  // A power of two.
+            int                     fCount = 0;
+            std::unique_ptr<Slot[]> fSlots;
+        };
+
+        std::atomic<Table*>                 fCurrent{nullptr};
+        // Every table there has been, the current one last.
+        std::vector<std::unique_ptr<Table>> fTables;
+    };
+
     // Return a glyph. Create it if it doesn't exist, and initialize the glyph with metrics and
     // advances using a scaler.
     SkGlyph* glyph(SkPackedGlyphID) SK_REQUIRES(fStrikeLock);
@@ -153,20 +223,18 @@ private:
     // Maintain memory use statistics.
     void updateMemoryUsage(size_t increase) SK_EXCLUDES(fStrikeLock);
 
-    enum PathDetail {
-        kMetricsOnly,
-        kMetricsAndPath
-    };
-
-    // internalPrepare will only be called with a mutex already held.
-    SkSpan<const SkGlyph*> internalPrepare(
-            SkSpan<const SkGlyphID> glyphIDs,
-            PathDetail pathDetail,
-            const SkGlyph** results) SK_REQUIRES(fStrikeLock);
+    // Look up the glyphs with the given Prepared bits for glyphIDs. The glyphs that have been
+    // prepared before are found without the lock, which is only taken from the first glyph that
+    // still needs preparing onwards.
+    template <typename GlyphID>
+    SkSpan<const SkGlyph*> prepareGlyphs(SkSpan<const GlyphID> glyphIDs,
+                                         uint32_t prepared,
+                                         const SkGlyph* results[]) SK_EXCLUDES(fStrikeLock);
 
     // The following are const and need no mutex protection.
     const SkFontMetrics               fFontMetrics;
     const SkGlyphPositionRoundingSpec fRoundingSpec;
+    const uint32_t                    fScalerVersion;
     const SkStrikeSpec                fStrikeSpec;
     SkStrikeCache* const              fStrikeCache;
 
@@ -184,6 +252,9 @@ private:
     // Maps from a glyphIndex to a glyph
     std::vector<SkGlyph*> fGlyphForIndex SK_GUARDED_BY(fStrikeLock);
 
+    // Read without the lock, but only changed with the lock held.
+    LockFreeLookup fLockFreeLookup;
+
     // Context that corresponds to the glyph information in this strike.
     const std::unique_ptr<SkScalerContext> fScalerContext SK_GUARDED_BY(fStrikeLock);
 
@@ -7,6 +7,8 @@
 
 #include "src/core/SkStrikeCache.h"
 
+#include "include/core/SkData.h"
+#include "include/core/SkFontMetrics.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkTraceMemoryDump.h"
@@ -14,14 +16,17 @@
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkMutex.h"
 #include "src/core/SkDescriptor.h"
+#include "src/core/SkFontMetricsPriv.h"
+#include "src/core/SkReadBuffer.h"
 #include "src/core/SkStrike.h"
 #include "src/core/SkStrikeSpec.h"
 
 #include <algorithm>
+#include <optional>
 #include <utility>
+#include <vector>
 
 class SkScalerContext;
-struct SkFontMetrics;
 
 using namespace sktext;
 
@@ -37,15 +42,58 @@ SkStrikeCache* SkStrikeCache::GlobalStrikeCache() {
 }
 
 auto SkStrikeCache::findOrCreateStrike(const SkStrikeSpec& strikeSpec) -> sk_sp<SkStrike> {
+    sk_sp<SkStrikePersistentCache> persistentCache;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        sk_sp<SkStrike> strike = this->internalFindStrikeOrNull(strikeSpec.descriptor());
+        if (strike == nullptr && fPersistentCache == nullptr) {
+            strike = this->internalCreateStrike(strikeSpec);
+        }
+        if (strike != nullptr) {
+            this->internalPurge();
+            return strike;
+        }
+        persistentCache = fPersistentCache;
+    }
+
+    // Reading in the saved glyphs updates the strike's memory use, which takes the lock.
+    sk_sp<SkStrike> loaded = this->loadStrike(*persistentCache, strikeSpec);
+
     SkAutoMutexExclusive ac(fLock);
+    // Another thread may have made the strike in the meantime.
     sk_sp<SkStrike> strike = this->internalFindStrikeOrNull(strikeSpec.descriptor());
     if (strike == nullptr) {
-        strike = this->internalCreateStrike(strikeSpec);
+        loaded->fRemoved = false;
+        strike = loaded;
+        this->internalAttachToHead(std::move(loaded));
     }
     this->internalPurge();
     return strike;
 }
 
+auto SkStrikeCache::loadStrike(SkStrikePersistentCache& persistentCache,
+                               const SkStrikeSpec& strikeSpec) -> sk_sp<SkStrike> {
+    // The saved glyphs are only good if the scaler context would make the same ones.
+    std::unique_ptr<SkScalerContext> scaler = strikeSpec.createScalerContext();
+    sk_sp<SkData> data = persistentCache.find(strikeSpec, scaler->getScalerVersion());
+    SkReadBuffer buffer{data ? data->data() : nullptr, data ? data->size() : 0};
+    std::optional<SkFontMetrics> metrics;
+    if (data != nullptr) {
+        metrics = SkFontMetricsPriv::MakeFromBuffer(buffer);
+    }
+    auto strike = sk_make_sp<SkStrike>(
+            this, strikeSpec, std::move(scaler), metrics ? &metrics.value() : nullptr, nullptr);
+    // Keep the memory the glyphs use out of the cache's total until the strike is attached.
+    strike->fRemoved = true;
+    if (metrics.has_value() && !strike->mergeFromBuffer(buffer)) {
+        // Start again from nothing rather than with some of the glyphs.
+        strike = sk_make_sp<SkStrike>(
+                this, strikeSpec, strikeSpec.createScalerContext(), nullptr, nullptr);
+        strike->fRemoved = true;
+    }
+    return strike;
+}
+
 sk_sp<StrikeForGPU> SkStrikeCache::findOrCreateScopedStrike(const SkStrikeSpec& strikeSpec) {
     return this->findOrCreateStrike(strikeSpec);
 }
@@ -193,6 +241,41 @@ int SkStrikeCache::setCacheCountLimit(int newCount) {
     return prevCount;
 }
 
+void SkStrikeCache::setPersistentCache(const char path[]) {
+    sk_sp<SkStrikePersistentCache> persistentCache =
+            path != nullptr ? sk_make_sp<SkStrikePersistentCache>(path) : nullptr;
+    SkAutoMutexExclusive ac(fLock);
+    fPersistentCache = std::move(persistentCache);
+}
+
+bool SkStrikeCache::savePersistentCache() {
+    sk_sp<SkStrikePersistentCache> persistentCache;
+    std::vector<sk_sp<SkStrike>> strikes;
+    {
+        SkAutoMutexExclusive ac(fLock);
+        if (fPersistentCache == nullptr) {
+            return false;
+        }
+        persistentCache = fPersistentCache;
+        for (SkStrike* strike = fHead; strike != nullptr; strike = strike->fNext) {
+            strikes.push_back(sk_ref_sp(strike));
+        }
+    }
+
+    // Writing the file is slow, so don't keep other threads from finding strikes meanwhile.
+    if (!persistentCache->save(strikes)) {
+        return false;
+    }
+
+    // Map the new file, unless another one has been set meanwhile.
+    auto saved = sk_make_sp<SkStrikePersistentCache>(persistentCache->path());
+    SkAutoMutexExclusive ac(fLock);
+    if (fPersistentCache == persistentCache) {
+        fPersistentCache = std::move(saved);
+    }
+    return true;
+}
+
 void SkStrikeCache::forEachStrike(std::function<void(const SkStrike&)> visitor) const {
     SkAutoMutexExclusive ac(fLock);
 
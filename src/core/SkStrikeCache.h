@@ -13,6 +13,7 @@
 #include "include/private/base/SkMutex.h"
 #include "include/private/base/SkThreadAnnotations.h"
 #include "src/core/SkStrike.h"
+#include "src/core/SkStrikePersistentCache.h"
 #include "src/core/SkTHash.h"
 #include "src/text/StrikeForGPU.h"
 
@@ -74,6 +75,13 @@ public:
     size_t setCacheSizeLimit(size_t limit) SK_EXCLUDES(fLock);
     size_t getTotalMemoryUsed() const SK_EXCLUDES(fLock);
 
+    // Strikes not in the cache are looked for in the file at path before being created. Pass
+    // nullptr to stop using a file.
+    void setPersistentCache(const char path[]) SK_EXCLUDES(fLock);
+    // Write the glyphs of every strike in the cache to the file. Returns false if there is no
+    // file or it could not be written.
+    bool savePersistentCache() SK_EXCLUDES(fLock);
+
 private:
     friend class SkStrike;  // for SkStrike::updateDelta
     static constexpr char kGlyphCacheDumpName[] = "skia/sk_glyph_cache";
@@ -87,6 +95,11 @@ private:
     void internalRemoveStrike(SkStrike* strike) SK_REQUIRES(fLock);
     void internalAttachToHead(sk_sp<SkStrike> strike) SK_REQUIRES(fLock);
 
+    // Make a strike, starting out with the glyphs saved in persistentCache if it has them.
+    // The strike is not attached to the cache.
+    sk_sp<SkStrike> loadStrike(SkStrikePersistentCache& persistentCache,
+                               const SkStrikeSpec& strikeSpec) SK_EXCLUDES(fLock);
+
     // Checkout budgets, modulated by the specified min-bytes-needed-to-purge,
     // and attempt to purge caches to match.
     // Returns number of bytes freed.
@@ -112,6 +125,7 @@ private:
     int32_t fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
     int32_t fCacheCount SK_GUARDED_BY(fLock) {0};
     int32_t fPinnerCount SK_GUARDED_BY(fLock) {0};
+    sk_sp<SkStrikePersistentCache> fPersistentCache SK_GUARDED_BY(fLock);
 };
 
 #endif  // SkStrikeCache_DEFINED
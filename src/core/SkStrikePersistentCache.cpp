@@ -0,0 +1,323 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkStrikePersistentCache.h"
+
+#include "include/core/SkFontArguments.h"
+#include "include/core/SkMilestone.h"
+#include "include/core/SkStream.h"
+#include "include/private/base/SkAlign.h"
+#include "include/private/base/SkTFitsIn.h"
+#include "src/core/SkChecksum.h"
+#include "src/core/SkDescriptor.h"
+#include "src/core/SkFontMetricsPriv.h"
+#include "src/core/SkScalerContext.h"
+#include "src/core/SkStrike.h"
+#include "src/core/SkStrikeSpec.h"
+#include "src/core/SkWriteBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+// The file starts with a Header, followed by an Entry for each strike sorted by the hash of its
+// key, followed by the keys and data the entries point at. Everything is four-byte aligned, as
+// SkReadBuffer requires.
+namespace {
+struct Header {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fMilestone;  // Glyphs may be rasterized differently by another version of Skia.
+    uint32_t fCount;
+};
+
+constexpr uint32_t kMagic = SkSetFourByteTag('s', 'k', 'g', 'c');
+constexpr uint32_t kVersion = 2;
+
+// A key starts with the typeface identity and the scaler version, then the descriptor.
+constexpr size_t kIdentityWords = 2;
+constexpr size_t kScalerVersionWord = 2;
+constexpr size_t kDescriptorWord = 3;
+}  // namespace
+
+struct SkStrikePersistentCache::Entry {
+    uint32_t fHash;
+    uint32_t fKeyOffset;
+    uint32_t fKeyLength;   // In bytes.
+    uint32_t fDataOffset;
+    uint32_t fDataLength;  // In bytes.
+};
+
+static bool is_valid_range(size_t fileSize, uint32_t offset, uint32_t length) {
+    return SkIsAlign4(offset) && SkIsAlign4(length) &&
+           offset <= fileSize && length <= fileSize - offset;
+}
+
+bool SkStrikePersistentCache::IsValidFile(const SkData& file) {
+    if (file.size() < sizeof(Header) || !SkTFitsIn<uint32_t>(file.size())) {
+        return false;
+    }
+    Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.fMagic != kMagic || header.fVersion != kVersion ||
+        header.fMilestone != SK_MILESTONE ||
+        header.fCount > (file.size() - sizeof(Header)) / sizeof(Entry)) {
+        return false;
+    }
+    auto entries = reinterpret_cast<const Entry*>(file.bytes() + sizeof(Header));
+    for (uint32_t i = 0; i < header.fCount; ++i) {
+        const auto& entry = entries[i];
+        if (!is_valid_range(file.size(), entry.fKeyOffset, entry.fKeyLength) ||
+            !is_valid_range(file.size(), entry.fDataOffset, entry.fDataLength) ||
+            (i > 0 && entries[i - 1].fHash > entry.fHash)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static sk_sp<SkData> read_file(const char path[]) {
+#if defined(SK_BUILD_FOR_WIN)
+    // Windows can't replace a file while it is mapped, which save() has to do, so read it.
+    SkFILEStream stream{path};
+    return stream.isValid() ? SkData::MakeFromStream(&stream, stream.getLength()) : nullptr;
+#else
+    return SkData::MakeFromFileName(path);
+#endif
+}
+
+SkStrikePersistentCache::SkStrikePersistentCache(const char path[]) : fPath{path} {
+    sk_sp<SkData> file = read_file(path);
+    if (file != nullptr && IsValidFile(*file)) {
+        fFile = std::move(file);
+    }
+}
+
+SkStrikePersistentCache::~SkStrikePersistentCache() = default;
+
+int SkStrikePersistentCache::count() const {
+    if (fFile == nullptr) {
+        return 0;
+    }
+    Header header;
+    memcpy(&header, fFile->data(), sizeof(header));
+    return SkTo<int>(header.fCount);
+}
+
+auto SkStrikePersistentCache::entries() const -> const Entry* {
+    return reinterpret_cast<const Entry*>(fFile->bytes() + sizeof(Header));
+}
+
+int SkStrikePersistentCache::find(const Key& key, uint32_t hash) const {
+    const Entry* begin = this->entries();
+    const Entry* end = begin + this->count();
+    const Entry* entry = std::lower_bound(begin, end, hash, [](const Entry& e, uint32_t h) {
+        return e.fHash < h;
+    });
+    for (; entry < end && entry->fHash == hash; ++entry) {
+        if (entry->fKeyLength == key.size() * sizeof(uint32_t) &&
+            0 == memcmp(fFile->bytes() + entry->fKeyOffset, key.data(), entry->fKeyLength)) {
+            return SkTo<int>(entry - begin);
+        }
+    }
+    return -1;
+}
+
+sk_sp<SkData> SkStrikePersistentCache::find(const SkStrikeSpec& strikeSpec,
+                                            uint32_t scalerVersion) {
+    if (fFile == nullptr) {
+        return nullptr;
+    }
+    std::optional<Key> key = this->makeKey(strikeSpec, scalerVersion);
+    if (!key.has_value()) {
+        return nullptr;
+    }
+    const int found =
+            this->find(*key, SkChecksum::Hash32(key->data(), key->size() * sizeof(uint32_t)));
+    if (found < 0) {
+        return nullptr;
+    }
+    const Entry& entry = this->entries()[found];
+    return SkData::MakeSubset(fFile.get(), entry.fDataOffset, entry.fDataLength);
+}
+
+auto SkStrikePersistentCache::makeKey(const SkStrikeSpec& strikeSpec, uint32_t scalerVersion)
+        -> std::optional<Key> {
+    // Without a version, glyphs saved before the font library or the OS rasterizer was updated
+    // could not be told from new ones, so they are neither saved nor looked up.
+    if (scalerVersion == 0) {
+        return std::nullopt;
+    }
+    std::optional<uint64_t> identity = this->typefaceIdentity(strikeSpec.typeface());
+    if (!identity.has_value()) {
+        return std::nullopt;
+    }
+
+    // Clear the typeface ID from the descriptor's rec, since it will be different next time.
+    SkAutoDescriptor autoDescriptor{strikeSpec.descriptor()};
+    SkDescriptor* descriptor = autoDescriptor.getDesc();
+    uint32_t size;
+    // findEntry returns a const void*, remove the const in order to update in place.
+    void* ptr = const_cast<void*>(descriptor->findEntry(kRec_SkDescriptorTag, &size));
+    SkScalerContextRec rec;
+    if (ptr == nullptr || size != sizeof(rec)) {
+        return std::nullopt;
+    }
+    memcpy((void*)&rec, ptr, size);
+    rec.fTypefaceID = 0;
+    memcpy(ptr, &rec, size);
+    descriptor->computeChecksum();
+
+    SkASSERT(SkIsAlign4(descriptor->getLength()));
+    Key key(kDescriptorWord + descriptor->getLength() / sizeof(uint32_t));
+    key[0] = static_cast<uint32_t>(*identity);
+    key[1] = static_cast<uint32_t>(*identity >> 32);
+    key[kScalerVersionWord] = scalerVersion;
+    memcpy(&key[kDescriptorWord], descriptor, descriptor->getLength());
+    return key;
+}
+
+std::optional<uint64_t> SkStrikePersistentCache::typefaceIdentity(const SkTypeface& typeface) {
+    SkAutoMutexExclusive lock{fIdentityLock};
+    if (const std::optional<uint64_t>* identity = fIdentities.find(typeface.uniqueID())) {
+        return *identity;
+    }
+
+    // Only sfnt fonts, which have a 'head' table, can be found again by another process. Hashing
+    // all of a font's data would cost about as much as making many glyphs, so a font is known
+    // instead by its 'head' table, which holds its revision, its creation and modification times
+    // and a checksum of the whole font, along with its PostScript name, which tells apart the
+    // fonts of a collection, and the tags and sizes of its tables. A font that is changed without
+    // changing any of these would be mistaken for the old one.
+    std::optional<uint64_t> identity;
+    constexpr SkFontTableTag kHeadTag = SkSetFourByteTag('h', 'e', 'a', 'd');
+    constexpr size_t kHeadSize = 54;
+    uint8_t head[kHeadSize];
+    SkString name;
+    const int tableCount = typeface.countTables();
+    if (typeface.getTableData(kHeadTag, 0, kHeadSize, head) == kHeadSize &&
+        typeface.getPostScriptName(&name) && tableCount > 0) {
+        uint64_t hash = SkChecksum::Hash64(head, kHeadSize);
+        hash = SkChecksum::Hash64(name.c_str(), name.size(), hash);
+        std::vector<SkFontTableTag> tags(tableCount);
+        typeface.getTableTags(tags.data());
+        for (SkFontTableTag tag : tags) {
+            const uint64_t table[] = {tag, typeface.getTableSize(tag)};
+            hash = SkChecksum::Hash64(table, sizeof(table), hash);
+        }
+        using Coordinate = SkFontArguments::VariationPosition::Coordinate;
+        const int axisCount = typeface.getVariationDesignPosition(nullptr, 0);
+        if (axisCount > 0) {
+            std::vector<Coordinate> position(axisCount);
+            if (typeface.getVariationDesignPosition(position.data(), axisCount) == axisCount) {
+                hash = SkChecksum::Hash64(
+                        position.data(), position.size() * sizeof(Coordinate), hash);
+            }
+        }
+        identity = hash;
+    }
+    fIdentities.set(typeface.uniqueID(), identity);
+    return identity;
+}
+
+bool SkStrikePersistentCache::save(SkSpan<const sk_sp<SkStrike>> strikes) {
+    struct Saved {
+        uint32_t      fHash;
+        Key           fKey;
+        sk_sp<SkData> fData;
+    };
+    auto byHash = [](const Saved& a, const Saved& b) { return a.fHash < b.fHash; };
+
+    std::vector<Saved> saved;
+    for (const sk_sp<SkStrike>& strike : strikes) {
+        std::optional<Key> key = this->makeKey(strike->strikeSpec(), strike->scalerVersion());
+        if (!key.has_value()) {
+            continue;
+        }
+        SkBinaryWriteBuffer buffer({});
+        SkFontMetricsPriv::Flatten(buffer, strike->getFontMetrics());
+        strike->flattenGlyphs(buffer);
+        const uint32_t hash = SkChecksum::Hash32(key->data(), key->size() * sizeof(uint32_t));
+        saved.push_back({hash, std::move(*key), buffer.snapshotAsData()});
+    }
+    std::sort(saved.begin(), saved.end(), byHash);
+
+    // Keep what was saved before for strikes that are not in the cache now, unless it was made
+    // by another version of the scaler of a typeface whose strikes we are saving.
+    const size_t current = saved.size();
+    auto isStale = [&](const uint32_t* key) {
+        return std::any_of(saved.begin(), saved.begin() + current, [&](const Saved& s) {
+            return 0 == memcmp(s.fKey.data(), key, kIdentityWords * sizeof(uint32_t)) &&
+                   s.fKey[kScalerVersionWord] != key[kScalerVersionWord];
+        });
+    };
+    for (int i = 0; i < this->count(); ++i) {
+        const Entry& entry = this->entries()[i];
+        auto [first, last] = std::equal_range(saved.begin(), saved.begin() + current,
+                                              Saved{entry.fHash, {}, nullptr}, byHash);
+        const uint8_t* key = fFile->bytes() + entry.fKeyOffset;
+        const bool replaced = std::any_of(first, last, [&](const Saved& s) {
+            return s.fKey.size() * sizeof(uint32_t) == entry.fKeyLength &&
+                   0 == memcmp(s.fKey.data(), key, entry.fKeyLength);
+        });
+        if (entry.fKeyLength < kDescriptorWord * sizeof(uint32_t) ||
+            replaced || isStale(reinterpret_cast<const uint32_t*>(key))) {
+            continue;
+        }
+        Key oldKey(entry.fKeyLength / sizeof(uint32_t));
+        memcpy(oldKey.data(), key, entry.fKeyLength);
+        saved.push_back({entry.fHash, std::move(oldKey),
+                         SkData::MakeSubset(fFile.get(), entry.fDataOffset, entry.fDataLength)});
+    }
+    std::stable_sort(saved.begin(), saved.end(), byHash);
+
+    // Lay out the entries, then everything they point at.
+    const Header header{kMagic, kVersion, SK_MILESTONE, SkTo<uint32_t>(saved.size())};
+    std::vector<Entry> entries;
+    size_t offset = sizeof(Header) + saved.size() * sizeof(Entry);
+    for (const Saved& s : saved) {
+        Entry entry;
+        entry.fHash = s.fHash;
+        entry.fKeyLength = SkTo<uint32_t>(s.fKey.size() * sizeof(uint32_t));
+        // SkWriteBuffer always writes whole words.
+        SkASSERT(SkIsAlign4(s.fData->size()));
+        entry.fDataLength = SkTo<uint32_t>(s.fData->size());
+        entry.fKeyOffset = SkTo<uint32_t>(offset);
+        offset += entry.fKeyLength;
+        entry.fDataOffset = SkTo<uint32_t>(offset);
+        offset += entry.fDataLength;
+        if (!SkTFitsIn<uint32_t>(offset)) {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+
+    const SkString tmpPath = SkStringPrintf("%s.tmp", fPath.c_str());
+    {
+        SkFILEWStream file{tmpPath.c_str()};
+        if (!file.isValid()) {
+            return false;
+        }
+        bool ok = file.write(&header, sizeof(header)) &&
+                  file.write(entries.data(), entries.size() * sizeof(Entry));
+        for (const Saved& s : saved) {
+            ok = ok && file.write(s.fKey.data(), s.fKey.size() * sizeof(uint32_t)) &&
+                       file.write(s.fData->data(), s.fData->size());
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    if (0 == std::rename(tmpPath.c_str(), fPath.c_str())) {
+        return true;
+    }
+    // On Windows std::rename() won't replace a file, so remove the old one first. Until the new
+    // one is in its place, other processes will find no file.
+    return 0 == std::remove(fPath.c_str()) && 0 == std::rename(tmpPath.c_str(), fPath.c_str());
+}
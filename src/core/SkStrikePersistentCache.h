@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkStrikePersistentCache_DEFINED
+#define SkStrikePersistentCache_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSpan.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
+#include "include/core/SkTypes.h"
+#include "include/private/base/SkMutex.h"
+#include "include/private/base/SkThreadAnnotations.h"
+#include "src/core/SkTHash.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class SkDescriptor;
+class SkStrike;
+class SkStrikeSpec;
+
+/**
+ * A file of the glyphs of strikes from an earlier run of the program, so that a new strike can
+ * start out with them instead of asking its SkScalerContext for each one again.
+ *
+ * Each strike is saved under a key made of the identity of its typeface, the version of the
+ * scaler that made its glyphs (see SkScalerContext::getScalerVersion()) and its descriptor.
+ * Strikes whose scaler does not report a version are not saved.
+ * Typeface IDs are only unique within a process, so the typeface is identified by a hash of its
+ * 'head' table, PostScript name, table sizes and variation position instead. The glyphs are saved
+ * the way SkStrike::FlattenGlyphsByType() writes them for SkStrikeClient, after the strike's font
+ * metrics.
+ *
+ * The file is memory-mapped and only the index of a strike that is looked up is read, so opening
+ * the file costs next to nothing however many strikes it holds. On Windows, where a mapped file
+ * can't be replaced, the file is read instead.
+ */
+class SkStrikePersistentCache final : public SkNVRefCnt<SkStrikePersistentCache> {
+public:
+    // Map the file at path if it holds glyphs saved by this version of Skia.
+    explicit SkStrikePersistentCache(const char path[]);
+    ~SkStrikePersistentCache();
+
+    // Return the font metrics and glyphs saved for strikes like the one strikeSpec describes, or
+    // nullptr if there are none. scalerVersion is the version of the scaler that will make the
+    // strike's other glyphs.
+    sk_sp<SkData> find(const SkStrikeSpec& strikeSpec, uint32_t scalerVersion)
+            SK_EXCLUDES(fIdentityLock);
+
+    // Write the glyphs of strikes to the file, keeping those saved for other strikes except ones
+    // made by another version of the scaler of the same typeface. The new file is written beside
+    // the old one and then renamed, so that the old one stays intact while it is mapped. Where
+    // renaming can't replace a file (Windows), the old file is removed first.
+    bool save(SkSpan<const sk_sp<SkStrike>> strikes) SK_EXCLUDES(fIdentityLock);
+
+    // How many strikes the mapped file holds.
+    int count() const;
+
+    const char* path() const { return fPath.c_str(); }
+
+private:
+    struct Entry;
+    using Key = std::vector<uint32_t>;
+
+    // Check that every entry of file is in bounds and that they are sorted.
+    static bool IsValidFile(const SkData& file);
+    std::optional<Key> makeKey(const SkStrikeSpec& strikeSpec, uint32_t scalerVersion)
+            SK_EXCLUDES(fIdentityLock);
+    std::optional<uint64_t> typefaceIdentity(const SkTypeface& typeface)
+            SK_EXCLUDES(fIdentityLock);
+    const Entry* entries() const;
+    int find(const Key& key, uint32_t hash) const;
+
+    const SkString fPath;
+    sk_sp<SkData>  fFile;  // Null if there was no valid file to map.
+
+    SkMutex fIdentityLock;
+    skia_private::THashMap<SkTypefaceID, std::optional<uint64_t>> fIdentities
+            SK_GUARDED_BY(fIdentityLock);
+};
+
+#endif  // SkStrikePersistentCache_DEFINED
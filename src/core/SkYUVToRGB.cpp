@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkYUVToRGB.h"
+
+#include "include/codec/SkEncodedOrigin.h"
+#include "include/core/SkAlphaType.h"
+#include "include/core/SkColorType.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "include/private/base/SkAssert.h"
+#include "src/core/SkColorSpaceXformSteps.h"
+#include "src/core/SkRasterPipeline.h"
+#include "src/core/SkRasterPipelineOpContexts.h"
+#include "src/core/SkYUVAInfoLocation.h"
+#include "src/core/SkYUVMath.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+struct ChannelAddr {
+    const uint8_t* fBase;
+    size_t         fRowBytes;
+    int            fStep;
+
+    const uint8_t* row(int y) const { return fBase + y * fRowBytes; }
+};
+}  // namespace
+
+static ChannelAddr channel_addr(const SkYUVAPixmaps& src,
+                                const SkYUVAInfo::YUVALocation& location) {
+    const SkPixmap& plane = src.plane(location.fPlane);
+    const int bpp = plane.info().bytesPerPixel();
+    // Single channel planes (kGray_8, kAlpha_8) hold their channel at offset 0 whichever it is.
+    const int offset = bpp == 1 ? 0 : static_cast<int>(location.fChannel);
+    return {static_cast<const uint8_t*>(plane.addr()) + offset, plane.rowBytes(), bpp};
+}
+
+// Where luma position i lands among chroma samples sited at the center of each block of factor.
+static float chroma_position(int i, int factor) {
+    SkASSERT(factor > 0);
+    return (i + 0.5f) / factor - 0.5f;
+}
+
+bool SkConvertYUVAPixmaps(const SkYUVAPixmaps& src,
+                          const SkColorSpace* srcColorSpace,
+                          const SkPixmap& dst) {
+    const SkYUVAInfo& info = src.yuvaInfo();
+    if (!src.isValid() || src.dataType() != SkYUVAPixmaps::DataType::kUnorm8 ||
+        info.origin() != kTopLeft_SkEncodedOrigin || dst.dimensions() != info.dimensions() ||
+        dst.colorType() == kUnknown_SkColorType || !dst.addr()) {
+        return false;
+    }
+
+    const SkYUVAInfo::YUVALocations locations = src.toYUVALocations();
+    const ChannelAddr y = channel_addr(src, locations[SkYUVAInfo::kY]),
+                      u = channel_addr(src, locations[SkYUVAInfo::kU]),
+                      v = channel_addr(src, locations[SkYUVAInfo::kV]);
+    const bool hasAlpha = locations[SkYUVAInfo::kA].fPlane >= 0;
+    const ChannelAddr a = hasAlpha ? channel_addr(src, locations[SkYUVAInfo::kA])
+                                   : ChannelAddr{nullptr, 0, 0};
+
+    const int uPlane = locations[SkYUVAInfo::kU].fPlane;
+    const auto [ssx, ssy] = info.planeSubsamplingFactors(uPlane);
+    const SkISize chromaSize = src.plane(uPlane).dimensions();
+
+    SkYUVToRGBRow row;
+    row.fYStep = y.fStep;
+    row.fAStep = a.fStep;
+    row.fUStep = u.fStep;
+    row.fVStep = v.fStep;
+    row.fChromaFactor = ssx;
+    row.fChromaMax    = chromaSize.width() - 1;
+
+    float m[20];
+    SkColorMatrix_YUV2RGB(info.yuvColorSpace(), m);
+    for (int c = 0; c < 3; ++c) {
+        row.fMatrix[0][c] = m[5 * c + 0] / 255;
+        row.fMatrix[1][c] = m[5 * c + 1] / 255;
+        row.fMatrix[2][c] = m[5 * c + 2] / 255;
+        row.fMatrix[3][c] = 0;
+        row.fBias[c]      = m[5 * c + 4];
+    }
+    row.fMatrix[0][3] = row.fMatrix[1][3] = row.fMatrix[2][3] = 0;
+    row.fMatrix[3][3] = 1.f / 255;
+    row.fBias[3]      = 0;
+
+    // Color management and the store to dst run on each span while it is still in cache.
+    float span[4 * SkYUVToRGBRow::kMaxPixels];
+    SkRasterPipeline_MemoryCtx srcCtx = {span, 0},
+                               dstCtx = {nullptr, 0};
+    SkRasterPipeline_<256> pipeline;
+    pipeline.appendLoad(kRGBA_F32_SkColorType, &srcCtx);
+    SkColorSpaceXformSteps(srcColorSpace, kUnpremul_SkAlphaType,
+                           dst.colorSpace(), dst.alphaType()).apply(&pipeline);
+    pipeline.appendStore(dst.colorType(), &dstCtx);
+    const std::function<void(size_t, size_t, size_t, size_t)> run = pipeline.compile();
+
+    for (int j = 0; j < dst.height(); ++j) {
+        const float cy = std::clamp(chroma_position(j, ssy),
+                                    0.f, (float)(chromaSize.height() - 1));
+        const int c0 = (int)cy,
+                  c1 = std::min(c0 + 1, chromaSize.height() - 1);
+        row.fY = y.row(j);
+        row.fA = hasAlpha ? a.row(j) : nullptr;
+        row.fU[0] = u.row(c0);
+        row.fU[1] = u.row(c1);
+        row.fV[0] = v.row(c0);
+        row.fV[1] = v.row(c1);
+        row.fChromaWeight = cy - c0;
+
+        for (int i = 0; i < dst.width(); i += SkYUVToRGBRow::kMaxPixels) {
+            const int n = std::min(dst.width() - i, SkYUVToRGBRow::kMaxPixels);
+            SkOpts::yuva8_to_rgba_f32(span, row, i, n);
+            dstCtx.pixels = dst.writable_addr(i, j);
+            run(0, 0, n, 1);
+        }
+    }
+    return true;
+}
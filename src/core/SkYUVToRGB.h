@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkYUVToRGB_DEFINED
+#define SkYUVToRGB_DEFINED
+
+#include <cstdint>
+
+class SkColorSpace;
+class SkPixmap;
+class SkYUVAPixmaps;
+
+/*
+ * Where to find the samples for one row of an image stored as 8-bit YUVA planes, and how to turn
+ * them into RGBA.  Each channel of column x is read from its pointer at [x * step].
+ */
+struct SkYUVToRGBRow {
+    // The most pixels converted by one call to SkOpts::yuva8_to_rgba_f32.
+    static constexpr int kMaxPixels = 256;
+
+    const uint8_t* fY;
+    int            fYStep;
+    // Null if the image is opaque.
+    const uint8_t* fA;
+    int            fAStep;
+
+    // The chroma rows above and below this row's chroma sample position, and how much of the
+    // one below to blend in.
+    const uint8_t* fU[2];
+    const uint8_t* fV[2];
+    int            fUStep;
+    int            fVStep;
+    float          fChromaWeight;
+
+    // Chroma samples are sited at the center of each run of fChromaFactor pixel columns.
+    int            fChromaFactor;
+    int            fChromaMax;
+
+    // The YUV to RGB matrix as the RGBA contributions of Y, U, V and A (in 0-255), plus a bias.
+    float          fMatrix[4][4];
+    float          fBias[4];
+};
+
+namespace SkOpts {
+    // Converts pixels [x, x+n) of a row to unpremultiplied RGBA floats, n <= kMaxPixels.  dst
+    // must have room for kMaxPixels pixels.
+    using YUVA8_to_RGBA_f32 = void (*)(float dst[], const SkYUVToRGBRow&, int x, int n);
+    extern YUVA8_to_RGBA_f32 yuva8_to_rgba_f32;
+
+    void Init_YUVToRGB();
+}  // namespace SkOpts
+
+/*
+ * Converts YUVA planes in srcColorSpace to the pixels of dst, upsampling the chroma bilinearly
+ * the way the GPU backends sample it.  Each row is converted, color managed and stored in one
+ * pass.  Only supports kUnorm8 planes with kTopLeft_SkEncodedOrigin; returns false otherwise.
+ */
+bool SkConvertYUVAPixmaps(const SkYUVAPixmaps& src,
+                          const SkColorSpace* srcColorSpace,
+                          const SkPixmap& dst);
+
+#endif  // SkYUVToRGB_DEFINED
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/private/base/SkFeatures.h"
+#include "src/core/SkOptsTargets.h"
+#include "src/core/SkYUVToRGB.h"
+
+#if defined(SK_CPU_X86) && \
+    !defined(SK_ENABLE_OPTIMIZE_SIZE) && \
+    SK_CPU_SSE_LEVEL < SK_CPU_SSE_LEVEL_AVX2
+
+// The order of these includes is important:
+// 1) Select the target CPU architecture by defining SK_OPTS_TARGET and including SkOpts_SetTarget
+// 2) Include the code to compile, typically in a _opts.inc file.
+// 3) Include SkOpts_RestoreTarget to switch back to the default CPU architecture
+
+#define SK_OPTS_TARGET SK_OPTS_TARGET_HSW
+#include "src/opts/SkOpts_SetTarget.h"
+
+#include "src/opts/SkYUVToRGB_opts.inc"
+
+#include "src/opts/SkOpts_RestoreTarget.h"
+
+namespace SkOpts {
+    void Init_YUVToRGB_hsw() {
+        yuva8_to_rgba_f32 = hsw::yuva8_to_rgba_f32;
+    }
+}  // namespace SkOpts
+
+#endif // SK_CPU_X86 && !SK_ENABLE_OPTIMIZE_SIZE
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDeflateChunk_DEFINED
+#define SkDeflateChunk_DEFINED
+
+#include "include/core/SkStream.h"
+#include "include/private/base/SkTo.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "zlib.h"  // NO_G3_REWRITE
+
+/**
+ *  Helpers for compressing one zlib stream as independent chunks, e.g. on several threads. Each
+ *  chunk is raw deflate data primed with the tail of the input before it, so the chunks can
+ *  simply be concatenated between a zlib header and trailer, with the trailer's Adler-32 made by
+ *  combining the chunks' with adler32_combine().
+ *
+ *  Only for code that already links zlib (SkDeflateWStream, the PNG encoder).
+ */
+namespace SkDeflateChunk {
+
+// The largest window deflate can refer back into, and so the most of the input before a chunk
+// that is worth priming it with.
+inline constexpr size_t kMaxDictionarySize = 32 * 1024;
+
+// The zlib header (RFC 1950) for a deflate stream with a 32K window, compressed at `level`
+// (-1 for zlib's default).
+inline std::array<uint8_t, 2> ZlibHeader(int level) {
+    // FLG holds a hint of the level, padded so that CMF and FLG are a multiple of 31.
+    level = level == -1 ? 6 : level;
+    const unsigned levelHint = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    unsigned header = (0x78 << 8) | (levelHint << 6);
+    header += 31 - header % 31;
+    return {SkToU8(header >> 8), SkToU8(header & 0xFF)};
+}
+
+// The zlib trailer: the big-endian Adler-32 of all of the input.
+inline std::array<uint8_t, 4> ZlibTrailer(uint32_t adler) {
+    return {uint8_t(adler >> 24), uint8_t(adler >> 16), uint8_t(adler >> 8), uint8_t(adler)};
+}
+
+// Compresses `size` bytes at `src` as one chunk, primed with `dictionarySize` bytes at
+// `dictionary` (the end of the input before this chunk, at most kMaxDictionarySize). The chunk
+// ends with a sync flush, or if it is the `last` one, with the final deflate block. `zStream`
+// supplies the allocator (zalloc, zfree and opaque); its other fields are set here.
+// Returns false, having written nothing to `dst`, on failure.
+inline bool Compress(z_stream* zStream, int level, int strategy,
+                     const uint8_t* dictionary, size_t dictionarySize,
+                     const uint8_t* src, size_t size, bool last, SkWStream* dst) {
+    zStream->next_in = nullptr;
+    zStream->avail_in = 0;
+    if (Z_OK != deflateInit2(zStream, level, Z_DEFLATED, -15, 8, strategy)) {
+        return false;
+    }
+    if (dictionarySize) {
+        (void)deflateSetDictionary(zStream, dictionary, SkToUInt(dictionarySize));
+    }
+    zStream->next_in = const_cast<uint8_t*>(src);
+    zStream->avail_in = SkToUInt(size);
+    // Room for the whole chunk (and its flush marker) in a single deflate() call.
+    const size_t capacity = deflateBound(zStream, size) + 16;
+    std::unique_ptr<uint8_t[]> out(new uint8_t[capacity]);
+    zStream->next_out = out.get();
+    zStream->avail_out = SkToUInt(capacity);
+    const int result = deflate(zStream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    const size_t written = capacity - zStream->avail_out;
+    const bool ok = result == (last ? Z_STREAM_END : Z_OK) && zStream->avail_in == 0;
+    (void)deflateEnd(zStream);
+    return ok && dst->write(out.get(), written);
+}
+
+}  // namespace SkDeflateChunk
+
+#endif  // SkDeflateChunk_DEFINED
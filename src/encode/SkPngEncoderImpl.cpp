@@ -14,6 +14,7 @@
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkDataTable.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkRefCnt.h"
@@ -27,8 +28,12 @@
 #include "include/private/base/SkAssert.h"
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkNoncopyable.h"
+#include "include/private/base/SkTo.h"
 #include "modules/skcms/skcms.h"
+#include "src/base/SkVx.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/encode/SkDeflateChunk.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/encode/SkImageEncoderFns.h"
 #include "src/encode/SkImageEncoderPriv.h"
 #include "src/encode/SkPngEncoderBase.h"
@@ -45,6 +50,7 @@
 
 #include <png.h>
 #include <pngconf.h>
+#include <zlib.h>
 
 class GrDirectContext;
 class SkImage;
@@ -87,6 +93,9 @@ public:
     bool setColorSpace(const SkImageInfo& info, const SkPngEncoder::Options& options);
     bool setV0Gainmap(const SkPngEncoder::Options& options);
     bool writeInfo(const SkImageInfo& srcInfo);
+    // Writes already-compressed image data as IDAT chunks, then the IEND chunk, in place of
+    // png_write_rows() and png_write_end().
+    bool writeCompressedImageData(const std::vector<sk_sp<SkData>>& idats);
 
     png_structp pngPtr() { return fPngPtr; }
     png_infop infoPtr() { return fInfoPtr; }
@@ -391,6 +400,252 @@ bool SkPngEncoderMgr::writeInfo(const SkImageInfo& srcInfo) {
     return true;
 }
 
+bool SkPngEncoderMgr::writeCompressedImageData(const std::vector<sk_sp<SkData>>& idats) {
+    if (setjmp(png_jmpbuf(fPngPtr))) {
+        return false;
+    }
+
+    for (const sk_sp<SkData>& idat : idats) {
+        if (!idat->isEmpty()) {
+            png_write_chunk(fPngPtr, (png_const_bytep)"IDAT", idat->bytes(), idat->size());
+        }
+    }
+    // png_write_end() refuses to finish a file whose IDATs libpng did not compress itself ("No
+    // IDATs written into file"), so do its part here: write the chunks that belong after the
+    // image data, then IEND. This encoder only sets unknown chunks, never text or tIME.
+    png_unknown_chunkp chunks = nullptr;
+    const int chunkCount = png_get_unknown_chunks(fPngPtr, fInfoPtr, &chunks);
+    for (int i = 0; i < chunkCount; i++) {
+        if (chunks[i].location & PNG_AFTER_IDAT) {
+            png_write_chunk(fPngPtr, chunks[i].name, chunks[i].data, chunks[i].size);
+        }
+    }
+    png_write_chunk(fPngPtr, (png_const_bytep)"IEND", nullptr, 0);
+    return true;
+}
+
+namespace {
+
+// PNG's filter types, in the order of their bits in SkPngEncoder::FilterFlag.
+enum FilterType : uint8_t { kNone, kSub, kUp, kAvg, kPaeth };
+
+// Applies filter `F` to `size` bytes of `row`, each pixel `bpp` bytes, whose row above is `prior`.
+// Writes the filtered bytes to `dst` and returns the sum of their magnitudes as signed bytes,
+// libpng's heuristic for the filter that will compress best.  16 bytes are filtered at a time;
+// the first pixel (which has nothing to its left) and any tail are done one byte at a time.
+template <FilterType F>
+uint32_t filter_row(const uint8_t* row, const uint8_t* prior, size_t size, size_t bpp,
+                    uint8_t* dst) {
+    auto filter = [](auto x, auto a, auto b, auto c) {
+        // x is the byte being filtered, a the byte to its left, b above, c above and left.
+        using V = decltype(x);
+        if constexpr (F == kNone) {
+            return x;
+        } else if constexpr (F == kSub) {
+            return V(x - a);
+        } else if constexpr (F == kUp) {
+            return V(x - b);
+        } else if constexpr (F == kAvg) {
+            return V(x - V((a & b) + ((a ^ b) >> 1)));  // (a + b) / 2 without overflow
+        } else {
+            auto A = skvx::cast<int16_t>(a),
+                 B = skvx::cast<int16_t>(b),
+                 C = skvx::cast<int16_t>(c);
+            auto pa = skvx::max(B - C, C - B),
+                 pb = skvx::max(A - C, C - A),
+                 pc = skvx::max(A + B - C - C, C + C - A - B);
+            auto predictor = skvx::if_then_else((pa <= pb) & (pa <= pc), A,
+                                                skvx::if_then_else(pb <= pc, B, C));
+            return V(x - skvx::cast<uint8_t>(predictor));
+        }
+    };
+    auto magnitude = [](auto v) { return skvx::min(v, decltype(v)(0) - v); };
+
+    using V1 = skvx::Vec<1, uint8_t>;
+    using V16 = skvx::Vec<16, uint8_t>;
+    uint32_t sum = 0;
+    size_t i = 0;
+    for (; i < std::min(bpp, size); i++) {
+        V1 v = filter(V1::Load(row + i), V1(0), V1::Load(prior + i), V1(0));
+        v.store(dst + i);
+        sum += magnitude(v).val;
+    }
+    while (i + 16 <= size) {
+        // Each lane of a 16-bit accumulator can take 512 magnitudes of up to 128.
+        skvx::Vec<16, uint16_t> sums(0);
+        for (int n = 0; n < 512 && i + 16 <= size; n++, i += 16) {
+            V16 v = filter(V16::Load(row + i), V16::Load(row + i - bpp),
+                           V16::Load(prior + i), V16::Load(prior + i - bpp));
+            v.store(dst + i);
+            sums += skvx::cast<uint16_t>(magnitude(v));
+        }
+        for (int lane = 0; lane < 16; lane++) {
+            sum += sums[lane];
+        }
+    }
+    for (; i < size; i++) {
+        V1 v = filter(V1::Load(row + i), V1::Load(row + i - bpp),
+                      V1::Load(prior + i), V1::Load(prior + i - bpp));
+        v.store(dst + i);
+        sum += magnitude(v).val;
+    }
+    return sum;
+}
+
+using FilterProc = uint32_t (*)(const uint8_t*, const uint8_t*, size_t, size_t, uint8_t*);
+constexpr FilterProc kFilterProcs[] = {
+        filter_row<kNone>, filter_row<kSub>, filter_row<kUp>, filter_row<kAvg>, filter_row<kPaeth>,
+};
+
+// Filters and deflates bands of rows independently of each other, for encoding on an SkExecutor.
+class StripeEncoder {
+public:
+    // Enough rows to make each stripe worth a task, and to keep the cost of splitting the zlib
+    // stream (a sync flush, and a dictionary in place of each stripe's lost history) small.
+    static constexpr size_t kStripeBytes = 256 * 1024;
+
+    StripeEncoder(const SkPngEncoderBase::TargetInfo& targetInfo,
+                  const SkPixmap& src,
+                  const SkPngEncoder::Options& options)
+            : fTargetInfo(targetInfo)
+            , fSrc(src)
+            , fBpp(SkToSizeT(targetInfo.fDstInfo.bitsPerPixel() / 8))
+            // Like libpng, treat no filters at all as permission to use any of them.
+            , fFilters((int)options.fFilterFlags & (int)SkPngEncoder::FilterFlag::kAll
+                               ? (int)options.fFilterFlags & (int)SkPngEncoder::FilterFlag::kAll
+                               : (int)SkPngEncoder::FilterFlag::kAll)
+            , fZLibLevel(std::min(std::max(0, options.fZLibLevel), 9))
+            , fRowsPerStripe(std::max<int>(1, SkToInt(kStripeBytes / this->filteredRowSize())))
+            , fStripes((src.height() + fRowsPerStripe - 1) / fRowsPerStripe) {}
+
+    int stripeCount() const { return fStripes; }
+
+    // Returns the image data as the payloads of a series of IDAT chunks, any of which are null
+    // if their stripe failed to compress.
+    std::vector<sk_sp<SkData>> encode(SkExecutor* executor) {
+        std::vector<sk_sp<SkData>> idats(fStripes);
+        std::vector<uLong> adlers(fStripes);
+        SkTaskGroup tg(*executor);
+        tg.batch(fStripes, [&](int i) { idats[i] = this->encodeStripe(i, &adlers[i]); });
+        tg.wait();
+
+        // The stripes' zlib streams become one with the Adler-32 of all of them after the last.
+        uLong adler = adlers[0];
+        for (int i = 1; i < fStripes; i++) {
+            const z_off_t size = static_cast<z_off_t>(this->stripeRows(i) *
+                                                      this->filteredRowSize());
+            adler = adler32_combine(adler, adlers[i], size);
+        }
+        if (sk_sp<SkData>& last = idats.back()) {
+            const auto trailer = SkDeflateChunk::ZlibTrailer(SkToU32(adler));
+            memcpy(static_cast<uint8_t*>(last->writable_data()) + last->size() - trailer.size(),
+                   trailer.data(), trailer.size());
+        }
+        return idats;
+    }
+
+private:
+    size_t filteredRowSize() const { return fTargetInfo.fDstRowSize + 1; }
+    int stripeRows(int stripe) const {
+        return std::min(fRowsPerStripe, fSrc.height() - stripe * fRowsPerStripe);
+    }
+
+    // Filters rows [y0, y1) into `dst`, each preceded by its filter type.
+    void filterRows(int y0, int y1, uint8_t* dst) const {
+        const size_t rowSize = fTargetInfo.fDstRowSize;
+        const int srcBpp = SkColorTypeBytesPerPixel(fSrc.colorType());
+        // Transformed rows, alternating between the current row and the one above it.
+        std::vector<uint8_t> rows(2 * rowSize, 0);
+        std::vector<uint8_t> scratch(fFilters & (fFilters - 1) ? rowSize : 0);
+        uint8_t* prior = rows.data();
+        uint8_t* row = rows.data() + rowSize;
+        if (y0 > 0) {
+            fTargetInfo.fTransformProc((char*)prior, (const char*)fSrc.addr(0, y0 - 1),
+                                       fSrc.width(), srcBpp);
+        }
+        for (int y = y0; y < y1; y++, dst += rowSize + 1) {
+            fTargetInfo.fTransformProc((char*)row, (const char*)fSrc.addr(0, y),
+                                       fSrc.width(), srcBpp);
+            if (scratch.empty()) {
+                // Only one filter to choose from.
+                int type = kNone;
+                while (!(fFilters & (0x08 << type))) {
+                    type++;
+                }
+                dst[0] = SkToU8(type);
+                kFilterProcs[type](row, prior, rowSize, fBpp, dst + 1);
+            } else {
+                // Try each allowed filter, keeping the output of the best so far in dst.
+                uint32_t best = UINT32_MAX;
+                for (int type = kNone; type <= kPaeth; type++) {
+                    if (!(fFilters & (0x08 << type))) {
+                        continue;
+                    }
+                    uint32_t sum = kFilterProcs[type](row, prior, rowSize, fBpp, scratch.data());
+                    if (sum < best) {
+                        best = sum;
+                        dst[0] = SkToU8(type);
+                        memcpy(dst + 1, scratch.data(), rowSize);
+                    }
+                }
+            }
+            std::swap(row, prior);
+        }
+    }
+
+    // Returns the stripe's IDAT payload: its part of the zlib stream (see SkDeflateChunk), with
+    // the zlib header if it is the first and room for the checksum if it is the last. Stores the
+    // Adler-32 of its filtered rows in `adler`. Returns null on failure.
+    sk_sp<SkData> encodeStripe(int stripe, uLong* adler) const {
+        using SkDeflateChunk::kMaxDictionarySize;
+        const size_t filteredRowSize = this->filteredRowSize();
+        const int y0 = stripe * fRowsPerStripe,
+                  y1 = y0 + this->stripeRows(stripe);
+        // The rows at the end of the previous stripe are filtered again here to be the
+        // dictionary, exactly as that stripe filtered them.
+        const int dictionaryRows = std::min<int>(
+                y0, SkToInt((kMaxDictionarySize + filteredRowSize - 1) / filteredRowSize));
+        const size_t dictionarySize = std::min(dictionaryRows * filteredRowSize,
+                                               kMaxDictionarySize);
+        const size_t size = (y1 - y0) * filteredRowSize;
+        std::vector<uint8_t> filtered((y1 - y0 + dictionaryRows) * filteredRowSize);
+        this->filterRows(y0 - dictionaryRows, y1, filtered.data());
+        const uint8_t* data = filtered.data() + dictionaryRows * filteredRowSize;
+
+        SkDynamicMemoryWStream idat;
+        if (stripe == 0) {
+            const auto header = SkDeflateChunk::ZlibHeader(fZLibLevel);
+            idat.write(header.data(), header.size());
+        }
+        z_stream zStream = {};
+        // libpng's default strategy.
+        const int strategy = fFilters == (int)SkPngEncoder::FilterFlag::kNone ? Z_DEFAULT_STRATEGY
+                                                                               : Z_FILTERED;
+        const bool last = stripe == fStripes - 1;
+        if (!SkDeflateChunk::Compress(&zStream, fZLibLevel, strategy,
+                                      data - dictionarySize, dictionarySize,
+                                      data, size, last, &idat)) {
+            return nullptr;
+        }
+        if (last) {
+            // Filled in by encode() once every stripe's checksum is known.
+            idat.write32(0);
+        }
+        *adler = adler32(1, data, SkToUInt(size));
+        return idat.detachAsData();
+    }
+
+    const SkPngEncoderBase::TargetInfo& fTargetInfo;
+    const SkPixmap& fSrc;
+    const size_t fBpp;
+    const int fFilters;
+    const int fZLibLevel;
+    const int fRowsPerStripe;
+    const int fStripes;
+};
+
+}  // namespace
+
 SkPngEncoderImpl::SkPngEncoderImpl(TargetInfo targetInfo,
                                    std::unique_ptr<SkPngEncoderMgr> encoderMgr,
                                    const SkPixmap& src)
@@ -419,8 +674,12 @@ bool SkPngEncoderImpl::onFinishEncoding() {
     return true;
 }
 
-namespace SkPngEncoder {
-std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Options& options) {
+// Sets up libpng to encode `src` and writes everything up to the image data.
+static std::unique_ptr<SkPngEncoderMgr> write_png_info(
+        SkWStream* dst,
+        const SkPixmap& src,
+        const SkPngEncoder::Options& options,
+        std::optional<SkPngEncoderBase::TargetInfo>* targetInfo) {
     if (!SkPixmapIsValid(src)) {
         return nullptr;
     }
@@ -430,13 +689,12 @@ std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Optio
         return nullptr;
     }
 
-    std::optional<SkPngEncoderBase::TargetInfo> targetInfo =
-            SkPngEncoderBase::getTargetInfo(src.info());
-    if (!targetInfo.has_value()) {
+    *targetInfo = SkPngEncoderBase::getTargetInfo(src.info());
+    if (!targetInfo->has_value()) {
         return nullptr;
     }
 
-    if (!encoderMgr->setHeader(targetInfo->fDstInfo, src.info(), options)) {
+    if (!encoderMgr->setHeader((*targetInfo)->fDstInfo, src.info(), options)) {
         return nullptr;
     }
 
@@ -451,11 +709,42 @@ std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Optio
     if (!encoderMgr->writeInfo(src.info())) {
         return nullptr;
     }
+    return encoderMgr;
+}
+
+namespace SkPngEncoder {
+std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Options& options) {
+    std::optional<SkPngEncoderBase::TargetInfo> targetInfo;
+    std::unique_ptr<SkPngEncoderMgr> encoderMgr = write_png_info(dst, src, options, &targetInfo);
+    if (!encoderMgr) {
+        return nullptr;
+    }
 
     return std::make_unique<SkPngEncoderImpl>(std::move(*targetInfo), std::move(encoderMgr), src);
 }
 
 bool Encode(SkWStream* dst, const SkPixmap& src, const Options& options) {
+    if (options.fExecutor && src.width() > 0 && src.height() > 0) {
+        std::optional<SkPngEncoderBase::TargetInfo> targetInfo;
+        std::unique_ptr<SkPngEncoderMgr> encoderMgr =
+                write_png_info(dst, src, options, &targetInfo);
+        if (!encoderMgr) {
+            return false;
+        }
+        StripeEncoder stripes(*targetInfo, src, options);
+        if (stripes.stripeCount() > 1) {
+            std::vector<sk_sp<SkData>> idats = stripes.encode(options.fExecutor);
+            for (const sk_sp<SkData>& idat : idats) {
+                if (!idat) {
+                    return false;
+                }
+            }
+            return encoderMgr->writeCompressedImageData(idats);
+        }
+        SkPngEncoderImpl encoder(std::move(*targetInfo), std::move(encoderMgr), src);
+        return encoder.encodeRows(src.height());
+    }
+
     auto encoder = Make(dst, src, options);
     return encoder.get() && encoder->encodeRows(src.height());
 }
@@ -34,6 +34,7 @@
 #include "include/private/gpu/ganesh/GrTypesPriv.h"
 #include "src/core/SkAutoPixmapStorage.h"
 #include "src/core/SkImageInfoPriv.h"
+#include "src/core/SkYUVToRGB.h"
 #include "src/gpu/GpuTypesPriv.h"
 #include "src/gpu/RefCntedCallback.h"
 #include "src/gpu/Swizzle.h"
@@ -505,6 +506,36 @@ sk_sp<SkImage> TextureFromYUVATextures(GrRecordingContext* context,
             sk_ref_sp(context), kNeedNewImageUniqueID, yuvaProxies, imageColorSpace);
 }
 
+// Converts the planes to RGBA on the CPU, for when the context can't make textures of them.
+static sk_sp<SkImage> rgba_texture_from_yuva_pixmaps(GrRecordingContext* context,
+                                                     const SkYUVAPixmaps& pixmaps,
+                                                     skgpu::Mipmapped buildMips,
+                                                     sk_sp<SkColorSpace> imageColorSpace) {
+    // Match the alpha type SkImage_GaneshYUVA would have had.
+    const SkAlphaType at = pixmaps.yuvaInfo().hasAlpha() ? kPremul_SkAlphaType
+                                                         : kOpaque_SkAlphaType;
+    SkBitmap bmp;
+    if (!bmp.tryAllocPixels(SkImageInfo::Make(pixmaps.yuvaInfo().dimensions(),
+                                              SkYUVAPixmaps::RecommendedRGBAColorType(
+                                                      pixmaps.dataType()),
+                                              at,
+                                              imageColorSpace)) ||
+        !SkConvertYUVAPixmaps(pixmaps, imageColorSpace.get(), bmp.pixmap())) {
+        return nullptr;
+    }
+    bmp.setImmutable();
+    auto [view, ct] = GrMakeUncachedBitmapProxyView(context, bmp, buildMips);
+    if (!view) {
+        return nullptr;
+    }
+    return sk_make_sp<SkImage_Ganesh>(sk_ref_sp(context),
+                                      kNeedNewImageUniqueID,
+                                      std::move(view),
+                                      SkColorInfo(GrColorTypeToSkColorType(ct),
+                                                  at,
+                                                  std::move(imageColorSpace)));
+}
+
 sk_sp<SkImage> TextureFromYUVAPixmaps(GrRecordingContext* context,
                                       const SkYUVAPixmaps& pixmaps,
                                       skgpu::Mipmapped buildMips,
@@ -569,7 +600,8 @@ sk_sp<SkImage> TextureFromYUVAPixmaps(GrRecordingContext* context,
         bmp.installPixels(pixmapsToUpload->plane(i));
         std::tie(views[i], std::ignore) = GrMakeUncachedBitmapProxyView(context, bmp, buildMips);
         if (!views[i]) {
-            return nullptr;
+            return rgba_texture_from_yuva_pixmaps(
+                    context, *pixmapsToUpload, buildMips, std::move(imageColorSpace));
         }
         pixmapColorTypes[i] = SkColorTypeToGrColorType(bmp.colorType());
     }
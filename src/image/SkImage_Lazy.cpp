@@ -20,6 +20,7 @@
 #include "src/core/SkNextID.h"
 #include "src/core/SkResourceCache.h"
 #include "src/core/SkYUVPlanesCache.h"
+#include "src/core/SkYUVToRGB.h"
 
 #include <utility>
 
@@ -107,6 +108,17 @@ SkImage_Lazy::SkImage_Lazy(Validator* validator)
     SkASSERT(fSharedGenerator);
 }
 
+// A generator that can't decode to RGBA may still have been decoded to YUVA planes for the GPU.
+// Those are only a fallback: converting them needn't match the generator's own RGBA decode
+// exactly, and getROPixels() shouldn't depend on whether the image was drawn on the GPU first.
+static bool convert_cached_planes(uint32_t uniqueID,
+                                  const SkColorSpace* colorSpace,
+                                  const SkPixmap& dst) {
+    SkYUVAPixmaps yuvaPixmaps;
+    sk_sp<SkCachedData> data(SkYUVPlanesCache::FindAndRef(uniqueID, &yuvaPixmaps));
+    return data && SkConvertYUVAPixmaps(yuvaPixmaps, colorSpace, dst);
+}
+
 bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
                                SkImage::CachingHint chint) const {
     auto check_output_bitmap = [bitmap]() {
@@ -131,6 +143,9 @@ bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
         {   // make sure ScopedGenerator goes out of scope before we try readPixelsProxy
             success = ScopedGenerator(fSharedGenerator)->getPixels(pmap);
         }
+        if (!success) {
+            success = convert_cached_planes(this->uniqueID(), this->colorSpace(), pmap);
+        }
         if (!success && !this->readPixelsProxy(ctx, pmap)) {
             return false;
         }
@@ -144,6 +159,9 @@ bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
         {   // make sure ScopedGenerator goes out of scope before we try readPixelsProxy
             success = ScopedGenerator(fSharedGenerator)->getPixels(bitmap->pixmap());
         }
+        if (!success) {
+            success = convert_cached_planes(this->uniqueID(), this->colorSpace(), bitmap->pixmap());
+        }
         if (!success && !this->readPixelsProxy(ctx, bitmap->pixmap())) {
             return false;
         }
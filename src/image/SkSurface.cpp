@@ -69,6 +69,7 @@ SkSurface::SkSurface(const SkImageInfo& info, const SkSurfaceProps* props)
 }
 
 uint32_t SkSurface::generationID() {
+    asSB(this)->onResolveDeferredDraws();
     if (0 == fGenerationID) {
         fGenerationID = asSB(this)->newGenerationID();
     }
@@ -76,6 +77,7 @@ uint32_t SkSurface::generationID() {
 }
 
 void SkSurface::notifyContentWillChange(ContentChangeMode mode) {
+    asSB(this)->onResolveDeferredDraws();
     sk_ignore_unused_variable(asSB(this)->aboutToDraw(mode));
 }
 
@@ -88,6 +90,7 @@ sk_sp<const SkCapabilities> SkSurface::capabilities() {
 }
 
 sk_sp<SkImage> SkSurface::makeImageSnapshot() {
+    asSB(this)->onResolveDeferredDraws();
     return asSB(this)->refCachedImage();
 }
 
@@ -101,11 +104,13 @@ sk_sp<SkImage> SkSurface::makeImageSnapshot(const SkIRect& srcBounds) {
     if (bounds == surfBounds) {
         return this->makeImageSnapshot();
     } else {
+        asSB(this)->onResolveDeferredDraws();
         return asSB(this)->onNewImageSnapshot(&bounds);
     }
 }
 
 sk_sp<SkImage> SkSurface::makeTemporaryImage() {
+    asSB(this)->onResolveDeferredDraws();
     return asSB(this)->onMakeTemporaryImage();
 }
 
@@ -119,15 +124,18 @@ sk_sp<SkSurface> SkSurface::makeSurface(int width, int height) {
 
 void SkSurface::draw(SkCanvas* canvas, SkScalar x, SkScalar y, const SkSamplingOptions& sampling,
                      const SkPaint* paint) {
+    asSB(this)->onResolveDeferredDraws();
     asSB(this)->onDraw(canvas, x, y, sampling, paint);
 }
 
 bool SkSurface::peekPixels(SkPixmap* pmap) {
-    return this->getCanvas()->peekPixels(pmap);
+    asSB(this)->onResolveDeferredDraws();
+    return asSB(this)->onPeekPixels(pmap);
 }
 
 bool SkSurface::readPixels(const SkPixmap& pm, int srcX, int srcY) {
-    return this->getCanvas()->readPixels(pm, srcX, srcY);
+    asSB(this)->onResolveDeferredDraws();
+    return asSB(this)->onReadPixels(pm, srcX, srcY);
 }
 
 bool SkSurface::readPixels(const SkImageInfo& dstInfo, void* dstPixels, size_t dstRowBytes,
@@ -215,6 +223,7 @@ void SkSurface::writePixels(const SkPixmap& pmap, int x, int y) {
         if (srcR.contains(dstR)) {
             mode = kDiscard_ContentChangeMode;
         }
+        asSB(this)->onResolveDeferredDraws();
         if (!asSB(this)->aboutToDraw(mode)) {
             return;
         }
@@ -97,6 +97,12 @@ public:
 
     virtual void onWritePixels(const SkPixmap&, int x, int y) = 0;
 
+    /**
+     *  Default implementations read from the surface's canvas.
+     */
+    virtual bool onPeekPixels(SkPixmap*);
+    virtual bool onReadPixels(const SkPixmap&, int srcX, int srcY);
+
     /**
      * Default implementation does a rescale/read and then calls the callback.
      */
@@ -136,6 +142,12 @@ public:
      */
     virtual void onDiscard() {}
 
+    /**
+     *  Surfaces that defer drawing must execute that work here. This is called before the
+     *  surface's contents are observed or modified other than through its canvas.
+     */
+    virtual void onResolveDeferredDraws() {}
+
     /**
      *  If the surface is about to change, we call this so that our subclass
      *  can optionally fork their backend (copy-on-write) in case it was
@@ -176,13 +188,14 @@ public:
     // called by SkSurface to compute a new genID
     uint32_t newGenerationID();
 
+protected:
+    // Returns false if drawing should not take place (allocation failure).
+    [[nodiscard]] bool aboutToDraw(ContentChangeMode mode);
+
 private:
     std::unique_ptr<SkCanvas> fCachedCanvas = nullptr;
     sk_sp<SkImage>            fCachedImage  = nullptr;
 
-    // Returns false if drawing should not take place (allocation failure).
-    [[nodiscard]] bool aboutToDraw(ContentChangeMode mode);
-
     // Returns true if there is an outstanding image-snapshot, indicating that a call to aboutToDraw
     // would trigger a copy-on-write.
     bool outstandingImageSnapshot() const;
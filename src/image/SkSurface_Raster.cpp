@@ -144,13 +144,17 @@ bool SkSurface_Raster::onCopyOnWrite(ContentChangeMode mode) {
         // Now fBitmap is a deep copy of itself (and therefore different from
         // what is being used by the image. Next we update the canvas to use
         // this as its backend, so we can't modify the image's pixels anymore.
-        SkASSERT(this->getCachedCanvas());
-        SkBitmapDevice* bmDev = static_cast<SkBitmapDevice*>(this->getCachedCanvas()->rootDevice());
-        bmDev->replaceBitmapBackendForRasterSurface(fBitmap);
+        this->onReplaceBitmapBackend();
     }
     return true;
 }
 
+void SkSurface_Raster::onReplaceBitmapBackend() {
+    SkASSERT(this->getCachedCanvas());
+    SkBitmapDevice* bmDev = static_cast<SkBitmapDevice*>(this->getCachedCanvas()->rootDevice());
+    bmDev->replaceBitmapBackendForRasterSurface(fBitmap);
+}
+
 sk_sp<const SkCapabilities> SkSurface_Raster::onCapabilities() {
     return SkCapabilities::RasterBackend();
 }
@@ -49,6 +49,13 @@ public:
     void onRestoreBackingMutability() override;
     sk_sp<const SkCapabilities> onCapabilities() override;
 
+protected:
+    const SkBitmap& bitmap() const { return fBitmap; }
+
+    // Called by onCopyOnWrite() once fBitmap holds a private copy of the pixels, so that the
+    // canvas stops drawing into the pixels shared with the snapshot.
+    virtual void onReplaceBitmapBackend();
+
 private:
     SkBitmap    fBitmap;
     bool        fWeOwnThePixels;
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBBHFactory.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkMallocPixelRef.h"
+#include "include/core/SkPixelRef.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSurface.h"
+#include "include/private/base/SkTArray.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkRTree.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkRecords.h"
+#include "src/core/SkSurfacePriv.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/image/SkSurface_Raster.h"
+
+#include <memory>
+#include <utility>
+
+using namespace skia_private;
+
+namespace {
+
+// Small enough that an 8K surface splits into hundreds of tiles, large enough that per-tile
+// replay of save/clip/matrix ops stays cheap relative to rasterization.
+constexpr int kDefaultTileSize = 256;
+
+// Sorts ops into the ones that draw pixels and the ones that only maintain canvas state.
+struct ClassifyOp {
+    enum Kind { kState, kDraw, kSave, kSaveLayer, kRestore };
+
+    template <typename T> Kind operator()(const T&) {
+        return (T::kTags & SkRecords::kDraw_Tag) ? kDraw : kState;
+    }
+    Kind operator()(const SkRecords::NoOp&)           { return kDraw; }
+    Kind operator()(const SkRecords::DrawAnnotation&) { return kDraw; }
+    Kind operator()(const SkRecords::Save&)           { return kSave; }
+    Kind operator()(const SkRecords::SaveLayer&)      { return kSaveLayer; }
+    Kind operator()(const SkRecords::SaveBehind&)     { return kSaveLayer; }
+    Kind operator()(const SkRecords::Restore&)        { return kRestore; }
+};
+
+/**
+ *  A raster surface whose canvas is an SkRecorder. Draws accumulate in an SkRecord until the
+ *  pixels are needed, then the record is bounded with SkRecordFillBounds, indexed in an SkRTree,
+ *  and played back with SkRecordDraw once per tile. Each tile gets its own SkCanvas (and so its
+ *  own SkBitmapDevice and SkRasterClip) clipped to its part of the surface's pixels, and tiles
+ *  are drawn concurrently through an SkTaskGroup.
+ */
+class SkSurface_RasterTiled final : public SkSurface_Raster {
+public:
+    SkSurface_RasterTiled(const SkImageInfo& info, sk_sp<SkPixelRef> pr, SkExecutor* executor,
+                          int tileSize, const SkSurfaceProps* props)
+            : SkSurface_Raster(info, std::move(pr), props)
+            , fExecutor(executor)
+            , fTileSize(tileSize)
+            , fRecord(sk_make_sp<SkRecord>()) {}
+
+    SkCanvas* onNewCanvas() override {
+        fRecorder = new SkRecorder(fRecord.get(), SkRect::Make(this->imageInfo().bounds()));
+        return fRecorder;
+    }
+
+    sk_sp<SkSurface> onNewSurface(const SkImageInfo& info) override {
+        return SkSurfaces::RasterTiled(info, fExecutor, fTileSize, &this->props());
+    }
+
+    bool onPeekPixels(SkPixmap* pmap) override {
+        return this->bitmap().peekPixels(pmap);
+    }
+
+    bool onReadPixels(const SkPixmap& dst, int srcX, int srcY) override {
+        return dst.addr() && this->bitmap().readPixels(dst, srcX, srcY);
+    }
+
+    void onResolveDeferredDraws() override;
+
+private:
+    // Our canvas never draws into the bitmap directly, so there's nothing to retarget; the next
+    // playback picks up the new pixels from bitmap().
+    void onReplaceBitmapBackend() override {}
+
+    // The index of the outermost saveLayer that has not been restored, or the record's count.
+    int firstOpenLayer() const;
+    void drawTiles(int end);
+    void restartRecording(int end);
+
+    SkExecutor*      fExecutor;
+    const int        fTileSize;
+    sk_sp<SkRecord>  fRecord;
+    SkRecorder*      fRecorder = nullptr;  // Owned by SkSurface_Base as its cached canvas.
+    // Ops in fRecord before this index only re-establish canvas state; they draw nothing.
+    // Ops from the outermost open saveLayer on may follow them, still waiting to be drawn.
+    int              fResolvedOps = 0;
+};
+
+void SkSurface_RasterTiled::onResolveDeferredDraws() {
+    if (!fRecorder || fRecord->count() == fResolvedOps) {
+        return;
+    }
+    // Like those of a Raster() surface, our pixels do not show what is drawn into a layer until
+    // the layer is restored, so only the ops before the outermost open saveLayer are drawn now.
+    // The rest wait, and the layer is composited in one piece when it is restored.
+    const int end = this->firstOpenLayer();
+    bool drawsPending = false;
+    for (int i = fResolvedOps; i < end && !drawsPending; i++) {
+        drawsPending = fRecord->visit(i, ClassifyOp()) == ClassifyOp::kDraw;
+    }
+    if (!drawsPending) {
+        return;
+    }
+    if (this->aboutToDraw(kRetain_ContentChangeMode)) {
+        this->drawTiles(end);
+    }
+    this->restartRecording(end);
+}
+
+int SkSurface_RasterTiled::firstOpenLayer() const {
+    TArray<int> layers;  // Each open save, or -1 for one that isn't a layer.
+    for (int i = 0; i < fRecord->count(); i++) {
+        switch (fRecord->visit(i, ClassifyOp())) {
+            case ClassifyOp::kSave:
+                layers.push_back(-1);
+                break;
+            case ClassifyOp::kSaveLayer:
+                layers.push_back(i);
+                break;
+            case ClassifyOp::kRestore:
+                if (!layers.empty()) {
+                    layers.pop_back();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    for (int layer : layers) {
+        if (layer >= 0) {
+            return layer;
+        }
+    }
+    return fRecord->count();
+}
+
+void SkSurface_RasterTiled::drawTiles(int end) {
+    const SkRecord& record = *fRecord;
+    const SkRect cull = SkRect::Make(this->imageInfo().bounds());
+
+    AutoTArray<SkRect> bounds(record.count());
+    AutoTMalloc<SkBBoxHierarchy::Metadata> meta(record.count());
+    SkRecordFillBounds(cull, record, bounds.data(), meta);
+
+    // Only ops the tree holds are drawn.
+    SkRTree rtree;
+    rtree.insert(bounds.data(), end);
+
+    std::unique_ptr<SkBigPicture::SnapshotArray> drawablePicts;
+    if (SkDrawableList* drawables = fRecorder->getDrawableList()) {
+        drawablePicts.reset(drawables->newDrawableSnapshot());
+    }
+    const SkPicture* const* picts = drawablePicts ? drawablePicts->begin() : nullptr;
+    const int pictCount = drawablePicts ? drawablePicts->count() : 0;
+
+    const SkBitmap& bitmap = this->bitmap();
+    const int tilesX = (bitmap.width()  + fTileSize - 1) / fTileSize,
+              tilesY = (bitmap.height() + fTileSize - 1) / fTileSize;
+
+    SkTaskGroup tg(fExecutor ? *fExecutor : SkExecutor::GetDefault());
+    tg.batch(tilesX * tilesY, [&](int i) {
+        const SkIRect tile = SkIRect::MakeXYWH((i % tilesX) * fTileSize,
+                                               (i / tilesX) * fTileSize,
+                                               fTileSize, fTileSize);
+        // Each tile draws through its own canvas over all of the surface's pixels, restricted to
+        // the tile. Drawing in the surface's own device space (rather than translating into a
+        // tile-sized bitmap) keeps anti-aliasing identical to an untiled raster surface, and the
+        // restriction (unlike a clipRect) also holds across ResetClip ops, so concurrent tiles
+        // never write each other's pixels.
+        SkCanvas canvas(bitmap, this->props());
+        canvas.androidFramework_setDeviceClipRestriction(tile);
+        SkRecordDraw(record, &canvas, picts, nullptr, pictCount, &rtree, nullptr);
+    });
+    tg.wait();
+}
+
+void SkSurface_RasterTiled::restartRecording(int end) {
+    // Everything before end is now in our pixels. Of those ops, all we need to keep are the ones
+    // that establish the canvas's current state: top-level matrix and clip ops, and any saves (and
+    // the state ops within them) that haven't been restored yet. Closed save blocks and draws go.
+    // The ops from end on have not been drawn, so they are all kept.
+    TArray<int> live;
+    TArray<int> saves;  // Indices into live of each open save.
+    for (int i = 0; i < end; i++) {
+        switch (fRecord->visit(i, ClassifyOp())) {
+            case ClassifyOp::kDraw:
+                break;
+            case ClassifyOp::kSave:
+            case ClassifyOp::kSaveLayer:
+                saves.push_back(live.size());
+                live.push_back(i);
+                break;
+            case ClassifyOp::kRestore:
+                if (!saves.empty()) {
+                    live.resize(saves.back());
+                    saves.pop_back();
+                }
+                break;
+            case ClassifyOp::kState:
+                live.push_back(i);
+                break;
+        }
+    }
+
+    // Re-record the kept ops into a fresh SkRecord through the canvas itself, which resets the
+    // canvas and then rebuilds exactly the state it had.
+    const int count = fRecord->count();
+    std::unique_ptr<SkDrawableList> drawables = fRecorder->detachDrawableList();
+    fRecorder->restoreToCount(1);
+    sk_sp<SkRecord> old = std::exchange(fRecord, sk_make_sp<SkRecord>());
+    fRecorder->reset(fRecord.get(), SkRect::Make(this->imageInfo().bounds()));
+    SkRecords::Draw draw(fRecorder, nullptr, drawables ? drawables->begin() : nullptr,
+                         drawables ? drawables->count() : 0);
+    for (int i : live) {
+        old->visit(i, draw);
+    }
+    fResolvedOps = fRecord->count();
+    for (int i = end; i < count; i++) {
+        old->visit(i, draw);
+    }
+}
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+namespace SkSurfaces {
+
+sk_sp<SkSurface> RasterTiled(const SkImageInfo& info,
+                             SkExecutor* executor,
+                             int tileSize,
+                             const SkSurfaceProps* props) {
+    if (!SkSurfaceValidateRasterInfo(info) || tileSize < 0) {
+        return nullptr;
+    }
+
+    sk_sp<SkPixelRef> pr = SkMallocPixelRef::MakeAllocate(info, 0);
+    if (!pr) {
+        return nullptr;
+    }
+    return sk_make_sp<SkSurface_RasterTiled>(info, std::move(pr), executor,
+                                             tileSize ? tileSize : kDefaultTileSize, props);
+}
+
+}  // namespace SkSurfaces
@@ -2355,6 +2355,43 @@ STAGE(srcover_rgba_8888, const SkRasterPipeline_MemoryCtx* ctx) {
     store(ptr, dst);
 }
 
+// SkRasterPipeline fuses runs of ops into the stages below. Each must compute exactly what the run
+// it replaces does, so they are built from the same helpers as the separate stages.
+STAGE(fused_srcover_rgba_8888, const SkRasterPipeline_MemoryCtx* ctx) {
+    // load_8888_dst, srcover, store_8888
+    auto ptr = ptr_at_xy<uint32_t>(ctx, dx,dy);
+    from_8888(load<U32>(ptr), &dr,&dg,&db,&da);
+    r = srcover_channel(r,dr,a,da);
+    g = srcover_channel(g,dg,a,da);
+    b = srcover_channel(b,db,a,da);
+    a = srcover_channel(a,da,a,da);
+    store(ptr, to_unorm(r, 255)
+             | to_unorm(g, 255) <<  8
+             | to_unorm(b, 255) << 16
+             | to_unorm(a, 255) << 24);
+}
+STAGE(fused_srcover_bgra_8888, const SkRasterPipeline_MemoryCtx* ctx) {
+    // load_8888_dst, swap_rb_dst, srcover, swap_rb, store_8888
+    auto ptr = ptr_at_xy<uint32_t>(ctx, dx,dy);
+    from_8888(load<U32>(ptr), &db,&dg,&dr,&da);
+    r = srcover_channel(r,dr,a,da);
+    g = srcover_channel(g,dg,a,da);
+    b = srcover_channel(b,db,a,da);
+    a = srcover_channel(a,da,a,da);
+    store(ptr, to_unorm(b, 255)
+             | to_unorm(g, 255) <<  8
+             | to_unorm(r, 255) << 16
+             | to_unorm(a, 255) << 24);
+}
+STAGE(load_8888_premul, const SkRasterPipeline_MemoryCtx* ctx) {
+    // load_8888, premul
+    auto ptr = ptr_at_xy<const uint32_t>(ctx, dx,dy);
+    from_8888(load<U32>(ptr), &r,&g,&b,&a);
+    r = r * a;
+    g = g * a;
+    b = b * a;
+}
+
 SI F clamp_01_(F v) { return min(max(0.0f, v), 1.0f); }
 
 STAGE(clamp_01, NoCtx) {
@@ -6669,6 +6706,34 @@ STAGE_PP(srcover_rgba_8888, const SkRasterPipeline_MemoryCtx* ctx) {
     store_8888_(ptr, r,g,b,a);
 }
 
+// Fused runs of ops; see the highp versions above.
+STAGE_PP(fused_srcover_rgba_8888, const SkRasterPipeline_MemoryCtx* ctx) {
+    auto ptr = ptr_at_xy<uint32_t>(ctx, dx,dy);
+
+    load_8888_(ptr, &dr,&dg,&db,&da);
+    r = srcover_channel(r,dr,a,da);
+    g = srcover_channel(g,dg,a,da);
+    b = srcover_channel(b,db,a,da);
+    a = srcover_channel(a,da,a,da);
+    store_8888_(ptr, r,g,b,a);
+}
+STAGE_PP(fused_srcover_bgra_8888, const SkRasterPipeline_MemoryCtx* ctx) {
+    auto ptr = ptr_at_xy<uint32_t>(ctx, dx,dy);
+
+    load_8888_(ptr, &db,&dg,&dr,&da);
+    r = srcover_channel(r,dr,a,da);
+    g = srcover_channel(g,dg,a,da);
+    b = srcover_channel(b,db,a,da);
+    a = srcover_channel(a,da,a,da);
+    store_8888_(ptr, b,g,r,a);
+}
+STAGE_PP(load_8888_premul, const SkRasterPipeline_MemoryCtx* ctx) {
+    load_8888_(ptr_at_xy<const uint32_t>(ctx, dx,dy), &r,&g,&b,&a);
+    r = div255_accurate(r * a);
+    g = div255_accurate(g * a);
+    b = div255_accurate(b * a);
+}
+
 // ~~~~~~ skgpu::Swizzle stage ~~~~~~ //
 
 STAGE_PP(swizzle, void* ctx) {
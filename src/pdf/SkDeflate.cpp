@@ -7,16 +7,24 @@
 
 #include "src/pdf/SkDeflate.h"
 
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkRefCnt.h"
 #include "include/private/base/SkAssert.h"
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkMalloc.h"
+#include "include/private/base/SkSemaphore.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkTo.h"
+#include "src/encode/SkDeflateChunk.h"
 #include "src/core/SkTraceEvent.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include "zlib.h"  // NO_G3_REWRITE
 
@@ -37,6 +45,15 @@ template <typename T> void* skia_alloc_func(void*, T items, T size) {
 
 void skia_free_func(void*, void* address) { sk_free(address); }
 
+void init_z_stream(z_stream* zStream) {
+    zStream->next_in = nullptr;
+    zStream->zalloc = &skia_alloc_func;
+    zStream->zfree = &skia_free_func;
+    zStream->opaque = nullptr;
+}
+
+using SkDeflateChunk::kMaxDictionarySize;
+
 }  // namespace
 
 #define SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE 4096
@@ -67,37 +84,215 @@ static void do_deflate(int flush,
                  : returnValue == Z_OK);
 }
 
+// Compresses all of src in one go, as a complete zlib or gzip stream.
+static void deflate_all(SkWStream* out, const void* src, size_t size,
+                        int compressionLevel, bool gzip) {
+    z_stream zStream;
+    init_z_stream(&zStream);
+    SkDEBUGCODE(int r =) deflateInit2(&zStream, compressionLevel,
+                                      Z_DEFLATED, gzip ? 0x1F : 0x0F,
+                                      8, Z_DEFAULT_STRATEGY);
+    SkASSERT(Z_OK == r);
+    // zlib's avail_in is only 32 bits.
+    const unsigned char* bytes = static_cast<const unsigned char*>(src);
+    do {
+        size_t chunk = std::min<size_t>(size, 1 << 30);
+        size -= chunk;
+        do_deflate(size ? Z_NO_FLUSH : Z_FINISH, &zStream, out,
+                   const_cast<unsigned char*>(bytes), chunk);
+        bytes += chunk;
+    } while (size);
+    (void)deflateEnd(&zStream);
+}
+
+/**
+ *  One piece of the input in chunked mode. Each block is compressed as a raw deflate stream,
+ *  primed with the tail of the previous block's input, and ends with a sync flush (or, for the
+ *  last block, the final deflate block) so that the pieces can simply be concatenated. Its
+ *  checksum is computed alongside, to be combined with the others at the end.
+ *
+ *  Whichever thread claims a block first compresses it: a task on the executor, or the thread
+ *  calling finalize(), which never waits for a block that no thread has started.
+ */
+struct SkDeflateBlock : public SkRefCnt {
+    sk_sp<SkData> fInput;
+    sk_sp<SkDeflateBlock> fPrevious;  // Holds the dictionary; dropped once compressed.
+    int fCompressionLevel;
+    bool fGzip;
+    bool fLast;
+
+    std::atomic<bool> fClaimed{false};
+    SkSemaphore fDone;
+    SkDynamicMemoryWStream fOutput;
+    uLong fChecksum;
+
+    void compress() {
+        TRACE_EVENT0("skia", TRACE_FUNC);
+        const uint8_t* dictionary = nullptr;
+        size_t dictionarySize = 0;
+        if (fPrevious) {
+            const SkData& previous = *fPrevious->fInput;
+            dictionarySize = std::min(previous.size(), kMaxDictionarySize);
+            dictionary = previous.bytes() + previous.size() - dictionarySize;
+        }
+        const unsigned char* input = fInput->bytes();
+        const size_t size = fInput->size();
+        z_stream zStream;
+        init_z_stream(&zStream);
+        SkDEBUGCODE(bool ok =) SkDeflateChunk::Compress(&zStream, fCompressionLevel,
+                                                        Z_DEFAULT_STRATEGY,
+                                                        dictionary, dictionarySize,
+                                                        input, size, fLast, &fOutput);
+        SkASSERT(ok);
+        fPrevious = nullptr;
+
+        fChecksum = fGzip ? crc32(0, input, SkToUInt(size))
+                          : adler32(1, input, SkToUInt(size));
+        fDone.signal();
+    }
+
+    // Returns true if this thread should compress the block.
+    bool claim() { return !fClaimed.exchange(true, std::memory_order_acq_rel); }
+};
+
 // Hide all zlib impl details.
 struct SkDeflateWStream::Impl {
     SkWStream* fOut;
     unsigned char fInBuffer[SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE];
     size_t fInBufferIndex;
     z_stream fZStream;
+
+    int fCompressionLevel;
+    bool fGzip;
+    Compressor fCompressor;
+    SkExecutor* fExecutor;
+    size_t fBlockSize;
+
+    // Whole-buffer and chunked modes collect their input here instead of streaming it into
+    // fZStream. In chunked mode it never holds more than one block.
+    SkDynamicMemoryWStream fPending;
+    size_t fTotalIn = 0;
+    std::vector<sk_sp<SkDeflateBlock>> fBlocks;
+    sk_sp<SkDeflateBlock> fLastBlock;
+    size_t fBlocksWritten = 0;
+    uLong fChecksum;
+
+    bool buffered() const { return fCompressor || fExecutor; }
+
+    void dispatchBlock(bool last);
+    void writeBlock(SkDeflateBlock*);
+    void writeFinishedBlocks();
+    void finishChunked();
 };
 
+void SkDeflateWStream::Impl::dispatchBlock(bool last) {
+    auto block = sk_make_sp<SkDeflateBlock>();
+    block->fInput = fPending.detachAsData();
+    block->fPrevious = std::exchange(fLastBlock, block);
+    block->fCompressionLevel = fCompressionLevel;
+    block->fGzip = fGzip;
+    block->fLast = last;
+    fBlocks.push_back(block);
+    if (last) {
+        // finalize() is about to need it; there's no point in queueing it.
+        return;
+    }
+    fExecutor->add([block = std::move(block)] {
+        if (block->claim()) {
+            block->compress();
+        }
+    });
+}
+
+void SkDeflateWStream::Impl::writeBlock(SkDeflateBlock* block) {
+    if (fBlocksWritten == 0) {
+        if (fGzip) {
+            // No name, comment, or modification time; OS unknown.
+            static constexpr uint8_t kGzipHeader[] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+            fOut->write(kGzipHeader, sizeof(kGzipHeader));
+        } else {
+            const auto zlibHeader = SkDeflateChunk::ZlibHeader(fCompressionLevel);
+            fOut->write(zlibHeader.data(), zlibHeader.size());
+        }
+        fChecksum = block->fChecksum;
+    } else {
+        const z_off_t size = static_cast<z_off_t>(block->fInput->size());
+        fChecksum = fGzip ? crc32_combine(fChecksum, block->fChecksum, size)
+                          : adler32_combine(fChecksum, block->fChecksum, size);
+    }
+    block->fOutput.writeToAndReset(fOut);
+    fBlocksWritten++;
+}
+
+void SkDeflateWStream::Impl::writeFinishedBlocks() {
+    // Write out whatever leading blocks are done, in order, without waiting on any.
+    while (fBlocksWritten < fBlocks.size() && fBlocks[fBlocksWritten]->fDone.try_wait()) {
+        sk_sp<SkDeflateBlock> block = std::move(fBlocks[fBlocksWritten]);
+        this->writeBlock(block.get());
+    }
+}
+
+void SkDeflateWStream::Impl::finishChunked() {
+    this->dispatchBlock(/*last=*/true);
+    while (fBlocksWritten < fBlocks.size()) {
+        sk_sp<SkDeflateBlock> block = std::move(fBlocks[fBlocksWritten]);
+        if (block->claim()) {
+            block->compress();
+        }
+        block->fDone.wait();
+        this->writeBlock(block.get());
+    }
+    fBlocks.clear();
+    fLastBlock = nullptr;
+
+    const uint32_t checksum = SkToU32(fChecksum);
+    if (fGzip) {
+        // Little-endian CRC-32 and input size (mod 2^32).
+        const uint32_t size = SkToU32(fTotalIn & 0xFFFFFFFF);
+        const uint8_t trailer[] = {uint8_t(checksum), uint8_t(checksum >>  8),
+                                   uint8_t(checksum >> 16), uint8_t(checksum >> 24),
+                                   uint8_t(size), uint8_t(size >>  8),
+                                   uint8_t(size >> 16), uint8_t(size >> 24)};
+        fOut->write(trailer, sizeof(trailer));
+    } else {
+        const auto trailer = SkDeflateChunk::ZlibTrailer(checksum);
+        fOut->write(trailer.data(), trailer.size());
+    }
+}
+
 SkDeflateWStream::SkDeflateWStream(SkWStream* out,
                                    int compressionLevel,
                                    bool gzip)
+    : SkDeflateWStream(out, Options{compressionLevel, gzip}) {}
+
+SkDeflateWStream::SkDeflateWStream(SkWStream* out, const Options& options)
     : fImpl(std::make_unique<SkDeflateWStream::Impl>()) {
 
     // There has existed at some point at least one zlib implementation which thought it was being
     // clever by randomizing the compression level. This is actually not entirely incorrect, except
     // for the no-compression level which should always be deterministically pass-through.
     // Users should instead consider the zero compression level broken and handle it themselves.
+    const int compressionLevel = options.fCompressionLevel;
     SkASSERT(compressionLevel != 0);
 
     fImpl->fOut = out;
     fImpl->fInBufferIndex = 0;
+    fImpl->fCompressionLevel = compressionLevel;
+    fImpl->fGzip = options.fGzip;
+    fImpl->fCompressor = options.fGzip ? nullptr : options.fCompressor;
+    fImpl->fExecutor = fImpl->fCompressor ? nullptr : options.fExecutor;
+    fImpl->fBlockSize = std::max<size_t>(options.fBlockSize, kMaxDictionarySize);
+    fImpl->fZStream.total_in = 0;
     if (!fImpl->fOut) {
         return;
     }
-    fImpl->fZStream.next_in = nullptr;
-    fImpl->fZStream.zalloc = &skia_alloc_func;
-    fImpl->fZStream.zfree = &skia_free_func;
-    fImpl->fZStream.opaque = nullptr;
     SkASSERT(compressionLevel <= 9 && compressionLevel >= -1);
+    if (fImpl->buffered()) {
+        return;
+    }
+    init_z_stream(&fImpl->fZStream);
     SkDEBUGCODE(int r =) deflateInit2(&fImpl->fZStream, compressionLevel,
-                                      Z_DEFLATED, gzip ? 0x1F : 0x0F,
+                                      Z_DEFLATED, options.fGzip ? 0x1F : 0x0F,
                                       8, Z_DEFAULT_STRATEGY);
     SkASSERT(Z_OK == r);
 }
@@ -109,9 +304,29 @@ void SkDeflateWStream::finalize() {
     if (!fImpl->fOut) {
         return;
     }
-    do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fInBuffer,
-               fImpl->fInBufferIndex);
-    (void)deflateEnd(&fImpl->fZStream);
+    if (fImpl->fCompressor) {
+        sk_sp<SkData> input = fImpl->fPending.detachAsData();
+        SkDynamicMemoryWStream compressed;
+        if (fImpl->fCompressor(&compressed, input->data(), input->size(),
+                               fImpl->fCompressionLevel)) {
+            compressed.writeToAndReset(fImpl->fOut);
+        } else {
+            deflate_all(fImpl->fOut, input->data(), input->size(),
+                        fImpl->fCompressionLevel, fImpl->fGzip);
+        }
+    } else if (fImpl->fExecutor) {
+        if (fImpl->fBlocks.empty()) {
+            sk_sp<SkData> input = fImpl->fPending.detachAsData();
+            deflate_all(fImpl->fOut, input->data(), input->size(),
+                        fImpl->fCompressionLevel, fImpl->fGzip);
+        } else {
+            fImpl->finishChunked();
+        }
+    } else {
+        do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fInBuffer,
+                   fImpl->fInBufferIndex);
+        (void)deflateEnd(&fImpl->fZStream);
+    }
     fImpl->fOut = nullptr;
 }
 
@@ -121,6 +336,25 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
         return false;
     }
     const char* buffer = (const char*)void_buffer;
+    if (fImpl->buffered()) {
+        fImpl->fTotalIn += len;
+        if (!fImpl->fExecutor) {
+            return fImpl->fPending.write(buffer, len);
+        }
+        while (len > 0) {
+            // A full block is only sent off once there's more input, so that input of exactly
+            // one block is still compressed serially.
+            if (fImpl->fPending.bytesWritten() == fImpl->fBlockSize) {
+                fImpl->dispatchBlock(/*last=*/false);
+            }
+            size_t tocopy = std::min(len, fImpl->fBlockSize - fImpl->fPending.bytesWritten());
+            fImpl->fPending.write(buffer, tocopy);
+            len -= tocopy;
+            buffer += tocopy;
+        }
+        fImpl->writeFinishedBlocks();
+        return true;
+    }
     while (len > 0) {
         size_t tocopy =
                 std::min(len, sizeof(fImpl->fInBuffer) - fImpl->fInBufferIndex);
@@ -141,5 +375,8 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
 }
 
 size_t SkDeflateWStream::bytesWritten() const {
+    if (fImpl->buffered()) {
+        return fImpl->fTotalIn;
+    }
     return fImpl->fZStream.total_in + fImpl->fInBufferIndex;
 }
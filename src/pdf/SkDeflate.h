@@ -14,6 +14,8 @@
 
 #include <memory>
 
+class SkExecutor;
+
 /**
   * Wrap a stream in this class to compress the information written to
   * this stream using the Deflate algorithm.
@@ -22,6 +24,30 @@
   */
 class SkDeflateWStream final : public SkWStream {
 public:
+    /** Compresses size bytes at src in one call, writing a complete zlib
+        stream (RFC 1950) to dst. Returns false, having written nothing, if it
+        can't; the data is then compressed with zlib instead. */
+    using Compressor = bool (*)(SkWStream* dst, const void* src, size_t size,
+                                int compressionLevel);
+
+    struct Options {
+        /** As for the compressionLevel and gzip arguments below. */
+        int fCompressionLevel = -1;
+        bool fGzip = false;
+
+        /** If set, all input is buffered and handed to this at finalize().
+            Not used for gzip output. */
+        Compressor fCompressor = nullptr;
+
+        /** If set, input is split into blocks of fBlockSize bytes which are
+            compressed concurrently on this executor, each primed with the
+            last 32K of the block before it as its dictionary. The output is a
+            single ordinary zlib (or gzip) stream, slightly larger than a
+            serial one. Input shorter than one block is compressed serially. */
+        SkExecutor* fExecutor = nullptr;
+        size_t fBlockSize = 128 * 1024;
+    };
+
     /** Does not take ownership of the stream.
 
         @param compressionLevel 1 is best speed; 9 is best compression.
@@ -37,6 +63,8 @@ public:
                      int compressionLevel,
                      bool gzip = false);
 
+    SkDeflateWStream(SkWStream*, const Options&);
+
     /** The destructor calls finalize(). */
     ~SkDeflateWStream() override;
 
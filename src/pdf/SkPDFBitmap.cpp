@@ -130,7 +130,7 @@ void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndirectRefe
     SkWStream* stream = &buffer;
     std::optional<SkDeflateWStream> deflateWStream;
     if (format == SkPDFStreamFormat::Flate) {
-        deflateWStream.emplace(&buffer, SkToInt(compressionLevel));
+        deflateWStream.emplace(&buffer, doc->deflateOptions());
         stream = &*deflateWStream;
     }
     if (kAlpha_8_SkColorType == pm.colorType()) {
@@ -212,7 +212,7 @@ void do_deflated_image(const SkPixmap& pm,
     SkWStream* stream = &buffer;
     std::optional<SkDeflateWStream> deflateWStream;
     if (format == SkPDFStreamFormat::Flate) {
-        deflateWStream.emplace(&buffer, SkToInt(compressionLevel));
+        deflateWStream.emplace(&buffer, doc->deflateOptions());
         stream = &*deflateWStream;
     }
     SkPDFUnion colorSpace = SkPDFUnion::Name("DeviceGray");
@@ -392,12 +392,16 @@ SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
     SkASSERT(img);
     SkASSERT(doc);
     SkPDFIndirectReference ref = doc->reserveRef();
-    if (SkExecutor* executor = doc->executor()) {
+    SkExecutor* executor = doc->executor();
+    // Serializing may decode the image, so count its pixels against the budget.
+    const size_t bytes = img->imageInfo().computeMinByteSize();
+    if (executor && doc->reserveJobMemory(bytes)) {
         SkRef(img);
         doc->incrementJobCount();
-        executor->add([img, encodingQuality, doc, ref]() {
+        executor->add([img, encodingQuality, doc, ref, bytes]() {
             serialize_image(img, encodingQuality, doc, ref);
             SkSafeUnref(img);
+            doc->releaseJobMemory(bytes);
             doc->signalJobComplete();
         });
         return ref;
@@ -27,6 +27,7 @@
 #include "src/core/SkAdvancedTypefaceMetrics.h"
 #include "src/core/SkTHash.h"
 #include "src/pdf/SkBitmapKey.h"
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFBitmap.h"
 #include "src/pdf/SkPDFDevice.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
@@ -86,17 +87,27 @@ static size_t difference(size_t minuend, size_t subtrahend) {
     return SkASSERT(minuend >= subtrahend), minuend - subtrahend;
 }
 
-void SkPDFOffsetMap::markStartOfObject(int referenceNumber, const SkWStream* s) {
+int SkPDFOffsetMap::markStartOfObject(int referenceNumber, const SkWStream* s) {
     SkASSERT(referenceNumber > 0);
     size_t index = SkToSizeT(referenceNumber - 1);
-    if (index >= fOffsets.size()) {
-        fOffsets.resize(index + 1);
+    if (index >= fEntries.size()) {
+        fEntries.resize(index + 1);
     }
-    fOffsets[index] = SkToInt(difference(s->bytesWritten(), fBaseOffset));
+    fEntries[index] = {SkToInt(difference(s->bytesWritten(), fBaseOffset)), 0};
+    return fEntries[index].fOffset;
+}
+
+void SkPDFOffsetMap::markObjectInStream(int referenceNumber, int objectStream, int index) {
+    SkASSERT(referenceNumber > 0 && objectStream > 0);
+    size_t entry = SkToSizeT(referenceNumber - 1);
+    if (entry >= fEntries.size()) {
+        fEntries.resize(entry + 1);
+    }
+    fEntries[entry] = {index, objectStream};
 }
 
 int SkPDFOffsetMap::objectCount() const {
-    return SkToInt(fOffsets.size() + 1); // Include the special zeroth object in the count.
+    return SkToInt(fEntries.size() + 1); // Include the special zeroth object in the count.
 }
 
 int SkPDFOffsetMap::emitCrossReferenceTable(SkWStream* s) const {
@@ -104,13 +115,32 @@ int SkPDFOffsetMap::emitCrossReferenceTable(SkWStream* s) const {
     s->writeText("xref\n0 ");
     s->writeDecAsText(this->objectCount());
     s->writeText("\n0000000000 65535 f \n");
-    for (int offset : fOffsets) {
-        SkASSERT(offset > 0);  // Offset was set.
-        s->writeBigDecAsText(offset, 10);
+    for (const Entry& entry : fEntries) {
+        SkASSERT(entry.fOffset > 0 && !entry.fObjectStream);  // Offset was set.
+        s->writeBigDecAsText(entry.fOffset, 10);
         s->writeText(" 00000 n \n");
     }
     return xRefFileOffset;
 }
+
+void SkPDFOffsetMap::emitCrossReferenceStreamData(SkWStream* s) const {
+    auto writeEntry = [s](uint8_t type, uint32_t field2, uint16_t field3) {
+        const uint8_t bytes[7] = {type,
+                                  uint8_t(field2 >> 24), uint8_t(field2 >> 16),
+                                  uint8_t(field2 >>  8), uint8_t(field2 >>  0),
+                                  uint8_t(field3 >>  8), uint8_t(field3 >>  0)};
+        s->write(bytes, sizeof(bytes));
+    };
+    writeEntry(0, 0, 65535);  // The head of the (empty) free list.
+    for (const Entry& entry : fEntries) {
+        if (entry.fObjectStream) {
+            writeEntry(2, SkToU32(entry.fObjectStream), SkToU16(entry.fOffset));
+        } else {
+            SkASSERT(entry.fOffset > 0);  // Offset was set.
+            writeEntry(1, SkToU32(entry.fOffset), 0);
+        }
+    }
+}
 //
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -121,9 +151,11 @@ static_assert((SKPDF_MAGIC[1] & 0x7F) == "Skia"[1], "");
 static_assert((SKPDF_MAGIC[2] & 0x7F) == "Skia"[2], "");
 static_assert((SKPDF_MAGIC[3] & 0x7F) == "Skia"[3], "");
 #endif
-static void serializeHeader(SkPDFOffsetMap* offsetMap, SkWStream* wStream) {
+static void serializeHeader(SkPDFOffsetMap* offsetMap, SkWStream* wStream, bool objectStreams) {
     offsetMap->markStartOfDocument(wStream);
-    wStream->writeText("%PDF-1.4\n%" SKPDF_MAGIC "\n");
+    // Object streams and cross-reference streams are PDF 1.5.
+    wStream->writeText(objectStreams ? "%PDF-1.5\n%" SKPDF_MAGIC "\n"
+                                     : "%PDF-1.4\n%" SKPDF_MAGIC "\n");
     // The PDF spec recommends including a comment with four
     // bytes, all with their high bits set.  "\xD3\xEB\xE9\xE1" is
     // "Skia" with the high bits set.
@@ -140,6 +172,27 @@ static void begin_indirect_object(SkPDFOffsetMap* offsetMap,
 
 static void end_indirect_object(SkWStream* s) { s->writeText("\nendobj\n"); }
 
+static void insert_trailer_entries(SkPDFDict* trailerDict,
+                                   const SkPDFOffsetMap& offsetMap,
+                                   SkPDFIndirectReference infoDict,
+                                   SkPDFIndirectReference docCatalog,
+                                   SkUUID uuid) {
+    trailerDict->insertInt("Size", offsetMap.objectCount());
+    SkASSERT(docCatalog != SkPDFIndirectReference());
+    trailerDict->insertRef("Root", docCatalog);
+    SkASSERT(infoDict != SkPDFIndirectReference());
+    trailerDict->insertRef("Info", infoDict);
+    if (SkUUID() != uuid) {
+        trailerDict->insertObject("ID", SkPDFMetadata::MakePdfId(uuid, uuid));
+    }
+}
+
+static void serialize_startxref(SkWStream* wStream, int xRefFileOffset) {
+    wStream->writeText("startxref\n");
+    wStream->writeBigDecAsText(xRefFileOffset);
+    wStream->writeText("\n%%EOF\n");
+}
+
 // Xref table and footer
 static void serialize_footer(const SkPDFOffsetMap& offsetMap,
                              SkWStream* wStream,
@@ -148,32 +201,63 @@ static void serialize_footer(const SkPDFOffsetMap& offsetMap,
                              SkUUID uuid) {
     int xRefFileOffset = offsetMap.emitCrossReferenceTable(wStream);
     SkPDFDict trailerDict;
-    trailerDict.insertInt("Size", offsetMap.objectCount());
-    SkASSERT(docCatalog != SkPDFIndirectReference());
-    trailerDict.insertRef("Root", docCatalog);
-    SkASSERT(infoDict != SkPDFIndirectReference());
-    trailerDict.insertRef("Info", infoDict);
-    if (SkUUID() != uuid) {
-        trailerDict.insertObject("ID", SkPDFMetadata::MakePdfId(uuid, uuid));
-    }
+    insert_trailer_entries(&trailerDict, offsetMap, infoDict, docCatalog, uuid);
     wStream->writeText("trailer\n");
     trailerDict.emitObject(wStream);
-    wStream->writeText("\nstartxref\n");
-    wStream->writeBigDecAsText(xRefFileOffset);
-    wStream->writeText("\n%%EOF\n");
-}
+    wStream->writeText("\n");
+    serialize_startxref(wStream, xRefFileOffset);
+}
+
+// Xref stream and footer. The xref stream also takes the place of the trailer dictionary.
+static void serialize_xref_stream_footer(SkPDFOffsetMap* offsetMap,
+                                         SkWStream* wStream,
+                                         SkPDFIndirectReference infoDict,
+                                         SkPDFIndirectReference docCatalog,
+                                         SkUUID uuid,
+                                         SkPDFIndirectReference xrefStream,
+                                         SkPDF::Metadata::CompressionLevel compressionLevel) {
+    // The xref stream is listed in itself, so it has to be marked before writing the table.
+    int xRefFileOffset = offsetMap->markStartOfObject(xrefStream.fValue, wStream);
+
+    SkDynamicMemoryWStream table;
+    offsetMap->emitCrossReferenceStreamData(&table);
+
+    SkPDFDict xrefDict("XRef");
+    insert_trailer_entries(&xrefDict, *offsetMap, infoDict, docCatalog, uuid);
+    xrefDict.insertObject("W", SkPDFMakeArray(1, 4, 2));
+    if (compressionLevel != SkPDF::Metadata::CompressionLevel::None) {
+        SkDynamicMemoryWStream compressed;
+        SkDeflateWStream deflate(&compressed, SkToInt(compressionLevel));
+        table.writeToAndReset(&deflate);
+        deflate.finalize();
+        compressed.writeToAndReset(&table);
+        xrefDict.insertName("Filter", "FlateDecode");
+    }
+    xrefDict.insertInt("Length", table.bytesWritten());
+
+    wStream->writeDecAsText(xrefStream.fValue);
+    wStream->writeText(" 0 obj\n");
+    xrefDict.emitObject(wStream);
+    wStream->writeText(" stream\n");
+    table.writeToAndReset(wStream);
+    wStream->writeText("\nendstream");
+    end_indirect_object(wStream);
+    serialize_startxref(wStream, xRefFileOffset);
+}
+
+// PDF wants a tree describing all the pages in the document.  We arbitrary
+// choose 8 as the number of allowed children of each node.
+static constexpr size_t kPageTreeMaxNodeSize = 8;
 
 static SkPDFIndirectReference generate_page_tree(
         SkPDFDocument* doc,
         std::vector<std::unique_ptr<SkPDFDict>> pages,
         const std::vector<SkPDFIndirectReference>& pageRefs) {
-    // PDF wants a tree describing all the pages in the document.  We arbitrary
-    // choose 8 (kMaxNodeSize) as the number of allowed children.  The internal
-    // nodes have type "Pages" with an array of children, a parent pointer, and
-    // the number of leaves below the node as "Count."  The leaves are passed
-    // into the method, have type "Page" and need a parent pointer. This method
-    // builds the tree bottom up, skipping internal nodes that would have only
-    // one child.
+    // The internal nodes have type "Pages" with an array of children, a parent
+    // pointer, and the number of leaves below the node as "Count."  The leaves
+    // are passed into the method, have type "Page" and need a parent pointer.
+    // This method builds the tree bottom up, skipping internal nodes that would
+    // have only one child.
     SkASSERT(!pages.empty());
     struct PageTreeNode {
         std::unique_ptr<SkPDFDict> fNode;
@@ -182,10 +266,9 @@ static SkPDFIndirectReference generate_page_tree(
 
         static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
             std::vector<PageTreeNode> result;
-            static constexpr size_t kMaxNodeSize = 8;
             const size_t n = vec.size();
             SkASSERT(n >= 1);
-            const size_t result_len = (n - 1) / kMaxNodeSize + 1;
+            const size_t result_len = (n - 1) / kPageTreeMaxNodeSize + 1;
             SkASSERT(result_len >= 1);
             SkASSERT(n == 1 || result_len < n);
             result.reserve(result_len);
@@ -198,7 +281,7 @@ static SkPDFIndirectReference generate_page_tree(
                 SkPDFIndirectReference parent = doc->reserveRef();
                 auto kids_list = SkPDFMakeArray();
                 int descendantCount = 0;
-                for (size_t j = 0; j < kMaxNodeSize && index < n; ++j) {
+                for (size_t j = 0; j < kPageTreeMaxNodeSize && index < n; ++j) {
                     PageTreeNode& node = vec[index++];
                     node.fNode->insertRef("Parent", parent);
                     kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
@@ -227,6 +310,71 @@ static SkPDFIndirectReference generate_page_tree(
     return doc->emit(*root.fNode, root.fReservedRef);
 }
 
+// Unlike generate_page_tree(), this can't know which node will end up alone at the end of its
+// level, so it never skips a level; every node but the root is full, though.
+SkPDFIndirectReference SkPDFStreamingPageTree::nextParent(SkPDFDocument* doc) {
+    return this->openNode(doc, 0);
+}
+
+void SkPDFStreamingPageTree::addPage(SkPDFDocument* doc, SkPDFIndirectReference page) {
+    this->addKid(doc, 0, page, 1);
+}
+
+SkPDFIndirectReference SkPDFStreamingPageTree::openNode(SkPDFDocument* doc, size_t level) {
+    if (level == fLevels.size()) {
+        fLevels.emplace_back();
+    }
+    Node& node = fLevels[level];
+    if (node.fRef == SkPDFIndirectReference()) {
+        node.fRef = doc->reserveRef();
+        node.fKids = SkPDFMakeArray();
+        node.fKids->reserve(kPageTreeMaxNodeSize);
+    }
+    return node.fRef;
+}
+
+void SkPDFStreamingPageTree::addKid(SkPDFDocument* doc, size_t level,
+                                    SkPDFIndirectReference kid, int descendantCount) {
+    Node& node = fLevels[level];
+    SkASSERT(node.fRef != SkPDFIndirectReference());
+    node.fKids->appendRef(kid);
+    node.fDescendantCount += descendantCount;
+    if (node.fKids->size() == kPageTreeMaxNodeSize) {
+        // Write out full nodes right away. The root is only picked in finish(), so this one
+        // gets a parent, even if that turns out to be a root with a single kid.
+        SkPDFIndirectReference parent = this->openNode(doc, level + 1);
+        int count = fLevels[level].fDescendantCount;
+        this->addKid(doc, level + 1, this->closeNode(doc, level, parent), count);
+    }
+}
+
+SkPDFIndirectReference SkPDFStreamingPageTree::closeNode(SkPDFDocument* doc, size_t level,
+                                                         SkPDFIndirectReference parent) {
+    Node& node = fLevels[level];
+    auto pages = SkPDFMakeDict("Pages");
+    if (parent != SkPDFIndirectReference()) {
+        pages->insertRef("Parent", parent);
+    }
+    pages->insertInt("Count", node.fDescendantCount);
+    pages->insertObject("Kids", std::move(node.fKids));
+    SkPDFIndirectReference ref = doc->emit(*pages, node.fRef);
+    node = Node();
+    return ref;
+}
+
+SkPDFIndirectReference SkPDFStreamingPageTree::finish(SkPDFDocument* doc) {
+    SkASSERT(!fLevels.empty());
+    // Close the open nodes from the bottom up. The highest one is the root.
+    for (size_t level = 0; level + 1 < fLevels.size(); ++level) {
+        if (fLevels[level].fRef != SkPDFIndirectReference()) {
+            SkPDFIndirectReference parent = this->openNode(doc, level + 1);
+            int count = fLevels[level].fDescendantCount;
+            this->addKid(doc, level + 1, this->closeNode(doc, level, parent), count);
+        }
+    }
+    return this->closeNode(doc, fLevels.size() - 1, SkPDFIndirectReference());
+}
+
 template<typename T, typename... Args>
 static void reset_object(T* dst, Args&&... args) {
     dst->~T();
@@ -250,12 +398,59 @@ SkPDFDocument::~SkPDFDocument() {
 }
 
 SkPDFIndirectReference SkPDFDocument::emit(const SkPDFObject& object, SkPDFIndirectReference ref){
+    if (fMetadata.fObjectStreams) {
+        this->emitToObjectStream(object, ref);
+        return ref;
+    }
     SkAutoMutexExclusive lock(fMutex);
     object.emitObject(this->beginObject(ref));
     this->endObject();
     return ref;
 }
 
+// Enough objects to compress well, but not so many that a reader has to inflate a lot to get at
+// any one of them.
+static constexpr size_t kObjectsPerObjectStream = 100;
+
+void SkPDFDocument::emitToObjectStream(const SkPDFObject& object, SkPDFIndirectReference ref) {
+    std::unique_ptr<SkPDFObjectStreamBuffer> full;
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        if (!fObjectStream) {
+            fObjectStream = std::make_unique<SkPDFObjectStreamBuffer>();
+        }
+        SkPDFObjectStreamBuffer* buffer = fObjectStream.get();
+        buffer->fNumbers.push_back(ref.fValue);
+        buffer->fHeader.writeDecAsText(ref.fValue);
+        buffer->fHeader.writeText(" ");
+        buffer->fHeader.writeBigDecAsText(SkToS64(buffer->fObjects.bytesWritten()));
+        buffer->fHeader.writeText("\n");
+        object.emitObject(&buffer->fObjects);
+        buffer->fObjects.writeText("\n");
+        if (buffer->fNumbers.size() == kObjectsPerObjectStream) {
+            full = std::move(fObjectStream);
+        }
+    }
+    // Writing the object stream takes the lock again (or hands it off to the executor).
+    if (full) {
+        this->writeObjectStream(std::move(full));
+    }
+}
+
+void SkPDFDocument::writeObjectStream(std::unique_ptr<SkPDFObjectStreamBuffer> buffer) {
+    auto dict = SkPDFMakeDict("ObjStm");
+    dict->insertInt("N", SkToInt(buffer->fNumbers.size()));
+    dict->insertInt("First", SkToInt(buffer->fHeader.bytesWritten()));
+    buffer->fHeader.prependToAndReset(&buffer->fObjects);
+    SkPDFIndirectReference ref = SkPDFStreamOut(std::move(dict),
+                                                buffer->fObjects.detachAsStream(), this);
+
+    SkAutoMutexExclusive lock(fMutex);
+    for (size_t i = 0; i < buffer->fNumbers.size(); ++i) {
+        fOffsetMap.markObjectInStream(buffer->fNumbers[i], ref.fValue, SkToInt(i));
+    }
+}
+
 SkWStream* SkPDFDocument::beginObject(SkPDFIndirectReference ref) SK_REQUIRES(fMutex) {
     begin_indirect_object(&fOffsetMap, ref, this->getStream());
     return this->getStream();
@@ -270,11 +465,11 @@ static SkSize operator*(SkSize u, SkScalar s) { return SkSize{u.width() * s, u.h
 
 SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         // if this is the first page if the document.
         {
             SkAutoMutexExclusive autoMutexAcquire(fMutex);
-            serializeHeader(&fOffsetMap, this->getStream());
+            serializeHeader(&fOffsetMap, this->getStream(), fMetadata.fObjectStreams);
 
         }
 
@@ -399,7 +594,12 @@ void SkPDFDocument::onEndPage() {
     // Tabs is PDF 1.5, but setting it checks an accessibility box.
     page->insertName("Tabs", "S");
 
-    fPages.emplace_back(std::move(page));
+    if (fMetadata.fStreaming) {
+        page->insertRef("Parent", fStreamingPageTree.nextParent(this));
+        fStreamingPageTree.addPage(this, this->emit(*page, fPageRefs.back()));
+    } else {
+        fPages.emplace_back(std::move(page));
+    }
     fPageDevice = nullptr;
 }
 
@@ -612,7 +812,7 @@ SkString SkPDFDocument::nextFontSubsetTag() {
 
 void SkPDFDocument::onClose(SkWStream* stream) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         this->waitForJobs();
         return;
     }
@@ -625,7 +825,10 @@ void SkPDFDocument::onClose(SkWStream* stream) {
         docCatalog->insertObject("OutputIntents", make_srgb_output_intents(this));
     }
 
-    docCatalog->insertRef("Pages", generate_page_tree(this, std::move(fPages), fPageRefs));
+    SkPDFIndirectReference pageTree = fMetadata.fStreaming
+                                    ? fStreamingPageTree.finish(this)
+                                    : generate_page_tree(this, std::move(fPages), fPageRefs);
+    docCatalog->insertRef("Pages", pageTree);
 
     if (!fNamedDestinations.empty()) {
         docCatalog->insertRef("Dests", append_destinations(this, fNamedDestinations));
@@ -667,9 +870,19 @@ void SkPDFDocument::onClose(SkWStream* stream) {
     }
 
     this->waitForJobs();
+    if (fObjectStream) {
+        // Jobs can emit objects too, so the last object stream waits until they're all done.
+        this->writeObjectStream(std::move(fObjectStream));
+        this->waitForJobs();
+    }
     {
         SkAutoMutexExclusive autoMutexAcquire(fMutex);
-        serialize_footer(fOffsetMap, this->getStream(), fInfoDict, docCatalogRef, fUUID);
+        if (fMetadata.fObjectStreams) {
+            serialize_xref_stream_footer(&fOffsetMap, this->getStream(), fInfoDict, docCatalogRef,
+                                         fUUID, this->reserveRef(), fMetadata.fCompressionLevel);
+        } else {
+            serialize_footer(fOffsetMap, this->getStream(), fInfoDict, docCatalogRef, fUUID);
+        }
     }
 }
 
@@ -677,6 +890,33 @@ void SkPDFDocument::incrementJobCount() { fJobCount++; }
 
 void SkPDFDocument::signalJobComplete() { fSemaphore.signal(); }
 
+SkDeflateWStream::Options SkPDFDocument::deflateOptions() const {
+    SkASSERT(fMetadata.fCompressionLevel != SkPDF::Metadata::CompressionLevel::None);
+    SkDeflateWStream::Options options;
+    options.fCompressionLevel = SkToInt(fMetadata.fCompressionLevel);
+    options.fCompressor = fMetadata.deflater;
+    options.fExecutor = fExecutor;
+    return options;
+}
+
+bool SkPDFDocument::reserveJobMemory(size_t bytes) {
+    const size_t budget = fMetadata.fMemoryBudget;
+    size_t pending = fJobMemory.load(std::memory_order_relaxed);
+    do {
+        // With nothing pending, queue the work anyway: doing it now would hold as much memory.
+        if (budget && pending && (pending > budget || bytes > budget - pending)) {
+            return false;
+        }
+    } while (!fJobMemory.compare_exchange_weak(pending, pending + bytes,
+                                               std::memory_order_relaxed));
+    return true;
+}
+
+void SkPDFDocument::releaseJobMemory(size_t bytes) {
+    SkASSERT(fJobMemory.load(std::memory_order_relaxed) >= bytes);
+    fJobMemory.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
 void SkPDFDocument::waitForJobs() {
      // fJobCount can increase while we wait.
      while (fJobCount > 0) {
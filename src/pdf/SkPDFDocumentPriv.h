@@ -24,6 +24,7 @@
 #include "include/private/base/SkSemaphore.h"
 #include "src/base/SkUTF.h"
 #include "src/core/SkTHash.h"
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFBitmap.h"
 #include "src/pdf/SkPDFFont.h"
 #include "src/pdf/SkPDFGraphicState.h"
@@ -41,6 +42,7 @@
 class SkDescriptor;
 class SkExecutor;
 class SkPDFDevice;
+class SkPDFDocument;
 struct SkAdvancedTypefaceMetrics;
 struct SkBitmapKey;
 class SkMatrix;
@@ -56,14 +58,56 @@ const char* SkPDFGetElemIdKey();
 class SkPDFOffsetMap {
 public:
     void markStartOfDocument(const SkWStream*);
-    void markStartOfObject(int referenceNumber, const SkWStream*);
+    // Returns the object's offset from the start of the document.
+    int markStartOfObject(int referenceNumber, const SkWStream*);
+    // Records that the object is the index'th object in the object stream objectStream.
+    void markObjectInStream(int referenceNumber, int objectStream, int index);
     int objectCount() const;
     int emitCrossReferenceTable(SkWStream* s) const;
+    // Writes the (uncompressed) data of a cross-reference stream, with /W [1 4 2].
+    void emitCrossReferenceStreamData(SkWStream* s) const;
 private:
-    std::vector<int> fOffsets;
+    struct Entry {
+        int fOffset = 0;        // Or, if fObjectStream is set, the index within it.
+        int fObjectStream = 0;
+    };
+    std::vector<Entry> fEntries;
     size_t fBaseOffset = SIZE_MAX;
 };
 
+// Objects waiting to be packed into an object stream (see SkPDF::Metadata::fObjectStreams).
+struct SkPDFObjectStreamBuffer {
+    SkDynamicMemoryWStream fHeader;   // Pairs of object number and offset into fObjects.
+    SkDynamicMemoryWStream fObjects;
+    std::vector<int> fNumbers;
+};
+
+// Also logically part of SkPDFDocument. In streaming mode, builds the page tree as pages are
+// added: each page and each full node is written as soon as it is complete, so only the one
+// partially filled node at each level of the tree is kept in memory.
+class SkPDFStreamingPageTree {
+public:
+    // Returns the node to use as the /Parent of the next page, reserving it if needed.
+    SkPDFIndirectReference nextParent(SkPDFDocument*);
+    // Adds a page, already written with nextParent() as its /Parent, to that node.
+    void addPage(SkPDFDocument*, SkPDFIndirectReference page);
+    // Writes the nodes that are not yet full and returns the root of the tree.
+    SkPDFIndirectReference finish(SkPDFDocument*);
+
+private:
+    struct Node {
+        SkPDFIndirectReference fRef;  // Unset if there is no open node at this level.
+        std::unique_ptr<SkPDFArray> fKids;
+        int fDescendantCount = 0;
+    };
+    // The open node at each level of the tree, starting with the parents of pages.
+    std::vector<Node> fLevels;
+
+    SkPDFIndirectReference openNode(SkPDFDocument*, size_t level);
+    void addKid(SkPDFDocument*, size_t level, SkPDFIndirectReference kid, int descendantCount);
+    SkPDFIndirectReference closeNode(SkPDFDocument*, size_t level, SkPDFIndirectReference parent);
+};
+
 
 struct SkPDFNamedDestination {
     sk_sp<SkData> fName;
@@ -155,9 +199,16 @@ public:
     SkString nextFontSubsetTag();
 
     SkExecutor* executor() const { return fExecutor; }
+    // How to deflate a stream at the metadata's fCompressionLevel (which must not be None).
+    SkDeflateWStream::Options deflateOptions() const;
     void incrementJobCount();
     void signalJobComplete();
-    size_t currentPageIndex() { return fPages.size(); }
+    // Called before queuing work on executor() that holds about `bytes` of memory until it runs.
+    // Returns false if that would go over the metadata's fMemoryBudget, in which case the caller
+    // should do the work right away instead. Otherwise call releaseJobMemory() when it's done.
+    bool reserveJobMemory(size_t bytes);
+    void releaseJobMemory(size_t bytes);
+    size_t currentPageIndex() { return fPageRefs.size() - (this->hasCurrentPage() ? 1 : 0); }
     size_t pageCount() { return fPageRefs.size(); }
 
     const SkMatrix& currentPageTransform() const;
@@ -194,12 +245,14 @@ public:
 private:
     SkPDFOffsetMap fOffsetMap;
     SkCanvas fCanvas;
-    std::vector<std::unique_ptr<SkPDFDict>> fPages;
+    std::vector<std::unique_ptr<SkPDFDict>> fPages;  // Unused in streaming mode.
     std::vector<SkPDFIndirectReference> fPageRefs;
+    SkPDFStreamingPageTree fStreamingPageTree;
 
     sk_sp<SkPDFDevice> fPageDevice;
     std::atomic<int> fNextObjectNumber = {1};
     std::atomic<int> fJobCount = {0};
+    std::atomic<size_t> fJobMemory = {0};
     uint32_t fNextFontSubsetTag = {0};
     SkUUID fUUID;
     SkPDFIndirectReference fInfoDict;
@@ -215,9 +268,14 @@ private:
     SkMutex fMutex;
     SkSemaphore fSemaphore;
 
+    // Only used when packing objects into object streams.
+    std::unique_ptr<SkPDFObjectStreamBuffer> fObjectStream;
+
     void waitForJobs();
     SkWStream* beginObject(SkPDFIndirectReference);
     void endObject();
+    void emitToObjectStream(const SkPDFObject&, SkPDFIndirectReference);
+    void writeObjectStream(std::unique_ptr<SkPDFObjectStreamBuffer>);
 };
 
 #endif  // SkPDFDocumentPriv_DEFINED
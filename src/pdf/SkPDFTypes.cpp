@@ -566,7 +566,7 @@ static void serialize_stream(SkPDFDict* origDict,
         stream->getLength() > kMinimumSavings)
     {
         SkDynamicMemoryWStream compressedData;
-        SkDeflateWStream deflateWStream(&compressedData,SkToInt(doc->metadata().fCompressionLevel));
+        SkDeflateWStream deflateWStream(&compressedData, doc->deflateOptions());
         SkStreamCopy(&deflateWStream, stream);
         deflateWStream.finalize();
         if (stream->getLength() > compressedData.bytesWritten() + kMinimumSavings) {
@@ -589,16 +589,19 @@ SkPDFIndirectReference SkPDFStreamOut(std::unique_ptr<SkPDFDict> dict,
                                       SkPDFDocument* doc,
                                       SkPDFSteamCompressionEnabled compress) {
     SkPDFIndirectReference ref = doc->reserveRef();
-    if (SkExecutor* executor = doc->executor()) {
+    SkExecutor* executor = doc->executor();
+    const size_t bytes = content->getLength();
+    if (executor && doc->reserveJobMemory(bytes)) {
         SkPDFDict* dictPtr = dict.release();
         SkStreamAsset* contentPtr = content.release();
         // Pass ownership of both pointers into a std::function, which should
         // only be executed once.
         doc->incrementJobCount();
-        executor->add([dictPtr, contentPtr, compress, doc, ref]() {
+        executor->add([dictPtr, contentPtr, compress, doc, ref, bytes]() {
             serialize_stream(dictPtr, contentPtr, compress, doc, ref);
             delete dictPtr;
             delete contentPtr;
+            doc->releaseJobMemory(bytes);
             doc->signalJobComplete();
         });
         return ref;
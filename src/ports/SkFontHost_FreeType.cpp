@@ -461,13 +461,17 @@ public:
     SkScalerContext_FreeType(const SkTypeface_FreeType& realTypeface,
                              const SkScalerContextEffects&,
                              const SkDescriptor* desc,
-                             SkTypeface& proxyTypeface);
+                             SkTypeface& proxyTypeface,
+                             bool ownFace = false);
     ~SkScalerContext_FreeType() override;
 
     bool success() const {
         return fFTSize != nullptr && fFace != nullptr;
     }
 
+    uint32_t getScalerVersion() const override;
+    std::unique_ptr<SkScalerContext> makeConcurrentContext(const SkDescriptor&) const override;
+
 protected:
     GlyphMetrics generateMetrics(const SkGlyph&, SkArenaAlloc*) override;
     void generateImage(const SkGlyph&, void*) override;
@@ -486,7 +490,14 @@ private:
     // This value was chosen by eyeballing the result in Firefox and trying to match it.
     static const FT_Pos kBitmapEmboldenStrength = 1 << 6;
 
-    SkTypeface_FreeType::FaceRec* fFaceRec; // Borrowed face from the typeface's FaceRec.
+    const SkTypeface_FreeType& fRealTypeface;  // Owned by the proxy typeface.
+    // The contexts of a typeface share its FaceRec, so using the face takes f_t_mutex(). A
+    // context made by makeConcurrentContext() has a face of its own instead, which only it uses,
+    // so that it can make glyphs while other threads use theirs. The face is one of the
+    // typeface's spares if it has one, and is given back to it when the context is deleted.
+    std::unique_ptr<SkTypeface_FreeType::FaceRec> fOwnFaceRec;
+    SkMutex   fOwnFaceMutex;
+    SkTypeface_FreeType::FaceRec* fFaceRec; // The typeface's FaceRec or fOwnFaceRec.
     FT_Face   fFace;  // Borrowed face from fFaceRec.
     FT_Size   fFTSize;  // The size to apply to the fFace.
     FT_Int    fStrikeIndex; // The bitmap strike for the fFace (or -1 if none).
@@ -507,14 +518,16 @@ private:
     bool      fDoLinearMetrics;
     bool      fLCDIsVert;
 
+    // The lock to hold while using fFace.
+    SkMutex& faceMutex() { return fOwnFaceRec ? fOwnFaceMutex : f_t_mutex(); }
     FT_Error setupSize();
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock faceMutex() before calling this function.
     static bool getBoundsOfCurrentOutlineGlyph(FT_GlyphSlot glyph, SkRect* bounds);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock faceMutex() before calling this function.
     bool getCBoxForLetter(char letter, FT_BBox* bbox);
     static void updateGlyphBoundsIfSubpixel(const SkGlyph&, SkRect* bounds, bool subpixel);
     void updateGlyphBoundsIfLCD(GlyphMetrics* mx);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock faceMutex() before calling this function.
     // update FreeType2 glyph slot with glyph emboldened
     bool emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph, SkGlyphID gid);
     bool shouldSubpixelBitmap(const SkGlyph&, const SkMatrix&);
@@ -919,14 +932,21 @@ static FT_Int chooseBitmapStrike(FT_Face face, FT_F26Dot6 scaleY) {
 SkScalerContext_FreeType::SkScalerContext_FreeType(const SkTypeface_FreeType& realTypeface,
                                                    const SkScalerContextEffects& effects,
                                                    const SkDescriptor* desc,
-                                                   SkTypeface& proxyTypeface)
+                                                   SkTypeface& proxyTypeface,
+                                                   bool ownFace)
     : SkScalerContext(proxyTypeface, effects, desc)
+    , fRealTypeface(realTypeface)
     , fFace(nullptr)
     , fFTSize(nullptr)
     , fStrikeIndex(-1)
 {
     SkAutoMutexExclusive  ac(f_t_mutex());
-    fFaceRec = realTypeface.getFaceRec();  // The proxyTypeface owns the realTypeface.
+    if (ownFace) {
+        fOwnFaceRec = realTypeface.takeSpareFaceRec();
+        fFaceRec = fOwnFaceRec.get();
+    } else {
+        fFaceRec = realTypeface.getFaceRec();  // The proxyTypeface owns the realTypeface.
+    }
 
     // load the font file
     if (nullptr == fFaceRec) {
@@ -1110,13 +1130,34 @@ SkScalerContext_FreeType::~SkScalerContext_FreeType() {
     }
 
     fFaceRec = nullptr;
+    if (fOwnFaceRec) {
+        fRealTypeface.returnSpareFaceRec(std::move(fOwnFaceRec));
+    }
+}
+
+uint32_t SkScalerContext_FreeType::getScalerVersion() const {
+    SkAutoMutexExclusive ac(f_t_mutex());
+    // Our typeface's FaceRec keeps the library alive.
+    FT_Int major, minor, patch;
+    FT_Library_Version(gFTLibrary->library(), &major, &minor, &patch);
+    return SkToU32((major << 16) | (minor << 8) | patch);
+}
+
+std::unique_ptr<SkScalerContext> SkScalerContext_FreeType::makeConcurrentContext(
+        const SkDescriptor& desc) const {
+    auto context = std::make_unique<SkScalerContext_FreeType>(
+            fRealTypeface, this->getEffects(), &desc, *this->getTypeface(), /*ownFace=*/true);
+    if (context->success()) {
+        return context;
+    }
+    return this->SkScalerContext::makeConcurrentContext(desc);
 }
 
 /*  We call this before each use of the fFace, since we may be sharing
     this face with other context (at different sizes).
 */
 FT_Error SkScalerContext_FreeType::setupSize() {
-    f_t_mutex().assertHeld();
+    this->faceMutex().assertHeld();
     FT_Error err = FT_Activate_Size(fFTSize);
     if (err != 0) {
         return err;
@@ -1196,7 +1237,7 @@ bool SkScalerContext_FreeType::shouldSubpixelBitmap(const SkGlyph& glyph, const
 
 SkScalerContext::GlyphMetrics SkScalerContext_FreeType::generateMetrics(const SkGlyph& glyph,
                                                                         SkArenaAlloc* alloc) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(this->faceMutex());
 
     GlyphMetrics mx(glyph.maskFormat());
 
@@ -1375,7 +1416,7 @@ SkScalerContext::GlyphMetrics SkScalerContext_FreeType::generateMetrics(const Sk
 }
 
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph, void* imageBuffer) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(this->faceMutex());
 
     if (this->setupSize()) {
         sk_bzero(imageBuffer, glyph.imageSize());
@@ -1448,7 +1489,7 @@ sk_sp<SkDrawable> SkScalerContext_FreeType::generateDrawable(const SkGlyph& glyp
     // It should be possible to draw the drawable straight out of the FT_Face. However, this would
     // mean locking each time any such drawable is drawn. To avoid locking, this implementation
     // creates drawables backed as pictures so that they can be played back later without locking.
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(this->faceMutex());
 
     if (this->setupSize()) {
         return nullptr;
@@ -1499,7 +1540,7 @@ sk_sp<SkDrawable> SkScalerContext_FreeType::generateDrawable(const SkGlyph& glyp
 bool SkScalerContext_FreeType::generatePath(const SkGlyph& glyph, SkPath* path, bool* modified) {
     SkASSERT(path);
 
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(this->faceMutex());
 
     SkGlyphID glyphID = glyph.getGlyphID();
     // FT_IS_SCALABLE is documented to mean the face contains outline glyphs.
@@ -1542,7 +1583,7 @@ void SkScalerContext_FreeType::generateFontMetrics(SkFontMetrics* metrics) {
         return;
     }
 
-    SkAutoMutexExclusive ac(f_t_mutex());
+    SkAutoMutexExclusive ac(this->faceMutex());
 
     if (this->setupSize()) {
         sk_bzero(metrics, sizeof(*metrics));
@@ -1730,9 +1771,10 @@ SkTypeface_FreeType::SkTypeface_FreeType(const SkFontStyle& style, bool isFixedP
 {}
 
 SkTypeface_FreeType::~SkTypeface_FreeType() {
-    if (fFaceRec) {
+    if (fFaceRec || !fSpareFaceRecs.empty()) {
         SkAutoMutexExclusive ac(f_t_mutex());
         fFaceRec.reset();
+        fSpareFaceRecs.clear();
     }
 }
 
@@ -1960,6 +2002,25 @@ SkTypeface_FreeType::FaceRec* SkTypeface_FreeType::getFaceRec() const {
     return fFaceRec.get();
 }
 
+std::unique_ptr<SkTypeface_FreeType::FaceRec> SkTypeface_FreeType::takeSpareFaceRec() const {
+    f_t_mutex().assertHeld();
+    if (fSpareFaceRecs.empty()) {
+        return SkTypeface_FreeType::FaceRec::Make(this);
+    }
+    std::unique_ptr<FaceRec> rec = std::move(fSpareFaceRecs.back());
+    fSpareFaceRecs.pop_back();
+    return rec;
+}
+
+void SkTypeface_FreeType::returnSpareFaceRec(std::unique_ptr<FaceRec> rec) const {
+    f_t_mutex().assertHeld();
+    // About as many as there are threads making glyphs at once.
+    static constexpr int kMaxSpareFaceRecs = 8;
+    if (fSpareFaceRecs.size() < kMaxSpareFaceRecs) {
+        fSpareFaceRecs.push_back(std::move(rec));
+    }
+}
+
 std::unique_ptr<SkFontData> SkTypeface_FreeType::makeFontData() const {
     return this->onMakeFontData();
 }
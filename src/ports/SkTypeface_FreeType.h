@@ -38,6 +38,9 @@ public:
     std::unique_ptr<SkFontData> makeFontData() const;
     class FaceRec;
     FaceRec* getFaceRec() const;
+    /** A FaceRec for one scaler context to use by itself, one returned earlier if there is one. */
+    std::unique_ptr<FaceRec> takeSpareFaceRec() const;
+    void returnSpareFaceRec(std::unique_ptr<FaceRec>) const;
 
     static constexpr SkTypeface::FactoryId FactoryId = SkSetFourByteTag('f','r','e','e');
     static sk_sp<SkTypeface> MakeFromStream(std::unique_ptr<SkStreamAsset>, const SkFontArguments&);
@@ -84,6 +87,9 @@ protected:
 private:
     mutable SkOnce fFTFaceOnce;
     mutable std::unique_ptr<FaceRec> fFaceRec;
+    // FaceRecs of scaler contexts that made glyphs alongside others, kept so that the next ones
+    // don't have to open the font again. Guarded by f_t_mutex().
+    mutable skia_private::TArray<std::unique_ptr<FaceRec>> fSpareFaceRecs;
 
     mutable SkSharedMutex fC2GCacheMutex;
     mutable SkCharToGlyphCache fC2GCache;
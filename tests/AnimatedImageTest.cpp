@@ -13,6 +13,8 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkRect.h"
@@ -27,6 +29,7 @@
 #include "tools/ToolUtils.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <utility>
@@ -286,6 +289,53 @@ DEF_TEST(AnimatedImage_copyOnWrite, r) {
     }
 }
 
+DEF_TEST(AnimatedImage_prefetch, r) {
+    if (GetResourcePath().isEmpty()) {
+        return;
+    }
+    auto executor = SkExecutor::MakeFIFOThreadPool(1);
+    for (const char* file : { "images/alphabetAnim.gif",
+                              "images/colorTables.gif",
+                              "images/stoplight.webp",
+                              "images/required.webp",
+                              }) {
+        auto data = GetResourceAsData(file);
+        if (!data) {
+            ERRORF(r, "Could not get %s", file);
+            continue;
+        }
+
+        auto serial     = SkAnimatedImage::Make(SkAndroidCodec::MakeFromData(data));
+        auto prefetched = SkAnimatedImage::Make(SkAndroidCodec::MakeFromData(data));
+        if (!serial || !prefetched) {
+            ERRORF(r, "Could not create animated images for %s", file);
+            continue;
+        }
+        prefetched->setPrefetchExecutor(executor.get(), SIZE_MAX);
+
+        // Play through twice, holding on to each frame while the next one is decoded ahead.
+        serial->setRepetitionCount(1);
+        prefetched->setRepetitionCount(1);
+        for (int i = 0; !serial->isFinished(); i++) {
+            sk_sp<SkImage> expected = serial->getCurrentFrame();
+            sk_sp<SkImage> actual   = prefetched->getCurrentFrame();
+            SkBitmap expectedBm, actualBm;
+            if (!expected || !actual ||
+                !expected->asLegacyBitmap(&expectedBm) || !actual->asLegacyBitmap(&actualBm)) {
+                ERRORF(r, "Could not read frame %i of %s", i, file);
+                break;
+            }
+            if (!compare_bitmaps(r, file, i, expectedBm, actualBm)) {
+                break;
+            }
+
+            const int duration = serial->decodeNextFrame();
+            REPORTER_ASSERT(r, prefetched->decodeNextFrame() == duration);
+            REPORTER_ASSERT(r, prefetched->isFinished() == serial->isFinished());
+        }
+    }
+}
+
 DEF_TEST(AnimatedImage, r) {
     if (GetResourcePath().isEmpty()) {
         return;
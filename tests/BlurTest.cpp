@@ -11,6 +11,8 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkColorType.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkPaint.h"
@@ -25,6 +27,7 @@
 #include "include/core/SkSize.h"
 #include "include/core/SkSurface.h"
 #include "include/core/SkTypes.h"
+#include "include/effects/SkImageFilters.h"
 #include "include/effects/SkPerlinNoiseShader.h"
 #include "include/gpu/GpuTypes.h"
 #include "include/gpu/ganesh/GrDirectContext.h"
@@ -45,9 +48,13 @@
 #include <math.h>
 #include <string.h>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
+#include <memory>
 
 struct GrContextOptions;
 
@@ -587,3 +594,64 @@ DEF_TEST(zero_blur, reporter) {
     SkIPoint offset;
     bitmap.extractAlpha(&alpha, &paint, nullptr, &offset);
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////
+
+DEF_SERIAL_TEST(BlurParallelBands, reporter) {
+    // Forwards work to a thread pool, counting how many tasks the blurs split into.
+    class CountingExecutor final : public SkExecutor {
+    public:
+        CountingExecutor() : fPool(SkExecutor::MakeFIFOThreadPool(4)) {}
+        void add(std::function<void(void)> work) override {
+            fTasks++;
+            fPool->add(std::move(work));
+        }
+        void borrow() override { fPool->borrow(); }
+
+        std::atomic<int> fTasks{0};
+
+    private:
+        std::unique_ptr<SkExecutor> fPool;
+    };
+
+    SkPath star;
+    for (int i = 0; i < 10; ++i) {
+        float r = (i & 1) ? 120 : 300,
+              a = i * SK_FloatPI / 5;
+        SkPoint p = {320 + r * std::cos(a), 320 + r * std::sin(a)};
+        i ? star.lineTo(p) : star.moveTo(p);
+    }
+
+    auto draw = [&] {
+        auto surf = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(640, 640));
+        SkCanvas* canvas = surf->getCanvas();
+        canvas->clear(SK_ColorWHITE);
+
+        SkPaint paint;
+        paint.setColor(0xFF3366CC);
+        paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, 12));
+        canvas->drawPath(star, paint);
+
+        paint.setMaskFilter(nullptr);
+        paint.setColor(0x80CC3366);
+        paint.setImageFilter(SkImageFilters::Blur(20, 8, nullptr));
+        canvas->drawPath(star, paint);
+
+        SkBitmap bm;
+        bm.allocPixels(surf->imageInfo());
+        surf->readPixels(bm, 0, 0);
+        return bm;
+    };
+
+    SkBitmap serial = draw();
+
+    CountingExecutor executor;
+    SkExecutor::SetDefault(&executor);
+    size_t oldThreshold = SkGraphics::SetRasterBlurParallelThreshold(1);
+    SkBitmap parallel = draw();
+    SkGraphics::SetRasterBlurParallelThreshold(oldThreshold);
+    SkExecutor::SetDefault(nullptr);
+
+    REPORTER_ASSERT(reporter, executor.fTasks.load() > 0);
+    REPORTER_ASSERT(reporter, ToolUtils::equal_pixels(serial, parallel));
+}
@@ -11,6 +11,7 @@
 #include "include/codec/SkEncodedOrigin.h"
 #include "include/core/SkAlphaType.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkColor.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkImage.h"
@@ -21,6 +22,8 @@
 #include "include/core/SkSize.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
+#include "src/codec/SkCodecFrameCache.h"
+#include "src/core/SkResourceCache.h"
 #include "tests/CodecPriv.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
@@ -581,6 +584,64 @@ DEF_TEST(AndroidCodec_animated_gif, r) {
     test_animated_AndroidCodec(r, "images/required.gif");
 }
 
+// Codecs of the same animation share decoded frames, even from separate copies of the data.
+DEF_TEST(Codec_sharedFrames, r) {
+    for (const char* file : { "images/required.webp",
+                              "images/required.gif",
+                              "images/alphabetAnim.gif" }) {
+        sk_sp<SkData> data(GetResourceAsData(file));
+        if (!data) {
+            continue;
+        }
+        sk_sp<SkData> copy = SkData::MakeWithCopy(data->data(), data->size());
+        const uint64_t dataID = SkCodecFrameCache::DataID(data->data(), data->size());
+        REPORTER_ASSERT(r, dataID == SkCodecFrameCache::DataID(copy->data(), copy->size()));
+        SkResourceCache::PostPurgeSharedID(dataID);
+
+        std::unique_ptr<SkCodec> codec(SkCodec::MakeFromData(data));
+        if (!codec) {
+            ERRORF(r, "Could not create codec for %s", file);
+            continue;
+        }
+        const int last = codec->getFrameCount() - 1;
+        const auto info = codec->getInfo().makeColorType(kN32_SkColorType)
+                                          .makeAlphaType(kPremul_SkAlphaType);
+        SkBitmap expected, actual;
+        expected.allocPixels(info);
+        actual.allocPixels(info);
+        REPORTER_ASSERT(r, !SkCodecFrameCache::Find(dataID, *data, last, info, actual.getPixels(),
+                                                    actual.rowBytes()));
+
+        SkCodec::Options options;
+        options.fFrameIndex = last;
+        REPORTER_ASSERT(r, codec->getPixels(info, expected.getPixels(), expected.rowBytes(),
+                                            &options) == SkCodec::kSuccess);
+        REPORTER_ASSERT(r, SkCodecFrameCache::Find(dataID, *copy, last, info, actual.getPixels(),
+                                                   actual.rowBytes()));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual));
+
+        // Other data under the same digest does not get the frame.
+        sk_sp<SkData> other = SkData::MakeWithCopy(data->data(), data->size());
+        static_cast<uint8_t*>(other->writable_data())[data->size() - 1] ^= 1;
+        REPORTER_ASSERT(r, !SkCodecFrameCache::Find(dataID, *other, last, info,
+                                                    actual.getPixels(), actual.rowBytes()));
+        REPORTER_ASSERT(r, codec->getPixels(info, expected.getPixels(), expected.rowBytes(),
+                                            &options) == SkCodec::kSuccess);
+
+        // A second codec gets the same frame from the cache.
+        actual.eraseColor(SK_ColorTRANSPARENT);
+        std::unique_ptr<SkCodec> second(SkCodec::MakeFromData(copy));
+        REPORTER_ASSERT(r, second->getFrameCount() == last + 1);
+        REPORTER_ASSERT(r, second->getPixels(info, actual.getPixels(), actual.rowBytes(),
+                                             &options) == SkCodec::kSuccess);
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual));
+
+        SkResourceCache::PostPurgeSharedID(dataID);
+        REPORTER_ASSERT(r, !SkCodecFrameCache::Find(dataID, *data, last, info, actual.getPixels(),
+                                                    actual.rowBytes()));
+    }
+}
+
 DEF_TEST(EncodedOriginToMatrixTest, r) {
     // SkAnimCodecPlayer relies on the fact that these matrices are invertible.
     for (auto origin : { kTopLeft_SkEncodedOrigin     ,
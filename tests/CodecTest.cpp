@@ -19,6 +19,7 @@
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkDataTable.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageGenerator.h"
 #include "include/core/SkImageInfo.h"
@@ -415,9 +416,11 @@ static void check_subset_decode(skiatest::Reporter* r,
             if (!supportsIncomplete) {
                 REPORTER_ASSERT(r, result == SkCodec::kSuccess);
             }
-            // Webp is the only codec that supports subsets, and it will have modified the subset
-            // to have even left/top.
-            REPORTER_ASSERT(r, SkIsAlign2(subset.fLeft) && SkIsAlign2(subset.fTop));
+            // Webp will have modified the subset to have even left/top. Jpeg and png decode any
+            // subset.
+            if (codec->getEncodedFormat() == SkEncodedImageFormat::kWEBP) {
+                REPORTER_ASSERT(r, SkIsAlign2(subset.fLeft) && SkIsAlign2(subset.fTop));
+            }
         } else {
             // No subsets will work.
             REPORTER_ASSERT(r, result == SkCodec::kUnimplemented);
@@ -520,7 +523,14 @@ static void check(skiatest::Reporter* r,
     check_scanline_decode(r, codec.get(), &codecDigest, info, path, size, supportsScanlineDecoding,
                           supportsIncomplete, supportsNewScanlineDecoding);
 
-    check_subset_decode(r, codec.get(), info, size, supportsSubsetDecoding, supportsIncomplete);
+    // Jpeg and png decode subsets by seeking with an index, which they can only build from the
+    // complete image.
+    const SkEncodedImageFormat format = codec->getEncodedFormat();
+    const bool subsetsNeedCompleteImage = format == SkEncodedImageFormat::kJPEG ||
+                                          format == SkEncodedImageFormat::kPNG;
+    check_subset_decode(r, codec.get(), info, size,
+                        supportsSubsetDecoding && !(supportsIncomplete && subsetsNeedCompleteImage),
+                        supportsIncomplete);
 
     check_android_codec(r, std::move(codec), codecDigest, info, path, size,
                         supportsScanlineDecoding, supportsSubsetDecoding, supportsIncomplete,
@@ -612,32 +622,33 @@ DEF_TEST(Codec_gif, r) {
 }
 
 DEF_TEST(Codec_jpg, r) {
-    check(r, "images/CMYK.jpg", SkISize::Make(642, 516), true, false, true);
-    check(r, "images/color_wheel.jpg", SkISize::Make(128, 128), true, false, true);
-    // grayscale.jpg is too small to test incomplete
+    check(r, "images/CMYK.jpg", SkISize::Make(642, 516), true, true, true);
+    check(r, "images/color_wheel.jpg", SkISize::Make(128, 128), true, true, true);
+    // grayscale.jpg is too small to test incomplete, and progressive, so it can't seek to subsets
     check(r, "images/grayscale.jpg", SkISize::Make(128, 128), true, false, false);
-    check(r, "images/mandrill_512_q075.jpg", SkISize::Make(512, 512), true, false, true);
+    check(r, "images/mandrill_512_q075.jpg", SkISize::Make(512, 512), true, true, true);
     // randPixels.jpg is too small to test incomplete
-    check(r, "images/randPixels.jpg", SkISize::Make(8, 8), true, false, false);
+    check(r, "images/randPixels.jpg", SkISize::Make(8, 8), true, true, false);
 }
 
 DEF_TEST(Codec_png, r) {
-    check(r, "images/arrow.png", SkISize::Make(187, 312), false, false, true, true);
-    check(r, "images/baby_tux.png", SkISize::Make(240, 246), false, false, true, true);
-    check(r, "images/color_wheel.png", SkISize::Make(128, 128), false, false, true, true);
+    check(r, "images/arrow.png", SkISize::Make(187, 312), false, true, true, true);
+    check(r, "images/baby_tux.png", SkISize::Make(240, 246), false, true, true, true);
+    check(r, "images/color_wheel.png", SkISize::Make(128, 128), false, true, true, true);
     // half-transparent-white-pixel.png is too small to test incomplete
     check(r, "images/half-transparent-white-pixel.png", SkISize::Make(1, 1), false, false, false, true);
-    check(r, "images/mandrill_128.png", SkISize::Make(128, 128), false, false, true, true);
+    check(r, "images/mandrill_128.png", SkISize::Make(128, 128), false, true, true, true);
     // mandrill_16.png is too small (relative to embedded sRGB profile) to test incomplete
-    check(r, "images/mandrill_16.png", SkISize::Make(16, 16), false, false, false, true);
-    check(r, "images/mandrill_256.png", SkISize::Make(256, 256), false, false, true, true);
-    check(r, "images/mandrill_32.png", SkISize::Make(32, 32), false, false, true, true);
-    check(r, "images/mandrill_512.png", SkISize::Make(512, 512), false, false, true, true);
-    check(r, "images/mandrill_64.png", SkISize::Make(64, 64), false, false, true, true);
-    check(r, "images/plane.png", SkISize::Make(250, 126), false, false, true, true);
+    check(r, "images/mandrill_16.png", SkISize::Make(16, 16), false, true, false, true);
+    check(r, "images/mandrill_256.png", SkISize::Make(256, 256), false, true, true, true);
+    check(r, "images/mandrill_32.png", SkISize::Make(32, 32), false, true, true, true);
+    check(r, "images/mandrill_512.png", SkISize::Make(512, 512), false, true, true, true);
+    check(r, "images/mandrill_64.png", SkISize::Make(64, 64), false, true, true, true);
+    check(r, "images/plane.png", SkISize::Make(250, 126), false, true, true, true);
+    // Interlaced pngs can't seek to subsets.
     check(r, "images/plane_interlaced.png", SkISize::Make(250, 126), false, false, true, true);
-    check(r, "images/randPixels.png", SkISize::Make(8, 8), false, false, true, true);
-    check(r, "images/yellow_rose.png", SkISize::Make(400, 301), false, false, true, true);
+    check(r, "images/randPixels.png", SkISize::Make(8, 8), false, true, true, true);
+    check(r, "images/yellow_rose.png", SkISize::Make(400, 301), false, true, true, true);
 }
 
 static void verifyFirstFourDecodedBytes(skiatest::Reporter* r,
@@ -1100,6 +1111,34 @@ DEF_TEST(Codec_webp_peek, r) {
     test_info(r, codec.get(), codec->getInfo(), SkCodec::kSuccess, nullptr);
 }
 
+DEF_TEST(Codec_webp_filter_thread, r) {
+    for (const char* path : {"images/yellow_rose.webp", "images/stoplight.webp"}) {
+        sk_sp<SkData> data(GetResourceAsData(path));
+        if (!data) {
+            continue;
+        }
+        std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+        if (!codec) {
+            ERRORF(r, "Unable to create codec '%s'.", path);
+            continue;
+        }
+        const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType);
+        for (int i = 0; i < codec->getFrameCount(); ++i) {
+            SkBitmap serial, threaded;
+            serial.allocPixels(info);
+            threaded.allocPixels(info);
+
+            SkCodec::Options options;
+            options.fFrameIndex = i;
+            REPORTER_ASSERT(r, codec->getPixels(serial.pixmap(), &options) == SkCodec::kSuccess);
+
+            options.fUseWebpFilterThread = true;
+            REPORTER_ASSERT(r, codec->getPixels(threaded.pixmap(), &options) == SkCodec::kSuccess);
+            REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial, threaded), "%s frame %d", path, i);
+        }
+    }
+}
+
 // SkCodec's wbmp decoder was initially unnecessarily restrictive.
 // It required the second byte to be zero. The wbmp specification allows
 // a couple of bits to be 1 (so long as they do not overlap with 0x9F).
@@ -1204,6 +1243,102 @@ DEF_TEST(Codec_jpeg_rewind, r) {
     REPORTER_ASSERT(r, SkCodec::kIncompleteInput == result);
 }
 
+DEF_TEST(Codec_jpeg_parallel, r) {
+    // A 12 megapixel baseline image with a restart marker at the start of every MCU row.
+    const char* path = "images/iphone_13_pro.jpeg";
+    sk_sp<SkData> data(GetResourceAsData(path));
+    if (!data) {
+        return;
+    }
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    auto adobeRGB = SkColorSpace::MakeRGB(SkNamedTransferFn::k2Dot2, SkNamedGamut::kAdobeRGB);
+    for (sk_sp<SkData> encoded : {data, SkData::MakeSubset(data.get(), 0, data->size() / 2)}) {
+        std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(encoded);
+        if (!codec) {
+            ERRORF(r, "Unable to create codec '%s'.", path);
+            return;
+        }
+        const SkImageInfo codecInfo = codec->getInfo();
+        for (const SkImageInfo& info : {
+                 codecInfo.makeColorType(kN32_SkColorType),
+                 codecInfo.makeColorType(kN32_SkColorType).makeColorSpace(adobeRGB),
+                 codecInfo.makeColorType(kRGB_565_SkColorType)}) {
+            SkBitmap serial, parallel;
+            serial.allocPixels(info);
+            parallel.allocPixels(info);
+
+            codec = SkCodec::MakeFromData(encoded);
+            const SkCodec::Result expected = codec->getPixels(serial.pixmap());
+            REPORTER_ASSERT(r, expected == (encoded == data ? SkCodec::kSuccess
+                                                            : SkCodec::kIncompleteInput));
+
+            // Truncated data can't be split at restart markers, so it is decoded serially.
+            SkCodec::Options options;
+            options.fExecutor = executor.get();
+            codec = SkCodec::MakeFromData(encoded);
+            REPORTER_ASSERT(r, codec->getPixels(info, parallel.getPixels(), parallel.rowBytes(),
+                                                &options) == expected);
+            REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial, parallel));
+        }
+    }
+}
+
+static void check_subsets_match_full_decode(skiatest::Reporter* r, sk_sp<SkData> data) {
+    std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+    if (!codec) {
+        ERRORF(r, "Unable to create codec.");
+        return;
+    }
+    SkBitmap full;
+    full.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType));
+    REPORTER_ASSERT(r, codec->getPixels(full.pixmap()) == SkCodec::kSuccess);
+
+    // The first subset builds the index, and the rest seek with it.
+    const int w = full.width(),
+              h = full.height();
+    for (SkIRect subset : {SkIRect::MakeXYWH(w / 3, h / 2, 257, 255),
+                           SkIRect::MakeXYWH(0, 0, 17, 9),
+                           SkIRect::MakeXYWH(w - 33, h - 19, 33, 19),
+                           SkIRect::MakeXYWH(1, h / 5 + 1, 7, 16)}) {
+        REPORTER_ASSERT(r, codec->getValidSubset(&subset));
+        SkCodec::Options options;
+        options.fSubset = &subset;
+        SkBitmap bm;
+        bm.allocPixels(full.info().makeDimensions(subset.size()));
+        REPORTER_ASSERT(r, codec->getPixels(bm.info(), bm.getPixels(), bm.rowBytes(), &options) ==
+                           SkCodec::kSuccess);
+
+        SkBitmap expected;
+        REPORTER_ASSERT(r, full.extractSubset(&expected, subset));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, bm),
+                        "subset %d,%d %dx%d", subset.x(), subset.y(), subset.width(),
+                        subset.height());
+    }
+}
+
+DEF_TEST(Codec_subset_index, r) {
+    // A jpeg with a restart marker at the start of every MCU row and 4:2:0 chroma.
+    if (sk_sp<SkData> jpeg = GetResourceAsData("images/iphone_13_pro.jpeg")) {
+        check_subsets_match_full_decode(r, jpeg);
+    }
+
+    // A png with enough image data for the index to take several checkpoints.
+    SkBitmap bm;
+    bm.allocPixels(SkImageInfo::Make(1031, 1023, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType));
+    SkRandom rand;
+    for (int y = 0; y < bm.height(); y++) {
+        for (int x = 0; x < bm.width(); x++) {
+            *bm.getAddr32(x, y) = (y / 8) % 3 ? rand.nextU() | 0xFF000000
+                                              : SkColorSetARGB(0xFF, x & 0xFF, y & 0xFF,
+                                                               (x ^ y) & 0xFF);
+        }
+    }
+    SkDynamicMemoryWStream stream;
+    SkASSERT_RELEASE(SkPngEncoder::Encode(&stream, bm.pixmap(), {}));
+    check_subsets_match_full_decode(r, stream.detachAsData());
+}
+
 static void check_color_xform(skiatest::Reporter* r, const char* path) {
     std::unique_ptr<SkAndroidCodec> codec(SkAndroidCodec::MakeFromStream(GetResourceAsStream(path)));
 
@@ -1513,6 +1648,46 @@ DEF_TEST(Codec_fallBack, r) {
     }
 }
 
+DEF_TEST(Codec_subsetFallBack, r) {
+    // A codec that can't build its subset index (here because the stream isn't in memory) must
+    // turn a subset down without rewinding, so that SkAndroidCodec can fall back to decoding
+    // rows from a stream that can't rewind again.
+    for (auto file : {"images/CMYK.jpg", "images/plane.png"}) {
+        auto stream = LimitedRewindingStream::Make(file, SkCodec::MinBufferedBytesNeeded());
+        if (!stream) {
+            SkDebugf("Missing resources (%s). Set --resourcePath.\n", file);
+            return;
+        }
+        std::unique_ptr<SkAndroidCodec> codec =
+                SkAndroidCodec::MakeFromCodec(SkCodec::MakeFromStream(std::move(stream)));
+        std::unique_ptr<SkCodec> full = SkCodec::MakeFromData(GetResourceAsData(file));
+        if (!codec || !full) {
+            ERRORF(r, "Failed to create codec for %s,", file);
+            continue;
+        }
+
+        const SkImageInfo info = full->getInfo().makeColorType(kN32_SkColorType);
+        SkBitmap expected;
+        expected.allocPixels(info);
+        REPORTER_ASSERT(r, full->getPixels(expected.pixmap()) == SkCodec::kSuccess);
+
+        SkIRect subset = SkIRect::MakeXYWH(info.width() / 4, info.height() / 3, 64, 32);
+        REPORTER_ASSERT(r, !codec->codec()->getValidSubset(&subset));
+        SkAndroidCodec::AndroidOptions options;
+        options.fSubset = &subset;
+        SkBitmap bm;
+        bm.allocPixels(info.makeDimensions(subset.size()));
+        const SkCodec::Result result =
+                codec->getAndroidPixels(bm.info(), bm.getPixels(), bm.rowBytes(), &options);
+        REPORTER_ASSERT(r, result == SkCodec::kSuccess, "%s: %s", file,
+                        SkCodec::ResultToString(result));
+
+        SkBitmap crop;
+        REPORTER_ASSERT(r, expected.extractSubset(&crop, subset));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(crop, bm), "%s", file);
+    }
+}
+
 static void seek_and_decode(const char* file, std::unique_ptr<SkStream> stream,
                             skiatest::Reporter* r) {
     if (!stream) {
@@ -6,17 +6,25 @@
  */
 #include "tests/Test.h"
 
+#include "include/core/SkBlendMode.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColorSpace.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPixmap.h"
+#include "include/core/SkShader.h"
 #include "include/core/SkSurface.h"
+#include "include/core/SkSurfaceProps.h"
+#include "src/base/SkArenaAlloc.h"
 #include "src/core/SkBlitter.h"
 #include "src/core/SkCoreBlitters.h"
 #include "src/core/SkMask.h"
 
+#include <cstring>
 #include <memory>
+#include <vector>
 
 static bool all_pixels_same_color(uint32_t* buffer, size_t len) {
     for (size_t i = 1; i < len; ++i) {
@@ -197,3 +205,69 @@ DEF_TEST(SkARGB32Blitter_MaskAndAntiHDrawTheSame, r) {
         }
     }
 }
+
+// Blits a rect, an anti-aliased run, and an A8 mask into dst with a new raster pipeline blitter.
+static void blit_with_raster_pipeline(const SkPixmap& dst, const SkPaint& paint) {
+    constexpr int kWidth = 19;
+    SkASSERT(dst.width() == kWidth && dst.height() == 3);
+
+    SkSTArenaAlloc<2048> alloc;
+    SkBlitter* blitter = SkCreateRasterPipelineBlitter(dst, paint, SkMatrix::I(), &alloc,
+                                                       /*clipShader=*/nullptr, SkSurfaceProps());
+    SkASSERT(blitter);
+
+    blitter->blitRect(0, 0, kWidth, 1);
+
+    SkAlpha antiAlias[] = {0x60, 0};
+    int16_t runs[kWidth + 1] = {kWidth};
+    blitter->blitAntiH(0, 1, antiAlias, runs);
+
+    uint8_t maskImage[kWidth];
+    for (int i = 0; i < kWidth; ++i) {
+        maskImage[i] = (uint8_t)(i * 255 / (kWidth - 1));
+    }
+    SkMask mask(maskImage, SkIRect::MakeXYWH(0, 2, kWidth, 1), kWidth, SkMask::kA8_Format);
+    blitter->blitMask(mask, mask.fBounds);
+}
+
+DEF_SERIAL_TEST(SkRasterPipelineBlitter_ProgramCache, r) {
+    SkGraphics::PurgeAllCaches();
+    const size_t initialMisses = SkGraphics::GetRasterPipelineCacheMisses();
+
+    for (SkColorType ct : {kRGBA_8888_SkColorType, kBGRA_8888_SkColorType, kRGBA_F16_SkColorType})
+    for (sk_sp<SkColorSpace> cs : {sk_sp<SkColorSpace>(nullptr), SkColorSpace::MakeSRGB()})
+    for (SkBlendMode mode : {SkBlendMode::kSrcOver, SkBlendMode::kSrc, SkBlendMode::kMultiply})
+    for (SkColor4f color : {SkColor4f{0.2f, 0.4f, 0.6f, 0.5f}, SkColor4f{0.2f, 0.4f, 0.6f, 1}}) {
+        SkImageInfo info = SkImageInfo::Make(19, 3, ct, kPremul_SkAlphaType, cs);
+        std::vector<uint64_t> expected(19 * 3), actual(19 * 3);
+        SkPixmap expectedPixmap(info, expected.data(), info.minRowBytes()),
+                 actualPixmap(info, actual.data(), info.minRowBytes());
+
+        // A color shader draws the same color as a solid paint, but doesn't use the cache.
+        SkPaint shaderPaint;
+        shaderPaint.setShader(SkShaders::Color(color, nullptr));
+        shaderPaint.setBlendMode(mode);
+        expectedPixmap.erase(SkColor4f{0.9f, 0.5f, 0.1f, 0.75f});
+        blit_with_raster_pipeline(expectedPixmap, shaderPaint);
+
+        SkPaint paint(color);
+        paint.setBlendMode(mode);
+        size_t hits = SkGraphics::GetRasterPipelineCacheHits(),
+               misses = SkGraphics::GetRasterPipelineCacheMisses();
+        for (int draw = 0; draw < 2; ++draw) {
+            actualPixmap.erase(SkColor4f{0.9f, 0.5f, 0.1f, 0.75f});
+            blit_with_raster_pipeline(actualPixmap, paint);
+            REPORTER_ASSERT(r,
+                            0 == memcmp(expected.data(), actual.data(), info.computeMinByteSize()),
+                            "ct=%d mode=%d alpha=%g draw=%d", ct, (int)mode, color.fA, draw);
+            if (draw > 0) {
+                // The second draw must find every program the first one compiled.
+                REPORTER_ASSERT(r, SkGraphics::GetRasterPipelineCacheMisses() == misses);
+                REPORTER_ASSERT(r, SkGraphics::GetRasterPipelineCacheHits() > hits);
+            }
+            hits = SkGraphics::GetRasterPipelineCacheHits();
+            misses = SkGraphics::GetRasterPipelineCacheMisses();
+        }
+    }
+    REPORTER_ASSERT(r, SkGraphics::GetRasterPipelineCacheMisses() > initialMisses);
+}
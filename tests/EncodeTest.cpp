@@ -15,9 +15,11 @@
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkDataTable.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkSurface.h"
@@ -30,6 +32,7 @@
 #include "include/private/base/SkMalloc.h"
 #include "include/private/base/SkTemplates.h"
 #include "modules/skcms/src/skcms_public.h"
+#include "src/base/SkRandom.h"
 #include "src/core/SkColorPriv.h"
 #include "src/core/SkConvertPixels.h"
 #include "src/core/SkImageInfoPriv.h"
@@ -543,6 +546,65 @@ DEF_TEST(Encode_PngOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0));
 }
 
+static void test_png_parallel(skiatest::Reporter* r, SkExecutor* executor,
+                              const SkPixmap& src, SkPngEncoder::FilterFlag filters,
+                              int zlibLevel) {
+    SkPngEncoder::Options options;
+    options.fFilterFlags = filters;
+    options.fZLibLevel = zlibLevel;
+    SkDynamicMemoryWStream serialStream, parallelStream;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&serialStream, src, options));
+    options.fExecutor = executor;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&parallelStream, src, options));
+
+    sk_sp<SkData> serial = serialStream.detachAsData(),
+                  parallel = parallelStream.detachAsData();
+    REPORTER_ASSERT(r, parallel->size() < serial->size() * 101 / 100,
+                    "%zu vs %zu", parallel->size(), serial->size());
+
+    SkBitmap serialBitmap, parallelBitmap;
+    REPORTER_ASSERT(r, SkImages::DeferredFromEncodedData(serial)->asLegacyBitmap(&serialBitmap));
+    REPORTER_ASSERT(r, SkImages::DeferredFromEncodedData(parallel)
+                               ->asLegacyBitmap(&parallelBitmap));
+    REPORTER_ASSERT(r, almost_equals(serialBitmap, parallelBitmap, 0),
+                    "color type %d, filters 0x%x, level %d",
+                    src.colorType(), (int)filters, zlibLevel);
+}
+
+DEF_TEST(Encode_PngParallel, r) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    using Filter = SkPngEncoder::FilterFlag;
+
+    for (SkColorType colorType : {kRGBA_8888_SkColorType, kGray_8_SkColorType,
+                                  kRGBA_F16_SkColorType}) {
+        // Tall enough to be split into several stripes, with a mix of smooth and noisy rows so
+        // that different filters win on different rows.
+        SkBitmap bitmap;
+        SkAlphaType alphaType = SkColorTypeIsAlwaysOpaque(colorType) ? kOpaque_SkAlphaType
+                                                                     : kUnpremul_SkAlphaType;
+        bitmap.allocPixels(SkImageInfo::Make(128, 2100, colorType, alphaType));
+        SkRandom random;
+        for (int y = 0; y < bitmap.height(); ++y) {
+            for (int x = 0; x < bitmap.width(); ++x) {
+                uint8_t noise = (y / 7) % 3 ? random.nextU() & 0x0F : x;
+                bitmap.erase(SkColorSetARGB(128 + x, (x * y) & 0xFF, (x ^ y) & 0xFF, noise),
+                             SkIRect::MakeXYWH(x, y, 1, 1));
+            }
+        }
+
+        test_png_parallel(r, executor.get(), bitmap.pixmap(), Filter::kAll, 6);
+        if (colorType != kRGBA_8888_SkColorType) {
+            continue;
+        }
+        for (Filter filters : {Filter::kZero, Filter::kNone, Filter::kSub, Filter::kUp,
+                               Filter::kAvg, Filter::kPaeth, Filter::kSub | Filter::kPaeth}) {
+            test_png_parallel(r, executor.get(), bitmap.pixmap(), filters, 1);
+        }
+        test_png_parallel(r, executor.get(), bitmap.pixmap(), Filter::kAll, 0);
+        test_png_parallel(r, executor.get(), bitmap.pixmap(), Filter::kAll, 9);
+    }
+}
+
 #ifndef SK_BUILD_FOR_GOOGLE3
 DEF_TEST(Encode_WebpQuality, r) {
     SkBitmap bm;
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkExecutor.h"
+#include "src/core/SkTaskGroup.h"
+#include "tests/Test.h"
+
+#include <atomic>
+#include <memory>
+
+DEF_TEST(SkExecutor_WorkStealing_Nested, r) {
+    for (int threads : {1, 2, 5}) {
+        std::unique_ptr<SkExecutor> executor = SkExecutor::MakeWorkStealingThreadPool(threads);
+
+        // Task groups nested three deep all wait on the same pool: the waits must help run
+        // the nested work from pool threads' own queues or this would deadlock.
+        std::atomic<int> count{0};
+        SkTaskGroup outer(*executor);
+        outer.batch(16, [&](int) {
+            SkTaskGroup middle(*executor);
+            middle.batch(64, [&](int) {
+                SkTaskGroup inner(*executor);
+                inner.batch(4, [&](int) { count.fetch_add(1, std::memory_order_relaxed); });
+                inner.wait();
+            });
+            middle.wait();
+        });
+        outer.wait();
+        REPORTER_ASSERT(r, count.load() == 16 * 64 * 4);
+    }
+}
+
+DEF_TEST(SkExecutor_WorkStealing_NoBorrowing, r) {
+    std::unique_ptr<SkExecutor> executor =
+            SkExecutor::MakeWorkStealingThreadPool(2, /*allowBorrowing=*/false);
+
+    // Work added from a pool thread goes on that thread's own queue; add enough to outgrow its
+    // initial capacity several times over, leaving the other thread to steal.
+    std::atomic<int> count{0};
+    SkTaskGroup tg(*executor);
+    tg.add([&] {
+        for (int i = 0; i < 1000; i++) {
+            tg.add([&] { count.fetch_add(1, std::memory_order_relaxed); });
+        }
+    });
+    tg.wait();
+    REPORTER_ASSERT(r, count.load() == 1000);
+
+    // Work still queued when the pool is destroyed is dropped, not leaked or run after.
+    for (int i = 0; i < 100; i++) {
+        executor->add([] {});
+    }
+    executor.reset();
+}
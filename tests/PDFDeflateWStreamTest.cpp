@@ -8,6 +8,8 @@
 #include "include/core/SkTypes.h"
 
 #ifdef SK_SUPPORT_PDF
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/private/base/SkDebug.h"
@@ -19,8 +21,10 @@
 #include "tests/Test.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 #include "zlib.h"
@@ -41,7 +45,8 @@ void skia_free_func(void*, void* address) { sk_free(address); }
  *  Use the un-deflate compression algorithm to decompress the data in src,
  *  returning the result.  Returns nullptr if an error occurs.
  */
-std::unique_ptr<SkStreamAsset> stream_inflate(skiatest::Reporter* reporter, SkStream* src) {
+std::unique_ptr<SkStreamAsset> stream_inflate(skiatest::Reporter* reporter, SkStream* src,
+                                              bool gzip = false) {
     SkDynamicMemoryWStream decompressedDynamicMemoryWStream;
     SkWStream* dst = &decompressedDynamicMemoryWStream;
 
@@ -57,7 +62,7 @@ std::unique_ptr<SkStreamAsset> stream_inflate(skiatest::Reporter* reporter, SkSt
     flateData.next_out = outputBuffer;
     flateData.avail_out = kBufferSize;
     int rc;
-    rc = inflateInit(&flateData);
+    rc = inflateInit2(&flateData, gzip ? 0x1F : 0x0F);
     if (rc != Z_OK) {
         ERRORF(reporter, "Zlib: inflateInit failed");
         return nullptr;
@@ -115,6 +120,56 @@ std::unique_ptr<SkStreamAsset> stream_inflate(skiatest::Reporter* reporter, SkSt
     }
     return decompressedDynamicMemoryWStream.detachAsStream();
 }
+
+// Text-like data: compressible, with matches that reach back across block boundaries.
+sk_sp<SkData> make_compressible_data(size_t size) {
+    static const char* kWords[] = {"moveto ", "lineto ", "curveto ", "closepath ", "fill ",
+                                   "stroke ", "0 ", "1 ", "72 ", "612 ", "792 ", "\n"};
+    SkRandom random(size);
+    SkDynamicMemoryWStream text;
+    while (text.bytesWritten() < size) {
+        const char* word = kWords[random.nextULessThan(std::size(kWords))];
+        text.write(word, std::min(strlen(word), size - text.bytesWritten()));
+    }
+    return text.detachAsData();
+}
+
+sk_sp<SkData> deflate(const SkData& input, const SkDeflateWStream::Options& options) {
+    SkDynamicMemoryWStream compressed;
+    SkDeflateWStream deflateWStream(&compressed, options);
+    // Uneven writes, so they straddle blocks.
+    for (size_t i = 0; i < input.size(); i += 1000) {
+        deflateWStream.write(input.bytes() + i, std::min<size_t>(1000, input.size() - i));
+    }
+    deflateWStream.finalize();
+    return compressed.detachAsData();
+}
+
+bool inflates_to(skiatest::Reporter* r, const SkData& compressed, const SkData& expected,
+                 bool gzip) {
+    SkMemoryStream src(compressed.data(), compressed.size());
+    std::unique_ptr<SkStreamAsset> decompressed = stream_inflate(r, &src, gzip);
+    return decompressed && decompressed->getLength() == expected.size() &&
+           SkData::MakeFromStream(decompressed.get(), expected.size())->equals(&expected);
+}
+
+std::atomic<int> gCompressorCalls{0};
+
+bool zlib_compressor(SkWStream* dst, const void* src, size_t size, int compressionLevel) {
+    gCompressorCalls++;
+    uLongf length = compressBound(static_cast<uLong>(size));
+    AutoTMalloc<uint8_t> buffer(length);
+    if (Z_OK != compress2(buffer.get(), &length, static_cast<const Bytef*>(src),
+                          static_cast<uLong>(size), compressionLevel)) {
+        return false;
+    }
+    return dst->write(buffer.get(), length);
+}
+
+bool failing_compressor(SkWStream*, const void*, size_t, int) {
+    gCompressorCalls++;
+    return false;
+}
 }  // namespace
 
 DEF_TEST(SkPDF_DeflateWStream, r) {
@@ -177,4 +232,52 @@ DEF_TEST(SkPDF_DeflateWStream, r) {
     REPORTER_ASSERT(r, !emptyDeflateWStream.writeText("FOO"));
 }
 
+DEF_TEST(SkPDF_DeflateWStream_Chunked, r) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    constexpr size_t kBlockSize = 64 * 1024;
+    for (size_t size : {size_t(0), size_t(1000), kBlockSize - 1, kBlockSize, kBlockSize + 1,
+                        5 * kBlockSize, 16 * kBlockSize + 777}) {
+        sk_sp<SkData> input = make_compressible_data(size);
+        for (bool gzip : {false, true}) {
+            SkDeflateWStream::Options serial;
+            serial.fGzip = gzip;
+            SkDeflateWStream::Options chunked = serial;
+            chunked.fExecutor = executor.get();
+            chunked.fBlockSize = kBlockSize;
+
+            sk_sp<SkData> expected = deflate(*input, serial);
+            sk_sp<SkData> actual = deflate(*input, chunked);
+            if (!inflates_to(r, *actual, *input, gzip)) {
+                ERRORF(r, "Chunked deflate of %zu bytes (gzip %d) didn't round trip.",
+                       size, gzip);
+                continue;
+            }
+            if (size <= kBlockSize) {
+                // A single block is compressed just as it would be serially.
+                REPORTER_ASSERT(r, actual->equals(expected.get()));
+            } else {
+                // Priming each block with the last one's tail keeps the cost of splitting small.
+                REPORTER_ASSERT(r, actual->size() < expected->size() * 21 / 20 + 64,
+                                "%zu vs %zu", actual->size(), expected->size());
+            }
+        }
+    }
+}
+
+DEF_TEST(SkPDF_DeflateWStream_Compressor, r) {
+    sk_sp<SkData> input = make_compressible_data(100000);
+    for (auto compressor : {zlib_compressor, failing_compressor}) {
+        for (bool gzip : {false, true}) {
+            SkDeflateWStream::Options options;
+            options.fCompressor = compressor;
+            options.fGzip = gzip;
+            gCompressorCalls = 0;
+            sk_sp<SkData> compressed = deflate(*input, options);
+            REPORTER_ASSERT(r, inflates_to(r, *compressed, *input, gzip));
+            // The compressor sees all the input at once, and is only used for zlib streams.
+            REPORTER_ASSERT(r, gCompressorCalls == (gzip ? 0 : 1));
+        }
+    }
+}
+
 #endif
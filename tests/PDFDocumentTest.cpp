@@ -18,14 +18,19 @@
 #include "include/core/SkString.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/docs/SkPDFJpegHelpers.h"
+#include "include/private/base/SkTo.h"
 #include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
 #include "tools/fonts/FontToolUtils.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <string_view>
 
 static void test_empty(skiatest::Reporter* reporter) {
     SkDynamicMemoryWStream stream;
@@ -273,3 +278,222 @@ DEF_TEST(SkPDF_abort_jobs, rep) {
     doc->abort();
 }
 
+
+// Returns the number of objects in the document if every entry in its cross-reference table
+// points at the start of that object, or zero if not.
+static int count_xref_objects(const SkData& data) {
+    const char* pdf = static_cast<const char*>(data.data());
+    const std::string_view doc(pdf, data.size());
+    size_t startxref = doc.rfind("startxref\n");
+    if (startxref == std::string_view::npos) {
+        return 0;
+    }
+    size_t xref = strtoul(pdf + startxref + strlen("startxref\n"), nullptr, 10);
+    if (xref >= doc.size() || doc.compare(xref, 7, "xref\n0 ") != 0) {
+        return 0;
+    }
+    char* entries;
+    int count = SkToInt(strtol(pdf + xref + 7, &entries, 10));
+    entries += strlen("\n0000000000 65535 f \n");
+    for (int i = 1; i < count; ++i, entries += 20) {
+        if (entries + 20 > pdf + doc.size()) {
+            return 0;
+        }
+        size_t offset = strtoul(entries, nullptr, 10);
+        SkString obj = SkStringPrintf("%d 0 obj\n", i);
+        if (offset >= doc.size() || doc.compare(offset, obj.size(), obj.c_str()) != 0) {
+            return 0;
+        }
+    }
+    return count;
+}
+
+DEF_TEST(SkPDF_streaming, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_streaming, r);
+    // Enough pages for a page tree three levels deep.
+    constexpr int kPageCount = 100;
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(2);
+
+    for (bool streaming : {false, true}) {
+        for (size_t budget : {0, 16 * 1024}) {
+            SkPDF::Metadata metadata = SkPDF::JPEG::MetadataWithCallbacks();
+            metadata.fExecutor = executor.get();
+            metadata.fStreaming = streaming;
+            metadata.fMemoryBudget = budget;
+
+            SkDynamicMemoryWStream stream;
+            auto doc = SkPDF::MakeDocument(&stream, metadata);
+            for (int i = 0; i < kPageCount; ++i) {
+                // A different image on each page, so each has its own image XObject.
+                SkBitmap bitmap;
+                bitmap.allocN32Pixels(40, 40);
+                bitmap.eraseColor(SkColorSetARGB(0xFF, i, 255 - i, 0x80));
+                SkCanvas* canvas = doc->beginPage(100, 100);
+                canvas->drawColor(SK_ColorWHITE);
+                canvas->drawImage(bitmap.asImage(), 10, 10);
+                doc->endPage();
+            }
+            doc->close();
+            sk_sp<SkData> data = stream.detachAsData();
+
+            REPORTER_ASSERT(r, count_xref_objects(*data) > kPageCount,
+                            "streaming %d, budget %zu", streaming, budget);
+            REPORTER_ASSERT(r, contains(data->bytes(), data->size(), "/Count 100\n"),
+                            "streaming %d, budget %zu", streaming, budget);
+        }
+    }
+}
+
+// Checks an uncompressed cross-reference stream: every object it lists as written directly must
+// start at its offset, and every object it lists as packed into an object stream must be at its
+// index in that stream's header. Returns the number of objects packed into object streams.
+static int count_packed_objects(skiatest::Reporter* r, const SkData& data) {
+    const char* pdf = static_cast<const char*>(data.data());
+    const std::string_view doc(pdf, data.size());
+    // Returns the bytes of the stream in the object starting at offset, or nullptr.
+    auto streamData = [&](size_t offset) -> const uint8_t* {
+        size_t stream = doc.find(" stream\n", offset);
+        return stream == std::string_view::npos ? nullptr : data.bytes() + stream + 8;
+    };
+    // Reads an n byte big-endian field of a cross-reference stream entry.
+    auto field = [](const uint8_t* p, int n) {
+        uint32_t v = 0;
+        while (n --> 0) {
+            v = (v << 8) | *p++;
+        }
+        return v;
+    };
+
+    size_t startxref = doc.rfind("startxref\n");
+    if (startxref == std::string_view::npos) {
+        ERRORF(r, "missing startxref");
+        return 0;
+    }
+    size_t xref = strtoul(pdf + startxref + strlen("startxref\n"), nullptr, 10);
+    size_t size = doc.find("/Size ", xref);
+    const uint8_t* table = streamData(xref);
+    if (size == std::string_view::npos || !table) {
+        ERRORF(r, "missing cross-reference stream");
+        return 0;
+    }
+    int count = atoi(pdf + size + strlen("/Size "));
+    if (table + 7 * count > data.bytes() + data.size()) {
+        ERRORF(r, "cross-reference stream too short");
+        return 0;
+    }
+
+    int packed = 0;
+    for (int i = 1; i < count; ++i) {
+        const uint8_t* entry = table + 7 * i;
+        if (entry[0] == 1) {
+            SkString obj = SkStringPrintf("%d 0 obj\n", i);
+            REPORTER_ASSERT(r, doc.compare(field(entry + 1, 4), obj.size(), obj.c_str()) == 0,
+                            "object %d", i);
+            continue;
+        }
+        if (entry[0] != 2) {
+            ERRORF(r, "object %d has type %d", i, entry[0]);
+            continue;
+        }
+        // Find the object stream from its own entry, then skip to the pair at our index.
+        const uint8_t* streamEntry = table + 7 * field(entry + 1, 4);
+        const char* header = (const char*)streamData(field(streamEntry + 1, 4));
+        if (streamEntry[0] != 1 || !header) {
+            ERRORF(r, "object %d is in a missing object stream", i);
+            continue;
+        }
+        char* p = const_cast<char*>(header);
+        for (uint32_t k = 0; k < field(entry + 5, 2); ++k) {
+            strtol(p, &p, 10);
+            strtol(p, &p, 10);
+        }
+        REPORTER_ASSERT(r, strtol(p, nullptr, 10) == i, "object %d", i);
+        ++packed;
+    }
+    return packed;
+}
+
+DEF_TEST(SkPDF_object_streams, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_object_streams, r);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(2);
+
+    auto makePDF = [](const SkPDF::Metadata& metadata) {
+        SkDynamicMemoryWStream stream;
+        auto doc = SkPDF::MakeDocument(&stream, metadata);
+        for (int i = 0; i < 30; ++i) {
+            SkBitmap bitmap;
+            bitmap.allocN32Pixels(20, 20);
+            bitmap.eraseColor(SkColorSetARGB(0xFF, 8 * i, 0x40, 0x80));
+            SkCanvas* canvas = doc->beginPage(100, 100);
+            canvas->drawImage(bitmap.asImage(), 10, 10);
+            canvas->drawString("Object streams", 10, 50, ToolUtils::DefaultFont(), SkPaint());
+            doc->endPage();
+        }
+        doc->close();
+        return stream.detachAsData();
+    };
+
+    for (SkExecutor* ex : {(SkExecutor*)nullptr, executor.get()}) {
+        SkPDF::Metadata metadata = SkPDF::JPEG::MetadataWithCallbacks();
+        metadata.fExecutor = ex;
+        sk_sp<SkData> plain = makePDF(metadata);
+
+        metadata.fObjectStreams = true;
+        sk_sp<SkData> packed = makePDF(metadata);
+        REPORTER_ASSERT(r, contains(packed->bytes(), packed->size(), "%PDF-1.5\n"));
+        REPORTER_ASSERT(r, contains(packed->bytes(), packed->size(), "/Type /ObjStm"));
+        REPORTER_ASSERT(r, packed->size() < plain->size(),
+                        "%zu >= %zu", packed->size(), plain->size());
+
+        metadata.fCompressionLevel = SkPDF::Metadata::CompressionLevel::None;
+        sk_sp<SkData> uncompressed = makePDF(metadata);
+        REPORTER_ASSERT(r, count_packed_objects(r, *uncompressed) > 30);
+    }
+}
+
+static std::atomic<int> gDeflaterCalls{0};
+
+DEF_TEST(SkPDF_deflater, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_deflater, r);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(2);
+
+    auto makePDF = [](const SkPDF::Metadata& metadata) {
+        SkDynamicMemoryWStream stream;
+        auto doc = SkPDF::MakeDocument(&stream, metadata);
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(400, 400);  // Big enough to be deflated in several blocks.
+        for (int y = 0; y < bitmap.height(); ++y) {
+            for (int x = 0; x < bitmap.width(); ++x) {
+                *bitmap.getAddr32(x, y) =
+                        SkColorSetARGB(0xFF, x & 0xFF, y & 0xFF, (x ^ y) & 0xFF);
+            }
+        }
+        SkCanvas* canvas = doc->beginPage(500, 500);
+        canvas->drawImage(bitmap.asImage(), 10, 10);
+        canvas->drawString("Deflate", 10, 450, ToolUtils::DefaultFont(), SkPaint());
+        doc->endPage();
+        doc->close();
+        return stream.detachAsData();
+    };
+
+    SkPDF::Metadata metadata = SkPDF::JPEG::MetadataWithCallbacks();
+    sk_sp<SkData> expected = makePDF(metadata);
+
+    // A deflater that declines leaves everything to zlib, as if there were none.
+    metadata.deflater = [](SkWStream*, const void*, size_t, int) {
+        gDeflaterCalls++;
+        return false;
+    };
+    gDeflaterCalls = 0;
+    sk_sp<SkData> declined = makePDF(metadata);
+    REPORTER_ASSERT(r, gDeflaterCalls > 0);
+    REPORTER_ASSERT(r, declined->equals(expected.get()));
+
+    // Large streams deflated across the executor in blocks still make a valid document.
+    metadata.deflater = nullptr;
+    metadata.fExecutor = executor.get();
+    sk_sp<SkData> chunked = makePDF(metadata);
+    REPORTER_ASSERT(r, contains(chunked->bytes(), chunked->size(), "/Filter /FlateDecode"));
+    REPORTER_ASSERT(r, chunked->size() < expected->size() * 21 / 20,
+                    "%zu vs %zu", chunked->size(), expected->size());
+}
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkAlphaType.h"
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
@@ -26,9 +27,11 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSamplingOptions.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSerialProcs.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
+#include "include/utils/SkNoDrawCanvas.h"
 #include "src/base/SkRandom.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkPicturePriv.h"
@@ -37,7 +40,10 @@
 #include "tools/fonts/FontToolUtils.h"
 
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 class SkRRect;
@@ -924,3 +930,154 @@ DEF_TEST(Picture_nested_op_count, r) {
     check(make_pic(10, leaf1),  10,  10);
     check(make_pic(10, leaf10), 10, 100);
 }
+
+DEF_TEST(Picture_MakeFromDataWithoutCopy, r) {
+    SkBitmap bm;
+    make_bm(&bm, 16, 16, SK_ColorBLUE, true);
+
+    SkPictureRecorder inner;
+    inner.beginRecording({0, 0, 32, 32})->drawCircle(16, 16, 8, SkPaint{});
+    sk_sp<SkPicture> nested = inner.finishRecordingAsPicture();
+
+    SkPictureRecorder rec;
+    SkCanvas* c = rec.beginRecording({0, 0, 64, 64});
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    c->drawRect({4, 4, 40, 24}, paint);
+    c->drawPath(SkPath().moveTo(0, 64).lineTo(32, 32).lineTo(64, 64), paint);
+    c->drawImage(bm.asImage(), 40, 40);
+    c->drawPicture(nested);
+    c->drawPicture(nested, nullptr, &paint);
+    sk_sp<SkPicture> pic = rec.finishRecordingAsPicture();
+
+    // Serialize images as raw pixels, so they can be read back without a codec.
+    SkSerialProcs sProcs;
+    sProcs.fImageProc = [](SkImage* img, void*) -> sk_sp<SkData> {
+        SkBitmap pixels;
+        pixels.allocN32Pixels(img->width(), img->height());
+        if (!img->readPixels(nullptr, pixels.pixmap(), 0, 0)) {
+            return nullptr;
+        }
+        return SkData::MakeWithCopy(pixels.getPixels(), pixels.computeByteSize());
+    };
+    sk_sp<SkData> data = pic->serialize(&sProcs);
+
+    struct Context {
+        const SkData* fSource;
+        bool          fShared = false;
+    } ctx = {data.get()};
+    SkDeserialProcs dProcs;
+    dProcs.fImageDataProc = [](sk_sp<SkData> pixels, std::optional<SkAlphaType>, void* c) {
+        auto ctx = static_cast<Context*>(c);
+        ctx->fShared = pixels->bytes() >= ctx->fSource->bytes() &&
+                       pixels->bytes() < ctx->fSource->bytes() + ctx->fSource->size();
+        return SkImages::RasterFromData(SkImageInfo::MakeN32Premul(16, 16), std::move(pixels),
+                                        16 * 4);
+    };
+    dProcs.fImageCtx = &ctx;
+
+    sk_sp<SkPicture> copied = SkPicture::MakeFromData(data.get(), &dProcs);
+    REPORTER_ASSERT(r, copied && !ctx.fShared);
+    sk_sp<SkPicture> shared = SkPicture::MakeFromDataWithoutCopy(data, &dProcs);
+    REPORTER_ASSERT(r, shared && ctx.fShared);
+    if (!copied || !shared) {
+        return;
+    }
+    REPORTER_ASSERT(r, !data->unique());
+
+    REPORTER_ASSERT(r, shared->cullRect() == copied->cullRect());
+    REPORTER_ASSERT(r, shared->approximateOpCount(false) == copied->approximateOpCount(false));
+    REPORTER_ASSERT(r, shared->approximateOpCount(true) == copied->approximateOpCount(true));
+
+    SkBitmap expected, actual;
+    expected.allocN32Pixels(64, 64);
+    actual.allocN32Pixels(64, 64);
+    expected.eraseColor(SK_ColorWHITE);
+    actual.eraseColor(SK_ColorWHITE);
+    SkCanvas(expected).drawPicture(copied);
+    SkCanvas(actual).drawPicture(shared);
+    REPORTER_ASSERT(r, !memcmp(expected.getPixels(), actual.getPixels(),
+                               expected.computeByteSize()));
+
+    // Reserializing plays it back like any other picture.
+    sk_sp<SkPicture> roundTrip = SkPicture::MakeFromData(shared->serialize(&sProcs).get(), &dProcs);
+    REPORTER_ASSERT(r, roundTrip && roundTrip->approximateOpCount(true) ==
+                                    copied->approximateOpCount(true));
+}
+
+DEF_TEST(Picture_SerializedOpBounds, r) {
+    SkRTreeFactory factory;
+    SkPictureRecorder rec;
+    SkCanvas* c = rec.beginRecording({0, 0, 1000, 1000}, &factory);
+    SkPaint paint;
+    for (int y = 0; y < 10; y++) {
+        for (int x = 0; x < 10; x++) {
+            paint.setColor(SkColorSetRGB(25 * x, 25 * y, 128));
+            const SkRect cell = SkRect::MakeXYWH(100 * x, 100 * y, 100, 100);
+            if ((x + y) % 3 == 0) {
+                // Blocks of state ops must be skipped or played as a whole.
+                c->save();
+                c->clipRect(cell.makeInset(10, 10));
+                c->translate(5, 5);
+                c->drawOval(cell, paint);
+                c->restore();
+            } else {
+                c->drawRect(cell.makeInset(20, 20), paint);
+            }
+        }
+    }
+    sk_sp<SkPicture> pic = rec.finishRecordingAsPicture();
+    sk_sp<SkData> data = pic->serialize();
+
+    sk_sp<SkPicture> shared = SkPicture::MakeFromDataWithoutCopy(data);
+    sk_sp<SkPicture> copied = SkPicture::MakeFromData(data.get());
+    REPORTER_ASSERT(r, shared && copied);
+    if (!shared || !copied) {
+        return;
+    }
+    // Pictures that lost their BBH would search nothing.
+    const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(copied);
+    REPORTER_ASSERT(r, big && big->bbh());
+
+    struct CountingCanvas : public SkNoDrawCanvas {
+        CountingCanvas() : SkNoDrawCanvas(1000, 1000) {}
+        void onDrawRect(const SkRect&, const SkPaint&) override { fDraws++; }
+        void onDrawOval(const SkRect&, const SkPaint&) override { fDraws++; }
+        int fDraws = 0;
+    };
+    CountingCanvas all;
+    shared->playback(&all);
+    REPORTER_ASSERT(r, all.fDraws == 100);
+    CountingCanvas viewport;
+    viewport.clipRect({150, 250, 350, 420});
+    shared->playback(&viewport);
+    REPORTER_ASSERT(r, viewport.fDraws == 9, "%d", viewport.fDraws);
+
+    // The ops that are skipped must not change what is drawn in the viewport.
+    auto draw = [](const sk_sp<SkPicture>& picture, SkBitmap* bm) {
+        bm->allocN32Pixels(200, 170);
+        bm->eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(*bm);
+        canvas.translate(-150, -250);
+        picture->playback(&canvas);
+    };
+    SkBitmap expected, actual;
+    draw(pic, &expected);
+    draw(shared, &actual);
+    REPORTER_ASSERT(r, !memcmp(expected.getPixels(), actual.getPixels(),
+                               expected.computeByteSize()));
+
+    // Serializing the shared picture again keeps its op bounds.
+    sk_sp<SkPicture> reshared = SkPicture::MakeFromDataWithoutCopy(shared->serialize());
+    REPORTER_ASSERT(r, reshared);
+    if (!reshared) {
+        return;
+    }
+    CountingCanvas reviewport;
+    reviewport.clipRect({150, 250, 350, 420});
+    reshared->playback(&reviewport);
+    REPORTER_ASSERT(r, reviewport.fDraws == 9, "%d", reviewport.fDraws);
+    draw(reshared, &actual);
+    REPORTER_ASSERT(r, !memcmp(expected.getPixels(), actual.getPixels(),
+                               expected.computeByteSize()));
+}
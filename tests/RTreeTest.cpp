@@ -5,15 +5,18 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBBHFactory.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkTypes.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkRandom.h"
+#include "src/core/SkPackedRTree.h"
 #include "src/core/SkRTree.h"
 #include "tests/Test.h"
 
 #include <cmath>
 #include <cstddef>
+#include <iterator>
 #include <vector>
 
 using namespace skia_private;
@@ -53,7 +56,7 @@ static bool verify_query(SkRect query, SkRect rects[], const std::vector<int>& f
 }
 
 static void run_queries(skiatest::Reporter* reporter, SkRandom& rand, SkRect rects[],
-                        const SkRTree& tree) {
+                        const SkBBoxHierarchy& tree) {
     for (size_t i = 0; i < NUM_QUERIES; ++i) {
         std::vector<int> hits;
         SkRect query = random_rect(rand);
@@ -97,3 +100,64 @@ DEF_TEST(RTree, reporter) {
                                   expectedDepthMax >= rtree.getDepth());
     }
 }
+
+DEF_TEST(PackedRTree, reporter) {
+    // The leaf level is full, and every level above it has a fraction of as many nodes.
+    int expectedDepth = 0;
+    for (int nodes = NUM_RECTS; nodes > 1; nodes = (nodes + 7) / 8) {
+        ++expectedDepth;
+    }
+
+    SkRandom rand;
+    AutoTArray<SkRect> rects(NUM_RECTS);
+    for (size_t i = 0; i < NUM_ITERATIONS; ++i) {
+        SkPackedRTree tree;
+        REPORTER_ASSERT(reporter, 0 == tree.getCount());
+
+        for (int j = 0; j < NUM_RECTS; j++) {
+            rects[j] = random_rect(rand);
+        }
+
+        tree.insert(rects.data(), NUM_RECTS);
+
+        run_queries(reporter, rand, rects.data(), tree);
+        REPORTER_ASSERT(reporter, NUM_RECTS == tree.getCount());
+        REPORTER_ASSERT(reporter, expectedDepth == tree.getDepth());
+    }
+
+    // Empty bounds are never found, and neither is anything by an empty query.
+    SkPackedRTree tree;
+    const SkRect bounds[] = {{0, 0, 10, 10}, SkRect::MakeEmpty(), {5, 5, 5, 20}, {0, 0, 10, 10}};
+    tree.insert(bounds, (int)std::size(bounds));
+    REPORTER_ASSERT(reporter, 2 == tree.getCount());
+    std::vector<int> hits;
+    tree.search({0, 0, 20, 20}, &hits);
+    REPORTER_ASSERT(reporter, (hits == std::vector<int>{0, 3}));
+    hits.clear();
+    tree.search({5, 5, 5, 5}, &hits);
+    REPORTER_ASSERT(reporter, hits.empty());
+}
+
+DEF_TEST(RTree_batchSearch, reporter) {
+    SkRandom rand;
+    AutoTArray<SkRect> rects(NUM_RECTS);
+    for (int j = 0; j < NUM_RECTS; j++) {
+        rects[j] = random_rect(rand);
+    }
+    AutoTArray<SkRect> queries(NUM_QUERIES);
+    for (size_t j = 0; j < NUM_QUERIES; j++) {
+        queries[j] = random_rect(rand);
+    }
+    queries[0] = SkRect::MakeEmpty();
+
+    sk_sp<SkBBoxHierarchy> trees[] = {SkRTreeFactory()(), SkPackedRTreeFactory()()};
+    for (const sk_sp<SkBBoxHierarchy>& tree : trees) {
+        tree->insert(rects.data(), NUM_RECTS);
+
+        std::vector<std::vector<int>> results(NUM_QUERIES);
+        tree->search(queries.data(), (int)NUM_QUERIES, results.data());
+        for (size_t j = 0; j < NUM_QUERIES; j++) {
+            REPORTER_ASSERT(reporter, verify_query(queries[j], rects.data(), results[j]));
+        }
+    }
+}
@@ -8,6 +8,7 @@
 #include "include/private/base/SkTo.h"
 #include "src/base/SkHalf.h"
 #include "src/base/SkUtils.h"
+#include "src/core/SkCpu.h"
 #include "src/core/SkOpts.h"
 #include "src/core/SkRasterPipeline.h"
 #include "src/core/SkRasterPipelineContextUtils.h"
@@ -16,7 +17,12 @@
 #include "tests/Test.h"
 
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
 #include <numeric>
+#include <vector>
 
 using namespace skia_private;
 
@@ -3450,3 +3456,243 @@ DEF_TEST(SkRasterPipeline_stack_rewind, r) {
         stack.validate(r);
     }
 }
+
+extern bool gForceHighPrecisionRasterPipeline;
+extern bool gDisableRasterPipelineFusion;
+
+// Serial, since this toggles the global precision and fusion switches.
+DEF_SERIAL_TEST(SkRasterPipeline_Fusion, r) {
+    constexpr int kW = 37;
+    uint32_t src[kW], dst[kW];
+    for (int i = 0; i < kW; i++) {
+        uint32_t a = i * 7;  // Unpremul, so premul has something to do.
+        src[i] = (a << 24) | ((255 - i) << 16) | ((i * 3) << 8) | (i * 5);
+        dst[i] = 0xff000000 | (i * 6) << 16 | (200 - i) << 8 | (i * 2);
+    }
+
+    // Runs `build` with fusion off and then on, checking that the results agree and that the
+    // fusion count for `fusedOp` goes up by `expectedFusions`.
+    auto check = [&](const char* name, SkRasterPipelineOp fusedOp, int expectedFusions,
+                     const std::function<void(SkRasterPipeline*, SkRasterPipeline_MemoryCtx*,
+                                              SkRasterPipeline_MemoryCtx*)>& build) {
+        for (bool highp : {false, true}) {
+            gForceHighPrecisionRasterPipeline = highp;
+            uint32_t results[2][kW];
+            for (bool fusion : {false, true}) {
+                gDisableRasterPipelineFusion = !fusion;
+                memcpy(results[fusion], dst, sizeof(dst));
+                SkRasterPipeline_MemoryCtx srcCtx = {src, 0},
+                                           dstCtx = {results[fusion], 0};
+                SkRasterPipeline_<256> p;
+                build(&p, &srcCtx, &dstCtx);
+
+                const int before = SkRasterPipeline::GetFusionCount(fusedOp);
+                p.run(0, 0, kW, 1);
+                const int fusions = SkRasterPipeline::GetFusionCount(fusedOp) - before;
+                REPORTER_ASSERT(r, fusions == (fusion ? expectedFusions : 0),
+                                "%s, %s: %d fusions", name, highp ? "highp" : "lowp", fusions);
+            }
+            // Fusion must never change a pixel.
+            for (int i = 0; i < kW; i++) {
+                REPORTER_ASSERT(r, results[0][i] == results[1][i],
+                                "%s, %s: pixel %d: %08x vs. %08x",
+                                name, highp ? "highp" : "lowp",
+                                i, results[0][i], results[1][i]);
+            }
+        }
+    };
+
+    using Op = SkRasterPipelineOp;
+    auto srcover_rgba = [](SkRasterPipeline* p, SkRasterPipeline_MemoryCtx* srcCtx,
+                           SkRasterPipeline_MemoryCtx* dstCtx) {
+        p->append(Op::load_8888, srcCtx);
+        p->append(Op::premul);
+        p->append(Op::load_8888_dst, dstCtx);
+        p->append(Op::srcover);
+        p->append(Op::store_8888, dstCtx);
+    };
+    check("load_8888_premul", Op::load_8888_premul, 1, srcover_rgba);
+    check("fused_srcover_rgba_8888", Op::fused_srcover_rgba_8888, 1, srcover_rgba);
+
+    check("fused_srcover_bgra_8888", Op::fused_srcover_bgra_8888, 1,
+          [](SkRasterPipeline* p, SkRasterPipeline_MemoryCtx* srcCtx,
+             SkRasterPipeline_MemoryCtx* dstCtx) {
+              p->append(Op::load_8888, srcCtx);
+              p->append(Op::premul);
+              p->append(Op::load_8888_dst, dstCtx);
+              p->append(Op::swap_rb_dst);
+              p->append(Op::srcover);
+              p->append(Op::swap_rb);
+              p->append(Op::store_8888, dstCtx);
+          });
+
+    // A run that loads from one place and stores to another can't be fused.
+    check("different contexts", Op::fused_srcover_rgba_8888, 0,
+          [](SkRasterPipeline* p, SkRasterPipeline_MemoryCtx* srcCtx,
+             SkRasterPipeline_MemoryCtx* dstCtx) {
+              p->append(Op::load_8888, srcCtx);
+              p->append(Op::load_8888_dst, srcCtx);
+              p->append(Op::srcover);
+              p->append(Op::store_8888, dstCtx);
+          });
+
+    // Nor can a fused store that doesn't end the program.
+    check("not at end", Op::fused_srcover_rgba_8888, 0,
+          [](SkRasterPipeline* p, SkRasterPipeline_MemoryCtx* srcCtx,
+             SkRasterPipeline_MemoryCtx* dstCtx) {
+              p->append(Op::load_8888, srcCtx);
+              p->append(Op::load_8888_dst, dstCtx);
+              p->append(Op::srcover);
+              p->append(Op::store_8888, dstCtx);
+              p->append(Op::swap_rb);
+              p->append(Op::store_8888, dstCtx);
+          });
+
+    gForceHighPrecisionRasterPipeline = false;
+    gDisableRasterPipelineFusion = false;
+}
+
+#if defined(SK_CPU_X86) && !defined(SK_ENABLE_OPTIMIZE_SIZE) && \
+    SK_CPU_SSE_LEVEL < SK_CPU_SSE_LEVEL_AVX2 && defined(SK_ENABLE_AVX512_OPTS)
+
+namespace SkOpts {
+    void Init_hsw();
+    void Init_skx();
+}  // namespace SkOpts
+
+// The SKX stages run 16 pixels at a time in highp, twice as many as HSW, and share HSW's 16-lane
+// layout in lowp. Run the same pipelines, in lowp and in highp, with each set of stages installed
+// and check that they agree, across widths that exercise both full strides and tails.
+// Serial, since this swaps out the global stages and toggles the global precision switch.
+DEF_SERIAL_TEST(SkRasterPipeline_SKXMatchesHSW, r) {
+    if (!SkCpu::Supports(SkCpu::SKX)) {
+        return;
+    }
+
+    // Each width is run on its own row, reading and writing only that row.
+    static constexpr int kWidths[] = {1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 71, 100};
+    constexpr int kW = 100, kH = std::size(kWidths);
+
+    uint32_t src[kW * kH], dst[kW * kH];
+    uint32_t seed = 0x1234567;
+    auto rand8 = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 24;
+    };
+    for (int i = 0; i < kW * kH; i++) {
+        uint32_t a = rand8(),
+                 R = rand8() * a / 255,
+                 G = rand8() * a / 255,
+                 B = rand8() * a / 255;
+        src[i] = (a << 24) | (B << 16) | (G << 8) | R;
+        dst[i] = 0xff000000 | rand8() << 16 | rand8() << 8 | rand8();
+    }
+
+    // Gradient stops: few enough for HSW to keep them all in registers, and more than that.
+    constexpr int kMaxStops = 20;
+    float fs[4][kMaxStops], bs[4][kMaxStops], ts[kMaxStops];
+    for (int i = 0; i < kMaxStops; i++) {
+        ts[i] = i / (float)kMaxStops;
+        for (int c = 0; c < 4; c++) {
+            fs[c][i] = ((i + c) % 3) * 0.25f;
+            bs[c][i] = ((i * 5 + c) % 7) / 7.0f;
+        }
+    }
+    auto make_gradient = [&](size_t stopCount) {
+        SkRasterPipeline_GradientCtx ctx;
+        ctx.stopCount = stopCount;
+        for (int c = 0; c < 4; c++) {
+            ctx.fs[c] = fs[c];
+            ctx.bs[c] = bs[c];
+        }
+        ctx.ts = ts;
+        return ctx;
+    };
+    const SkRasterPipeline_GradientCtx gradients[] = {make_gradient(5),
+                                                      make_gradient(kMaxStops)};
+    const float toT[6]   = {1.0f / kW, 0.1f, 0,     0,     0,     0};
+    const float toSrc[6] = {0.37f,     0.21f, 3.5f, 0.13f, 0.51f, 0.25f};
+
+    SkRasterPipeline_GatherCtx gather;
+    gather.pixels = src;
+    gather.stride = kW;
+    gather.width  = kW;
+    gather.height = kH;
+
+    using Op = SkRasterPipelineOp;
+    // The last few blends, the radial gradient and bicubic sampling only have highp stages.
+    const Op blends[] = {Op::srcover, Op::modulate, Op::multiply, Op::screen, Op::xor_,
+                         Op::overlay, Op::softlight, Op::colorburn, Op::hue};
+    const Op samplers[] = {Op::bilerp_clamp_8888, Op::bicubic_clamp_8888};
+    constexpr int kPipelines = std::size(blends) + std::size(gradients) + 1 + std::size(samplers);
+
+    auto run_all = [&](uint32_t* out) {
+        SkRasterPipeline_MemoryCtx srcCtx = {src, kW},
+                                   dstCtx = {dst, kW};
+        SkRasterPipeline_MemoryCtx outCtx[kPipelines];
+        for (int n = 0; n < kPipelines; n++) {
+            outCtx[n] = {out + n * kW * kH, kW};
+        }
+        SkRasterPipeline_<256> p[kPipelines];
+        int n = 0;
+        for (Op blend : blends) {
+            p[n].append(Op::load_8888, &srcCtx);
+            p[n].append(Op::load_8888_dst, &dstCtx);
+            p[n].append(blend);
+            p[n].append(Op::store_8888, &outCtx[n]);
+            n++;
+        }
+        for (const SkRasterPipeline_GradientCtx& gradient : gradients) {
+            p[n].append(Op::seed_shader);
+            p[n].append(Op::matrix_2x3, toT);
+            p[n].append(Op::gradient, &gradient);
+            p[n].append(Op::store_8888, &outCtx[n]);
+            n++;
+        }
+        p[n].append(Op::seed_shader);
+        p[n].append(Op::matrix_2x3, toT);
+        p[n].append(Op::xy_to_radius);
+        p[n].append(Op::gradient, &gradients[0]);
+        p[n].append(Op::store_8888, &outCtx[n]);
+        n++;
+        for (Op sampler : samplers) {
+            p[n].append(Op::seed_shader);
+            p[n].append(Op::matrix_2x3, toSrc);
+            p[n].append(sampler, &gather);
+            p[n].append(Op::clamp_01);
+            p[n].append(Op::store_8888, &outCtx[n]);
+            n++;
+        }
+
+        for (const SkRasterPipeline& pipeline : p) {
+            for (int y = 0; y < kH; y++) {
+                pipeline.run(0, y, kWidths[y], 1);
+            }
+        }
+    };
+
+    for (bool highp : {false, true}) {
+        gForceHighPrecisionRasterPipeline = highp;
+        std::vector<uint32_t> hsw(kPipelines * kW * kH, 0),
+                              skx(kPipelines * kW * kH, 0);
+        SkOpts::Init_hsw();
+        run_all(hsw.data());
+        SkOpts::Init_skx();  // This also restores the stages in use before the test.
+        run_all(skx.data());
+
+        // HSW and SKX approximate reciprocals to different precisions, so allow off-by-one.
+        for (size_t i = 0; i < hsw.size(); i++) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                int h = (hsw[i] >> shift) & 0xff,
+                    s = (skx[i] >> shift) & 0xff;
+                REPORTER_ASSERT(r, std::abs(h - s) <= 1,
+                                "%s pipeline %d, pixel %d: hsw %08x skx %08x",
+                                highp ? "highp" : "lowp", (int)(i / (kW * kH)),
+                                (int)(i % (kW * kH)), hsw[i], skx[i]);
+            }
+        }
+    }
+    gForceHighPrecisionRasterPipeline = false;
+}
+
+#endif
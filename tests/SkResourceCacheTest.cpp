@@ -24,13 +24,16 @@
 #include "src/core/SkCachedData.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkResourceCache.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/image/SkImage_Base.h"
 #include "src/lazy/SkDiscardableMemoryPool.h"
 #include "tests/Test.h"
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <initializer_list>
 #include <memory>
 
@@ -242,6 +245,7 @@ struct TestRec : SkResourceCache::Rec {
     TestKey fKey;
     int*    fFlags;
     bool    fCanBePurged;
+    double  fCost = 1024;
 
     TestRec(int sharedID, int32_t data, int* flagPtr) : fKey(sharedID, data), fFlags(flagPtr) {
         fCanBePurged = false;
@@ -249,6 +253,7 @@ struct TestRec : SkResourceCache::Rec {
 
     const Key& getKey() const override { return fKey; }
     size_t bytesUsed() const override { return 1024; /* just need a value */ }
+    double regenerationCost() const override { return fCost; }
     bool canBePurged() override { return fCanBePurged; }
     void postAddInstall(void*) override {
         *fFlags |= kDidInstall;
@@ -306,3 +311,123 @@ DEF_TEST(ResourceCache_purge, reporter) {
         }
     }
 }
+
+DEF_TEST(ResourceCache_purgeSome, reporter) {
+    SkResourceCache cache(1024 * 1024);
+    int flags[4] = {};
+    TestRec* recs[4];
+    for (int i = 0; i < 4; ++i) {
+        recs[i] = new TestRec(1, i, &flags[i]);
+        recs[i]->fCanBePurged = i != 0;
+        cache.add(recs[i], nullptr);
+    }
+    REPORTER_ASSERT(reporter, cache.getCount() == 4);
+
+    // rec 0 is the oldest, but can't be purged, so 1 and 2 go.
+    REPORTER_ASSERT(reporter, cache.purgeSome(1500, 0) == 2);
+    REPORTER_ASSERT(reporter, cache.getCount() == 2);
+    REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() == 2048);
+
+    REPORTER_ASSERT(reporter, cache.purgeSome(0, 5) == 1);
+    REPORTER_ASSERT(reporter, cache.getCount() == 1);
+    recs[0]->fCanBePurged = true;  // so we can cleanup the cache
+}
+
+static bool find_any(const SkResourceCache::Rec&, void*) { return true; }
+
+DEF_TEST(ResourceCache_greedyDualSize, reporter) {
+    for (auto policy : {SkResourceCache::EvictionPolicy::kLRU,
+                        SkResourceCache::EvictionPolicy::kGreedyDualSize}) {
+        // Room for four recs.
+        SkResourceCache cache(5000);
+        cache.setEvictionPolicy(policy);
+        int flags = 0;
+        for (int i = 0; i < 4; ++i) {
+            auto rec = new TestRec(1, i, &flags);
+            rec->fCanBePurged = true;
+            rec->fCost = i == 0 ? 16 * 1024 : 1024;
+            cache.add(rec);
+        }
+
+        auto rec = new TestRec(1, 4, &flags);
+        rec->fCanBePurged = true;
+        cache.add(rec);
+        REPORTER_ASSERT(reporter, cache.getCount() == 4);
+        REPORTER_ASSERT(reporter, cache.stats().fEvictions == 1);
+        REPORTER_ASSERT(reporter, cache.stats().fEvictedBytes == 1024);
+
+        // The expensive rec 0 is the oldest, but only LRU purges it before rec 1.
+        const bool lru = policy == SkResourceCache::EvictionPolicy::kLRU;
+        REPORTER_ASSERT(reporter, cache.find(TestKey(1, 0), find_any, nullptr) == !lru);
+        REPORTER_ASSERT(reporter, cache.find(TestKey(1, 1), find_any, nullptr) == lru);
+        REPORTER_ASSERT(reporter, cache.stats().fHits == 1);
+        REPORTER_ASSERT(reporter, cache.stats().fMisses == 1);
+
+        if (!lru) {
+            // Unused, it ages out eventually.
+            for (int i = 5; i < 100; ++i) {
+                rec = new TestRec(1, i, &flags);
+                rec->fCanBePurged = true;
+                cache.add(rec);
+            }
+            REPORTER_ASSERT(reporter, !cache.find(TestKey(1, 0), find_any, nullptr));
+            REPORTER_ASSERT(reporter, cache.getCount() == 4);
+        }
+    }
+}
+
+static void count_test_recs(const SkResourceCache::Rec& rec, void* context) {
+    if (!strcmp(rec.getCategory(), "test-category") && rec.getKey().getSharedID() == 0x5A4D) {
+        *static_cast<int*>(context) += 1;
+    }
+}
+
+struct FindContext {
+    int32_t fExpected;
+    bool    fMatched;
+};
+
+static bool check_found_data(const SkResourceCache::Rec& rec, void* context) {
+    auto ctx = static_cast<FindContext*>(context);
+    ctx->fMatched = static_cast<const TestRec&>(rec).fKey.fData == ctx->fExpected;
+    return true;
+}
+
+/*
+ *  Threads adding to and finding in the global cache at once.
+ */
+DEF_TEST(ResourceCache_global_threads, reporter) {
+    constexpr int kSharedID = 0x5A4D;
+    constexpr int kThreads = 8, kRecsPerThread = 64;
+
+    int flags[kThreads][kRecsPerThread] = {};
+    std::atomic<int> mismatches{0};
+    SkTaskGroup().batch(kThreads, [&](int thread) {
+        for (int i = 0; i < kRecsPerThread; ++i) {
+            auto rec = new TestRec(kSharedID, thread * kRecsPerThread + i, &flags[thread][i]);
+            rec->fCanBePurged = true;
+            SkResourceCache::Add(rec);
+
+            // Other threads may purge them, but what is found must be what we added.
+            for (int j = 0; j <= i; ++j) {
+                FindContext ctx = {thread * kRecsPerThread + j, false};
+                TestKey key(kSharedID, ctx.fExpected);
+                if (SkResourceCache::Find(key, check_found_data, &ctx) && !ctx.fMatched) {
+                    mismatches.fetch_add(1);
+                }
+            }
+        }
+    });
+    REPORTER_ASSERT(reporter, mismatches.load() == 0);
+    for (const auto& threadFlags : flags) {
+        for (int f : threadFlags) {
+            REPORTER_ASSERT(reporter, f & TestRec::kDidInstall);
+        }
+    }
+
+    SkResourceCache::PostPurgeSharedID(kSharedID);
+    SkResourceCache::CheckMessages();
+    int remaining = 0;
+    SkResourceCache::VisitAll(count_test_recs, &remaining);
+    REPORTER_ASSERT(reporter, remaining == 0);
+}
@@ -7,18 +7,27 @@
 
 #include "include/core/SkFont.h"
 #include "include/core/SkFontStyle.h"
+#include "include/core/SkFontTypes.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkString.h"
 #include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypeface.h"
+#include "src/core/SkGlyph.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkStrike.h"  // IWYU pragma: keep
 #include "src/core/SkStrikeCache.h"
+#include "src/core/SkStrikePersistentCache.h"
 #include "src/core/SkStrikeSpec.h"
+#include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
 #include "tools/ToolUtils.h"
 #include "tools/fonts/FontToolUtils.h"
+#include "tools/fonts/RandomScalerContext.h"
+
+#include <cstdio>
+#include <cstring>
 
 DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
     SkStrikeCache cache;
@@ -61,3 +70,106 @@ DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
 
 
 }
+
+DEF_TEST(SkStrikeCache_PersistentFile, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString path = SkOSPath::Join(tmpDir.c_str(), "strike_cache_test");
+
+    // Only sfnt fonts are kept in the file.
+    sk_sp<SkTypeface> typeface = ToolUtils::CreateTypefaceFromResource("fonts/Roboto-Regular.ttf");
+    if (!typeface) {
+        return;
+    }
+    SkFont font{typeface, 24};
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+    SkGlyphID glyphIDs[5];
+    font.textToGlyphs("Hello", 5, SkTextEncoding::kUTF8, glyphIDs, 5);
+    SkPackedGlyphID packedIDs[5];
+    for (int i = 0; i < 5; ++i) {
+        packedIDs[i] = SkPackedGlyphID{glyphIDs[i]};
+    }
+
+    // Save the glyphs of one cache's strike.
+    SkStrikeCache savingCache;
+    savingCache.setPersistentCache(path.c_str());
+    sk_sp<SkStrike> saved = strikeSpec.findOrCreateStrike(&savingCache);
+    if (saved->scalerVersion() == 0) {
+        // This font manager's scaler does not report a version, so nothing is saved. See
+        // SkStrikeCache_PersistentFileUnknownScaler.
+        return;
+    }
+    const SkGlyph* savedGlyphs[5];
+    saved->prepareImages(packedIDs, savedGlyphs);
+    REPORTER_ASSERT(reporter, savingCache.savePersistentCache());
+
+    // The glyphs are only found for the version of the scaler that made them.
+    auto file = sk_make_sp<SkStrikePersistentCache>(path.c_str());
+    REPORTER_ASSERT(reporter, file->find(strikeSpec, saved->scalerVersion()) != nullptr);
+    REPORTER_ASSERT(reporter, file->find(strikeSpec, saved->scalerVersion() + 1) == nullptr);
+
+    // Without the file, a new strike has no glyphs yet.
+    SkStrikeCache emptyCache;
+    sk_sp<SkStrike> empty = strikeSpec.findOrCreateStrike(&emptyCache);
+
+    // With it, a new strike starts out with the saved ones.
+    SkStrikeCache loadingCache;
+    loadingCache.setPersistentCache(path.c_str());
+    sk_sp<SkStrike> loaded = strikeSpec.findOrCreateStrike(&loadingCache);
+    REPORTER_ASSERT(reporter, loadingCache.getTotalMemoryUsed() > emptyCache.getTotalMemoryUsed());
+
+    const SkGlyph* loadedGlyphs[5];
+    loaded->prepareImages(packedIDs, loadedGlyphs);
+    for (int i = 0; i < 5; ++i) {
+        const SkGlyph* s = savedGlyphs[i];
+        const SkGlyph* l = loadedGlyphs[i];
+        REPORTER_ASSERT(reporter, s->iRect() == l->iRect());
+        REPORTER_ASSERT(reporter, s->advanceX() == l->advanceX());
+        REPORTER_ASSERT(reporter, s->isEmpty() ||
+                                  0 == memcmp(s->image(), l->image(), s->imageSize()));
+    }
+}
+
+DEF_TEST(SkStrikeCache_PersistentFileUnknownScaler, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString path = SkOSPath::Join(tmpDir.c_str(), "strike_cache_unknown_scaler_test");
+    // Saving keeps the strikes of an earlier file, so start without one.
+    std::remove(path.c_str());
+
+    // The random typeface has the tables of the sfnt font it wraps, so it has an identity, but its
+    // scaler does not report a version.
+    sk_sp<SkTypeface> proxy = ToolUtils::CreateTypefaceFromResource("fonts/Roboto-Regular.ttf");
+    if (!proxy) {
+        return;
+    }
+    SkFont font{sk_make_sp<SkRandomTypeface>(proxy, SkPaint(), false), 24};
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+    SkGlyphID glyphIDs[5];
+    font.textToGlyphs("Hello", 5, SkTextEncoding::kUTF8, glyphIDs, 5);
+    SkPackedGlyphID packedIDs[5];
+    for (int i = 0; i < 5; ++i) {
+        packedIDs[i] = SkPackedGlyphID{glyphIDs[i]};
+    }
+
+    SkStrikeCache savingCache;
+    savingCache.setPersistentCache(path.c_str());
+    sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike(&savingCache);
+    REPORTER_ASSERT(reporter, strike->scalerVersion() == 0);
+    const SkGlyph* glyphs[5];
+    strike->prepareImages(packedIDs, glyphs);
+    REPORTER_ASSERT(reporter, savingCache.savePersistentCache());
+
+    auto file = sk_make_sp<SkStrikePersistentCache>(path.c_str());
+    REPORTER_ASSERT(reporter, file->count() == 0);
+    REPORTER_ASSERT(reporter, file->find(strikeSpec, 0) == nullptr);
+}
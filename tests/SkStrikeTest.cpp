@@ -43,6 +43,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <memory>
@@ -172,6 +173,134 @@ DEF_TEST(SkStrikeMultiThread, Reporter) {
     }
 }
 
+DEF_TEST(SkStrike_LockFreeLookup, reporter) {
+    SkFont font;
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    font.setSubpixel(true);
+    font.setTypeface(ToolUtils::CreatePortableTypeface("serif", SkFontStyle()));
+
+    SkPaint defaultPaint;
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, defaultPaint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+    SkStrikeCache strikeCache;
+
+    // Enough glyphs to grow the lookup table several times.
+    std::vector<SkPackedGlyphID> packedIDs;
+    for (int c = ' '; c < 'z'; c++) {
+        for (uint32_t x = 0; x < 4; x++) {
+            packedIDs.push_back(SkPackedGlyphID{font.unicharToGlyph(c), x, 0u});
+        }
+    }
+    const size_t count = packedIDs.size();
+
+    {
+        SkStrike strike{&strikeCache, strikeSpec, strikeSpec.createScalerContext(), nullptr,
+                        nullptr};
+        SkGlyphDigest digest;
+        REPORTER_ASSERT(reporter,
+                        strike.findDigest(kDirectMaskCPU, packedIDs[0], &digest) == nullptr);
+
+        // The second time, the glyphs are all found without taking the lock.
+        std::vector<const SkGlyph*> glyphs(count), again(count);
+        strike.prepareImages(packedIDs, glyphs.data());
+        strike.prepareImages(packedIDs, again.data());
+        REPORTER_ASSERT(reporter, glyphs == again);
+        for (const SkGlyph* glyph : again) {
+            REPORTER_ASSERT(reporter, glyph->setImageHasBeenCalled());
+        }
+
+        // A digest is found once digestFor() has decided its action.
+        std::vector<SkGlyphDigest> expected;
+        strike.lock();
+        for (SkPackedGlyphID packedID : packedIDs) {
+            expected.push_back(strike.digestFor(kPath, packedID));
+        }
+        strike.unlock();
+        for (size_t i = 0; i < count; i++) {
+            const SkGlyph* glyph = strike.findDigest(kPath, packedIDs[i], &digest);
+            REPORTER_ASSERT(reporter, glyph == glyphs[i]);
+            REPORTER_ASSERT(reporter, digest.index() == expected[i].index());
+            REPORTER_ASSERT(reporter, digest.actionFor(kPath) == expected[i].actionFor(kPath));
+        }
+    }
+
+    // Threads racing to fill a strike all get the same glyphs.
+    static constexpr int kThreadCount = 4;
+    auto executor = SkExecutor::MakeFIFOThreadPool(kThreadCount);
+    for (int tries = 0; tries < 20; tries++) {
+        SkStrike strike{&strikeCache, strikeSpec, strikeSpec.createScalerContext(), nullptr,
+                        nullptr};
+        std::vector<const SkGlyph*> glyphs[kThreadCount];
+        Barrier barrier{kThreadCount};
+        SkTaskGroup(*executor).batch(kThreadCount, [&](int threadIndex) {
+            barrier.waitForAll();
+            std::vector<const SkGlyph*>& results = glyphs[threadIndex];
+            results.resize(count);
+            for (int i = 0; i < 10; i++) {
+                strike.prepareImages(packedIDs, results.data());
+            }
+        });
+        for (int thread = 1; thread < kThreadCount; thread++) {
+            REPORTER_ASSERT(reporter, glyphs[thread] == glyphs[0]);
+        }
+    }
+}
+
+DEF_TEST(SkStrike_PrepareImagesOnExecutor, reporter) {
+    // A font from a file is scaled by the platform's port, e.g. by FreeType with faces of its own
+    // for the tasks.
+    for (sk_sp<SkTypeface> typeface :
+                 {ToolUtils::CreatePortableTypeface("serif", SkFontStyle()),
+                  ToolUtils::CreateTypefaceFromResource("fonts/Roboto-Regular.ttf")}) {
+        if (!typeface) {
+            continue;
+        }
+        SkFont font{typeface, 48};
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        font.setSubpixel(true);
+        SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+                font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+        SkStrikeCache strikeCache;
+
+        // Enough glyphs to split among several tasks, with some repeated.
+        std::vector<SkPackedGlyphID> packedIDs;
+        for (int c = ' '; c < 'z'; c++) {
+            for (uint32_t x = 0; x < 4; x++) {
+                packedIDs.push_back(SkPackedGlyphID{font.unicharToGlyph(c), x, 0u});
+            }
+        }
+        packedIDs.insert(packedIDs.end(), packedIDs.begin(), packedIDs.begin() + 50);
+        const size_t count = packedIDs.size();
+
+        SkStrike serial{
+                &strikeCache, strikeSpec, strikeSpec.createScalerContext(), nullptr, nullptr};
+        std::vector<const SkGlyph*> expected(count);
+        serial.prepareImages(packedIDs, expected.data());
+
+        auto executor = SkExecutor::MakeFIFOThreadPool(4);
+        SkStrike strike{
+                &strikeCache, strikeSpec, strikeSpec.createScalerContext(), nullptr, nullptr};
+        std::vector<const SkGlyph*> glyphs(count);
+        strike.prepareImages(packedIDs, glyphs.data(), executor.get());
+        for (size_t i = 0; i < count; i++) {
+            const SkGlyph* glyph = glyphs[i];
+            REPORTER_ASSERT(reporter, glyph->getPackedID() == packedIDs[i]);
+            REPORTER_ASSERT(reporter, glyph->setImageHasBeenCalled());
+            REPORTER_ASSERT(reporter, glyph->iRect() == expected[i]->iRect());
+            REPORTER_ASSERT(reporter, glyph->isEmpty() ||
+                                      0 == memcmp(glyph->image(), expected[i]->image(),
+                                                  glyph->imageSize()));
+        }
+
+        // The images are now found without making them again.
+        std::vector<const SkGlyph*> again(count);
+        strike.prepareImages(packedIDs, again.data());
+        REPORTER_ASSERT(reporter, again == glyphs);
+    }
+}
+
 class SkGlyphTestPeer {
 public:
     static void SetGlyph(SkGlyph* glyph) {
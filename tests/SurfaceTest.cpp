@@ -13,6 +13,7 @@
 #include "include/core/SkColorFilter.h"
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkColorType.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
@@ -1313,6 +1314,104 @@ DEF_TEST(Surface_null, r) {
     REPORTER_ASSERT(r, surf->makeImageSnapshot() == nullptr);
 }
 
+// Tiled raster surfaces defer their draws and play them back tile by tile on an executor; the
+// results must match drawing directly, however the resolves fall relative to saves and layers.
+DEF_TEST(Surface_RasterTiled, r) {
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(300, 200);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    REPORTER_ASSERT(r, SkSurfaces::RasterTiled(info, executor.get(), -1) == nullptr);
+
+    sk_sp<SkSurface> tiled = SkSurfaces::RasterTiled(info, executor.get(), 64);
+    sk_sp<SkSurface> plain = SkSurfaces::Raster(info);
+    REPORTER_ASSERT(r, tiled && plain);
+
+    // Paths are clipped to each tile before they're scan converted, which can nudge their edges,
+    // so only draw rects and clip them with rects; those rasterize identically in any tile.
+    auto draw_first = [](SkCanvas* canvas) {
+        canvas->clear(SK_ColorWHITE);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setColor(SK_ColorRED);
+        canvas->drawRect(SkRect::MakeLTRB(60.5f, 10.25f, 240.75f, 190.5f), paint);
+
+        canvas->save();
+        canvas->translate(20, 30);
+        canvas->clipRect(SkRect::MakeWH(200, 100), true);
+        paint.setColor(0x8000FF00);
+        canvas->drawRect(SkRect::MakeXYWH(-10, -10, 250, 60), paint);
+        // Left open across the first resolve.
+    };
+    auto draw_second = [](SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setColor(SK_ColorBLUE);
+        canvas->drawRect(SkRect::MakeXYWH(0.5f, 40.25f, 260, 70), paint);
+        canvas->restore();
+
+        SkPaint layerPaint;
+        layerPaint.setAlphaf(0.5f);
+        canvas->saveLayer(nullptr, &layerPaint);
+        paint.setColor(SK_ColorBLACK);
+        canvas->clipRect(SkRect::MakeLTRB(10.5f, 100.5f, 290, 190), true);
+        canvas->drawPaint(paint);
+        canvas->restore();
+    };
+
+    auto same_pixels = [](SkSurface* a, SkSurface* b) {
+        SkBitmap bmA, bmB;
+        bmA.allocPixels(a->imageInfo());
+        bmB.allocPixels(b->imageInfo());
+        return a->readPixels(bmA, 0, 0) &&
+               b->readPixels(bmB, 0, 0) &&
+               ToolUtils::equal_pixels(bmA, bmB);
+    };
+
+    draw_first(tiled->getCanvas());
+    draw_first(plain->getCanvas());
+    REPORTER_ASSERT(r, same_pixels(tiled.get(), plain.get()));
+
+    // Snapshots must not see draws recorded after them.
+    sk_sp<SkImage> tiledSnap = tiled->makeImageSnapshot();
+    sk_sp<SkImage> plainSnap = plain->makeImageSnapshot();
+    REPORTER_ASSERT(r, ToolUtils::equal_pixels(tiledSnap.get(), plainSnap.get()));
+
+    draw_second(tiled->getCanvas());
+    draw_second(plain->getCanvas());
+    REPORTER_ASSERT(r, tiled->getCanvas()->getSaveCount() == 1);
+    REPORTER_ASSERT(r, same_pixels(tiled.get(), plain.get()));
+    REPORTER_ASSERT(r, ToolUtils::equal_pixels(tiledSnap.get(), plainSnap.get()));
+
+    sk_sp<SkImage> tiledFinal = tiled->makeImageSnapshot();
+    REPORTER_ASSERT(r, !ToolUtils::equal_pixels(tiledSnap.get(), tiledFinal.get()));
+
+    // A layer still open when the pixels are needed is not in them yet, and once restored it is
+    // composited in one piece, so group opacity covers the draws on both sides of the resolve.
+    auto open_layer = [](SkCanvas* canvas) {
+        SkPaint layerPaint;
+        layerPaint.setAlphaf(0.5f);
+        canvas->saveLayer(nullptr, &layerPaint);
+        SkPaint paint;
+        paint.setColor(SK_ColorGREEN);
+        canvas->drawRect(SkRect::MakeXYWH(20, 20, 150, 100), paint);
+    };
+    auto close_layer = [](SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        canvas->drawRect(SkRect::MakeXYWH(100, 60, 150, 100), paint);
+        canvas->restore();
+    };
+    open_layer(tiled->getCanvas());
+    open_layer(plain->getCanvas());
+    REPORTER_ASSERT(r, same_pixels(tiled.get(), plain.get()));
+    sk_sp<SkImage> beforeLayer = tiled->makeImageSnapshot();
+    REPORTER_ASSERT(r, ToolUtils::equal_pixels(beforeLayer.get(), tiledFinal.get()));
+
+    close_layer(tiled->getCanvas());
+    close_layer(plain->getCanvas());
+    REPORTER_ASSERT(r, same_pixels(tiled.get(), plain.get()));
+}
+
 // assert: if a given imageinfo is valid for a surface, then it must be valid for an image
 //         (so the snapshot can succeed)
 DEF_TEST(surface_image_unity, reporter) {
@@ -7,8 +7,12 @@
 
 #include "include/codec/SkCodec.h"
 #include "include/codec/SkEncodedOrigin.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColor.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageGenerator.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkScalar.h"
@@ -20,11 +24,20 @@
 #include "include/effects/SkColorMatrix.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/private/base/SkTo.h"
+#include "src/base/SkRandom.h"
+#include "src/core/SkCachedData.h"
+#include "src/core/SkResourceCache.h"
+#include "src/core/SkYUVPlanesCache.h"
+#include "src/core/SkYUVAInfoLocation.h"
+#include "src/core/SkYUVMath.h"
+#include "src/core/SkYUVToRGB.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -238,3 +251,154 @@ DEF_TEST(YUVMath, reporter) {
         }
     }
 }
+
+// Reads the channel at location from the plane it lives in, clamping (x, y) to the plane.
+static float yuva_sample(const SkYUVAPixmaps& pixmaps,
+                         const SkYUVAInfo::YUVALocation& location, int x, int y) {
+    const SkPixmap& plane = pixmaps.plane(location.fPlane);
+    x = std::clamp(x, 0, plane.width() - 1);
+    y = std::clamp(y, 0, plane.height() - 1);
+    const int bpp = plane.info().bytesPerPixel();
+    return static_cast<const uint8_t*>(plane.addr(x, y))[bpp == 1 ? 0 : (int)location.fChannel];
+}
+
+// Bilinearly samples a chroma channel at the position of pixel (x, y).
+static double yuva_chroma(const SkYUVAPixmaps& pixmaps,
+                          const SkYUVAInfo::YUVALocation& location, int x, int y) {
+    auto [sx, sy] = pixmaps.yuvaInfo().planeSubsamplingFactors(location.fPlane);
+    SkISize size = pixmaps.plane(location.fPlane).dimensions();
+    // Chroma is sited at the center of each block of luma.
+    auto position = [](int i, int factor, int size) {
+        return std::clamp((i + 0.5) / factor - 0.5, 0.0, size - 1.0);
+    };
+    double cx = position(x, sx, size.width()),
+           cy = position(y, sy, size.height());
+    int x0 = (int)cx, y0 = (int)cy;
+    double tx = cx - x0, ty = cy - y0;
+    auto row = [&](int yy) {
+        return yuva_sample(pixmaps, location, x0, yy) * (1 - tx) +
+               yuva_sample(pixmaps, location, x0 + 1, yy) * tx;
+    };
+    return row(y0) * (1 - ty) + row(y0 + 1) * ty;
+}
+
+DEF_TEST(YUVToRGB_Convert, r) {
+    struct {
+        SkYUVAInfo::PlaneConfig fConfig;
+        SkYUVAInfo::Subsampling fSubsampling;
+        SkYUVColorSpace         fColorSpace;
+    } kCases[] = {
+        {SkYUVAInfo::PlaneConfig::kY_U_V,   SkYUVAInfo::Subsampling::k420,
+         kJPEG_Full_SkYUVColorSpace},
+        {SkYUVAInfo::PlaneConfig::kY_UV,    SkYUVAInfo::Subsampling::k420,
+         kRec709_Limited_SkYUVColorSpace},
+        {SkYUVAInfo::PlaneConfig::kY_U_V_A, SkYUVAInfo::Subsampling::k422,
+         kRec601_Limited_SkYUVColorSpace},
+        {SkYUVAInfo::PlaneConfig::kYUVA,    SkYUVAInfo::Subsampling::k444,
+         kBT2020_8bit_Full_SkYUVColorSpace},
+    };
+    // Wide enough to be converted in more than one span, and odd so chroma is rounded up.
+    const SkISize kSize = {SkYUVToRGBRow::kMaxPixels + 37, 23};
+
+    SkRandom random;
+    for (const auto& c : kCases) {
+        SkYUVAInfo info(kSize, c.fConfig, c.fSubsampling, c.fColorSpace);
+        auto pixmaps = SkYUVAPixmaps::Allocate(
+                SkYUVAPixmapInfo(info, SkYUVAPixmaps::DataType::kUnorm8, nullptr));
+        REPORTER_ASSERT(r, pixmaps.isValid());
+        for (int i = 0; i < pixmaps.numPlanes(); ++i) {
+            const SkPixmap& plane = pixmaps.plane(i);
+            for (int y = 0; y < plane.height(); ++y) {
+                auto row = static_cast<uint8_t*>(plane.writable_addr(0, y));
+                for (size_t b = 0; b < plane.info().minRowBytes(); ++b) {
+                    row[b] = random.nextU() >> 24;
+                }
+            }
+        }
+
+        SkBitmap dst;
+        dst.allocPixels(SkImageInfo::Make(kSize, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType));
+        REPORTER_ASSERT(r, SkConvertYUVAPixmaps(pixmaps, nullptr, dst.pixmap()));
+
+        float m[20];
+        SkColorMatrix_YUV2RGB(c.fColorSpace, m);
+        const auto locations = pixmaps.toYUVALocations();
+        int maxDiff = 0;
+        for (int y = 0; y < kSize.height(); ++y) {
+            for (int x = 0; x < kSize.width(); ++x) {
+                const double yuva[] = {
+                    yuva_sample(pixmaps, locations[SkYUVAInfo::kY], x, y) / 255.0,
+                    yuva_chroma(pixmaps, locations[SkYUVAInfo::kU], x, y) / 255.0,
+                    yuva_chroma(pixmaps, locations[SkYUVAInfo::kV], x, y) / 255.0,
+                    locations[SkYUVAInfo::kA].fPlane >= 0
+                            ? yuva_sample(pixmaps, locations[SkYUVAInfo::kA], x, y) / 255.0
+                            : 1.0,
+                };
+                const uint8_t* actual = static_cast<const uint8_t*>(dst.getAddr(x, y));
+                for (int ch = 0; ch < 4; ++ch) {
+                    double v = ch == 3 ? yuva[3]
+                                       : m[5*ch + 0] * yuva[0] + m[5*ch + 1] * yuva[1] +
+                                         m[5*ch + 2] * yuva[2] + m[5*ch + 4];
+                    int expected = (int)std::lround(std::clamp(v, 0.0, 1.0) * 255);
+                    maxDiff = std::max(maxDiff, std::abs(expected - actual[ch]));
+                }
+            }
+        }
+        REPORTER_ASSERT(r, maxDiff <= 1, "max diff %d", maxDiff);
+    }
+
+    // Other data types and origins are left to the GPU.
+    SkYUVAInfo rotated(kSize, SkYUVAInfo::PlaneConfig::kY_U_V, SkYUVAInfo::Subsampling::k420,
+                       kJPEG_Full_SkYUVColorSpace, kRightTop_SkEncodedOrigin);
+    auto pixmaps = SkYUVAPixmaps::Allocate(
+            SkYUVAPixmapInfo(rotated, SkYUVAPixmaps::DataType::kUnorm8, nullptr));
+    SkBitmap dst;
+    dst.allocPixels(SkImageInfo::MakeN32Premul(rotated.dimensions()));
+    REPORTER_ASSERT(r, !SkConvertYUVAPixmaps(pixmaps, nullptr, dst.pixmap()));
+}
+
+// YUVA planes cached for the GPU only stand in for a raster decode that the generator can't make.
+DEF_TEST(YUVToRGB_LazyImage, r) {
+    class SolidGenerator final : public SkImageGenerator {
+    public:
+        explicit SolidGenerator(bool decodesRGBA)
+                : SkImageGenerator(SkImageInfo::MakeN32Premul(16, 16))
+                , fDecodesRGBA(decodesRGBA) {}
+
+    private:
+        bool onGetPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                         const Options&) override {
+            if (!fDecodesRGBA) {
+                return false;
+            }
+            SkPixmap(info, pixels, rowBytes).erase(SK_ColorRED);
+            return true;
+        }
+
+        bool fDecodesRGBA;
+    };
+
+    for (bool decodesRGBA : {true, false}) {
+        sk_sp<SkImage> image =
+                SkImages::DeferredFromGenerator(std::make_unique<SolidGenerator>(decodesRGBA));
+
+        // Cache black 4:2:0 planes for the image, as a GPU draw of it would.
+        SkYUVAInfo yuvaInfo(image->dimensions(), SkYUVAInfo::PlaneConfig::kY_U_V,
+                            SkYUVAInfo::Subsampling::k420, kJPEG_Full_SkYUVColorSpace);
+        SkYUVAPixmapInfo pixmapInfo(yuvaInfo, SkYUVAPixmaps::DataType::kUnorm8, nullptr);
+        sk_sp<SkCachedData> data(SkResourceCache::NewCachedData(pixmapInfo.computeTotalBytes()));
+        auto planes = SkYUVAPixmaps::FromExternalMemory(pixmapInfo, data->writable_data());
+        for (int i = 0; i < planes.numPlanes(); ++i) {
+            const SkPixmap& plane = planes.plane(i);
+            memset(plane.writable_addr(), i ? 0x80 : 0x00, plane.computeByteSize());
+        }
+        SkYUVPlanesCache::Add(image->uniqueID(), data.get(), planes);
+
+        SkBitmap bm;
+        bm.allocPixels(image->imageInfo());
+        REPORTER_ASSERT(r, image->readPixels(nullptr, bm.pixmap(), 0, 0,
+                                             SkImage::kDisallow_CachingHint));
+        const SkColor expected = decodesRGBA ? SK_ColorRED : SK_ColorBLACK;
+        REPORTER_ASSERT(r, bm.getColor(7, 9) == expected, "%08x", bm.getColor(7, 9));
+    }
+}
@@ -85,6 +85,15 @@ int main(int argc, char** argv) {
 
         uint32_t chunkSize;
         if (!stream.readU32(&chunkSize)) { return kTruncatedFile; }
+
+        // Newer files pad these chunks to a 4-byte offset.
+        if ((tag == SK_PICT_READER_TAG || tag == SK_PICT_BUFFER_SIZE_TAG) &&
+            info.getVersion() >= SkPicturePriv::kAlignedStreamData) {
+            uint32_t padding;
+            if (!stream.readU32(&padding) || padding > 3 || !stream.move(padding)) {
+                return kTruncatedFile;
+            }
+        }
         size_t curPos = stream.getPosition();
 
         // "move" doesn't error out when seeking beyond the end of file